@@ -0,0 +1,308 @@
+//! 包装层热点路径基准测试
+//!
+//! 运行：`cd easyx-bench && cargo bench`
+
+use std::hint::black_box;
+use std::time::{Duration, Instant};
+
+use criterion::{BenchmarkId, Criterion, Throughput, criterion_group, criterion_main};
+use easyx::easyx_sys::POINT;
+use easyx::prelude::*;
+use easyx_bench::{Bench, HEIGHT, WIDTH};
+
+// 消息吞吐测试每批投递的消息数
+const MESSAGE_BATCH: usize = 64;
+
+const WM_KEYDOWN: u32 = 0x0100;
+const VK_SPACE: usize = 0x20;
+
+#[link(name = "user32")]
+unsafe extern "system" {
+    fn PostMessageW(hwnd: *mut std::ffi::c_void, msg: u32, wparam: usize, lparam: isize) -> i32;
+}
+
+fn primitives(c: &mut Criterion, bench: &Bench) {
+    let app = &bench.app;
+    bench.offscreen();
+    app.set_linecolor(&Color::WHITE);
+    app.set_fillcolor(&Color::BLUE);
+
+    let mut group = c.benchmark_group("primitives");
+
+    group.bench_function("clear_device", |b| b.iter(|| app.clear_device()));
+    group.bench_function("line", |b| {
+        b.iter(|| app.line(black_box(10), black_box(10), WIDTH - 10, HEIGHT - 10))
+    });
+    group.bench_function("rectangle", |b| {
+        b.iter(|| app.rectangle(black_box(10), black_box(10), 110, 110))
+    });
+    group.bench_function("fill_rectangle", |b| {
+        b.iter(|| app.fill_rectangle(black_box(10), black_box(10), 110, 110))
+    });
+    group.bench_function("solid_rectangle", |b| {
+        b.iter(|| app.solid_rectangle(black_box(10), black_box(10), 110, 110))
+    });
+    group.bench_function("circle", |b| {
+        b.iter(|| app.circle(black_box(320), black_box(240), 100))
+    });
+    group.bench_function("fill_circle", |b| {
+        b.iter(|| app.fill_circle(black_box(320), black_box(240), 100))
+    });
+
+    let points: Vec<POINT> = (0..100)
+        .map(|i| POINT {
+            x: i * WIDTH / 100,
+            y: if i % 2 == 0 { 100 } else { 300 },
+        })
+        .collect();
+    group.throughput(Throughput::Elements(points.len() as u64));
+    group.bench_function("poly_line_100", |b| {
+        b.iter(|| app.poly_line(black_box(&points)))
+    });
+
+    group.throughput(Throughput::Elements(1000));
+    group.bench_function("put_pixel_1000", |b| {
+        b.iter(|| {
+            for i in 0..1000 {
+                app.put_pixel(i % WIDTH, i / WIDTH, &Color::RED);
+            }
+        })
+    });
+
+    // 每帧逐格填充的棋盘，对照 GDI 与软件光栅化
+    let cells: Vec<[i32; 4]> = (0..20 * 10)
+        .map(|i| {
+            let (x, y) = ((i % 10) * 24, (i / 10) * 24);
+            [x, y, x + 22, y + 22]
+        })
+        .collect();
+    group.throughput(Throughput::Elements(cells.len() as u64));
+    group.bench_function("board_fill_rectangle", |b| {
+        b.iter(|| {
+            for cell in &cells {
+                app.set_fillcolor(&Color::CYAN);
+                app.solid_rectangle(cell[0], cell[1], cell[2], cell[3]);
+            }
+        })
+    });
+    group.bench_function("board_raster_fill_rects", |b| {
+        b.iter(|| app.raster_fill_rects(black_box(&cells), &Color::CYAN))
+    });
+
+    group.finish();
+}
+
+fn text(c: &mut Criterion, bench: &Bench) {
+    let app = &bench.app;
+    bench.offscreen();
+    app.set_textstyle(20, 0, "Consolas");
+    app.set_textcolor(&Color::WHITE);
+
+    let ascii = "Score: 123450  Lines: 42  Level: 7";
+    let cjk = "得分：123450 消除行数：42 等级：7";
+    let atlas = TextAtlas::current();
+    atlas.preload(cjk);
+
+    let mut group = c.benchmark_group("text");
+
+    for (name, label) in [("ascii", ascii), ("cjk", cjk)] {
+        group.throughput(Throughput::Elements(label.chars().count() as u64));
+        group.bench_with_input(BenchmarkId::new("out_text", name), label, |b, label| {
+            b.iter(|| app.out_text(10, 10, black_box(label)))
+        });
+        group.bench_with_input(BenchmarkId::new("text_width", name), label, |b, label| {
+            b.iter(|| black_box(app.text_width(black_box(label))))
+        });
+        group.bench_with_input(BenchmarkId::new("atlas_draw", name), label, |b, label| {
+            b.iter(|| black_box(atlas.draw(10, 40, black_box(label), &Color::WHITE)))
+        });
+        group.bench_with_input(
+            BenchmarkId::new("atlas_text_width", name),
+            label,
+            |b, label| b.iter(|| black_box(atlas.text_width(black_box(label)))),
+        );
+    }
+
+    group.finish();
+}
+
+fn images(c: &mut Criterion, bench: &Bench) {
+    bench.offscreen();
+
+    let sprite = bench.pattern(64, 64);
+    let large = bench.pattern(WIDTH, HEIGHT);
+
+    let mut group = c.benchmark_group("images");
+
+    let rops = [
+        ("SrcCopy", Rop::SrcCopy),
+        ("SrcPaint", Rop::SrcPaint),
+        ("SrcAnd", Rop::SrcAnd),
+        ("SrcInvert", Rop::SrcInvert),
+        ("NotSrcCopy", Rop::NotSrcCopy),
+        ("NotSrcErase", Rop::NotSrcErase),
+        ("MergeCopy", Rop::MergeCopy),
+        ("MergePaint", Rop::MergePaint),
+        ("PatCopy", Rop::PatCopy),
+        ("PatInvert", Rop::PatInvert),
+        ("DstInvert", Rop::DstInvert),
+        ("Blackness", Rop::Blackness),
+    ];
+    for (name, rop) in rops {
+        group.bench_with_input(BenchmarkId::new("put_image_64", name), &rop, |b, &rop| {
+            b.iter(|| sprite.put_image_rop(black_box(100), black_box(100), rop))
+        });
+        group.bench_with_input(
+            BenchmarkId::new("put_image_part_32", name),
+            &rop,
+            |b, &rop| {
+                b.iter(|| {
+                    sprite.put_image_part_rop(black_box(100), black_box(100), 32, 32, 16, 16, rop)
+                })
+            },
+        );
+    }
+
+    group.bench_function("put_image_full", |b| b.iter(|| large.put_image(0, 0)));
+    group.bench_function("put_image_alpha_64", |b| {
+        b.iter(|| sprite.put_image_alpha(black_box(100), black_box(100), 128))
+    });
+
+    for highquality in [false, true] {
+        let name = if highquality { "highquality" } else { "fast" };
+        group.bench_with_input(
+            BenchmarkId::new("rotate_64", name),
+            &highquality,
+            |b, &hq| b.iter(|| black_box(sprite.rotate(0.5, Color::BLACK, true, hq))),
+        );
+    }
+
+    for name in ["sprite.bmp", "sprite.png", "sprite.jpg"] {
+        let path = bench.asset(name, 256, 256).expect("无法生成测试图像");
+        group.bench_with_input(BenchmarkId::new("load_file_256", name), &path, |b, path| {
+            b.iter(|| black_box(Image::load_file(path, 0, 0, false)))
+        });
+    }
+
+    // 粒子系统：逐个 put_image 对照图集批量绘制
+    let mut atlas = SpriteAtlas::new(256, 256);
+    let particle = bench.pattern(8, 8);
+    let id = atlas.add_image(&particle).expect("无法添加精灵");
+    let instances: Vec<SpriteInstance> = (0..5000)
+        .map(|i| SpriteInstance::new(id, (i * 37) % WIDTH, (i * 91) % HEIGHT))
+        .collect();
+    group.throughput(Throughput::Elements(instances.len() as u64));
+    group.bench_function("particles_put_image_5000", |b| {
+        b.iter(|| {
+            for instance in &instances {
+                particle.put_image(instance.x, instance.y);
+            }
+        })
+    });
+    group.bench_function("particles_atlas_draw_batch_5000", |b| {
+        b.iter(|| black_box(atlas.draw_batch(black_box(&instances))))
+    });
+
+    group.finish();
+}
+
+fn flush(c: &mut Criterion, bench: &Bench) {
+    let app = &bench.app;
+    bench.onscreen();
+    app.begin_batch_draw();
+
+    let mut group = c.benchmark_group("flush");
+
+    group.bench_function("flush_batch_draw", |b| b.iter(|| app.flush_batch_draw()));
+    group.bench_function("flush_batch_draw_rect_64", |b| {
+        b.iter(|| app.flush_batch_draw_rect(100, 100, 163, 163))
+    });
+    group.bench_function("flush_batch_draw_dirty_4", |b| {
+        b.iter(|| {
+            for i in 0..4 {
+                app.mark_dirty(i * 150, i * 100, i * 150 + 31, i * 100 + 31);
+            }
+            black_box(app.flush_batch_draw_dirty())
+        })
+    });
+    group.bench_function("present_frame_dirty_unpaced", |b| {
+        app.set_target_fps(0.0);
+        app.set_vsync(false);
+        b.iter(|| {
+            app.mark_dirty(0, 0, 63, 63);
+            app.present_frame_dirty()
+        })
+    });
+
+    group.finish();
+
+    app.end_batch_draw();
+    bench.offscreen();
+}
+
+fn messages(c: &mut Criterion, bench: &Bench) {
+    let app = &bench.app;
+    let hwnd = app.graphics_hwnd() as *mut std::ffi::c_void;
+
+    // 投递一批按键消息，计时从投递完成到全部取出为止
+    let measure = |iters: u64, take: &mut dyn FnMut() -> usize| {
+        let mut total = Duration::ZERO;
+        for _ in 0..iters {
+            app.flush_messages(MessageFilter::All);
+            for _ in 0..MESSAGE_BATCH {
+                unsafe {
+                    PostMessageW(hwnd, WM_KEYDOWN, VK_SPACE, 1);
+                }
+            }
+
+            let start = Instant::now();
+            let deadline = start + Duration::from_millis(100);
+            let mut received = 0;
+            while received < MESSAGE_BATCH && Instant::now() < deadline {
+                received += take();
+            }
+            total += start.elapsed();
+        }
+        total
+    };
+
+    let mut group = c.benchmark_group("messages");
+    group.throughput(Throughput::Elements(MESSAGE_BATCH as u64));
+
+    group.bench_function("peek_message", |b| {
+        b.iter_custom(|iters| {
+            measure(iters, &mut || {
+                let mut count = 0;
+                while app.peek_message(MessageFilter::KeyBoard, true).is_some() {
+                    count += 1;
+                }
+                count
+            })
+        })
+    });
+
+    let mut buffer = MessageBuffer::new(MESSAGE_BATCH);
+    group.bench_function("message_buffer_drain", |b| {
+        b.iter_custom(|iters| {
+            measure(iters, &mut || {
+                buffer.drain(MessageFilter::KeyBoard).map(black_box).count()
+            })
+        })
+    });
+
+    group.finish();
+}
+
+fn wrapper(c: &mut Criterion) {
+    let bench = Bench::new();
+    bench.write_metadata().expect("无法写入环境信息");
+
+    primitives(c, &bench);
+    text(c, &bench);
+    images(c, &bench);
+    flush(c, &bench);
+    messages(c, &bench);
+}
+
+criterion_group!(benches, wrapper);
+criterion_main!(benches);
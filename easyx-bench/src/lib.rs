@@ -0,0 +1,159 @@
+//! # easyx-bench
+//!
+//! EasyX 包装层热点路径的基准测试的公共部分。
+//!
+//! 基准测试在离屏 `Image` 上绘制（通过 `easyx_setworkingimage` 切换工作图像），
+//! 只有刷新和消息相关的测试才会用到窗口本身。
+//!
+//! ## 结果
+//! criterion 会把每项测试的统计结果写入 `target/criterion/<组>/<测试>/new/estimates.json`，
+//! 同时写入 `target/criterion/easyx-bench.json` 记录 EasyX 版本、光栅化级别等环境信息，
+//! 用于在 EasyX 版本或包装层改动之间对比结果。
+//!
+//! easyx-bench 是独立的工作区（被主工作区 `exclude`），需要在本目录中运行：
+//!
+//! ```bash
+//! cd easyx-bench
+//! cargo bench -- --save-baseline before
+//! # 修改包装层或升级 EasyX 后
+//! cargo bench -- --baseline before
+//! ```
+
+use std::fs;
+use std::io;
+use std::path::PathBuf;
+
+use easyx::prelude::*;
+
+/// 基准测试窗口宽度
+pub const WIDTH: i32 = 640;
+
+/// 基准测试窗口高度
+pub const HEIGHT: i32 = 480;
+
+/// 基准测试环境
+///
+/// 持有图形窗口和一张与窗口同样大小的离屏图像，创建后工作图像为离屏图像
+pub struct Bench {
+    /// 图形窗口
+    pub app: App,
+
+    /// 离屏绘制目标
+    pub target: Image,
+
+    assets: PathBuf,
+}
+
+impl Bench {
+    /// 创建基准测试环境
+    ///
+    /// 打开图形窗口，创建离屏图像并设为工作图像
+    ///
+    /// # 返回值
+    /// 新创建的 Bench 对象
+    pub fn new() -> Self {
+        let app = App::new(WIDTH, HEIGHT, InitFlags::None);
+        let target = Image::new(WIDTH, HEIGHT);
+
+        let assets = target_dir().join("easyx-bench-assets");
+        let bench = Self {
+            app,
+            target,
+            assets,
+        };
+
+        bench.offscreen();
+        bench
+    }
+
+    /// 将工作图像切换为离屏图像
+    pub fn offscreen(&self) {
+        self.target.set_working_image();
+    }
+
+    /// 将工作图像切换为窗口
+    pub fn onscreen(&self) {
+        Image::reset_working_image();
+    }
+
+    /// 生成一张带渐变内容的测试图像
+    ///
+    /// # 参数
+    /// - `width`: 图像宽度
+    /// - `height`: 图像高度
+    ///
+    /// # 返回值
+    /// 生成的图像，内容与设备状态无关
+    pub fn pattern(&self, width: i32, height: i32) -> Image {
+        let image = Image::new(width, height);
+        let buffer = image.buffer();
+
+        for y in 0..height {
+            for x in 0..width {
+                let r = (x * 255 / width.max(1)) as u32;
+                let g = (y * 255 / height.max(1)) as u32;
+                let b = ((x ^ y) & 0xFF) as u32;
+                unsafe {
+                    *buffer.add((y * width + x) as usize) = (r << 16) | (g << 8) | b;
+                }
+            }
+        }
+
+        image
+    }
+
+    /// 将测试图像保存为文件并返回路径
+    ///
+    /// # 参数
+    /// - `name`: 文件名，扩展名决定保存格式（bmp/png/jpg）
+    /// - `width`: 图像宽度
+    /// - `height`: 图像高度
+    ///
+    /// # 返回值
+    /// 保存后的文件路径
+    pub fn asset(&self, name: &str, width: i32, height: i32) -> io::Result<String> {
+        fs::create_dir_all(&self.assets)?;
+
+        let path = self.assets.join(name);
+        let path = path.to_string_lossy().into_owned();
+        self.pattern(width, height)
+            .save(&path)
+            .map_err(io::Error::other)?;
+
+        Ok(path)
+    }
+
+    /// 写入本次运行的环境信息
+    ///
+    /// 输出到 `target/criterion/easyx-bench.json`，便于区分不同 EasyX 版本和包装层配置下的结果
+    pub fn write_metadata(&self) -> io::Result<()> {
+        let dir = target_dir().join("criterion");
+        fs::create_dir_all(&dir)?;
+
+        let json = format!(
+            "{{\n  \"easyx_version\": \"{}\",\n  \"raster_supported\": \"{:?}\",\n  \"raster_level\": \"{:?}\",\n  \"profiler\": {},\n  \"width\": {},\n  \"height\": {}\n}}\n",
+            self.app.version(),
+            self.app.raster_supported_level(),
+            self.app.raster_level(),
+            Profiler::available(),
+            WIDTH,
+            HEIGHT
+        );
+
+        fs::write(dir.join("easyx-bench.json"), json)
+    }
+}
+
+impl Default for Bench {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+// 与 criterion 一致：优先使用 CARGO_TARGET_DIR，否则使用本工作区的 target 目录
+fn target_dir() -> PathBuf {
+    match std::env::var_os("CARGO_TARGET_DIR") {
+        Some(dir) => PathBuf::from(dir),
+        None => PathBuf::from(env!("CARGO_MANIFEST_DIR")).join("target"),
+    }
+}
@@ -1,14 +1,22 @@
+use std::sync::OnceLock;
+use std::time::{Duration, Instant};
+
 use easyx_sys::*;
 use windows_sys::Win32::Foundation::HWND;
 
 use crate::color::Color;
+use crate::coords::Coords;
 use crate::enums::BkMode;
+use crate::enums::Rop2;
 use crate::enums::DrawTextFormat;
 use crate::fillstyle::FillStyle;
+use crate::image::{LoadProgress, PixelFormat, pixel_stride, wake_finished_loads};
 use crate::input::InputBox;
 use crate::linestyle::LineStyle;
 use crate::logfont::LogFont;
-use crate::msg::{ExMessage, MessageFilter};
+use crate::msg::{ExMessage, MessageFilter, WaitResult, WakeHandle};
+use crate::parallel::{self, RenderTile};
+use crate::scheduler::{MainSender, Scheduler, TaskContext, TaskHandle};
 
 /// RECT结构体，用于draw_text函数
 #[repr(C)]
@@ -42,6 +50,7 @@ pub struct App {
     width: i32,
     height: i32,
     hwnd: HWND,
+    scheduler: OnceLock<Scheduler>,
 }
 
 impl App {
@@ -63,9 +72,42 @@ impl App {
             width,
             height,
             hwnd: hwnd as HWND,
+            scheduler: OnceLock::new(),
+        }
+    }
+
+    /// 创建一个不创建窗口的 EasyX 图形应用实例（无窗口模式）。
+    ///
+    /// 只创建一块离屏画布并设为工作图像，绘图函数照常使用，`Image::reset_working_image`
+    /// 回到画布。批量绘图不再刷新到窗口，消息函数不返回消息，呈现线程无法启动。
+    /// 画布属于当前进程，多个进程可以同时渲染互不影响，适合在服务器上生成图像和并行运行图像比较测试。
+    ///
+    /// # 参数
+    ///
+    /// * `width` - 画布的宽度。
+    /// * `height` - 画布的高度。
+    ///
+    /// # 返回值
+    ///
+    /// 一个新的 `App` 实例，窗口句柄为空。
+    pub fn headless(width: i32, height: i32) -> Self {
+        unsafe {
+            easyx_initheadless(width, height);
+        }
+
+        Self {
+            width,
+            height,
+            hwnd: std::ptr::null_mut(),
+            scheduler: OnceLock::new(),
         }
     }
 
+    /// 是否处于无窗口模式。
+    pub fn is_headless(&self) -> bool {
+        unsafe { !easyx_getcanvas().is_null() }
+    }
+
     /// 初始化图形窗口并运行提供的闭包。
     ///
     /// 此方法初始化图形窗口，运行提供的闭包，并确保窗口在完成后正确关闭。
@@ -388,6 +430,65 @@ impl App {
     }
 }
 
+/// 绘图状态缓存的统计信息
+#[derive(Debug, Clone, Copy, Default, PartialEq, Eq, Hash)]
+pub struct StateCacheStats {
+    /// 与缓存一致而被跳过的状态设置次数
+    pub hits: u64,
+    /// 实际下发给 EasyX 的状态设置次数
+    pub misses: u64,
+}
+
+impl App {
+    /// 启用或禁用绘图状态缓存。
+    ///
+    /// 启用后，包装层会按当前工作图像记录颜色、背景模式、线条样式和填充样式，
+    /// 重复设置相同的值时直接跳过，避免重复创建 GDI 画笔和画刷。默认启用。
+    ///
+    /// # 参数
+    /// * `enabled` - 是否启用状态缓存。
+    pub fn set_state_cache_enabled(&self, enabled: bool) {
+        unsafe {
+            easyx_statecache_setenabled(enabled as i32);
+        }
+    }
+
+    /// 绘图状态缓存是否启用。
+    pub fn state_cache_enabled(&self) -> bool {
+        unsafe { easyx_statecache_getenabled() != 0 }
+    }
+
+    /// 使绘图状态缓存失效。
+    ///
+    /// 通过图像的 HDC 直接修改了 GDI 状态后，需要调用此方法，
+    /// 确保后续的状态设置都会下发给 EasyX。
+    pub fn invalidate_state_cache(&self) {
+        unsafe {
+            easyx_statecache_invalidate();
+        }
+    }
+
+    /// 获取绘图状态缓存的命中统计。
+    ///
+    /// # 返回值
+    /// 当前的命中和未命中次数。
+    pub fn state_cache_stats(&self) -> StateCacheStats {
+        let mut stats = StateCacheStats::default();
+
+        unsafe {
+            easyx_statecache_getstats(&mut stats.hits, &mut stats.misses);
+        }
+        stats
+    }
+
+    /// 清零绘图状态缓存的命中统计。
+    pub fn reset_state_cache_stats(&self) {
+        unsafe {
+            easyx_statecache_resetstats();
+        }
+    }
+}
+
 impl App {
     /// 绘制直线。
     ///
@@ -860,6 +961,105 @@ impl App {
             easyx_polybezier(points.as_ptr() as _, points.len() as i32);
         }
     }
+
+    /// 使用借用的顶点缓冲区绘制折线。
+    ///
+    /// 与 `poly_line` 相同，但接受元组、数组或分开存放的坐标，不需要先转换为 `POINT`。
+    ///
+    /// # 参数
+    /// * `coords` - 折线的顶点，见 `Coords`。
+    pub fn poly_line_coords<'a>(&self, coords: impl Into<Coords<'a>>) {
+        let c = coords.into();
+        unsafe {
+            easyx_polyline_strided(c.x_ptr(), c.y_ptr(), c.stride(), c.kind(), c.count());
+        }
+    }
+
+    /// 使用借用的顶点缓冲区绘制多边形。
+    ///
+    /// # 参数
+    /// * `coords` - 多边形的顶点，见 `Coords`。
+    pub fn poly_gon_coords<'a>(&self, coords: impl Into<Coords<'a>>) {
+        let c = coords.into();
+        unsafe {
+            easyx_polygon_strided(c.x_ptr(), c.y_ptr(), c.stride(), c.kind(), c.count());
+        }
+    }
+
+    /// 使用借用的顶点缓冲区绘制填充多边形。
+    ///
+    /// # 参数
+    /// * `coords` - 多边形的顶点，见 `Coords`。
+    pub fn fill_polygon_coords<'a>(&self, coords: impl Into<Coords<'a>>) {
+        let c = coords.into();
+        unsafe {
+            easyx_fillpolygon_strided(c.x_ptr(), c.y_ptr(), c.stride(), c.kind(), c.count());
+        }
+    }
+
+    /// 使用借用的顶点缓冲区绘制实心多边形。
+    ///
+    /// # 参数
+    /// * `coords` - 多边形的顶点，见 `Coords`。
+    pub fn solid_polygon_coords<'a>(&self, coords: impl Into<Coords<'a>>) {
+        let c = coords.into();
+        unsafe {
+            easyx_solidpolygon_strided(c.x_ptr(), c.y_ptr(), c.stride(), c.kind(), c.count());
+        }
+    }
+
+    /// 一次绘制多条折线。
+    ///
+    /// 所有折线的顶点连续存放在 `coords` 中，第 `i` 条折线由顶点 `offsets[i]..offsets[i + 1]` 组成，
+    /// 适合一次绘制图表的全部数据系列。顶点不足两个的折线被跳过。
+    ///
+    /// # 参数
+    /// * `coords` - 所有折线的顶点，见 `Coords`。
+    /// * `offsets` - 每条折线起始顶点的编号，最后一项为结束位置，因此比折线数多一项。
+    ///
+    /// # 示例
+    /// ```no_run
+    /// use easyx::prelude::*;
+    /// use easyx::run;
+    ///
+    /// fn main() -> Result<(), Box<dyn std::error::Error>> {
+    ///     run(800, 600, |app| {
+    ///         let mut points: Vec<[f32; 2]> = Vec::new();
+    ///         let mut offsets = vec![0];
+    ///         for series in 0..8 {
+    ///             points.extend((0..800).map(|x| [x as f32, 50.0 + series as f32 * 70.0 + (x as f32 / 30.0).sin() * 20.0]));
+    ///             offsets.push(points.len() as i32);
+    ///         }
+    ///         app.poly_lines(&points, &offsets);
+    ///         Ok(())
+    ///     })
+    /// }
+    /// ```
+    pub fn poly_lines<'a>(&self, coords: impl Into<Coords<'a>>, offsets: &[i32]) {
+        let c = coords.into();
+        let Some(&last) = offsets.last() else {
+            return;
+        };
+        assert!(
+            offsets.windows(2).all(|w| w[0] <= w[1]) && offsets[0] >= 0,
+            "offsets 必须从非负数开始单调不减"
+        );
+        assert!(last as usize <= c.len(), "offsets 超出顶点数");
+        if offsets.len() < 2 {
+            return;
+        }
+
+        unsafe {
+            easyx_polylines(
+                c.x_ptr(),
+                c.y_ptr(),
+                c.stride(),
+                c.kind(),
+                offsets.as_ptr(),
+                (offsets.len() - 1).min(i32::MAX as usize) as i32,
+            );
+        }
+    }
 }
 
 /// 区域填充类型。
@@ -899,10 +1099,8 @@ impl App {
     /// * `y` - 文本输出的y坐标。
     /// * `text` - 要输出的文本。
     pub fn out_text(&self, x: i32, y: i32, text: &str) {
-        use std::ffi::CString;
         unsafe {
-            let c_str = CString::new(text).expect("Failed to create C string");
-            easyx_outtextxy(x, y, c_str.as_ptr());
+            easyx_outtextxy_n(x, y, text.as_ptr().cast(), text.len());
         }
     }
 
@@ -930,11 +1128,7 @@ impl App {
     /// # 返回值
     /// 文本的宽度，以像素为单位。
     pub fn text_width(&self, text: &str) -> i32 {
-        use std::ffi::CString;
-        unsafe {
-            let c_str = CString::new(text).expect("Failed to create C string");
-            easyx_textwidth(c_str.as_ptr())
-        }
+        unsafe { easyx_textwidth_n(text.as_ptr().cast(), text.len()) }
     }
 
     /// 获取单个字符的宽度。
@@ -960,11 +1154,7 @@ impl App {
     /// # 返回值
     /// 文本的高度，以像素为单位。
     pub fn text_height(&self, text: &str) -> i32 {
-        use std::ffi::CString;
-        unsafe {
-            let c_str = CString::new(text).expect("Failed to create C string");
-            easyx_textheight(c_str.as_ptr())
-        }
+        unsafe { easyx_textheight_n(text.as_ptr().cast(), text.len()) }
     }
 
     /// 获取单个字符的高度。
@@ -992,12 +1182,13 @@ impl App {
     /// # 返回值
     /// 实际绘制的文本高度，以像素为单位。
     pub fn draw_text(&self, str: &str, mut rect: RECT, format: DrawTextFormat) -> i32 {
-        use std::ffi::CString;
-
         unsafe {
-            let c_str = CString::new(str).expect("Failed to create C string");
-
-            easyx_drawtext(c_str.as_ptr(), &mut rect as *mut _ as *mut _, format.bits())
+            easyx_drawtext_n(
+                str.as_ptr().cast(),
+                str.len(),
+                &mut rect as *mut _ as *mut _,
+                format.bits(),
+            )
         }
     }
 
@@ -1244,79 +1435,1605 @@ impl App {
             easyx_endbatchdraw_rect(left, top, right, bottom);
         }
     }
-}
 
-impl App {
-    /// 创建输入框
+    /// 只刷新批处理期间改变过的区域
     ///
-    /// 创建一个输入框，用于获取用户输入
+    /// 批处理期间绘制到窗口的每个图元都会记录外接矩形，并合并为少量矩形，
+    /// 此方法只把这些区域刷新到屏幕上。画面大部分静止时可以显著减少刷新开销。
+    /// 清屏、区域填充等无法确定范围的操作会使整个窗口刷新。
+    ///
+    /// 记录范围有额外开销（文本需要多测量一次），因此跟踪默认关闭，
+    /// 第一次调用此方法时开启，这一次刷新整个窗口。
+    ///
+    /// # 注意
+    /// 通过 `Image::buffer` 直接修改窗口缓冲区时，需要调用 `mark_dirty` 登记修改的区域
+    ///
+    /// # 返回值
+    /// 刷新的矩形数量，0 表示没有需要刷新的区域
+    ///
+    /// # 示例
+    /// ```no_run
+    /// use easyx::prelude::*;
+    /// use easyx::run;
+    ///
+    /// fn main() -> Result<(), Box<dyn std::error::Error>> {
+    ///     run(800, 600, |app| {
+    ///         app.begin_batch_draw();
+    ///         app.clear_device();
+    ///         app.flush_batch_draw();
+    ///
+    ///         for x in 0..100 {
+    ///             app.solid_rectangle(x * 4, 100, x * 4 + 20, 120);
+    ///             app.flush_batch_draw_dirty();
+    ///         }
+    ///
+    ///         app.end_batch_draw();
+    ///         Ok(())
+    ///     })
+    /// }
+    /// ```
+    pub fn flush_batch_draw_dirty(&self) -> usize {
+        unsafe { easyx_flushbatchdraw_dirty() as usize }
+    }
+
+    /// 开启或关闭脏矩形跟踪
+    ///
+    /// `flush_batch_draw_dirty` 会自动开启跟踪，不再使用局部刷新时可以关闭以省去记录的开销。
+    /// 开启时之前的绘制没有记录，下一次局部刷新会刷新整个窗口
     ///
     /// # 参数
-    /// - `max`: 最大输入字符数
-    /// - `prompt`: 提示文本
+    /// - `enabled`: 是否记录批处理期间的绘制范围
+    pub fn set_dirty_tracking(&self, enabled: bool) {
+        unsafe {
+            easyx_dirty_enable(enabled as i32);
+        }
+    }
+
+    /// 脏矩形跟踪是否已开启
+    pub fn dirty_tracking(&self) -> bool {
+        unsafe { easyx_dirty_isenabled() != 0 }
+    }
+
+    /// 登记需要刷新的区域
+    ///
+    /// # 参数
+    /// - `left`: 区域左上角x坐标（设备坐标）
+    /// - `top`: 区域左上角y坐标（设备坐标）
+    /// - `right`: 区域右下角x坐标（包含）
+    /// - `bottom`: 区域右下角y坐标（包含）
+    pub fn mark_dirty(&self, left: i32, top: i32, right: i32, bottom: i32) {
+        unsafe {
+            easyx_dirty_add(left, top, right, bottom);
+        }
+    }
+
+    /// 登记整个窗口都需要刷新
+    pub fn mark_all_dirty(&self) {
+        unsafe {
+            easyx_dirty_markall();
+        }
+    }
+
+    /// 设置脏矩形的合并阈值
+    ///
+    /// 两个矩形的外接矩形面积不超过二者面积之和的 `ratio` 倍时合并为一个。
+    /// 阈值越大刷新次数越少，但刷新的面积越大。默认为 1.5
+    ///
+    /// # 参数
+    /// - `ratio`: 合并阈值，非正数表示恢复默认值
+    pub fn set_dirty_merge_threshold(&self, ratio: f32) {
+        unsafe {
+            easyx_dirty_setmergethreshold(ratio);
+        }
+    }
+
+    /// 获取当前记录的脏矩形
     ///
     /// # 返回值
-    /// 输入框对象
-    pub fn input_box(&self, max: i32, prompt: &str) -> InputBox {
-        InputBox::new(max, prompt)
+    /// 脏矩形数组，每个元素为 `[left, top, right, bottom]`，右下边界包含在内
+    pub fn dirty_rects(&self) -> Vec<[i32; 4]> {
+        let mut rects = vec![[0i32; 4]; EASYX_DIRTY_MAX_RECTS as usize];
+        let count = unsafe { easyx_dirty_getrects(rects.as_mut_ptr().cast(), rects.len() as i32) };
+
+        rects.truncate(count.max(0) as usize);
+        rects
+    }
+}
+
+/// 帧调度的统计信息
+///
+/// 由 `App::present_frame` 在每帧提交后更新
+#[derive(Debug, Clone, Copy, Default, PartialEq)]
+pub struct FrameStats {
+    /// 上一帧提交完成到本帧调用 `present_frame` 的时间，即本帧的计算和绘制时间
+    pub cpu: Duration,
+    /// 为对齐提交时刻而等待的时间
+    pub wait: Duration,
+    /// 刷新批处理绘图（启用垂直同步时包括等待 DWM 合成）的时间
+    pub present: Duration,
+    /// 整帧时间
+    pub frame: Duration,
+    /// 已提交的帧数
+    pub frame_index: u64,
+    /// 调用 `present_frame` 时已经错过提交时刻的帧数
+    pub missed_frames: u64,
+}
+
+impl From<&EasyXFrameStats> for FrameStats {
+    fn from(stats: &EasyXFrameStats) -> Self {
+        let ms = |v: f64| Duration::from_secs_f64(v.max(0.0) / 1000.0);
+
+        Self {
+            cpu: ms(stats.cpuMs),
+            wait: ms(stats.waitMs),
+            present: ms(stats.presentMs),
+            frame: ms(stats.frameMs),
+            frame_index: stats.frameIndex,
+            missed_frames: stats.missedFrames,
+        }
     }
 }
 
 impl App {
-    /// 设置鼠标捕获
+    /// 设置目标帧率。
     ///
-    /// 设置鼠标捕获，使当前窗口接收所有鼠标事件
-    pub fn set_capture(&self) {
+    /// `present_frame` 会等待到按目标帧率计算出的提交时刻再刷新画面。
+    /// 等待使用高精度可等待计时器，最后不足一毫秒的部分自旋等待，比 `Sleep` 精确得多。
+    ///
+    /// # 参数
+    /// * `fps` - 目标帧率，0 表示不限制帧率。
+    pub fn set_target_fps(&self, fps: f64) {
         unsafe {
-            easyx_setcapture();
+            easyx_frame_settargetfps(fps);
         }
     }
 
-    /// 释放鼠标捕获
+    /// 获取目标帧率，0 表示不限制帧率。
+    pub fn target_fps(&self) -> f64 {
+        unsafe { easyx_frame_gettargetfps() }
+    }
+
+    /// 启用或禁用垂直同步。
     ///
-    /// 释放之前设置的鼠标捕获
-    pub fn release_capture(&self) {
+    /// 启用后每帧刷新画面后会等待 DWM 完成下一次合成，使提交与显示器刷新对齐。
+    ///
+    /// # 参数
+    /// * `enabled` - 是否启用垂直同步。
+    pub fn set_vsync(&self, enabled: bool) {
         unsafe {
-            easyx_releasecapture();
+            easyx_frame_setvsync(enabled as i32);
         }
     }
 
-    /// 获取消息（阻塞）
+    /// 是否启用垂直同步。
+    pub fn vsync(&self) -> bool {
+        unsafe { easyx_frame_getvsync() != 0 }
+    }
+
+    /// 重新开始帧计时并清零统计信息。
     ///
-    /// 获取消息队列中的消息，阻塞直到有消息可用
+    /// `begin_batch_draw` 会自动调用此方法。
+    pub fn reset_frame_clock(&self) {
+        unsafe {
+            easyx_frame_reset();
+        }
+    }
+
+    /// 按帧节奏提交一帧。
     ///
-    /// # 参数
-    /// - `filter`: 消息过滤类型
+    /// 等待到本帧的提交时刻后调用 `flush_batch_draw` 刷新画面，需要在批处理绘图模式下使用。
+    /// 错过提交时刻时不等待，落后超过一帧时重新对齐节奏。
     ///
     /// # 返回值
-    /// 捕获到的消息
-    pub fn get_message(&self, filter: MessageFilter) -> ExMessage {
-        ExMessage::get_message(filter)
+    /// 本帧的统计信息。
+    ///
+    /// # 示例
+    /// ```no_run
+    /// use easyx::prelude::*;
+    /// use easyx::run;
+    ///
+    /// fn main() -> Result<(), Box<dyn std::error::Error>> {
+    ///     run(800, 600, |app| {
+    ///         app.set_target_fps(60.0);
+    ///         app.begin_batch_draw();
+    ///
+    ///         for _ in 0..600 {
+    ///             app.clear_device();
+    ///             // 绘制...
+    ///             let stats = app.present_frame();
+    ///             println!("cpu: {:?}, frame: {:?}", stats.cpu, stats.frame);
+    ///         }
+    ///
+    ///         app.end_batch_draw();
+    ///         Ok(())
+    ///     })
+    /// }
+    /// ```
+    pub fn present_frame(&self) -> FrameStats {
+        unsafe {
+            easyx_frame_present(0);
+        }
+        self.frame_stats()
     }
 
-    /// 查看消息（非阻塞）
+    /// 按帧节奏提交一帧，只刷新改变过的区域。
     ///
-    /// 查看消息队列中的消息，非阻塞，如果没有消息则返回None
+    /// 与 `present_frame` 相同，但使用 `flush_batch_draw_dirty` 刷新画面。
     ///
-    /// # 参数
-    /// - `filter`: 消息过滤类型
-    /// - `removemsg`: 是否从消息队列中移除消息
+    /// # 返回值
+    /// 本帧的统计信息。
+    pub fn present_frame_dirty(&self) -> FrameStats {
+        unsafe {
+            easyx_frame_present(1);
+        }
+        self.frame_stats()
+    }
+
+    /// 获取最近一帧的统计信息。
+    pub fn frame_stats(&self) -> FrameStats {
+        let mut stats = unsafe { std::mem::zeroed::<EasyXFrameStats>() };
+
+        unsafe {
+            easyx_frame_getstats(&mut stats);
+        }
+        FrameStats::from(&stats)
+    }
+
+    /// 获取距本帧提交时刻的剩余时间。
+    ///
+    /// 用于在提交前把剩余的时间分配给其他工作，见 `run_main_tasks_in_frame`。
     ///
     /// # 返回值
-    /// 如果有消息则返回Some(ExMessage)，否则返回None
-    pub fn peek_message(&self, filter: MessageFilter, removemsg: bool) -> Option<ExMessage> {
-        ExMessage::peek_message(filter, removemsg)
+    /// 剩余时间，已错过提交时刻时为 0，不限帧率时返回 None。
+    pub fn frame_time_remaining(&self) -> Option<Duration> {
+        let ms = unsafe { easyx_frame_getremaining() };
+        if ms < 0.0 {
+            None
+        } else {
+            Some(Duration::from_secs_f64(ms / 1000.0))
+        }
     }
+}
 
-    /// 刷新消息队列
+impl App {
+    /// 获取 App 持有的工作窃取线程池。
     ///
-    /// 刷新指定类型的消息队列，处理所有待处理的消息
+    /// 第一次调用时创建，工作线程数为 CPU 核心数减一，App 销毁时停止。
+    pub fn scheduler(&self) -> &Scheduler {
+        self.scheduler.get_or_init(|| Scheduler::new(0))
+    }
+
+    /// 提交后台任务。
+    ///
+    /// 任务在工作线程上执行，不能调用 EasyX 的函数，
+    /// 需要绘图时通过 `TaskContext::post` 把闭包发回绘图线程。
     ///
     /// # 参数
-    /// - `filter`: 消息过滤类型
-    pub fn flush_messages(&self, filter: MessageFilter) {
-        unsafe {
-            easyx_flushmessage(filter as u8);
+    /// * `f` - 任务闭包。
+    ///
+    /// # 返回值
+    /// 任务句柄，用于获取结果。
+    ///
+    /// # 示例
+    /// ```no_run
+    /// use std::time::Duration;
+    ///
+    /// use easyx::prelude::*;
+    /// use easyx::run;
+    ///
+    /// fn main() -> Result<(), Box<dyn std::error::Error>> {
+    ///     run(800, 600, |app| {
+    ///         app.set_target_fps(60.0);
+    ///         app.begin_batch_draw();
+    ///
+    ///         let path = app.spawn(|ctx| {
+    ///             // 耗时的寻路计算...
+    ///             let path = vec![(10, 10), (200, 100), (400, 300)];
+    ///             let points = path.clone();
+    ///             ctx.post(move |app| {
+    ///                 for &(x, y) in &points {
+    ///                     app.fill_circle(x, y, 4);
+    ///                 }
+    ///             });
+    ///             path
+    ///         });
+    ///
+    ///         while !path.is_done() {
+    ///             // 绘制...
+    ///             app.run_main_tasks_in_frame(Duration::from_millis(2));
+    ///             app.present_frame();
+    ///         }
+    ///
+    ///         app.end_batch_draw();
+    ///         Ok(())
+    ///     })
+    /// }
+    /// ```
+    pub fn spawn<T, F>(&self, f: F) -> TaskHandle<T>
+    where
+        F: FnOnce(&TaskContext) -> T + Send + 'static,
+        T: Send + 'static,
+    {
+        self.scheduler().spawn(f)
+    }
+
+    /// 获取向绘图线程发送闭包的句柄，可以移动到任意线程。
+    pub fn main_sender(&self) -> MainSender {
+        self.scheduler().main_sender()
+    }
+
+    /// 执行后台任务发回绘图线程的闭包，直到队列为空或超出时间预算。
+    ///
+    /// 至少执行一个闭包，执行期间新发回的闭包留到下一次调用。
+    ///
+    /// # 参数
+    /// * `budget` - 时间预算。
+    ///
+    /// # 返回值
+    /// 执行的闭包数。
+    pub fn run_main_tasks(&self, budget: Duration) -> usize {
+        match self.scheduler.get() {
+            Some(scheduler) => scheduler.run_main(self, Some(budget)),
+            None => 0,
+        }
+    }
+
+    /// 用本帧剩余的时间执行发回绘图线程的闭包。
+    ///
+    /// 预算为距本帧提交时刻的剩余时间减去 `reserve`，使 `present_frame` 不会错过提交时刻。
+    /// 不限帧率时执行调用时已在队列中的全部闭包。
+    ///
+    /// # 参数
+    /// * `reserve` - 为本帧之后的绘制保留的时间。
+    ///
+    /// # 返回值
+    /// 执行的闭包数。
+    pub fn run_main_tasks_in_frame(&self, reserve: Duration) -> usize {
+        let Some(scheduler) = self.scheduler.get() else {
+            return 0;
+        };
+        let budget = self
+            .frame_time_remaining()
+            .map(|remaining| remaining.saturating_sub(reserve));
+        scheduler.run_main(self, budget)
+    }
+}
+
+/// 软件光栅化内核级别
+///
+/// 由 CPU 特性检测决定默认使用的最高级别
+#[derive(Debug, Clone, Copy, PartialEq, Eq, PartialOrd, Ord, Hash)]
+pub enum RasterLevel {
+    /// 标量内核
+    Scalar,
+    /// SSE2 内核，每次写入 4 个像素
+    Sse2,
+    /// AVX2 内核，每次写入 8 个像素
+    Avx2,
+}
+
+impl RasterLevel {
+    /// 将 RasterLevel 转换为 i32
+    pub fn as_i32(&self) -> i32 {
+        match self {
+            Self::Scalar => EASYX_RASTER_SCALAR as i32,
+            Self::Sse2 => EASYX_RASTER_SSE2 as i32,
+            Self::Avx2 => EASYX_RASTER_AVX2 as i32,
+        }
+    }
+}
+
+impl From<i32> for RasterLevel {
+    /// 从 i32 转换为 RasterLevel，未知的级别视为标量内核
+    fn from(level: i32) -> Self {
+        match level as u32 {
+            EASYX_RASTER_AVX2 => Self::Avx2,
+            EASYX_RASTER_SSE2 => Self::Sse2,
+            _ => Self::Scalar,
+        }
+    }
+}
+
+impl App {
+    /// 获取 CPU 支持的最高软件光栅化内核级别
+    pub fn raster_supported_level(&self) -> RasterLevel {
+        unsafe { easyx_raster_getsupported().into() }
+    }
+
+    /// 获取当前使用的软件光栅化内核级别
+    pub fn raster_level(&self) -> RasterLevel {
+        unsafe { easyx_raster_getlevel().into() }
+    }
+
+    /// 设置软件光栅化内核级别
+    ///
+    /// 超出 CPU 支持范围的级别会被降为支持的最高级别，主要用于对比测试
+    ///
+    /// # 参数
+    /// - `level`: 期望的内核级别
+    ///
+    /// # 返回值
+    /// 实际使用的内核级别
+    pub fn set_raster_level(&self, level: RasterLevel) -> RasterLevel {
+        unsafe { easyx_raster_setlevel(level.as_i32()).into() }
+    }
+
+    /// 使用软件光栅化清空当前工作图像
+    ///
+    /// 以下 `raster_*` 方法直接写入当前工作图像的像素缓冲区，不经过 GDI，
+    /// 适合每帧大量绘制小的填充图形。
+    ///
+    /// # 注意
+    /// - 坐标为设备像素坐标，不受 `set_origin` 和裁剪区域影响
+    /// - 绘制到窗口时需要配合批处理绘图，在 `flush_batch_draw` 后才会显示
+    ///
+    /// # 参数
+    /// - `color`: 填充颜色
+    pub fn raster_clear(&self, color: &Color) {
+        unsafe {
+            easyx_raster_clear(color.as_colorref());
+        }
+    }
+
+    /// 使用软件光栅化绘制水平线段，包含两端像素
+    ///
+    /// # 参数
+    /// - `x1`: 起点x坐标
+    /// - `x2`: 终点x坐标
+    /// - `y`: y坐标
+    /// - `color`: 线段颜色
+    pub fn raster_hline(&self, x1: i32, x2: i32, y: i32, color: &Color) {
+        unsafe {
+            easyx_raster_hline(x1, x2, y, color.as_colorref());
+        }
+    }
+
+    /// 使用软件光栅化绘制 1 像素宽的矩形边框
+    ///
+    /// # 参数
+    /// - `left`: 矩形左边界x坐标
+    /// - `top`: 矩形上边界y坐标
+    /// - `right`: 矩形右边界x坐标（包含）
+    /// - `bottom`: 矩形下边界y坐标（包含）
+    /// - `color`: 边框颜色
+    pub fn raster_rectangle(&self, left: i32, top: i32, right: i32, bottom: i32, color: &Color) {
+        unsafe {
+            easyx_raster_rectangle(left, top, right, bottom, color.as_colorref());
+        }
+    }
+
+    /// 使用软件光栅化填充矩形
+    ///
+    /// # 参数
+    /// - `left`: 矩形左边界x坐标
+    /// - `top`: 矩形上边界y坐标
+    /// - `right`: 矩形右边界x坐标（包含）
+    /// - `bottom`: 矩形下边界y坐标（包含）
+    /// - `color`: 填充颜色
+    pub fn raster_fill_rect(&self, left: i32, top: i32, right: i32, bottom: i32, color: &Color) {
+        unsafe {
+            easyx_raster_fillrect(left, top, right, bottom, color.as_colorref());
+        }
+    }
+
+    /// 使用软件光栅化以同一颜色填充多个矩形
+    ///
+    /// 一次调用完成所有矩形的填充，只跨越一次 FFI 边界
+    ///
+    /// # 参数
+    /// - `rects`: 矩形数组，每个元素为 `[left, top, right, bottom]`，右下边界包含在内
+    /// - `color`: 填充颜色
+    pub fn raster_fill_rects(&self, rects: &[[i32; 4]], color: &Color) {
+        unsafe {
+            easyx_raster_fillrects(rects.as_ptr().cast(), rects.len(), color.as_colorref());
+        }
+    }
+
+    /// 使用软件光栅化填充圆
+    ///
+    /// # 参数
+    /// - `x`: 圆心x坐标
+    /// - `y`: 圆心y坐标
+    /// - `radius`: 半径
+    /// - `color`: 填充颜色
+    pub fn raster_fill_circle(&self, x: i32, y: i32, radius: i32, color: &Color) {
+        unsafe {
+            easyx_raster_fillcircle(x, y, radius, color.as_colorref());
+        }
+    }
+
+    /// 使用软件光栅化填充椭圆
+    ///
+    /// # 参数
+    /// - `left`: 外接矩形左边界x坐标
+    /// - `top`: 外接矩形上边界y坐标
+    /// - `right`: 外接矩形右边界x坐标（包含）
+    /// - `bottom`: 外接矩形下边界y坐标（包含）
+    /// - `color`: 填充颜色
+    pub fn raster_fill_ellipse(&self, left: i32, top: i32, right: i32, bottom: i32, color: &Color) {
+        unsafe {
+            easyx_raster_fillellipse(left, top, right, bottom, color.as_colorref());
+        }
+    }
+
+    /// 批量读取当前工作图像的像素
+    ///
+    /// 代替逐个调用 `get_pixel`，按行复制到 `dst`，超出设备的部分跳过
+    ///
+    /// # 参数
+    /// - `x`: 区域左上角x坐标（设备像素坐标）
+    /// - `y`: 区域左上角y坐标（设备像素坐标）
+    /// - `width`: 区域宽度
+    /// - `height`: 区域高度
+    /// - `dst`: 目标缓冲区
+    /// - `stride`: 目标缓冲区每行的像素数，0 表示等于 `width`
+    /// - `format`: 目标缓冲区的像素格式
+    ///
+    /// # 返回值
+    /// 实际复制的像素数
+    #[allow(clippy::too_many_arguments)]
+    pub fn read_pixels(
+        &self,
+        x: i32,
+        y: i32,
+        width: i32,
+        height: i32,
+        dst: &mut [u32],
+        stride: usize,
+        format: PixelFormat,
+    ) -> usize {
+        let stride = pixel_stride(dst.len(), width, height, stride);
+        unsafe {
+            easyx_read_pixels(
+                std::ptr::null(),
+                x,
+                y,
+                width,
+                height,
+                dst.as_mut_ptr(),
+                stride,
+                format.as_i32(),
+            ) as usize
+        }
+    }
+
+    /// 批量写入当前工作图像的像素
+    ///
+    /// 代替逐个调用 `put_pixel`，按行从 `src` 复制，超出设备的部分跳过。
+    /// 批处理绘图期间写入窗口的区域会记为脏矩形
+    ///
+    /// # 参数
+    /// - `x`: 区域左上角x坐标（设备像素坐标）
+    /// - `y`: 区域左上角y坐标（设备像素坐标）
+    /// - `width`: 区域宽度
+    /// - `height`: 区域高度
+    /// - `src`: 源缓冲区
+    /// - `stride`: 源缓冲区每行的像素数，0 表示等于 `width`
+    /// - `format`: 源缓冲区的像素格式
+    ///
+    /// # 返回值
+    /// 实际复制的像素数
+    #[allow(clippy::too_many_arguments)]
+    pub fn write_pixels(
+        &self,
+        x: i32,
+        y: i32,
+        width: i32,
+        height: i32,
+        src: &[u32],
+        stride: usize,
+        format: PixelFormat,
+    ) -> usize {
+        let stride = pixel_stride(src.len(), width, height, stride);
+        unsafe {
+            easyx_write_pixels(
+                std::ptr::null_mut(),
+                x,
+                y,
+                width,
+                height,
+                src.as_ptr(),
+                stride,
+                format.as_i32(),
+            ) as usize
+        }
+    }
+}
+
+impl App {
+    /// 多线程分块渲染当前工作图像
+    ///
+    /// 把工作图像划分为 `tile_width x tile_height` 的分块，调用线程和工作线程并发领取分块，
+    /// 每个分块先在私有缓冲区中由 `render` 绘制，再复制回工作图像。
+    /// 绘制全部通过 `RenderTile` 的软件光栅化方法完成，不经过 GDI，
+    /// 适合大分辨率下由大量图元组成、可以按区域拆分的画面。
+    ///
+    /// `render` 会对每个分块调用一次，可能在任意线程上并发运行。
+    /// 它应当绘制整个画面，`RenderTile` 会裁掉分块之外的部分；
+    /// 图元较多时可以先用 `RenderTile::intersects` 跳过不可见的图元。
+    /// `render` 中的 panic 会在所有分块完成后在调用线程上重新抛出
+    ///
+    /// # 参数
+    /// - `tile_width`: 分块宽度，0 表示默认值（64）
+    /// - `tile_height`: 分块高度，0 表示默认值（64）
+    /// - `background`: 分块缓冲区的初始颜色，None 表示保留工作图像原有的像素
+    /// - `render`: 渲染闭包
+    ///
+    /// # 返回值
+    /// 渲染的分块数
+    ///
+    /// # 示例
+    /// ```no_run
+    /// use easyx::prelude::*;
+    /// use easyx::run;
+    ///
+    /// fn main() -> Result<(), Box<dyn std::error::Error>> {
+    ///     run(3840, 2160, |app| {
+    ///         let points: Vec<(i32, i32)> = (0..100_000).map(|i| (i % 3840, i * 7 % 2160)).collect();
+    ///         app.begin_batch_draw();
+    ///         app.render_tiles(128, 128, Some(&Color::BLACK), |tile| {
+    ///             for &(x, y) in &points {
+    ///                 if tile.intersects(x - 2, y - 2, x + 2, y + 2) {
+    ///                     tile.fill_circle(x, y, 2, &Color::GREEN);
+    ///                 }
+    ///             }
+    ///         });
+    ///         app.flush_batch_draw();
+    ///         Ok(())
+    ///     })
+    /// }
+    /// ```
+    pub fn render_tiles<F>(
+        &self,
+        tile_width: i32,
+        tile_height: i32,
+        background: Option<&Color>,
+        render: F,
+    ) -> usize
+    where
+        F: Fn(&mut RenderTile) + Sync,
+    {
+        parallel::render_tiles(tile_width, tile_height, background, render)
+    }
+
+    /// 设置分块渲染使用的线程数（包括调用线程）
+    ///
+    /// # 参数
+    /// - `threads`: 线程数，0 表示使用 CPU 核心数，1 表示只在调用线程上渲染
+    pub fn set_render_threads(&self, threads: usize) {
+        unsafe {
+            easyx_render_setthreads(threads.min(i32::MAX as usize) as i32);
+        }
+    }
+
+    /// 获取分块渲染使用的线程数（包括调用线程）
+    pub fn render_threads(&self) -> usize {
+        unsafe { easyx_render_getthreads() as usize }
+    }
+}
+
+impl App {
+    /// 创建输入框
+    ///
+    /// 创建一个输入框，用于获取用户输入
+    ///
+    /// # 参数
+    /// - `max`: 最大输入字符数
+    /// - `prompt`: 提示文本
+    ///
+    /// # 返回值
+    /// 输入框对象
+    pub fn input_box(&self, max: i32, prompt: &str) -> InputBox {
+        InputBox::new(max, prompt)
+    }
+}
+
+impl App {
+    /// 设置鼠标捕获
+    ///
+    /// 设置鼠标捕获，使当前窗口接收所有鼠标事件
+    pub fn set_capture(&self) {
+        unsafe {
+            easyx_setcapture();
+        }
+    }
+
+    /// 释放鼠标捕获
+    ///
+    /// 释放之前设置的鼠标捕获
+    pub fn release_capture(&self) {
+        unsafe {
+            easyx_releasecapture();
+        }
+    }
+
+    /// 获取消息（阻塞）
+    ///
+    /// 获取消息队列中的消息，阻塞直到有消息可用
+    ///
+    /// # 参数
+    /// - `filter`: 消息过滤类型
+    ///
+    /// # 返回值
+    /// 捕获到的消息
+    pub fn get_message(&self, filter: MessageFilter) -> ExMessage {
+        ExMessage::get_message(filter)
+    }
+
+    /// 查看消息（非阻塞）
+    ///
+    /// 查看消息队列中的消息，非阻塞，如果没有消息则返回None
+    ///
+    /// # 参数
+    /// - `filter`: 消息过滤类型
+    /// - `removemsg`: 是否从消息队列中移除消息
+    ///
+    /// # 返回值
+    /// 如果有消息则返回Some(ExMessage)，否则返回None
+    pub fn peek_message(&self, filter: MessageFilter, removemsg: bool) -> Option<ExMessage> {
+        ExMessage::peek_message(filter, removemsg)
+    }
+
+    /// 刷新消息队列
+    ///
+    /// 刷新指定类型的消息队列，处理所有待处理的消息
+    ///
+    /// # 参数
+    /// - `filter`: 消息过滤类型
+    pub fn flush_messages(&self, filter: MessageFilter) {
+        unsafe {
+            easyx_flushmessage(filter as u8);
+        }
+    }
+
+    /// 等待消息（休眠）
+    ///
+    /// 休眠到消息队列中有符合过滤条件的消息、超时或被 `WakeHandle` 唤醒，代替
+    /// `peek_message` 加 `delay` 的轮询，空闲时不占用 CPU。不会取出消息
+    ///
+    /// # 参数
+    /// - `filter`: 消息过滤类型
+    /// - `timeout`: 最长等待时间，None 表示一直等待
+    ///
+    /// # 返回值
+    /// 结束等待的原因
+    pub fn wait_message(&self, filter: MessageFilter, timeout: Option<Duration>) -> WaitResult {
+        ExMessage::wait(filter, timeout)
+    }
+
+    /// 获取唤醒绘图线程的句柄，可以移动到其他线程
+    ///
+    /// 通过 `MainSender` 发回绘图线程的闭包会自动唤醒，不需要再调用 `wake`
+    pub fn waker(&self) -> WakeHandle {
+        WakeHandle
+    }
+
+    /// 运行事件驱动的主循环，只在需要时重新绘制
+    ///
+    /// 进入批处理绘图模式后先绘制一次，然后休眠等待消息。每个消息交给 `handle` 处理，
+    /// 根据返回的 `LoopControl` 决定是否重新绘制；被唤醒时先执行发回绘图线程的闭包，
+    /// 再以 `LoopEvent::Wake` 调用 `handle`。`render` 返回的时间或 `RedrawAfter`
+    /// 指定的时刻到达时也会重新绘制，用于动画或定时刷新的仪表盘。
+    ///
+    /// # 参数
+    /// - `filter`: 消息过滤类型
+    /// - `handle`: 处理事件的闭包
+    /// - `render`: 绘制整个画面的闭包，返回后自动刷新批处理绘图。
+    ///   返回 `Some(delay)` 表示经过 `delay` 后需要再绘制一次，None 表示等到下一个事件
+    ///
+    /// # 示例
+    /// ```no_run
+    /// use std::time::Duration;
+    ///
+    /// use easyx::prelude::*;
+    /// use easyx::run;
+    ///
+    /// fn main() -> Result<(), Box<dyn std::error::Error>> {
+    ///     run(800, 600, |app| {
+    ///         let clicks = std::cell::Cell::new(0);
+    ///
+    ///         app.run_event_loop(
+    ///             MessageFilter::All,
+    ///             |_, event| match event {
+    ///                 LoopEvent::Message(msg) => match msg.msg {
+    ///                     Message::KeyBoard { vkcode: KeyCode::Escape, .. } => LoopControl::Exit,
+    ///                     Message::Mouse { lbutton: true, .. } => {
+    ///                         clicks.set(clicks.get() + 1);
+    ///                         LoopControl::Redraw
+    ///                     }
+    ///                     _ => LoopControl::Wait,
+    ///                 },
+    ///                 LoopEvent::Wake => LoopControl::Wait,
+    ///             },
+    ///             |app| {
+    ///                 app.clear_device();
+    ///                 app.out_text(10, 10, &format!("clicks: {}", clicks.get()));
+    ///                 // 每秒刷新一次时钟，其余时间休眠
+    ///                 Some(Duration::from_secs(1))
+    ///             },
+    ///         );
+    ///         Ok(())
+    ///     })
+    /// }
+    /// ```
+    pub fn run_event_loop<H, R>(&self, filter: MessageFilter, mut handle: H, mut render: R)
+    where
+        H: FnMut(&App, LoopEvent) -> LoopControl,
+        R: FnMut(&App) -> Option<Duration>,
+    {
+        let mut redraw = true;
+        let mut deadline: Option<Instant> = None;
+
+        // 合并控制结果，返回 false 表示退出
+        let apply = |control: LoopControl, redraw: &mut bool, deadline: &mut Option<Instant>| {
+            match control {
+                LoopControl::Wait => {}
+                LoopControl::Redraw => *redraw = true,
+                LoopControl::RedrawAfter(delay) => redraw_at(deadline, delay),
+                LoopControl::Exit => return false,
+            }
+            true
+        };
+
+        self.begin_batch_draw();
+        'run: loop {
+            if let Some(at) = deadline
+                && Instant::now() >= at
+            {
+                deadline = None;
+                redraw = true;
+            }
+            if redraw {
+                let next = render(self);
+                self.flush_batch_draw();
+                redraw = false;
+                if let Some(delay) = next {
+                    redraw_at(&mut deadline, delay);
+                }
+            }
+
+            let timeout = deadline.map(|at| at.saturating_duration_since(Instant::now()));
+            match self.wait_message(filter, timeout) {
+                WaitResult::Message => {
+                    while let Some(msg) = self.peek_message(filter, true) {
+                        if !apply(
+                            handle(self, LoopEvent::Message(msg)),
+                            &mut redraw,
+                            &mut deadline,
+                        ) {
+                            break 'run;
+                        }
+                    }
+                }
+                WaitResult::Wake => {
+                    if let Some(scheduler) = self.scheduler.get() {
+                        scheduler.run_main(self, None);
+                    }
+                    if !apply(handle(self, LoopEvent::Wake), &mut redraw, &mut deadline) {
+                        break;
+                    }
+                }
+                WaitResult::Timeout => {}
+            }
+        }
+        self.end_batch_draw();
+    }
+}
+
+// 记录下一次重新绘制的时刻，多次指定时取最早的
+fn redraw_at(deadline: &mut Option<Instant>, delay: Duration) {
+    let at = Instant::now() + delay;
+    *deadline = Some(deadline.map_or(at, |d| d.min(at)));
+}
+
+/// 事件驱动主循环中的事件
+///
+/// 由 `App::run_event_loop` 传给事件处理闭包
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum LoopEvent {
+    /// 消息队列中取出的消息
+    Message(ExMessage),
+    /// 被 `WakeHandle::wake` 或发回绘图线程的闭包唤醒
+    Wake,
+}
+
+/// 事件处理后主循环的动作
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum LoopControl {
+    /// 不重新绘制，继续等待
+    Wait,
+    /// 处理完当前这批消息后重新绘制
+    Redraw,
+    /// 经过指定时间后重新绘制，多次指定时取最早的时刻
+    RedrawAfter(Duration),
+    /// 退出主循环
+    Exit,
+}
+
+/// 命令缓冲回放错误
+///
+/// 定义了 `App::submit_commands` 回放命令流时可能发生的错误
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Hash)]
+pub enum CommandError {
+    /// 命令流头部无效或版本不匹配
+    Header,
+    /// 命令流被截断
+    Truncated,
+    /// 未知的操作码
+    Opcode,
+    /// 命令参数个数错误
+    Args,
+    /// 未知错误，包含错误码
+    Unknown(i32),
+}
+
+impl std::fmt::Display for CommandError {
+    /// 格式化命令缓冲错误为字符串
+    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+        match self {
+            CommandError::Header => write!(f, "命令流头部无效"),
+            CommandError::Truncated => write!(f, "命令流被截断"),
+            CommandError::Opcode => write!(f, "未知的操作码"),
+            CommandError::Args => write!(f, "命令参数个数错误"),
+            CommandError::Unknown(code) => write!(f, "未知错误，错误码: {}", code),
+        }
+    }
+}
+
+impl std::error::Error for CommandError {}
+
+impl From<i32> for CommandError {
+    /// 从错误码转换为 CommandError
+    fn from(code: i32) -> Self {
+        match code {
+            EASYX_CMD_ERR_HEADER => CommandError::Header,
+            EASYX_CMD_ERR_TRUNCATED => CommandError::Truncated,
+            EASYX_CMD_ERR_OPCODE => CommandError::Opcode,
+            EASYX_CMD_ERR_ARGS => CommandError::Args,
+            other => CommandError::Unknown(other),
+        }
+    }
+}
+
+/// 绘图命令缓冲
+///
+/// 将绘图命令（包括颜色、样式等状态设置）编码为紧凑的命令流，
+/// 通过 `App::submit_commands` 一次性交给 C++ 包装层回放，
+/// 避免每个图元都跨越一次 FFI 边界。
+///
+/// 命令流按 32 位字存放在 `Vec<u32>` 中，保证 C++ 端按 `uint32_t` 读取时对齐，
+/// `clear` 后保留容量，适合每帧重复录制。
+///
+/// # 示例
+/// ```no_run
+/// use easyx::prelude::*;
+/// use easyx::run;
+///
+/// fn main() -> Result<(), Box<dyn std::error::Error>> {
+///     run(800, 600, |app| {
+///         let mut cmds = CommandBuffer::new();
+///
+///         cmds.set_fillcolor(&Color::RED)
+///             .fill_rectangle(10, 10, 100, 100)
+///             .set_fillcolor(&Color::BLUE)
+///             .fill_circle(200, 200, 50);
+///
+///         app.submit_commands(&cmds)?;
+///         Ok(())
+///     })
+/// }
+/// ```
+#[derive(Debug, Clone, PartialEq, Eq)]
+pub struct CommandBuffer {
+    buf: Vec<u32>,
+    count: usize,
+}
+
+impl Default for CommandBuffer {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+impl CommandBuffer {
+    /// 创建一个空的命令缓冲
+    pub fn new() -> Self {
+        Self::with_capacity(0)
+    }
+
+    /// 创建一个预分配指定字节数的命令缓冲
+    ///
+    /// # 参数
+    /// - `bytes`: 预分配的字节数
+    pub fn with_capacity(bytes: usize) -> Self {
+        let mut cmds = Self {
+            buf: Vec::with_capacity(bytes.div_ceil(4).max(2)),
+            count: 0,
+        };
+        cmds.write_header();
+        cmds
+    }
+
+    /// 清空已录制的命令，保留已分配的内存
+    pub fn clear(&mut self) {
+        self.buf.clear();
+        self.count = 0;
+        self.write_header();
+    }
+
+    /// 获取已录制的命令数
+    pub fn len(&self) -> usize {
+        self.count
+    }
+
+    /// 是否没有录制任何命令
+    pub fn is_empty(&self) -> bool {
+        self.count == 0
+    }
+
+    /// 获取编码后的命令流
+    ///
+    /// 返回的字节切片按 4 字节对齐，可以直接交给按 32 位字读取的 C++ 接口
+    pub fn as_bytes(&self) -> &[u8] {
+        let len = std::mem::size_of_val(self.buf.as_slice());
+        unsafe { std::slice::from_raw_parts(self.buf.as_ptr().cast(), len) }
+    }
+
+    fn write_header(&mut self) {
+        self.write_word(EASYX_CMD_MAGIC);
+        self.write_word(EASYX_CMD_VERSION);
+    }
+
+    fn write_word(&mut self, word: u32) {
+        self.buf.push(word);
+    }
+
+    /// 写入字节串并按 4 字节补齐
+    fn write_padded(&mut self, bytes: &[u8]) {
+        for chunk in bytes.chunks(4) {
+            let mut word = [0u8; 4];
+            word[..chunk.len()].copy_from_slice(chunk);
+            self.buf.push(u32::from_ne_bytes(word));
+        }
+    }
+
+    fn begin(&mut self, op: u32, argc: usize) {
+        assert!(argc <= u16::MAX as usize, "too many command arguments");
+        self.write_word(op | ((argc as u32) << 16));
+        self.count += 1;
+    }
+
+    fn push(&mut self, op: u32, args: &[i32]) -> &mut Self {
+        self.begin(op, args.len());
+        for arg in args {
+            self.write_word(*arg as u32);
+        }
+        self
+    }
+
+    fn push_points(&mut self, op: u32, points: &[POINT]) -> &mut Self {
+        self.begin(op, 1 + 2 * points.len());
+        self.write_word(points.len() as u32);
+        for point in points {
+            self.write_word(point.x as u32);
+            self.write_word(point.y as u32);
+        }
+        self
+    }
+}
+
+impl CommandBuffer {
+    /// 录制设置线条颜色
+    pub fn set_linecolor(&mut self, color: &Color) -> &mut Self {
+        self.push(EASYX_CMD_SETLINECOLOR, &[color.as_colorref() as i32])
+    }
+
+    /// 录制设置填充颜色
+    pub fn set_fillcolor(&mut self, color: &Color) -> &mut Self {
+        self.push(EASYX_CMD_SETFILLCOLOR, &[color.as_colorref() as i32])
+    }
+
+    /// 录制设置文本颜色
+    pub fn set_textcolor(&mut self, color: &Color) -> &mut Self {
+        self.push(EASYX_CMD_SETTEXTCOLOR, &[color.as_colorref() as i32])
+    }
+
+    /// 录制设置背景颜色
+    pub fn set_bkcolor(&mut self, color: &Color) -> &mut Self {
+        self.push(EASYX_CMD_SETBKCOLOR, &[color.as_colorref() as i32])
+    }
+
+    /// 录制设置背景模式
+    pub fn set_bkmode(&mut self, bkmode: &BkMode) -> &mut Self {
+        self.push(EASYX_CMD_SETBKMODE, &[*bkmode as i32])
+    }
+
+    /// 录制设置二元光栅操作模式
+    pub fn set_rop2(&mut self, rop2: &Rop2) -> &mut Self {
+        self.push(EASYX_CMD_SETROP2, &[*rop2 as i32])
+    }
+
+    /// 录制设置线条样式
+    ///
+    /// 用户自定义样式的样式数组会一并写入命令流
+    pub fn set_linestyle(&mut self, linestyle: &LineStyle) -> &mut Self {
+        let user_style = linestyle.user_style().unwrap_or(&[]);
+
+        self.begin(EASYX_CMD_SETLINESTYLE, 2 + user_style.len());
+        self.write_word(linestyle.style_value() as u32);
+        self.write_word(linestyle.thickness() as u32);
+        for style in user_style {
+            self.write_word(*style as u32);
+        }
+        self
+    }
+
+    /// 录制设置填充样式
+    ///
+    /// 命令流中只记录样式和图案类型，不能引用图像
+    ///
+    /// # Panics
+    /// `fillstyle` 是图像填充或 8x8 位图填充时触发 panic
+    pub fn set_fillstyle(&mut self, fillstyle: &FillStyle) -> &mut Self {
+        let hatch = match fillstyle {
+            FillStyle::Solid | FillStyle::Null => 0,
+            FillStyle::Hatched(hatch) => *hatch as i32,
+            _ => panic!("命令流不支持图像填充样式"),
+        };
+        self.push(EASYX_CMD_SETFILLSTYLE, &[fillstyle.get_style(), hatch])
+    }
+
+    /// 录制设置文本样式
+    ///
+    /// 字体名以 UTF-8 字节直接写入命令流
+    pub fn set_textstyle(&mut self, height: i32, width: i32, face: &str) -> &mut Self {
+        let bytes = face.as_bytes();
+
+        self.begin(EASYX_CMD_SETTEXTSTYLE, 3 + bytes.len().div_ceil(4));
+        self.write_word(height as u32);
+        self.write_word(width as u32);
+        self.write_word(bytes.len() as u32);
+        self.write_padded(bytes);
+        self
+    }
+
+    /// 录制清空设备
+    pub fn clear_device(&mut self) -> &mut Self {
+        self.push(EASYX_CMD_CLEARDEVICE, &[])
+    }
+
+    /// 录制绘制点
+    pub fn put_pixel(&mut self, x: i32, y: i32, color: &Color) -> &mut Self {
+        self.push(EASYX_CMD_PUTPIXEL, &[x, y, color.as_colorref() as i32])
+    }
+
+    /// 录制绘制直线
+    pub fn line(&mut self, left: i32, top: i32, right: i32, bottom: i32) -> &mut Self {
+        self.push(EASYX_CMD_LINE, &[left, top, right, bottom])
+    }
+
+    /// 录制绘制矩形
+    pub fn rectangle(&mut self, left: i32, top: i32, right: i32, bottom: i32) -> &mut Self {
+        self.push(EASYX_CMD_RECTANGLE, &[left, top, right, bottom])
+    }
+
+    /// 录制绘制填充矩形
+    pub fn fill_rectangle(&mut self, left: i32, top: i32, right: i32, bottom: i32) -> &mut Self {
+        self.push(EASYX_CMD_FILLRECTANGLE, &[left, top, right, bottom])
+    }
+
+    /// 录制绘制实心矩形
+    pub fn solid_rectangle(&mut self, left: i32, top: i32, right: i32, bottom: i32) -> &mut Self {
+        self.push(EASYX_CMD_SOLIDRECTANGLE, &[left, top, right, bottom])
+    }
+
+    /// 录制清除矩形区域
+    pub fn clear_rectangle(&mut self, left: i32, top: i32, right: i32, bottom: i32) -> &mut Self {
+        self.push(EASYX_CMD_CLEARRECTANGLE, &[left, top, right, bottom])
+    }
+
+    /// 录制绘制圆形
+    pub fn circle(&mut self, x: i32, y: i32, radius: i32) -> &mut Self {
+        self.push(EASYX_CMD_CIRCLE, &[x, y, radius])
+    }
+
+    /// 录制绘制填充圆形
+    pub fn fill_circle(&mut self, x: i32, y: i32, radius: i32) -> &mut Self {
+        self.push(EASYX_CMD_FILLCIRCLE, &[x, y, radius])
+    }
+
+    /// 录制绘制实心圆形
+    pub fn solid_circle(&mut self, x: i32, y: i32, radius: i32) -> &mut Self {
+        self.push(EASYX_CMD_SOLIDCIRCLE, &[x, y, radius])
+    }
+
+    /// 录制清除圆形区域
+    pub fn clear_circle(&mut self, x: i32, y: i32, radius: i32) -> &mut Self {
+        self.push(EASYX_CMD_CLEARCIRCLE, &[x, y, radius])
+    }
+
+    /// 录制绘制椭圆
+    pub fn ellipse(&mut self, left: i32, top: i32, right: i32, bottom: i32) -> &mut Self {
+        self.push(EASYX_CMD_ELLIPSE, &[left, top, right, bottom])
+    }
+
+    /// 录制绘制填充椭圆
+    pub fn fill_ellipse(&mut self, left: i32, top: i32, right: i32, bottom: i32) -> &mut Self {
+        self.push(EASYX_CMD_FILLELLIPSE, &[left, top, right, bottom])
+    }
+
+    /// 录制绘制实心椭圆
+    pub fn solid_ellipse(&mut self, left: i32, top: i32, right: i32, bottom: i32) -> &mut Self {
+        self.push(EASYX_CMD_SOLIDELLIPSE, &[left, top, right, bottom])
+    }
+
+    /// 录制清除椭圆区域
+    pub fn clear_ellipse(&mut self, left: i32, top: i32, right: i32, bottom: i32) -> &mut Self {
+        self.push(EASYX_CMD_CLEARELLIPSE, &[left, top, right, bottom])
+    }
+
+    /// 录制绘制圆角矩形
+    #[allow(clippy::too_many_arguments)]
+    pub fn roundrect(
+        &mut self,
+        left: i32,
+        top: i32,
+        right: i32,
+        bottom: i32,
+        ellipsewidth: i32,
+        ellipseheight: i32,
+    ) -> &mut Self {
+        self.push(
+            EASYX_CMD_ROUNDRECT,
+            &[left, top, right, bottom, ellipsewidth, ellipseheight],
+        )
+    }
+
+    /// 录制绘制填充圆角矩形
+    #[allow(clippy::too_many_arguments)]
+    pub fn fill_roundrect(
+        &mut self,
+        left: i32,
+        top: i32,
+        right: i32,
+        bottom: i32,
+        ellipsewidth: i32,
+        ellipseheight: i32,
+    ) -> &mut Self {
+        self.push(
+            EASYX_CMD_FILLROUNDRECT,
+            &[left, top, right, bottom, ellipsewidth, ellipseheight],
+        )
+    }
+
+    /// 录制绘制实心圆角矩形
+    #[allow(clippy::too_many_arguments)]
+    pub fn solid_roundrect(
+        &mut self,
+        left: i32,
+        top: i32,
+        right: i32,
+        bottom: i32,
+        ellipsewidth: i32,
+        ellipseheight: i32,
+    ) -> &mut Self {
+        self.push(
+            EASYX_CMD_SOLIDROUNDRECT,
+            &[left, top, right, bottom, ellipsewidth, ellipseheight],
+        )
+    }
+
+    /// 录制清除圆角矩形区域
+    #[allow(clippy::too_many_arguments)]
+    pub fn clear_roundrect(
+        &mut self,
+        left: i32,
+        top: i32,
+        right: i32,
+        bottom: i32,
+        ellipsewidth: i32,
+        ellipseheight: i32,
+    ) -> &mut Self {
+        self.push(
+            EASYX_CMD_CLEARROUNDRECT,
+            &[left, top, right, bottom, ellipsewidth, ellipseheight],
+        )
+    }
+
+    /// 录制绘制折线
+    pub fn poly_line(&mut self, points: &[POINT]) -> &mut Self {
+        self.push_points(EASYX_CMD_POLYLINE, points)
+    }
+
+    /// 录制绘制多边形
+    pub fn poly_gon(&mut self, points: &[POINT]) -> &mut Self {
+        self.push_points(EASYX_CMD_POLYGON, points)
+    }
+
+    /// 录制绘制填充多边形
+    pub fn fill_polygon(&mut self, points: &[POINT]) -> &mut Self {
+        self.push_points(EASYX_CMD_FILLPOLYGON, points)
+    }
+
+    /// 录制绘制实心多边形
+    pub fn solid_polygon(&mut self, points: &[POINT]) -> &mut Self {
+        self.push_points(EASYX_CMD_SOLIDPOLYGON, points)
+    }
+
+    /// 录制清除多边形区域
+    pub fn clear_polygon(&mut self, points: &[POINT]) -> &mut Self {
+        self.push_points(EASYX_CMD_CLEARPOLYGON, points)
+    }
+
+    /// 录制输出文本
+    ///
+    /// 文本以 UTF-8 字节直接写入命令流，无需构造 `CString`
+    pub fn out_text(&mut self, x: i32, y: i32, text: &str) -> &mut Self {
+        let bytes = text.as_bytes();
+
+        self.begin(EASYX_CMD_OUTTEXTXY, 3 + bytes.len().div_ceil(4));
+        self.write_word(x as u32);
+        self.write_word(y as u32);
+        self.write_word(bytes.len() as u32);
+        self.write_padded(bytes);
+        self
+    }
+}
+
+impl App {
+    /// 提交命令缓冲
+    ///
+    /// 在一次 FFI 调用中按顺序回放命令缓冲中录制的所有命令。
+    /// 回放遇到错误时立即停止，之前的命令已经生效。
+    ///
+    /// # 参数
+    /// - `cmds`: 要回放的命令缓冲
+    ///
+    /// # 返回值
+    /// 成功返回执行的命令数，失败返回 CommandError
+    pub fn submit_commands(&self, cmds: &CommandBuffer) -> Result<usize, CommandError> {
+        let bytes = cmds.as_bytes();
+        let result = unsafe { easyx_submit_commands(bytes.as_ptr().cast(), bytes.len()) };
+
+        if result >= 0 {
+            Ok(result as usize)
+        } else {
+            Err(result.into())
+        }
+    }
+}
+
+/// 无锁队列错误
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Hash)]
+pub enum RingError {
+    /// 队列已满，稍后重试或丢弃
+    Full,
+    /// 命令流超过队列的总容量，永远无法提交
+    TooBig,
+    /// 参数无效
+    Invalid,
+    /// 未知错误，包含错误码
+    Unknown(i32),
+}
+
+impl std::fmt::Display for RingError {
+    /// 格式化无锁队列错误为字符串
+    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+        match self {
+            RingError::Full => write!(f, "队列已满"),
+            RingError::TooBig => write!(f, "命令流超过队列容量"),
+            RingError::Invalid => write!(f, "参数无效"),
+            RingError::Unknown(code) => write!(f, "未知错误，错误码: {}", code),
+        }
+    }
+}
+
+impl std::error::Error for RingError {}
+
+impl From<i32> for RingError {
+    /// 从错误码转换为 RingError
+    fn from(code: i32) -> Self {
+        match code {
+            EASYX_RING_ERR_FULL => RingError::Full,
+            EASYX_RING_ERR_TOOBIG => RingError::TooBig,
+            EASYX_RING_ERR_INVALID => RingError::Invalid,
+            other => RingError::Unknown(other),
+        }
+    }
+}
+
+/// 无锁队列的统计信息
+#[derive(Debug, Clone, Copy, Default, PartialEq, Eq)]
+pub struct RingStats {
+    /// 成功提交的命令流数或消息数
+    pub pushed: u64,
+    /// 已回放的命令流数或已取出的消息数
+    pub popped: u64,
+    /// 因队列已满被拒绝的次数
+    pub rejected: u64,
+    /// 占用的容量，命令队列为字节数，消息队列为消息数
+    pub used: usize,
+    /// 总容量，单位同上
+    pub capacity: usize,
+}
+
+impl From<&EasyXRingStats> for RingStats {
+    fn from(stats: &EasyXRingStats) -> Self {
+        Self {
+            pushed: stats.pushed,
+            popped: stats.popped,
+            rejected: stats.rejected,
+            used: stats.used,
+            capacity: stats.capacity,
+        }
+    }
+}
+
+/// 跨线程的无锁命令队列
+///
+/// 多生产者单消费者：任意线程用 `post` 提交录制好的 `CommandBuffer`，
+/// 绘图线程用 `drain` 按提交顺序回放。命令流在提交时被复制，生产者之间
+/// 以及生产者与绘图线程之间都不加锁，队列满时 `post` 立即返回 `RingError::Full`。
+///
+/// 通常用 `Arc` 共享给工作线程。
+///
+/// # 示例
+/// ```no_run
+/// use std::sync::Arc;
+/// use std::thread;
+///
+/// use easyx::prelude::*;
+/// use easyx::run;
+///
+/// fn main() -> Result<(), Box<dyn std::error::Error>> {
+///     run(800, 600, |app| {
+///         let ring = Arc::new(CommandRing::new(256 * 1024));
+///
+///         let producer = ring.clone();
+///         let worker = thread::spawn(move || {
+///             let mut cmds = CommandBuffer::new();
+///             for i in 0..100 {
+///                 cmds.clear();
+///                 cmds.set_fillcolor(&Color::GREEN).fill_circle(i * 8, 300, 4);
+///                 while producer.post(&cmds) == Err(RingError::Full) {
+///                     thread::yield_now();
+///                 }
+///             }
+///         });
+///
+///         app.begin_batch_draw();
+///         while !worker.is_finished() || ring.stats().used > 0 {
+///             ring.drain(app);
+///             app.present_frame();
+///         }
+///         app.end_batch_draw();
+///         Ok(())
+///     })
+/// }
+/// ```
+#[derive(Debug)]
+pub struct CommandRing {
+    ptr: *mut std::os::raw::c_void,
+}
+
+// 提交在任意线程中进行，回放需要 &App，只能在绘图线程中进行，保证只有一个消费者
+unsafe impl Send for CommandRing {}
+unsafe impl Sync for CommandRing {}
+
+impl CommandRing {
+    /// 创建命令队列
+    ///
+    /// # 参数
+    /// - `bytes`: 可以同时排队的命令流总字节数，向上取整
+    pub fn new(bytes: usize) -> Self {
+        Self {
+            ptr: unsafe { easyx_cmdring_create(bytes) },
+        }
+    }
+
+    /// 提交一段命令流，可以在任意线程中调用
+    ///
+    /// # 参数
+    /// - `cmds`: 录制好的命令缓冲
+    ///
+    /// # 返回值
+    /// 成功返回 ()，队列已满或命令流过大时返回 RingError
+    pub fn post(&self, cmds: &CommandBuffer) -> Result<(), RingError> {
+        let bytes = cmds.as_bytes();
+        let result = unsafe { easyx_cmdring_post(self.ptr, bytes.as_ptr().cast(), bytes.len()) };
+        if result == 0 {
+            Ok(())
+        } else {
+            Err(result.into())
+        }
+    }
+
+    /// 在绘图线程中按提交顺序回放所有已提交的命令流
+    ///
+    /// # 参数
+    /// - `app`: 绘图线程的 App，保证只在绘图线程中回放
+    ///
+    /// # 返回值
+    /// 回放的命令流数
+    pub fn drain(&self, app: &App) -> usize {
+        self.drain_max(app, 0)
+    }
+
+    /// 在绘图线程中最多回放 `max` 段命令流，0 表示全部
+    ///
+    /// # 参数
+    /// - `app`: 绘图线程的 App
+    /// - `max`: 最多回放的命令流数
+    ///
+    /// # 返回值
+    /// 回放的命令流数
+    pub fn drain_max(&self, _app: &App, max: usize) -> usize {
+        let max = max.min(i32::MAX as usize) as i32;
+        unsafe { easyx_cmdring_drain(self.ptr, max).max(0) as usize }
+    }
+
+    /// 获取统计信息
+    pub fn stats(&self) -> RingStats {
+        let mut stats = unsafe { std::mem::zeroed::<EasyXRingStats>() };
+        unsafe {
+            easyx_cmdring_getstats(self.ptr, &mut stats);
+        }
+        RingStats::from(&stats)
+    }
+}
+
+impl Drop for CommandRing {
+    /// 释放队列，尚未回放的命令流被丢弃
+    fn drop(&mut self) {
+        unsafe {
+            easyx_cmdring_destroy(self.ptr);
+        }
+    }
+}
+
+impl App {
+    /// 在时间预算内把已解码的异步加载请求创建为图像
+    ///
+    /// 图像必须在绘图线程中创建，通常每帧调用一次。
+    /// 至少创建一张，即使超出预算，保证加载总能推进。
+    ///
+    /// # 参数
+    /// - `budget`: 本次调用最多使用的时间，0 表示创建所有已解码的图像
+    ///
+    /// # 返回值
+    /// 本次创建的图像数
+    pub fn finalize_image_loads(&self, budget: Duration) -> usize {
+        let created = unsafe { easyx_loadimage_finalize(budget.as_secs_f64() * 1000.0) as usize };
+        wake_finished_loads();
+        created
+    }
+
+    /// 获取异步加载的进度
+    ///
+    /// # 返回值
+    /// 从上次重置开始的统计
+    pub fn image_load_progress(&self) -> LoadProgress {
+        let mut progress = EasyXLoadProgress {
+            requested: 0,
+            finished: 0,
+            failed: 0,
+            cancelled: 0,
+        };
+        unsafe {
+            easyx_loadimage_progress(&mut progress);
+        }
+        LoadProgress {
+            requested: progress.requested.max(0) as u32,
+            finished: progress.finished.max(0) as u32,
+            failed: progress.failed.max(0) as u32,
+            cancelled: progress.cancelled.max(0) as u32,
+        }
+    }
+
+    /// 重置异步加载的进度统计，尚未完成的请求仍会继续计入
+    pub fn reset_image_load_progress(&self) {
+        unsafe {
+            easyx_loadimage_resetprogress();
         }
     }
 }
@@ -1327,6 +3044,8 @@ impl Drop for App {
     /// 当App实例被销毁时，会自动调用此方法关闭图形窗口，
     /// 确保资源正确释放。
     fn drop(&mut self) {
+        // 先停止工作线程，之后发回的闭包不会再执行
+        drop(self.scheduler.take());
         unsafe {
             easyx_closegraph();
         }
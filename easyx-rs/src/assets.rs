@@ -0,0 +1,379 @@
+//! 解码图像缓存与预解码的资源包
+
+use std::error::Error;
+use std::ffi::{CStr, CString};
+use std::fmt;
+
+use easyx_sys::*;
+
+use crate::image::{Image, ImageError};
+
+/// 资源包相关错误
+#[derive(Debug, PartialEq, Eq)]
+pub enum AssetError {
+    /// 文件读写失败，或资源包格式无效
+    Io,
+    /// 名称或编号不存在
+    NotFound,
+    /// 参数无效
+    Invalid,
+    /// 未知错误
+    Unknown(i32),
+}
+
+impl fmt::Display for AssetError {
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        match self {
+            AssetError::Io => write!(f, "资源包读写失败"),
+            AssetError::NotFound => write!(f, "资源不存在"),
+            AssetError::Invalid => write!(f, "参数无效"),
+            AssetError::Unknown(code) => write!(f, "未知错误，错误码: {}", code),
+        }
+    }
+}
+
+impl Error for AssetError {}
+
+impl From<i32> for AssetError {
+    /// 从错误码转换为 AssetError
+    fn from(code: i32) -> Self {
+        match code {
+            EASYX_PACK_ERR_IO => AssetError::Io,
+            EASYX_PACK_ERR_NOTFOUND => AssetError::NotFound,
+            EASYX_PACK_ERR_INVALID => AssetError::Invalid,
+            _ => AssetError::Unknown(code),
+        }
+    }
+}
+
+/// 解码图像缓存的统计信息
+#[derive(Debug, Clone, Copy, Default, PartialEq, Eq)]
+pub struct ImageCacheStats {
+    /// 命中次数
+    pub hits: u64,
+    /// 未命中次数
+    pub misses: u64,
+    /// 因超出预算被淘汰的条目数
+    pub evictions: u64,
+    /// 缓存的像素占用的字节数
+    pub bytes: u64,
+    /// 缓存的条目数
+    pub entries: usize,
+}
+
+/// 解码图像缓存
+///
+/// 按文件内容和加载参数索引解码后的像素，内容相同的文件（即使路径不同）只解码一次。
+/// 命中时仍会读取文件计算哈希，但跳过解码，直接复制像素。
+/// 缓存占用超出内存预算（默认 64 MiB）时淘汰最久未使用的条目。
+///
+/// 缓存是全局的，只能在绘图线程中使用。
+///
+/// # 示例
+/// ```no_run
+/// use easyx::prelude::*;
+/// use easyx::run;
+///
+/// fn main() -> Result<(), Box<dyn std::error::Error>> {
+///     run(800, 600, |app| {
+///         ImageCache::set_budget(128 * 1024 * 1024);
+///         for _ in 0..10 {
+///             // 只有第一次会解码
+///             let tile = ImageCache::load("tile.png", 0, 0, false)?;
+///             tile.put_image(0, 0);
+///         }
+///         println!("{:?}", ImageCache::stats());
+///         Ok(())
+///     })
+/// }
+/// ```
+pub struct ImageCache;
+
+impl ImageCache {
+    /// 通过缓存加载图像文件，参数与 `Image::load_file` 相同
+    ///
+    /// # 参数
+    /// - `path`: 图像文件路径
+    /// - `width`: 图像宽度，0表示使用原始宽度
+    /// - `height`: 图像高度，0表示使用原始高度
+    /// - `resize`: 是否调整图像大小以适应指定的宽高
+    ///
+    /// # 返回值
+    /// 成功返回 Image 对象，失败返回 ImageError
+    pub fn load(path: &str, width: i32, height: i32, resize: bool) -> Result<Image, ImageError> {
+        let c_path = CString::new(path).map_err(|_| ImageError::Unknown(-1))?;
+        let img = Image::new(width, height);
+        let result = unsafe {
+            easyx_imagecache_load(
+                img.as_mut_ptr(),
+                c_path.as_ptr(),
+                width,
+                height,
+                resize as i32,
+            )
+        };
+        if result == 0 {
+            Ok(img)
+        } else {
+            Err(result.into())
+        }
+    }
+
+    /// 设置内存预算，超出的部分立即淘汰
+    ///
+    /// # 参数
+    /// - `bytes`: 缓存的像素最多占用的字节数，0 表示禁用缓存
+    pub fn set_budget(bytes: usize) {
+        unsafe {
+            easyx_imagecache_setbudget(bytes);
+        }
+    }
+
+    /// 获取内存预算（字节）
+    pub fn budget() -> usize {
+        unsafe { easyx_imagecache_getbudget() }
+    }
+
+    /// 清空缓存，统计信息保留
+    pub fn clear() {
+        unsafe {
+            easyx_imagecache_clear();
+        }
+    }
+
+    /// 获取统计信息
+    pub fn stats() -> ImageCacheStats {
+        let mut stats = EasyXImageCacheStats {
+            hits: 0,
+            misses: 0,
+            evictions: 0,
+            bytes: 0,
+            entries: 0,
+        };
+        unsafe {
+            easyx_imagecache_getstats(&mut stats);
+        }
+        ImageCacheStats {
+            hits: stats.hits,
+            misses: stats.misses,
+            evictions: stats.evictions,
+            bytes: stats.bytes,
+            entries: stats.entries.max(0) as usize,
+        }
+    }
+}
+
+/// 预解码的资源包
+///
+/// 资源包保存与图像缓冲区格式相同的像素（0xAARRGGBB，按 64 字节对齐），
+/// 打开时内存映射整个文件，加载图像只需调整大小并复制像素，没有解码开销。
+/// 资源包用 `AssetPackBuilder` 生成，通常在构建阶段完成。
+///
+/// # 示例
+/// ```no_run
+/// use easyx::prelude::*;
+/// use easyx::run;
+///
+/// fn main() -> Result<(), Box<dyn std::error::Error>> {
+///     run(800, 600, |app| {
+///         // 构建阶段：把 PNG 解码后写入资源包
+///         let mut builder = AssetPackBuilder::new();
+///         builder.add("background", &Image::load_file("background.png", 0, 0, false)?)?;
+///         builder.write("assets.expk")?;
+///
+///         // 启动时：直接复制像素
+///         let pack = AssetPack::open("assets.expk")?;
+///         let background = pack.load("background")?;
+///         background.put_image(0, 0);
+///         Ok(())
+///     })
+/// }
+/// ```
+#[derive(Debug)]
+pub struct AssetPack {
+    ptr: *mut std::os::raw::c_void,
+}
+
+impl AssetPack {
+    /// 打开资源包
+    ///
+    /// # 参数
+    /// - `path`: 资源包文件路径
+    ///
+    /// # 返回值
+    /// 成功返回 AssetPack 对象，文件不存在或格式无效时返回 AssetError
+    pub fn open(path: &str) -> Result<Self, AssetError> {
+        let c_path = CString::new(path).map_err(|_| AssetError::Invalid)?;
+        let ptr = unsafe { easyx_pack_open(c_path.as_ptr()) };
+        if ptr.is_null() {
+            Err(AssetError::Io)
+        } else {
+            Ok(Self { ptr })
+        }
+    }
+
+    /// 获取资源数量
+    pub fn len(&self) -> usize {
+        unsafe { easyx_pack_count(self.ptr) as usize }
+    }
+
+    /// 判断资源包是否为空
+    pub fn is_empty(&self) -> bool {
+        self.len() == 0
+    }
+
+    /// 按名称查找资源
+    ///
+    /// # 参数
+    /// - `name`: 资源名称
+    ///
+    /// # 返回值
+    /// 资源编号，不存在时返回 None
+    pub fn find(&self, name: &str) -> Option<usize> {
+        let c_name = CString::new(name).ok()?;
+        let index = unsafe { easyx_pack_find(self.ptr, c_name.as_ptr()) };
+        if index >= 0 {
+            Some(index as usize)
+        } else {
+            None
+        }
+    }
+
+    /// 获取资源名称
+    ///
+    /// # 参数
+    /// - `index`: 资源编号
+    ///
+    /// # 返回值
+    /// 资源名称，编号无效或名称不是 UTF-8 时返回 None
+    pub fn name(&self, index: usize) -> Option<&str> {
+        let ptr = unsafe { easyx_pack_getname(self.ptr, index.min(i32::MAX as usize) as i32) };
+        if ptr.is_null() {
+            None
+        } else {
+            unsafe { CStr::from_ptr(ptr) }.to_str().ok()
+        }
+    }
+
+    /// 获取资源图像的大小
+    ///
+    /// # 参数
+    /// - `index`: 资源编号
+    ///
+    /// # 返回值
+    /// `(width, height)`，编号无效时返回 None
+    pub fn size(&self, index: usize) -> Option<(i32, i32)> {
+        let mut size = [0; 2];
+        let index = index.min(i32::MAX as usize) as i32;
+        if unsafe { easyx_pack_getsize(self.ptr, index, size.as_mut_ptr()) } != 0 {
+            Some((size[0], size[1]))
+        } else {
+            None
+        }
+    }
+
+    /// 按名称加载资源图像
+    ///
+    /// # 参数
+    /// - `name`: 资源名称
+    ///
+    /// # 返回值
+    /// 成功返回 Image 对象，失败返回 AssetError
+    pub fn load(&self, name: &str) -> Result<Image, AssetError> {
+        let index = self.find(name).ok_or(AssetError::NotFound)?;
+        self.load_index(index)
+    }
+
+    /// 按编号加载资源图像
+    ///
+    /// # 参数
+    /// - `index`: 资源编号
+    ///
+    /// # 返回值
+    /// 成功返回 Image 对象，失败返回 AssetError
+    pub fn load_index(&self, index: usize) -> Result<Image, AssetError> {
+        let img = Image::new(0, 0);
+        let index = index.min(i32::MAX as usize) as i32;
+        let result = unsafe { easyx_pack_load(self.ptr, index, img.as_mut_ptr()) };
+        if result == 0 {
+            Ok(img)
+        } else {
+            Err(result.into())
+        }
+    }
+}
+
+impl Drop for AssetPack {
+    /// 取消内存映射并关闭文件
+    fn drop(&mut self) {
+        unsafe {
+            easyx_pack_close(self.ptr);
+        }
+    }
+}
+
+/// 资源包生成器
+///
+/// 添加的图像会立即复制，之后可以释放
+#[derive(Debug)]
+pub struct AssetPackBuilder {
+    ptr: *mut std::os::raw::c_void,
+}
+
+impl AssetPackBuilder {
+    /// 创建空的资源包生成器
+    pub fn new() -> Self {
+        let ptr = unsafe { easyx_packwriter_create() };
+        Self { ptr }
+    }
+
+    /// 添加一张图像
+    ///
+    /// # 参数
+    /// - `name`: 资源名称，同名资源只能查找到先添加的一个
+    /// - `image`: 图像，宽高必须大于 0
+    ///
+    /// # 返回值
+    /// 成功返回 ()，失败返回 AssetError
+    pub fn add(&mut self, name: &str, image: &Image) -> Result<(), AssetError> {
+        let c_name = CString::new(name).map_err(|_| AssetError::Invalid)?;
+        let result = unsafe { easyx_packwriter_add(self.ptr, c_name.as_ptr(), image.as_mut_ptr()) };
+        if result == 0 {
+            Ok(())
+        } else {
+            Err(result.into())
+        }
+    }
+
+    /// 写入资源包文件
+    ///
+    /// # 参数
+    /// - `path`: 资源包文件路径，已存在时覆盖
+    ///
+    /// # 返回值
+    /// 成功返回 ()，失败返回 AssetError
+    pub fn write(&self, path: &str) -> Result<(), AssetError> {
+        let c_path = CString::new(path).map_err(|_| AssetError::Invalid)?;
+        let result = unsafe { easyx_packwriter_save(self.ptr, c_path.as_ptr()) };
+        if result == 0 {
+            Ok(())
+        } else {
+            Err(result.into())
+        }
+    }
+}
+
+impl Default for AssetPackBuilder {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+impl Drop for AssetPackBuilder {
+    /// 释放生成器持有的像素
+    fn drop(&mut self) {
+        unsafe {
+            easyx_packwriter_destroy(self.ptr);
+        }
+    }
+}
@@ -0,0 +1,209 @@
+//! 借用的顶点缓冲区，绘制折线和多边形时不需要转换为 `POINT` 数组
+
+use std::marker::PhantomData;
+use std::mem::size_of;
+use std::os::raw::c_void;
+
+use easyx_sys::*;
+
+/// 借用的顶点缓冲区
+///
+/// 描述调用者已有的顶点数据，第 `i` 个顶点的x、y坐标分别位于 `x + i * stride` 和 `y + i * stride`，
+/// 覆盖交错存放（`[[f32; 2]]`、元组）和分开存放（两个坐标数组）的常见布局。
+/// 紧密排列的 `i32` 顶点直接交给 GDI，其他布局由 C++ 包装层在线程局部的暂存区中转换，
+/// Rust 侧不需要每帧分配 `Vec<POINT>`。
+///
+/// `f32` 坐标按四舍五入（就近取偶）取整。
+///
+/// # 示例
+/// ```no_run
+/// use easyx::prelude::*;
+/// use easyx::run;
+///
+/// fn main() -> Result<(), Box<dyn std::error::Error>> {
+///     run(800, 600, |app| {
+///         let wave: Vec<(f32, f32)> = (0..800)
+///             .map(|x| (x as f32, 300.0 + 100.0 * (x as f32 / 50.0).sin()))
+///             .collect();
+///         app.poly_line_coords(&wave);
+///
+///         let xs: Vec<i32> = (0..800).collect();
+///         let ys: Vec<i32> = xs.iter().map(|x| 500 - x / 4).collect();
+///         app.poly_line_coords(Coords::split_i32(&xs, &ys));
+///         Ok(())
+///     })
+/// }
+/// ```
+#[derive(Debug, Clone, Copy)]
+pub struct Coords<'a> {
+    x: *const c_void,
+    y: *const c_void,
+    stride: usize,
+    kind: i32,
+    len: usize,
+    _data: PhantomData<&'a [u8]>,
+}
+
+impl<'a> Coords<'a> {
+    /// 以第一个元素中x、y坐标的地址构造顶点缓冲区，空切片时不会被读取
+    fn interleaved<T, C>(items: &'a [T], kind: u32, fields: impl Fn(&T) -> (&C, &C)) -> Self {
+        let (x, y) = match items.first() {
+            Some(first) => {
+                let (x, y) = fields(first);
+                (
+                    x as *const C as *const c_void,
+                    y as *const C as *const c_void,
+                )
+            }
+            None => (
+                items.as_ptr() as *const c_void,
+                items.as_ptr() as *const c_void,
+            ),
+        };
+        Self {
+            x,
+            y,
+            stride: size_of::<T>(),
+            kind: kind as i32,
+            len: items.len(),
+            _data: PhantomData,
+        }
+    }
+
+    fn split<C>(xs: &'a [C], ys: &'a [C], kind: u32) -> Self {
+        Self {
+            x: xs.as_ptr() as *const c_void,
+            y: ys.as_ptr() as *const c_void,
+            stride: size_of::<C>(),
+            kind: kind as i32,
+            len: xs.len().min(ys.len()),
+            _data: PhantomData,
+        }
+    }
+
+    /// 使用 `POINT` 数组
+    pub fn points(points: &'a [POINT]) -> Self {
+        Self::interleaved(points, EASYX_COORD_INT32, |p| (&p.x, &p.y))
+    }
+
+    /// 使用 `(x, y)` 元组数组
+    pub fn pairs_i32(points: &'a [(i32, i32)]) -> Self {
+        Self::interleaved(points, EASYX_COORD_INT32, |p| (&p.0, &p.1))
+    }
+
+    /// 使用 `(x, y)` 元组数组，坐标四舍五入取整
+    pub fn pairs_f32(points: &'a [(f32, f32)]) -> Self {
+        Self::interleaved(points, EASYX_COORD_FLOAT, |p| (&p.0, &p.1))
+    }
+
+    /// 使用 `[x, y]` 数组
+    pub fn arrays_i32(points: &'a [[i32; 2]]) -> Self {
+        Self::interleaved(points, EASYX_COORD_INT32, |p| (&p[0], &p[1]))
+    }
+
+    /// 使用 `[x, y]` 数组，坐标四舍五入取整
+    pub fn arrays_f32(points: &'a [[f32; 2]]) -> Self {
+        Self::interleaved(points, EASYX_COORD_FLOAT, |p| (&p[0], &p[1]))
+    }
+
+    /// 使用分开存放的x坐标和y坐标数组，顶点数为两者中较短的长度
+    pub fn split_i32(xs: &'a [i32], ys: &'a [i32]) -> Self {
+        Self::split(xs, ys, EASYX_COORD_INT32)
+    }
+
+    /// 使用分开存放的x坐标和y坐标数组，顶点数为两者中较短的长度，坐标四舍五入取整
+    pub fn split_f32(xs: &'a [f32], ys: &'a [f32]) -> Self {
+        Self::split(xs, ys, EASYX_COORD_FLOAT)
+    }
+
+    /// 获取顶点数
+    pub fn len(&self) -> usize {
+        self.len
+    }
+
+    /// 判断是否没有顶点
+    pub fn is_empty(&self) -> bool {
+        self.len == 0
+    }
+
+    /// 顶点数，超出 C 接口范围的部分被截断
+    pub(crate) fn count(&self) -> i32 {
+        self.len.min(i32::MAX as usize) as i32
+    }
+
+    pub(crate) fn x_ptr(&self) -> *const c_void {
+        self.x
+    }
+
+    pub(crate) fn y_ptr(&self) -> *const c_void {
+        self.y
+    }
+
+    pub(crate) fn stride(&self) -> usize {
+        self.stride
+    }
+
+    pub(crate) fn kind(&self) -> i32 {
+        self.kind
+    }
+}
+
+impl<'a> From<&'a [POINT]> for Coords<'a> {
+    fn from(points: &'a [POINT]) -> Self {
+        Self::points(points)
+    }
+}
+
+impl<'a> From<&'a [(i32, i32)]> for Coords<'a> {
+    fn from(points: &'a [(i32, i32)]) -> Self {
+        Self::pairs_i32(points)
+    }
+}
+
+impl<'a> From<&'a [(f32, f32)]> for Coords<'a> {
+    fn from(points: &'a [(f32, f32)]) -> Self {
+        Self::pairs_f32(points)
+    }
+}
+
+impl<'a> From<&'a [[i32; 2]]> for Coords<'a> {
+    fn from(points: &'a [[i32; 2]]) -> Self {
+        Self::arrays_i32(points)
+    }
+}
+
+impl<'a> From<&'a [[f32; 2]]> for Coords<'a> {
+    fn from(points: &'a [[f32; 2]]) -> Self {
+        Self::arrays_f32(points)
+    }
+}
+
+impl<'a> From<&'a Vec<POINT>> for Coords<'a> {
+    fn from(points: &'a Vec<POINT>) -> Self {
+        Self::points(points)
+    }
+}
+
+impl<'a> From<&'a Vec<(i32, i32)>> for Coords<'a> {
+    fn from(points: &'a Vec<(i32, i32)>) -> Self {
+        Self::pairs_i32(points)
+    }
+}
+
+impl<'a> From<&'a Vec<(f32, f32)>> for Coords<'a> {
+    fn from(points: &'a Vec<(f32, f32)>) -> Self {
+        Self::pairs_f32(points)
+    }
+}
+
+impl<'a> From<&'a Vec<[i32; 2]>> for Coords<'a> {
+    fn from(points: &'a Vec<[i32; 2]>) -> Self {
+        Self::arrays_i32(points)
+    }
+}
+
+impl<'a> From<&'a Vec<[f32; 2]>> for Coords<'a> {
+    fn from(points: &'a Vec<[f32; 2]>) -> Self {
+        Self::arrays_f32(points)
+    }
+}
@@ -0,0 +1,186 @@
+//! 图像比较，用于黄金图像（golden image）测试
+
+use std::error::Error;
+use std::ffi::CString;
+use std::fmt;
+use std::path::Path;
+
+use easyx_sys::*;
+
+use crate::image::{Image, ImageError};
+
+/// 两幅图像的比较结果
+#[derive(Debug, Clone, Copy, Default, PartialEq, Eq)]
+pub struct ImageDiff {
+    /// 超出容差的像素数
+    pub pixels: u64,
+    /// 所有像素中红、绿、蓝通道差值的最大值
+    pub max_delta: u8,
+    /// 超出容差的像素的外接矩形 (left, top, right, bottom)，包含右下边界
+    pub bounds: Option<(i32, i32, i32, i32)>,
+}
+
+impl ImageDiff {
+    /// 是否没有超出容差的像素
+    pub fn is_match(&self) -> bool {
+        self.pixels == 0
+    }
+}
+
+/// 图像比较的错误
+#[derive(Debug, PartialEq, Eq)]
+pub enum CompareError {
+    /// 两幅图像的大小不同
+    SizeMismatch,
+    /// 图像没有像素缓冲区，或差异图与参与比较的图像相同
+    Invalid,
+    /// 加载或保存图像失败
+    Image(ImageError),
+    /// 超出容差的像素多于允许的数量
+    ///
+    /// `diff_path` 为写入的差异图路径
+    Mismatch { diff: ImageDiff, diff_path: String },
+}
+
+impl fmt::Display for CompareError {
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        match self {
+            CompareError::SizeMismatch => write!(f, "图像大小不同"),
+            CompareError::Invalid => write!(f, "无效的图像"),
+            CompareError::Image(err) => write!(f, "{}", err),
+            CompareError::Mismatch { diff, diff_path } => write!(
+                f,
+                "{} 个像素超出容差，最大差值 {}，差异图: {}",
+                diff.pixels, diff.max_delta, diff_path
+            ),
+        }
+    }
+}
+
+impl Error for CompareError {}
+
+impl From<ImageError> for CompareError {
+    fn from(err: ImageError) -> Self {
+        CompareError::Image(err)
+    }
+}
+
+/// 为 None 时取当前工作图像，保存和比较使用同一幅图像
+fn image_ptr(image: Option<&Image>) -> *mut std::os::raw::c_void {
+    image.map_or_else(|| unsafe { easyx_getworkingimage() }, |img| img.as_mut_ptr())
+}
+
+/// 比较两幅图像
+///
+/// 按 CPU 支持情况使用 SSE2/AVX2 内核逐行比较红、绿、蓝通道，透明度不参与比较
+/// （GDI 绘制的像素透明度通常为 0）。任一通道的差值超过 `tolerance` 的像素计为不同。
+///
+/// # 参数
+/// - `actual`: 实际的图像，为 None 时使用当前工作图像（无窗口模式下为画布）
+/// - `expected`: 期望的图像
+/// - `tolerance`: 每个通道允许的差值
+/// - `diff`: 不为 None 时调整为同样大小并写入差异图：超出容差的像素为红色，
+///   容差内的差异为黄色，其余为变淡的灰度
+///
+/// # 返回值
+/// 比较结果，图像大小不同时返回 `CompareError::SizeMismatch`
+pub fn compare_images(
+    actual: Option<&Image>,
+    expected: &Image,
+    tolerance: u8,
+    diff: Option<&mut Image>,
+) -> Result<ImageDiff, CompareError> {
+    compare_ptr(image_ptr(actual), expected, tolerance, diff)
+}
+
+fn compare_ptr(
+    actual: *mut std::os::raw::c_void,
+    expected: &Image,
+    tolerance: u8,
+    diff: Option<&mut Image>,
+) -> Result<ImageDiff, CompareError> {
+    let mut result = unsafe { std::mem::zeroed::<EasyXImageDiff>() };
+    let diff = diff.map_or(std::ptr::null_mut(), |img| img.as_mut_ptr());
+    let ret = unsafe {
+        easyx_image_compare(
+            actual,
+            expected.as_mut_ptr(),
+            tolerance as i32,
+            diff,
+            &mut result,
+        )
+    };
+
+    match ret {
+        EASYX_COMPARE_ERR_SIZE => Err(CompareError::SizeMismatch),
+        r if r < 0 => Err(CompareError::Invalid),
+        _ => Ok(ImageDiff {
+            pixels: result.pixels,
+            max_delta: result.maxDelta.clamp(0, 255) as u8,
+            bounds: (result.pixels > 0).then_some((
+                result.left,
+                result.top,
+                result.right,
+                result.bottom,
+            )),
+        }),
+    }
+}
+
+/// 与黄金图像比较
+///
+/// 黄金图像不存在时把实际的图像保存为黄金图像并返回一致的结果；
+/// 超出容差的像素多于 `max_pixels` 时在黄金图像旁写入 `<文件名>.diff.png` 差异图。
+///
+/// # 参数
+/// - `actual`: 实际的图像，为 None 时使用当前工作图像（无窗口模式下为画布）
+/// - `path`: 黄金图像的路径
+/// - `tolerance`: 每个通道允许的差值
+/// - `max_pixels`: 允许超出容差的像素数
+///
+/// # 返回值
+/// 比较结果，超出允许的像素数时返回 `CompareError::Mismatch`
+///
+/// # 示例
+/// ```no_run
+/// use easyx::prelude::*;
+/// use easyx::run_headless;
+///
+/// fn main() -> Result<(), Box<dyn std::error::Error>> {
+///     run_headless(320, 240, |app| {
+///         app.clear_device();
+///         app.fill_circle(160, 120, 50);
+///         check_golden(None, "tests/golden/circle.png", 2, 0)?;
+///         Ok(())
+///     })
+/// }
+/// ```
+pub fn check_golden(
+    actual: Option<&Image>,
+    path: &str,
+    tolerance: u8,
+    max_pixels: u64,
+) -> Result<ImageDiff, CompareError> {
+    let c_path = CString::new(path).map_err(|_| ImageError::Unknown(-1))?;
+    let actual = image_ptr(actual);
+    if !Path::new(path).exists() {
+        unsafe {
+            easyx_saveimage(c_path.as_ptr(), actual);
+        }
+        return Ok(ImageDiff::default());
+    }
+
+    let expected = Image::load_file(path, 0, 0, false)?;
+    let diff = compare_ptr(actual, &expected, tolerance, None)?;
+    if diff.pixels <= max_pixels {
+        return Ok(diff);
+    }
+
+    // 只在不一致时才生成差异图，一致时只运行向量化的比较
+    let mut diff_image = Image::new(1, 1);
+    compare_ptr(actual, &expected, tolerance, Some(&mut diff_image))?;
+    let diff_path = Path::new(path).with_extension("diff.png");
+    let diff_path = diff_path.to_string_lossy().into_owned();
+    diff_image.save(&diff_path)?;
+    Err(CompareError::Mismatch { diff, diff_path })
+}
@@ -2,7 +2,10 @@ use easyx_sys::*;
 use std::error::Error;
 use std::ffi::CString;
 use std::fmt;
+use std::marker::PhantomData;
 use std::ptr;
+use std::sync::Mutex;
+use std::task::Waker;
 
 use crate::color::Color;
 
@@ -166,6 +169,79 @@ impl From<i32> for ImageError {
     }
 }
 
+/// 批量读写像素时外部缓冲区的像素格式
+#[derive(Debug, Copy, Clone, PartialEq, Eq, Hash, Default)]
+pub enum PixelFormat {
+    /// 0xAARRGGBB，与图像缓冲区相同，读写时直接复制
+    #[default]
+    Argb,
+    /// 0xAABBGGRR，与 COLORREF 相同，读写时交换红蓝通道
+    Abgr,
+}
+
+impl PixelFormat {
+    /// 将 PixelFormat 转换为 i32
+    pub fn as_i32(&self) -> i32 {
+        match self {
+            Self::Argb => EASYX_PIXEL_ARGB as i32,
+            Self::Abgr => EASYX_PIXEL_ABGR as i32,
+        }
+    }
+}
+
+/// 图像变换时的采样方式
+#[derive(Debug, Copy, Clone, PartialEq, Eq, Hash, Default)]
+pub enum Filter {
+    /// 最近邻采样，最快，放大时像素呈块状
+    #[default]
+    Nearest,
+    /// 双线性采样，旋转和缩放后边缘更平滑
+    Bilinear,
+}
+
+impl Filter {
+    /// 将 Filter 转换为 `EASYX_TRANSFORM_*` 标志
+    pub fn as_i32(&self) -> i32 {
+        match self {
+            Self::Nearest => EASYX_TRANSFORM_NEAREST as i32,
+            Self::Bilinear => EASYX_TRANSFORM_BILINEAR as i32,
+        }
+    }
+}
+
+/// 变换绘制的标志，`blend` 为 `Some(alpha)` 时按透明度通道和全局透明度混合
+fn transform_flags(filter: Filter, blend: Option<u8>) -> (i32, u8) {
+    match blend {
+        Some(alpha) => (filter.as_i32() | EASYX_TRANSFORM_BLEND as i32, alpha),
+        None => (filter.as_i32(), 255),
+    }
+}
+
+/// 检查外部缓冲区能否容纳 width x height 的区域，返回实际使用的行跨度
+/// 
+/// # 参数
+/// - `len`: 缓冲区长度（像素数）
+/// - `width`: 区域宽度
+/// - `height`: 区域高度
+/// - `stride`: 每行的像素数，0 表示等于 `width`
+pub(crate) fn pixel_stride(len: usize, width: i32, height: i32, stride: usize) -> usize {
+    let width = width.max(0) as usize;
+    let height = height.max(0) as usize;
+    let stride = if stride == 0 { width } else { stride };
+
+    assert!(stride >= width, "行跨度 {} 小于区域宽度 {}", stride, width);
+    if width > 0 && height > 0 {
+        let required = (height - 1) * stride + width;
+        assert!(
+            len >= required,
+            "缓冲区长度 {} 不足，至少需要 {} 个像素",
+            len,
+            required
+        );
+    }
+    stride
+}
+
 /// 图像结构体，用于包装 EasyX 的 IMAGE 类型
 /// 
 /// Image 结构体是 EasyX-RS 中表示图像的核心类型，
@@ -178,6 +254,9 @@ pub struct Image {
 impl Image {
     /// 创建一个新的图像
     /// 
+    /// 优先从图像池中取出同样大小的空闲图像（见 `ImagePool`），像素清零、绘图状态恢复默认，
+    /// 与新创建的图像没有区别，但省去了创建位图的开销
+    /// 
     /// # 参数
     /// - `width`: 图像宽度
     /// - `height`: 图像高度
@@ -185,7 +264,7 @@ impl Image {
     /// # 返回值
     /// 新创建的 Image 对象
     pub fn new(width: i32, height: i32) -> Self {
-        let ptr = unsafe { easyx_create_image(width, height) };
+        let ptr = unsafe { easyx_image_acquire(width, height) };
         Self { ptr }
     }
 
@@ -244,6 +323,66 @@ impl Image {
         }
     }
 
+    /// 在后台线程中异步加载图像文件
+    /// 
+    /// 解码在工作线程中进行，不会阻塞绘图线程。解码完成后需要在绘图线程中调用
+    /// `App::finalize_image_loads` 创建图像，之后才能通过返回的句柄取得结果
+    /// 
+    /// # 参数
+    /// - `path`: 图像文件路径（bmp/png/jpg 等 WIC 支持的格式）
+    /// - `width`: 拉伸后的宽度，0表示使用原始宽度
+    /// - `height`: 拉伸后的高度，0表示使用原始高度
+    /// 
+    /// # 返回值
+    /// 成功返回加载句柄，路径无效时返回 ImageError
+    /// 
+    /// # 示例
+    /// ```no_run
+    /// use easyx::prelude::*;
+    /// use easyx::run;
+    /// use std::time::Duration;
+    ///
+    /// fn main() -> Result<(), Box<dyn std::error::Error>> {
+    ///     run(800, 600, |app| {
+    ///         app.reset_image_load_progress();
+    ///         let mut pending: Vec<LoadHandle> = ["a.png", "b.png", "c.jpg"]
+    ///             .iter()
+    ///             .map(|path| Image::load_file_async(path, 0, 0))
+    ///             .collect::<Result<_, _>>()?;
+    ///         let mut images = Vec::new();
+    ///
+    ///         app.begin_batch_draw();
+    ///         while !pending.is_empty() {
+    ///             // 每帧最多花 4 毫秒创建图像，保持窗口响应
+    ///             app.finalize_image_loads(Duration::from_millis(4));
+    ///             pending.retain_mut(|handle| match handle.try_take() {
+    ///                 Some(result) => {
+    ///                     images.push(result);
+    ///                     false
+    ///                 }
+    ///                 None => true,
+    ///             });
+    ///
+    ///             let progress = app.image_load_progress();
+    ///             app.clear_device();
+    ///             app.fill_rectangle(0, 290, (progress.fraction() * 800.0) as i32, 310);
+    ///             app.flush_batch_draw();
+    ///         }
+    ///         app.end_batch_draw();
+    ///         Ok(())
+    ///     })
+    /// }
+    /// ```
+    pub fn load_file_async(path: &str, width: i32, height: i32) -> Result<LoadHandle, ImageError> {
+        let c_path = CString::new(path).map_err(|_| ImageError::Unknown(-1))?;
+        let id = unsafe { easyx_loadimage_async(c_path.as_ptr(), width, height) };
+        if id > 0 {
+            Ok(LoadHandle { id })
+        } else {
+            Err(ImageError::Unknown(-1))
+        }
+    }
+
     /// 从资源加载图像
     /// 
     /// # 参数
@@ -389,6 +528,46 @@ impl Image {
         }
     }
 
+    /// 按透明度通道混合绘制图像
+    /// 
+    /// 使用图像自身的透明度通道（例如带透明度的 PNG）与目标混合，
+    /// 并额外乘以全局透明度，不需要掩码图和两次绘制。
+    /// 绘制范围会裁剪到目标设备和裁剪区域的外接矩形内
+    /// 
+    /// # 参数
+    /// - `x`: 目标位置x坐标
+    /// - `y`: 目标位置y坐标
+    /// - `alpha`: 全局透明度，255 表示仅使用图像自身的透明度
+    pub fn put_image_alpha(&self, x: i32, y: i32, alpha: u8) {
+        self.put_image_part_alpha(x, y, self.width(), self.height(), 0, 0, alpha);
+    }
+
+    /// 按透明度通道混合绘制图像的一部分
+    /// 
+    /// # 参数
+    /// - `x`: 目标位置x坐标
+    /// - `y`: 目标位置y坐标
+    /// - `width`: 绘制宽度
+    /// - `height`: 绘制高度
+    /// - `src_x`: 源图像起始x坐标
+    /// - `src_y`: 源图像起始y坐标
+    /// - `alpha`: 全局透明度，255 表示仅使用图像自身的透明度
+    #[allow(clippy::too_many_arguments)]
+    pub fn put_image_part_alpha(
+        &self,
+        x: i32,
+        y: i32,
+        width: i32,
+        height: i32,
+        src_x: i32,
+        src_y: i32,
+        alpha: u8,
+    ) {
+        unsafe {
+            easyx_putimage_alpha(x, y, self.ptr, src_x, src_y, width, height, alpha);
+        }
+    }
+
     /// 旋转图像
     /// 
     /// # 参数
@@ -421,14 +600,263 @@ impl Image {
         img
     }
 
+    /// 快速旋转并缩放图像
+    /// 
+    /// `rotate` 的替代方法，一次仿射变换直接写入新图像的缓冲区。
+    /// 新图像大小为旋转后的外接矩形，未被源图像覆盖的像素为透明（0）。
+    /// 每帧都要旋转同一张图像时使用 `rotation_cache`
+    /// 
+    /// # 参数
+    /// - `radian`: 逆时针旋转的弧度
+    /// - `scale`: 缩放比例
+    /// - `filter`: 采样方式
+    /// 
+    /// # 返回值
+    /// 旋转后的新 Image 对象
+    pub fn rotated(&self, radian: f64, scale: f64, filter: Filter) -> Self {
+        let img = Self::new(1, 1);
+        unsafe {
+            easyx_rotateimage_fast(img.ptr, self.ptr, radian, scale, filter.as_i32());
+        }
+        img
+    }
+
+    /// 带过滤的缩放
+    /// 
+    /// 与 `resize` 不同，会按 `filter` 重新采样像素，而不是保留左上角的内容
+    /// 
+    /// # 参数
+    /// - `width`: 新宽度
+    /// - `height`: 新高度
+    /// - `filter`: 采样方式
+    /// 
+    /// # 返回值
+    /// 缩放后的新 Image 对象
+    pub fn scaled(&self, width: i32, height: i32, filter: Filter) -> Self {
+        let img = Self::new(1, 1);
+        unsafe {
+            easyx_scaleimage(img.ptr, self.ptr, width.max(1), height.max(1), filter.as_i32());
+        }
+        img
+    }
+
+    /// 旋转并缩放后绘制到当前工作图像，不创建中间图像
+    /// 
+    /// 图像中心放到 `(x, y)`，坐标为逻辑坐标，自动裁剪到设备范围和裁剪区域的外接矩形内
+    /// 
+    /// # 参数
+    /// - `x`: 图像中心的目标x坐标
+    /// - `y`: 图像中心的目标y坐标
+    /// - `radian`: 逆时针旋转的弧度
+    /// - `scale_x`: 水平缩放比例
+    /// - `scale_y`: 垂直缩放比例
+    /// - `filter`: 采样方式
+    /// - `blend`: `None` 表示直接复制，`Some(alpha)` 表示按透明度通道和全局透明度混合
+    #[allow(clippy::too_many_arguments)]
+    pub fn put_image_transform(
+        &self,
+        x: f64,
+        y: f64,
+        radian: f64,
+        scale_x: f64,
+        scale_y: f64,
+        filter: Filter,
+        blend: Option<u8>,
+    ) {
+        let (flags, alpha) = transform_flags(filter, blend);
+        let pivot_x = self.width() as f64 * 0.5;
+        let pivot_y = self.height() as f64 * 0.5;
+        unsafe {
+            easyx_putimage_transform(
+                x, y, self.ptr, radian, scale_x, scale_y, pivot_x, pivot_y, flags, alpha,
+            );
+        }
+    }
+
+    /// 按仿射矩阵绘制到当前工作图像
+    /// 
+    /// 源图像坐标 `(u, v)` 映射到 `(m[0] * u + m[1] * v + m[2], m[3] * u + m[4] * v + m[5])`（逻辑坐标）
+    /// 
+    /// # 参数
+    /// - `matrix`: 仿射矩阵
+    /// - `filter`: 采样方式
+    /// - `blend`: `None` 表示直接复制，`Some(alpha)` 表示按透明度通道和全局透明度混合
+    pub fn put_image_affine(&self, matrix: &[f64; 6], filter: Filter, blend: Option<u8>) {
+        let (flags, alpha) = transform_flags(filter, blend);
+        unsafe {
+            easyx_putimage_affine(self.ptr, matrix.as_ptr(), flags, alpha);
+        }
+    }
+
+    /// 按仿射矩阵把 `src` 绘制到本图像中，坐标为本图像的像素坐标
+    /// 
+    /// # 参数
+    /// - `src`: 源图像
+    /// - `matrix`: 仿射矩阵，含义与 `put_image_affine` 相同
+    /// - `filter`: 采样方式
+    /// - `blend`: `None` 表示直接复制，`Some(alpha)` 表示按透明度通道和全局透明度混合
+    pub fn draw_affine(&mut self, src: &Image, matrix: &[f64; 6], filter: Filter, blend: Option<u8>) {
+        let (flags, alpha) = transform_flags(filter, blend);
+        unsafe {
+            easyx_transformimage(self.ptr, src.ptr, matrix.as_ptr(), flags, alpha);
+        }
+    }
+
+    /// 创建按量化角度缓存预旋转帧的旋转缓存
+    /// 
+    /// # 参数
+    /// - `steps`: 一整圈划分的角度数，绘制时角度取最近的一档
+    /// - `scale`: 缩放比例
+    /// - `filter`: 渲染帧时的采样方式
+    /// 
+    /// # 返回值
+    /// 新创建的 RotationCache 对象
+    pub fn rotation_cache(&self, steps: u32, scale: f64, filter: Filter) -> RotationCache<'_> {
+        RotationCache::new(self, steps, scale, filter)
+    }
+
     /// 获取图像缓冲区
     /// 
+    /// 需要安全地访问像素时使用 `pixels` / `pixels_mut`
+    /// 
     /// # 返回值
     /// 指向图像像素数据的指针，每个像素为32位RGBA格式
     pub fn buffer(&self) -> *mut u32 {
         unsafe { easyx_getimagebuffer(self.ptr) }
     }
 
+    /// 获取图像像素的只读切片
+    /// 
+    /// 像素按行排列，每行 `width()` 个，格式为 0xAARRGGBB
+    /// 
+    /// # 返回值
+    /// 长度为 `width() * height()` 的像素切片
+    /// 
+    /// # Panics
+    /// 此图像是当前工作图像时触发 panic，`App` 的绘图函数不借用图像就能写入工作图像
+    pub fn pixels(&self) -> &[u32] {
+        let (buffer, len) = self.pixel_buffer();
+        if buffer.is_null() || len == 0 {
+            return &[];
+        }
+        unsafe { std::slice::from_raw_parts(buffer, len) }
+    }
+
+    /// 获取图像像素的可变切片
+    /// 
+    /// 直接修改图像内容，不经过 GDI
+    /// 
+    /// # 返回值
+    /// 长度为 `width() * height()` 的像素切片
+    /// 
+    /// # Panics
+    /// 此图像是当前工作图像时触发 panic，`App` 的绘图函数不借用图像就能写入工作图像
+    pub fn pixels_mut(&mut self) -> &mut [u32] {
+        let (buffer, len) = self.pixel_buffer();
+        if buffer.is_null() || len == 0 {
+            return &mut [];
+        }
+        unsafe { std::slice::from_raw_parts_mut(buffer, len) }
+    }
+
+    /// 借出像素切片前检查此图像不是工作图像，返回缓冲区和像素数
+    fn pixel_buffer(&self) -> (*mut u32, usize) {
+        assert!(
+            unsafe { easyx_getworkingimage() } != self.ptr,
+            "不能借用当前工作图像的像素"
+        );
+        let len = self.width().max(0) as usize * self.height().max(0) as usize;
+        (self.buffer(), len)
+    }
+
+    /// 批量读取图像像素
+    /// 
+    /// 按行复制到 `dst`，超出图像的部分跳过，`dst` 中对应位置保持不变
+    /// 
+    /// # 参数
+    /// - `x`: 区域左上角x坐标
+    /// - `y`: 区域左上角y坐标
+    /// - `width`: 区域宽度
+    /// - `height`: 区域高度
+    /// - `dst`: 目标缓冲区
+    /// - `stride`: 目标缓冲区每行的像素数，0 表示等于 `width`
+    /// - `format`: 目标缓冲区的像素格式
+    /// 
+    /// # 返回值
+    /// 实际复制的像素数
+    /// 
+    /// # Panics
+    /// `dst` 无法容纳整个区域时触发 panic
+    #[allow(clippy::too_many_arguments)]
+    pub fn read_pixels(
+        &self,
+        x: i32,
+        y: i32,
+        width: i32,
+        height: i32,
+        dst: &mut [u32],
+        stride: usize,
+        format: PixelFormat,
+    ) -> usize {
+        let stride = pixel_stride(dst.len(), width, height, stride);
+        unsafe {
+            easyx_read_pixels(
+                self.ptr,
+                x,
+                y,
+                width,
+                height,
+                dst.as_mut_ptr(),
+                stride,
+                format.as_i32(),
+            ) as usize
+        }
+    }
+
+    /// 批量写入图像像素
+    /// 
+    /// 按行从 `src` 复制，超出图像的部分跳过
+    /// 
+    /// # 参数
+    /// - `x`: 区域左上角x坐标
+    /// - `y`: 区域左上角y坐标
+    /// - `width`: 区域宽度
+    /// - `height`: 区域高度
+    /// - `src`: 源缓冲区
+    /// - `stride`: 源缓冲区每行的像素数，0 表示等于 `width`
+    /// - `format`: 源缓冲区的像素格式
+    /// 
+    /// # 返回值
+    /// 实际复制的像素数
+    /// 
+    /// # Panics
+    /// `src` 小于整个区域时触发 panic
+    #[allow(clippy::too_many_arguments)]
+    pub fn write_pixels(
+        &mut self,
+        x: i32,
+        y: i32,
+        width: i32,
+        height: i32,
+        src: &[u32],
+        stride: usize,
+        format: PixelFormat,
+    ) -> usize {
+        let stride = pixel_stride(src.len(), width, height, stride);
+        unsafe {
+            easyx_write_pixels(
+                self.ptr,
+                x,
+                y,
+                width,
+                height,
+                src.as_ptr(),
+                stride,
+                format.as_i32(),
+            ) as usize
+        }
+    }
+
     /// 获取当前工作图像
     /// 
     /// # 返回值
@@ -496,10 +924,427 @@ impl Image {
 impl Drop for Image {
     /// 释放图像资源
     /// 
-    /// 当 Image 对象被销毁时，自动释放底层的 IMAGE 结构资源
+    /// 当 Image 对象被销毁时，把底层的 IMAGE 放回图像池，超出图像池的内存预算时直接销毁
+    fn drop(&mut self) {
+        unsafe {
+            easyx_image_release(self.ptr);
+        }
+    }
+}
+
+/// 图像池的统计信息
+#[derive(Debug, Clone, Copy, Default, PartialEq, Eq)]
+pub struct ImagePoolStats {
+    /// 取出空闲图像的次数
+    pub hits: u64,
+    /// 没有空闲图像、新建图像的次数
+    pub misses: u64,
+    /// 放回池中的次数
+    pub released: u64,
+    /// 因超出预算被销毁的空闲图像数
+    pub evictions: u64,
+    /// 空闲图像占用的字节数
+    pub bytes: u64,
+    /// 空闲图像数
+    pub idle: usize,
+}
+
+/// 图像池
+/// 
+/// `Image` 销毁时底层的 IMAGE 按宽高放回池中，`Image::new` 优先取出同样大小的空闲图像，
+/// 每帧创建的临时图像（`Image::get_image`、旋转结果、离屏图层）不再每次都创建位图和 GDI 对象。
+/// 空闲图像超出内存预算（默认 64 MiB）时先销毁最早放回的。
+/// 
+/// 图像池是全局的，内部带锁，任意线程上创建和销毁的 `Image` 都会经过它。
+/// 清除绘图状态缓存只能在绘图线程中进行，其他线程上销毁的 `Image` 会等到绘图线程
+/// 下一次创建或销毁 `Image` 时才放回池中。
+/// 
+/// # 示例
+/// ```no_run
+/// use easyx::prelude::*;
+/// use easyx::run;
+/// 
+/// fn main() -> Result<(), Box<dyn std::error::Error>> {
+///     run(800, 600, |app| {
+///         for _ in 0..100 {
+///             // 第一次之后都从池中取出
+///             let snapshot = Image::get_image(0, 0, 200, 200);
+///             snapshot.put_image(300, 300);
+///         }
+///         println!("{:?}", ImagePool::stats());
+///         Ok(())
+///     })
+/// }
+/// ```
+pub struct ImagePool;
+
+impl ImagePool {
+    /// 设置内存预算，超出的部分立即销毁
+    /// 
+    /// # 参数
+    /// - `bytes`: 空闲图像最多占用的字节数，0 表示禁用图像池
+    pub fn set_budget(bytes: usize) {
+        unsafe {
+            easyx_imagepool_setbudget(bytes);
+        }
+    }
+
+    /// 获取内存预算（字节）
+    pub fn budget() -> usize {
+        unsafe { easyx_imagepool_getbudget() }
+    }
+
+    /// 销毁所有空闲图像，统计信息保留
+    pub fn clear() {
+        unsafe {
+            easyx_imagepool_clear();
+        }
+    }
+
+    /// 获取统计信息
+    pub fn stats() -> ImagePoolStats {
+        let mut stats = EasyXImagePoolStats {
+            hits: 0,
+            misses: 0,
+            released: 0,
+            evictions: 0,
+            bytes: 0,
+            idle: 0,
+        };
+        unsafe {
+            easyx_imagepool_getstats(&mut stats);
+        }
+        ImagePoolStats {
+            hits: stats.hits,
+            misses: stats.misses,
+            released: stats.released,
+            evictions: stats.evictions,
+            bytes: stats.bytes,
+            idle: stats.idle.max(0) as usize,
+        }
+    }
+}
+
+/// 旋转缓存
+/// 
+/// 把一整圈划分为 `steps` 个角度，某个角度第一次绘制时渲染一帧预旋转的图像并缓存，
+/// 之后同一档角度只需复制或混合缓存的像素。直接复制时只复制每行被源图像覆盖的部分，
+/// 旋转后的空白角不会覆盖背景。
+/// 
+/// # 注意
+/// - 坐标为逻辑坐标，自动裁剪到设备范围和裁剪区域的外接矩形内
+/// - 源图像的像素变化后需要调用 `invalidate`
+/// - 每帧占用一张外接矩形大小的图像，`steps` 越大越平滑，占用的内存也越多
+/// 
+/// # 示例
+/// ```no_run
+/// use easyx::prelude::*;
+/// use easyx::run;
+/// 
+/// fn main() -> Result<(), Box<dyn std::error::Error>> {
+///     run(800, 600, |app| {
+///         let sprite = Image::load_file("ship.png", 0, 0, false)?;
+///         let mut cache = sprite.rotation_cache(64, 1.0, Filter::Bilinear);
+///         let mut angle = 0.0f64;
+/// 
+///         app.begin_batch_draw();
+///         loop {
+///             angle += 0.05;
+///             app.clear_device();
+///             cache.draw(400.0, 300.0, angle, Some(255));
+///             app.flush_batch_draw();
+///         }
+///     })
+/// }
+/// ```
+#[derive(Debug)]
+pub struct RotationCache<'a> {
+    ptr: *mut std::os::raw::c_void,
+    steps: u32,
+    _source: PhantomData<&'a Image>,
+}
+
+impl<'a> RotationCache<'a> {
+    /// 创建旋转缓存，帧在第一次绘制对应角度时渲染
+    /// 
+    /// # 参数
+    /// - `source`: 源图像
+    /// - `steps`: 一整圈划分的角度数
+    /// - `scale`: 缩放比例
+    /// - `filter`: 渲染帧时的采样方式
+    /// 
+    /// # 返回值
+    /// 新创建的 RotationCache 对象
+    pub fn new(source: &'a Image, steps: u32, scale: f64, filter: Filter) -> Self {
+        let steps = steps.clamp(1, i32::MAX as u32);
+        let scale = if scale > 0.0 { scale } else { 1.0 };
+        let ptr = unsafe { easyx_rotcache_create(source.ptr, steps as i32, scale, filter.as_i32()) };
+        Self {
+            ptr,
+            steps,
+            _source: PhantomData,
+        }
+    }
+
+    /// 获取一整圈划分的角度数
+    pub fn steps(&self) -> u32 {
+        self.steps
+    }
+
+    /// 获取已经渲染的帧数
+    pub fn cached(&self) -> usize {
+        unsafe { easyx_rotcache_getcached(self.ptr).max(0) as usize }
+    }
+
+    /// 丢弃所有已渲染的帧，源图像的像素变化后调用
+    pub fn invalidate(&mut self) {
+        unsafe {
+            easyx_rotcache_invalidate(self.ptr);
+        }
+    }
+
+    /// 绘制旋转后的图像
+    /// 
+    /// # 参数
+    /// - `x`: 图像中心的目标x坐标
+    /// - `y`: 图像中心的目标y坐标
+    /// - `radian`: 逆时针旋转的弧度，取最近的一档角度
+    /// - `blend`: `None` 表示直接复制，`Some(alpha)` 表示按透明度通道和全局透明度混合
+    pub fn draw(&mut self, x: f64, y: f64, radian: f64, blend: Option<u8>) {
+        let (flags, alpha) = transform_flags(Filter::Nearest, blend);
+        unsafe {
+            easyx_rotcache_draw(self.ptr, x, y, radian, flags, alpha);
+        }
+    }
+}
+
+impl Drop for RotationCache<'_> {
+    /// 释放缓存的帧
     fn drop(&mut self) {
         unsafe {
-            easyx_destroy_image(self.ptr);
+            easyx_rotcache_destroy(self.ptr);
+        }
+    }
+}
+
+/// 异步加载请求的状态
+#[derive(Debug, Copy, Clone, PartialEq, Eq, Hash)]
+pub enum LoadStatus {
+    /// 等待或正在解码
+    Pending,
+    /// 已解码，等待 `App::finalize_image_loads` 创建图像
+    Decoded,
+    /// 图像已创建，可以取走
+    Ready,
+    /// 加载失败
+    Failed,
+    /// 结果已经取走或请求已取消
+    Gone,
+}
+
+impl From<i32> for LoadStatus {
+    /// 从状态码转换为 LoadStatus
+    fn from(code: i32) -> Self {
+        match code as u32 {
+            EASYX_LOAD_PENDING => LoadStatus::Pending,
+            EASYX_LOAD_DECODED => LoadStatus::Decoded,
+            EASYX_LOAD_READY => LoadStatus::Ready,
+            EASYX_LOAD_FAILED => LoadStatus::Failed,
+            _ => LoadStatus::Gone,
+        }
+    }
+}
+
+/// 异步加载的进度
+/// 
+/// 从上次 `App::reset_image_load_progress` 开始统计，通常在提交一批请求（例如一个关卡的资源）之前重置
+#[derive(Debug, Copy, Clone, Default, PartialEq, Eq)]
+pub struct LoadProgress {
+    /// 提交的请求数
+    pub requested: u32,
+    /// 已完成（成功或失败）的请求数
+    pub finished: u32,
+    /// 失败的请求数
+    pub failed: u32,
+    /// 完成前被取消的请求数
+    pub cancelled: u32,
+}
+
+impl LoadProgress {
+    /// 尚未完成的请求数
+    pub fn pending(&self) -> u32 {
+        self.requested
+            .saturating_sub(self.finished)
+            .saturating_sub(self.cancelled)
+    }
+
+    /// 完成比例，范围 0.0 ~ 1.0，没有请求时为 1.0
+    pub fn fraction(&self) -> f32 {
+        let total = self.requested.saturating_sub(self.cancelled);
+        if total == 0 {
+            1.0
+        } else {
+            (self.finished as f32 / total as f32).min(1.0)
+        }
+    }
+}
+
+/// 异步加载图像的句柄
+/// 
+/// 由 `Image::load_file_async` 返回。结果只能取走一次；
+/// 在取走之前丢弃句柄会取消请求并释放已解码的数据。
+/// 
+/// 句柄也实现了 `Future`，结果只会在绘图线程调用 `App::finalize_image_loads` 后就绪，
+/// 等待中的任务由这次调用唤醒（解码失败的请求也在下一次调用时唤醒），轮询之间不占用 CPU
+#[derive(Debug)]
+pub struct LoadHandle {
+    id: i32,
+}
+
+impl LoadHandle {
+    /// 获取请求的当前状态
+    pub fn status(&self) -> LoadStatus {
+        unsafe { easyx_loadimage_status(self.id) }.into()
+    }
+
+    /// 判断结果是否可以取走（成功或失败）
+    pub fn is_done(&self) -> bool {
+        matches!(self.status(), LoadStatus::Ready | LoadStatus::Failed)
+    }
+
+    /// 尝试取走加载结果
+    /// 
+    /// # 返回值
+    /// 尚未完成时返回 None；完成后返回一次结果，之后再调用返回 None
+    pub fn try_take(&mut self) -> Option<Result<Image, ImageError>> {
+        if self.id == 0 || !self.is_done() {
+            return None;
+        }
+
+        let mut error = 0;
+        let ptr = unsafe { easyx_loadimage_take(self.id, &mut error) };
+        self.id = 0;
+
+        if !ptr.is_null() {
+            Some(Ok(Image { ptr }))
+        } else if error != 0 {
+            Some(Err(error.into()))
+        } else {
+            Some(Err(ImageError::Unknown(-1)))
         }
     }
-}
\ No newline at end of file
+
+    /// 阻塞等待加载完成并取走结果
+    /// 
+    /// 等待期间会在当前线程中创建已解码的图像，只能在绘图线程中调用
+    /// 
+    /// # 返回值
+    /// 成功返回 Image 对象，失败返回 ImageError
+    pub fn wait(mut self) -> Result<Image, ImageError> {
+        loop {
+            if let Some(result) = self.try_take() {
+                return result;
+            }
+            match self.status() {
+                LoadStatus::Gone => return Err(ImageError::Unknown(-1)),
+                LoadStatus::Decoded => {
+                    unsafe {
+                        easyx_loadimage_finalize(0.0);
+                    }
+                    wake_finished_loads();
+                }
+                _ => std::thread::sleep(std::time::Duration::from_millis(1)),
+            }
+        }
+    }
+
+    /// 取消请求
+    /// 
+    /// 正在解码的请求会在解码结束后丢弃，已经创建的图像会被释放
+    pub fn cancel(self) {
+        drop(self);
+    }
+}
+
+impl std::future::Future for LoadHandle {
+    type Output = Result<Image, ImageError>;
+
+    fn poll(
+        mut self: std::pin::Pin<&mut Self>,
+        cx: &mut std::task::Context<'_>,
+    ) -> std::task::Poll<Self::Output> {
+        let id = self.id;
+        if let Some(result) = self.try_take() {
+            forget_load_waker(id);
+            return std::task::Poll::Ready(result);
+        }
+        if id == 0 || self.status() == LoadStatus::Gone {
+            forget_load_waker(id);
+            return std::task::Poll::Ready(Err(ImageError::Unknown(-1)));
+        }
+
+        register_load_waker(id, cx.waker());
+        // 登记之前 finalize 可能已经完成了这个请求
+        if self.is_done() {
+            cx.waker().wake_by_ref();
+        }
+        std::task::Poll::Pending
+    }
+}
+
+impl Drop for LoadHandle {
+    /// 取消尚未取走的请求
+    fn drop(&mut self) {
+        if self.id != 0 {
+            forget_load_waker(self.id);
+            unsafe {
+                easyx_loadimage_cancel(self.id);
+            }
+        }
+    }
+}
+
+/// 正在等待的 `LoadHandle` 的请求编号和唤醒器
+static LOAD_WAKERS: Mutex<Vec<(i32, Waker)>> = Mutex::new(Vec::new());
+
+fn load_wakers() -> std::sync::MutexGuard<'static, Vec<(i32, Waker)>> {
+    LOAD_WAKERS.lock().unwrap_or_else(|e| e.into_inner())
+}
+
+fn register_load_waker(id: i32, waker: &Waker) {
+    let mut wakers = load_wakers();
+    match wakers.iter_mut().find(|(other, _)| *other == id) {
+        Some((_, old)) => old.clone_from(waker),
+        None => wakers.push((id, waker.clone())),
+    }
+}
+
+fn forget_load_waker(id: i32) {
+    load_wakers().retain(|(other, _)| *other != id);
+}
+
+/// 唤醒结果已经可以取走的 `LoadHandle`，在 `easyx_loadimage_finalize` 之后调用
+pub(crate) fn wake_finished_loads() {
+    let finished: Vec<Waker> = {
+        let mut wakers = load_wakers();
+        if wakers.is_empty() {
+            return;
+        }
+
+        let mut finished = Vec::new();
+        wakers.retain(|(id, waker)| {
+            let status = LoadStatus::from(unsafe { easyx_loadimage_status(*id) });
+            if matches!(status, LoadStatus::Pending | LoadStatus::Decoded) {
+                return true;
+            }
+            finished.push(waker.clone());
+            false
+        });
+        finished
+    };
+
+    // 不持有锁唤醒，执行器可能在唤醒时立即轮询
+    for waker in finished {
+        waker.wake();
+    }
+}
@@ -201,16 +201,30 @@
 //!
 //! ## 模块说明
 //!
-//! - **app**: 应用程序管理，负责窗口创建和初始化
+//! - **app**: 应用程序管理，负责窗口创建和初始化，也可以不创建窗口只渲染到离屏画布
+//! - **assets**: 解码图像缓存和预解码的资源包，避免重复解码
 //! - **color**: 颜色处理，支持多种颜色模型
+//! - **coords**: 借用的顶点缓冲区，绘制折线和多边形时不需要转换坐标
 //! - **enums**: 通用枚举定义
 //! - **fillstyle**: 填充样式设置
+//! - **golden**: 图像比较，按 CPU 支持情况向量化逐行比较并生成差异图，用于黄金图像测试
 //! - **image**: 图像处理，支持图像加载和显示
 //! - **input**: 输入处理，支持输入框
 //! - **keycode**: 键盘码定义
 //! - **linestyle**: 线条样式设置
-//! - **logfont**: 字体设置
+//! - **logfont**: 字体设置，按字体样式缓存 GDI 字体的字体句柄
 //! - **msg**: 消息处理，支持事件监听
+//! - **parallel**: 多线程分块渲染，多个线程并行绘制工作图像的不同分块
+//! - **plot**: 时间序列折线图，按像素列抽稀，大量样本也只绘制与视口宽度成正比的顶点
+//! - **scene**: 保留模式的场景图层，缓存光栅化结果，只重新合成变化的区域
+//! - **present**: 多缓冲呈现，独立的呈现线程把完成的帧复制到窗口，绘图线程不必等待
+//! - **profiler**: 包装层性能分析，统计各类调用的次数和耗时
+//! - **recorder**: 帧序列录制，后台线程编码，帧池用尽时丢帧而不阻塞绘图循环
+//! - **scheduler**: 工作窃取线程池，后台任务把绘制工作发回绘图线程按帧预算执行
+//! - **spriteatlas**: 精灵图集，一次调用批量绘制大量精灵
+//! - **textatlas**: 字形图集，绕过 GDI 快速绘制文本
+//! - **textlayout**: 多行文本排版，缓存测量结果和换行位置，编辑时只重新测量变化的段落
+//! - **tilemap**: 瓦片地图，按区块缓存渲染结果，只重新渲染变化的区块
 //!
 //! ## 最佳实践
 //!
@@ -229,15 +243,29 @@ use crate::app::{App, InitFlags};
 
 // Module imports
 pub mod app;
+pub mod assets;
 pub mod color;
+pub mod coords;
 pub mod enums;
 pub mod fillstyle;
+pub mod golden;
 pub mod image;
 pub mod input;
 pub mod keycode;
 pub mod linestyle;
 pub mod logfont;
 pub mod msg;
+pub mod parallel;
+pub mod plot;
+pub mod present;
+pub mod profiler;
+pub mod recorder;
+pub mod scene;
+pub mod scheduler;
+pub mod spriteatlas;
+pub mod textatlas;
+pub mod textlayout;
+pub mod tilemap;
 
 /// 预导入模块，包含常用的类型和函数
 ///
@@ -269,13 +297,41 @@ pub mod prelude {
     // Re-export the Msg struct from the msg module
     pub use crate::msg::*;
     // Re-export the TextStyle struct from the textstyle module
-    pub use crate::logfont::LogFont;
+    pub use crate::logfont::{FontCacheStats, FontHandle, LogFont};
     // Re-export the InputBox related structs and functions
     pub use crate::input::*;
     // Re-export other types
     pub use crate::enums::*;
     // Re-export the KeyCode enum from the keycode module
     pub use crate::keycode::KeyCode;
+    // Re-export the Coords struct from the coords module
+    pub use crate::coords::Coords;
+    // Re-export the TextAtlas struct from the textatlas module
+    pub use crate::textatlas::TextAtlas;
+    // Re-export the SpriteAtlas related types
+    pub use crate::spriteatlas::*;
+    // Re-export the RenderTile struct from the parallel module
+    pub use crate::parallel::RenderTile;
+    // Re-export the Profiler related types
+    pub use crate::profiler::*;
+    // Re-export the Scheduler related types
+    pub use crate::scheduler::*;
+    // Re-export the TileMap related types
+    pub use crate::tilemap::*;
+    // Re-export the asset cache and pack types
+    pub use crate::assets::*;
+    // Re-export the Plot related types
+    pub use crate::plot::*;
+    // Re-export the Scene related types
+    pub use crate::scene::*;
+    // Re-export the Presenter related types
+    pub use crate::present::*;
+    // Re-export the TextLayout related types
+    pub use crate::textlayout::*;
+    // Re-export the Recorder related types
+    pub use crate::recorder::*;
+    // Re-export the golden image comparison types
+    pub use crate::golden::*;
 }
 
 /// 使用初始化标志运行图形应用程序
@@ -360,3 +416,43 @@ where
 {
     run_flags(width, height, InitFlags::None, f)
 }
+
+/// 以无窗口模式运行图形应用程序
+///
+/// 不创建窗口，只创建指定大小的离屏画布并设为工作图像，然后执行提供的闭包。
+/// 闭包执行完毕后画布被释放。适合在服务器上生成图像和在 CI 中并行运行黄金图像测试，
+/// 每个进程各自拥有画布，互不影响。
+///
+/// # 参数
+///
+/// * `width` - 画布的宽度
+/// * `height` - 画布的高度
+/// * `f` - 要执行的闭包，接收App实例作为参数
+///
+/// # 返回值
+///
+/// 执行结果，成功返回Ok(())，失败返回Err
+///
+/// # 示例
+///
+/// ```no_run
+/// use easyx::prelude::*;
+/// use easyx::run_headless;
+///
+/// fn main() -> Result<(), Box<dyn std::error::Error>> {
+///     run_headless(800, 600, |app| {
+///         app.out_text(100, 100, "Hello, EasyX-RS!");
+///         let report = Image::get_image(0, 0, app.width(), app.height());
+///         report.save("report.png")?;
+///         Ok(())
+///     })
+/// }
+/// ```
+pub fn run_headless<F>(width: i32, height: i32, f: F) -> Result<(), Box<dyn std::error::Error>>
+where
+    F: FnOnce(&App) -> Result<(), Box<dyn std::error::Error>> + std::panic::UnwindSafe,
+{
+    let app = App::headless(width, height);
+
+    app.run(f)
+}
@@ -1,6 +1,6 @@
 //! 文本字体样式定义
 
-use easyx_sys::{easyx_gettextstyle, easyx_settextstyle_logfont};
+use easyx_sys::*;
 
 /// Windows API LOGFONT 结构体的 Rust 包装
 ///
@@ -46,7 +46,8 @@ impl LogFont {
     /// 将当前字体样式应用到 EasyX 绘图上下文
     ///
     /// 将 LogFont 中定义的字体样式设置为 EasyX 图形库的活动字体样式，
-    /// 后续绘制的所有文本都将使用此样式。
+    /// 后续绘制的所有文本都将使用此样式。字体从字体缓存中取得，
+    /// 反复切换相同的样式不会重复创建字体。
     ///
     /// # 示例
     /// ```no_run
@@ -92,3 +93,152 @@ impl LogFont {
         }
     }
 }
+
+/// 字体缓存的统计信息
+#[derive(Debug, Clone, Copy, Default, PartialEq, Eq)]
+pub struct FontCacheStats {
+    /// 在缓存中找到字体的次数
+    pub hits: u64,
+    /// 创建字体的次数
+    pub created: u64,
+    /// 被删除的字体数
+    pub evictions: u64,
+    /// 选入字体的次数
+    pub selects: u64,
+    /// 已经是当前字体、跳过选入的次数
+    pub skipped: u64,
+    /// 缓存的字体数
+    pub cached: usize,
+    /// 选入了缓存字体的图像数
+    pub selected: usize,
+}
+
+/// 字体缓存中的字体
+///
+/// 按完整的 `LogFont` 共享同一个 GDI 字体，`select` 直接把它选入当前工作图像，
+/// 不再像 `App::set_textstyle` 那样每次切换都重新创建字体。适合在粗体和常规等
+/// 几种字体之间频繁切换的场合。`LogFont::apply` 和 `TextLayout` 使用同一个缓存。
+///
+/// 没有被 `FontHandle` 引用、也没有被选入的字体在超出缓存容量时按最久未使用被删除。
+///
+/// # 示例
+/// ```no_run
+/// use easyx::prelude::*;
+/// use easyx::run;
+///
+/// fn main() -> Result<(), Box<dyn std::error::Error>> {
+///     run(800, 600, |app| {
+///         app.set_textstyle_full(20, 0, "微软雅黑", 0, 0, 700, false, false, false);
+///         let bold = FontHandle::current().ok_or("无法创建字体")?;
+///         app.set_textstyle(20, 0, "微软雅黑");
+///         let regular = FontHandle::current().ok_or("无法创建字体")?;
+///
+///         for i in 0..20 {
+///             bold.select();
+///             app.out_text(10, i * 24, "名称：");
+///             regular.select();
+///             app.out_text(80, i * 24, "EasyX-RS");
+///         }
+///         Ok(())
+///     })
+/// }
+/// ```
+#[derive(Debug)]
+pub struct FontHandle {
+    ptr: *mut std::os::raw::c_void,
+}
+
+impl FontHandle {
+    /// 从字体缓存中取得字体
+    ///
+    /// # 参数
+    /// - `font`: 字体样式
+    ///
+    /// # 返回值
+    /// 无法创建字体时返回 None
+    pub fn new(font: &LogFont) -> Option<Self> {
+        let ptr = unsafe { easyx_font_acquire(&font.logfont as *const _ as *const _) };
+        (!ptr.is_null()).then_some(Self { ptr })
+    }
+
+    /// 按当前文本样式从字体缓存中取得字体
+    ///
+    /// # 返回值
+    /// 无法创建字体时返回 None
+    pub fn current() -> Option<Self> {
+        let ptr = unsafe { easyx_font_acquire(std::ptr::null()) };
+        (!ptr.is_null()).then_some(Self { ptr })
+    }
+
+    /// 设为当前工作图像的文本字体
+    ///
+    /// # 返回值
+    /// 已经是当前字体时返回 false
+    pub fn select(&self) -> bool {
+        unsafe { easyx_font_select(self.ptr) != 0 }
+    }
+
+    /// 获取字体样式
+    pub fn logfont(&self) -> LogFont {
+        unsafe {
+            let mut font = LogFont {
+                logfont: std::mem::zeroed(),
+            };
+            easyx_font_getlogfont(self.ptr, &mut font.logfont as *mut _ as *mut _);
+            font
+        }
+    }
+
+    /// 设置缓存容量
+    ///
+    /// # 参数
+    /// - `capacity`: 最多缓存的字体数，被引用的字体不受限制。为 0 时恢复默认值
+    pub fn set_cache_capacity(capacity: usize) {
+        unsafe {
+            easyx_fontcache_setcapacity(capacity.min(i32::MAX as usize) as i32);
+        }
+    }
+
+    /// 删除所有没有被引用的字体
+    pub fn clear_cache() {
+        unsafe {
+            easyx_fontcache_clear();
+        }
+    }
+
+    /// 获取字体缓存的统计信息
+    pub fn cache_stats() -> FontCacheStats {
+        let mut stats = unsafe { std::mem::zeroed::<EasyXFontCacheStats>() };
+        unsafe {
+            easyx_fontcache_getstats(&mut stats);
+        }
+
+        FontCacheStats {
+            hits: stats.hits,
+            created: stats.created,
+            evictions: stats.evictions,
+            selects: stats.selects,
+            skipped: stats.skipped,
+            cached: stats.cached.max(0) as usize,
+            selected: stats.selected.max(0) as usize,
+        }
+    }
+}
+
+impl Clone for FontHandle {
+    /// 增加同一个字体的引用
+    fn clone(&self) -> Self {
+        let font = self.logfont();
+        let ptr = unsafe { easyx_font_acquire(&font.logfont as *const _ as *const _) };
+        Self { ptr }
+    }
+}
+
+impl Drop for FontHandle {
+    /// 释放引用，字体留在缓存中
+    fn drop(&mut self) {
+        unsafe {
+            easyx_font_release(self.ptr);
+        }
+    }
+}
@@ -1,7 +1,10 @@
 //! 消息处理相关定义
 
+use std::time::Duration;
+
 use easyx_sys::*;
 
+use crate::app::RingStats;
 use crate::keycode::KeyCode;
 
 /// 表示 EasyX 图形库中的各种消息类型
@@ -309,3 +312,388 @@ impl ExMessage {
         }
     }
 }
+
+/// 等待消息的结果
+///
+/// 由 `ExMessage::wait` 返回
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Hash)]
+pub enum WaitResult {
+    /// 消息队列中有符合过滤条件的消息
+    Message,
+    /// 被 `WakeHandle::wake` 唤醒
+    Wake,
+    /// 等待超时
+    Timeout,
+}
+
+impl ExMessage {
+    /// 等待消息，期间线程休眠，不占用 CPU
+    ///
+    /// 休眠到消息队列中有符合过滤条件的消息、超时或其他线程调用 `WakeHandle::wake`。
+    /// 不会取出消息，返回 `WaitResult::Message` 后用 `peek_message` 或 `MessageBuffer` 取出。
+    ///
+    /// # 参数
+    /// - `filter`: 指定要等待的消息范围
+    /// - `timeout`: 最长等待时间，None 表示一直等待
+    ///
+    /// # 返回值
+    /// 结束等待的原因
+    ///
+    /// # 示例
+    /// ```no_run
+    /// use std::time::Duration;
+    ///
+    /// use easyx::msg::{ExMessage, MessageFilter, WaitResult};
+    ///
+    /// loop {
+    ///     match ExMessage::wait(MessageFilter::All, Some(Duration::from_secs(1))) {
+    ///         WaitResult::Message => {
+    ///             while let Some(msg) = ExMessage::peek_message(MessageFilter::All, true) {
+    ///                 println!("获取到消息: {:?}", msg);
+    ///             }
+    ///         }
+    ///         WaitResult::Wake => println!("被唤醒"),
+    ///         WaitResult::Timeout => println!("一秒内没有消息"),
+    ///     }
+    /// }
+    /// ```
+    pub fn wait(filter: MessageFilter, timeout: Option<Duration>) -> WaitResult {
+        // 向上取整到毫秒，避免不足一毫秒的超时变成 0 而空转
+        let ms = match timeout {
+            Some(timeout) => timeout.as_micros().div_ceil(1000).min(i32::MAX as u128) as i32,
+            None => -1,
+        };
+
+        match unsafe { easyx_waitmessage(ms, filter as u8) } {
+            code if code == EASYX_WAIT_MESSAGE as i32 => WaitResult::Message,
+            code if code == EASYX_WAIT_WAKE as i32 => WaitResult::Wake,
+            _ => WaitResult::Timeout,
+        }
+    }
+}
+
+/// 唤醒等待消息的线程的句柄
+///
+/// 可以复制并移动到任意线程。调用 `wake` 时没有线程在等待，下一次等待会立即返回
+#[derive(Debug, Clone, Copy, Default, PartialEq, Eq)]
+pub struct WakeHandle;
+
+impl WakeHandle {
+    /// 唤醒正在等待消息的线程
+    pub fn wake(&self) {
+        unsafe {
+            easyx_wake();
+        }
+    }
+}
+
+/// 消息缓冲区
+///
+/// 每次调用从消息队列中一次取出多个消息，避免逐个调用 `peek_message`
+/// 反复跨越 FFI 边界。缓冲区可以在每帧之间复用。
+///
+/// # 示例
+/// ```no_run
+/// use easyx::msg::{MessageBuffer, MessageFilter};
+///
+/// let mut messages = MessageBuffer::new(64).with_mouse_move_coalescing(true);
+///
+/// // 每帧处理所有待处理的消息
+/// for msg in messages.drain(MessageFilter::All) {
+///     println!("获取到消息: {:?}", msg);
+/// }
+/// ```
+#[derive(Clone)]
+pub struct MessageBuffer {
+    raw: Vec<CExMessage>,
+    len: usize,
+    coalesce_mouse_move: bool,
+}
+
+impl MessageBuffer {
+    /// 创建一个新的消息缓冲区
+    ///
+    /// # 参数
+    /// - `capacity`: 每次最多取出的消息数量，至少为 1
+    ///
+    /// # 返回值
+    /// 新创建的 MessageBuffer 实例
+    pub fn new(capacity: usize) -> Self {
+        let raw = vec![unsafe { std::mem::zeroed::<CExMessage>() }; capacity.max(1)];
+
+        Self {
+            raw,
+            len: 0,
+            coalesce_mouse_move: false,
+        }
+    }
+
+    /// 设置是否合并连续的鼠标移动消息
+    ///
+    /// 启用后，一次取出的消息中连续的鼠标移动消息只保留最后一个位置
+    ///
+    /// # 参数
+    /// - `coalesce`: 是否合并
+    ///
+    /// # 返回值
+    /// 更新后的 MessageBuffer 实例，用于链式调用
+    pub fn with_mouse_move_coalescing(mut self, coalesce: bool) -> Self {
+        self.coalesce_mouse_move = coalesce;
+        self
+    }
+
+    /// 缓冲区容量
+    pub fn capacity(&self) -> usize {
+        self.raw.len()
+    }
+
+    /// 缓冲区中的消息数量
+    pub fn len(&self) -> usize {
+        self.len
+    }
+
+    /// 缓冲区是否为空
+    pub fn is_empty(&self) -> bool {
+        self.len == 0
+    }
+
+    /// 从消息队列中取出一批消息，替换缓冲区中原有的消息
+    ///
+    /// # 参数
+    /// - `filter`: 指定要获取的消息范围
+    ///
+    /// # 返回值
+    /// 取出的消息数量，0 表示消息队列中没有消息
+    pub fn peek(&mut self, filter: MessageFilter) -> usize {
+        let count = unsafe {
+            easyx_peekmessages(
+                self.raw.as_mut_ptr(),
+                self.raw.len() as i32,
+                filter as u8,
+                self.coalesce_mouse_move as i32,
+            )
+        };
+
+        self.len = count.max(0) as usize;
+        self.len
+    }
+
+    /// 遍历缓冲区中的消息
+    pub fn iter(&self) -> impl Iterator<Item = ExMessage> + '_ {
+        self.raw[..self.len].iter().map(ExMessage::from_c_message)
+    }
+
+    /// 取出消息队列中的所有消息
+    ///
+    /// 缓冲区中的消息处理完后自动取出下一批，直到消息队列为空
+    ///
+    /// # 参数
+    /// - `filter`: 指定要获取的消息范围
+    ///
+    /// # 返回值
+    /// 消息迭代器
+    pub fn drain(&mut self, filter: MessageFilter) -> MessageDrain<'_> {
+        self.len = 0;
+        MessageDrain {
+            buffer: self,
+            filter,
+            pos: 0,
+            done: false,
+        }
+    }
+}
+
+/// 取出消息队列中所有消息的迭代器
+///
+/// 由 `MessageBuffer::drain` 创建
+pub struct MessageDrain<'a> {
+    buffer: &'a mut MessageBuffer,
+    filter: MessageFilter,
+    pos: usize,
+    done: bool,
+}
+
+impl Iterator for MessageDrain<'_> {
+    type Item = ExMessage;
+
+    fn next(&mut self) -> Option<Self::Item> {
+        if self.pos == self.buffer.len {
+            // 上一批没有填满缓冲区，说明消息队列已经取空
+            if self.done {
+                return None;
+            }
+
+            self.buffer.peek(self.filter);
+            self.pos = 0;
+            self.done = self.buffer.len < self.buffer.capacity();
+            if self.buffer.len == 0 {
+                return None;
+            }
+        }
+
+        let msg = ExMessage::from_c_message(&self.buffer.raw[self.pos]);
+        self.pos += 1;
+        Some(msg)
+    }
+}
+
+/// 消息队列两端共享的无锁队列
+#[derive(Debug)]
+struct RawMessageRing {
+    ptr: *mut std::os::raw::c_void,
+}
+
+// 两端各自只有一个，由 MessagePump 和 MessageReceiver 的所有权保证
+unsafe impl Send for RawMessageRing {}
+unsafe impl Sync for RawMessageRing {}
+
+impl Drop for RawMessageRing {
+    fn drop(&mut self) {
+        unsafe {
+            easyx_msgring_destroy(self.ptr);
+        }
+    }
+}
+
+/// 创建跨线程的无锁消息队列
+///
+/// 单生产者单消费者：绘图线程持有 `MessagePump`，把 EasyX 队列中的消息移入无锁队列；
+/// 另一个线程持有 `MessageReceiver` 取出已经转换好的消息。两端都不加锁，
+/// 队列满时剩余的消息留在 EasyX 的队列中，等下一次 `pump`。
+///
+/// # 参数
+/// - `capacity`: 可以同时排队的消息数，向上取整到 2 的幂
+///
+/// # 返回值
+/// `(pump, receiver)`
+///
+/// # 示例
+/// ```no_run
+/// use std::thread;
+///
+/// use easyx::prelude::*;
+/// use easyx::run;
+///
+/// fn main() -> Result<(), Box<dyn std::error::Error>> {
+///     run(800, 600, |app| {
+///         let (mut pump, mut receiver) = message_ring(256);
+///
+///         // 输入处理线程
+///         thread::spawn(move || {
+///             loop {
+///                 while let Some(msg) = receiver.pop() {
+///                     println!("获取到消息: {:?}", msg);
+///                 }
+///                 thread::yield_now();
+///             }
+///         });
+///
+///         loop {
+///             app.wait_message(MessageFilter::All, None);
+///             pump.pump(MessageFilter::All);
+///         }
+///     })
+/// }
+/// ```
+pub fn message_ring(capacity: usize) -> (MessagePump, MessageReceiver) {
+    let capacity = capacity.min(i32::MAX as usize) as i32;
+    let ring = std::sync::Arc::new(RawMessageRing {
+        ptr: unsafe { easyx_msgring_create(capacity) },
+    });
+
+    (
+        MessagePump {
+            ring: ring.clone(),
+            _marker: std::marker::PhantomData,
+        },
+        MessageReceiver {
+            ring,
+            raw: vec![unsafe { std::mem::zeroed::<CExMessage>() }; 64],
+            len: 0,
+            pos: 0,
+        },
+    )
+}
+
+/// 消息队列的生产端，只能在绘图线程中使用
+///
+/// 由 `message_ring` 创建
+#[derive(Debug)]
+pub struct MessagePump {
+    ring: std::sync::Arc<RawMessageRing>,
+    // 读取 EasyX 的消息队列，只能在绘图线程中使用
+    _marker: std::marker::PhantomData<*mut ()>,
+}
+
+impl MessagePump {
+    /// 把 EasyX 队列中符合过滤条件的消息移入无锁队列
+    ///
+    /// # 参数
+    /// - `filter`: 指定要移入的消息范围
+    ///
+    /// # 返回值
+    /// 移入的消息数，队列满时可能少于 EasyX 队列中的消息数
+    pub fn pump(&mut self, filter: MessageFilter) -> usize {
+        unsafe { easyx_msgring_pump(self.ring.ptr, filter as u8).max(0) as usize }
+    }
+
+    /// 获取统计信息
+    pub fn stats(&self) -> RingStats {
+        ring_stats(&self.ring)
+    }
+}
+
+/// 消息队列的消费端，可以移动到其他线程
+///
+/// 由 `message_ring` 创建，每次从无锁队列中批量取出消息
+pub struct MessageReceiver {
+    ring: std::sync::Arc<RawMessageRing>,
+    raw: Vec<CExMessage>,
+    len: usize,
+    pos: usize,
+}
+
+impl MessageReceiver {
+    /// 取出一个消息
+    ///
+    /// # 返回值
+    /// 队列为空时返回 None
+    pub fn pop(&mut self) -> Option<ExMessage> {
+        if self.pos == self.len {
+            let count = unsafe {
+                easyx_msgring_pop(self.ring.ptr, self.raw.as_mut_ptr(), self.raw.len() as i32)
+            };
+            self.len = count.max(0) as usize;
+            self.pos = 0;
+            if self.len == 0 {
+                return None;
+            }
+        }
+
+        let msg = ExMessage::from_c_message(&self.raw[self.pos]);
+        self.pos += 1;
+        Some(msg)
+    }
+
+    /// 获取统计信息，`popped` 包含已经批量取出但还没有被 `pop` 返回的消息
+    pub fn stats(&self) -> RingStats {
+        ring_stats(&self.ring)
+    }
+}
+
+impl Iterator for MessageReceiver {
+    type Item = ExMessage;
+
+    /// 取出一个消息，队列为空时结束迭代
+    fn next(&mut self) -> Option<Self::Item> {
+        self.pop()
+    }
+}
+
+fn ring_stats(ring: &RawMessageRing) -> RingStats {
+    let mut stats = unsafe { std::mem::zeroed::<EasyXRingStats>() };
+    unsafe {
+        easyx_msgring_getstats(ring.ptr, &mut stats);
+    }
+    RingStats::from(&stats)
+}
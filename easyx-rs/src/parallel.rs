@@ -0,0 +1,214 @@
+//! 多线程分块渲染
+
+use std::any::Any;
+use std::panic::{self, AssertUnwindSafe};
+use std::sync::Mutex;
+
+use easyx_sys::*;
+
+use crate::color::Color;
+
+/// 正在渲染的分块
+///
+/// 由 `App::render_tiles` 传给渲染闭包，闭包可能在任意线程上并发运行，
+/// 只能通过分块的方法或 `pixels_mut` 绘制，不能调用 `App` 的绘图方法。
+///
+/// 绘图方法使用设备坐标（整个工作图像中的坐标），自动裁剪到分块范围内，
+/// 因此闭包可以像绘制整张图像一样绘制，只有落在本分块内的部分会被写入。
+/// 形状与对应的 `App::raster_*` 方法逐像素一致。
+pub struct RenderTile<'a> {
+    raw: &'a mut EasyXTile,
+}
+
+impl RenderTile<'_> {
+    /// 分块左上角在工作图像中的x坐标
+    pub fn x(&self) -> i32 {
+        self.raw.x
+    }
+
+    /// 分块左上角在工作图像中的y坐标
+    pub fn y(&self) -> i32 {
+        self.raw.y
+    }
+
+    /// 分块宽度，右侧的分块可能小于指定大小
+    pub fn width(&self) -> i32 {
+        self.raw.width
+    }
+
+    /// 分块高度，底部的分块可能小于指定大小
+    pub fn height(&self) -> i32 {
+        self.raw.height
+    }
+
+    /// 分块编号，按行排列
+    pub fn index(&self) -> usize {
+        self.raw.index as usize
+    }
+
+    /// 渲染线程编号，0 为调用线程，小于 `App::render_threads`
+    ///
+    /// 可用于索引按线程预先分配的临时数据
+    pub fn thread(&self) -> usize {
+        self.raw.thread as usize
+    }
+
+    /// 判断矩形 `[left, right] x [top, bottom]`（设备坐标）是否与分块相交
+    ///
+    /// 用于在闭包中跳过不可见的图元
+    pub fn intersects(&self, left: i32, top: i32, right: i32, bottom: i32) -> bool {
+        left.min(right) < self.raw.x + self.raw.width
+            && left.max(right) >= self.raw.x
+            && top.min(bottom) < self.raw.y + self.raw.height
+            && top.max(bottom) >= self.raw.y
+    }
+
+    /// 获取分块缓冲区的像素，格式为 0xAARRGGBB
+    ///
+    /// 像素按行存放，每行 `pitch()` 个像素，第 `(x, y)` 个像素（分块内坐标）
+    /// 位于 `y * pitch() + x`
+    pub fn pixels_mut(&mut self) -> &mut [u32] {
+        let len = if self.raw.height > 0 {
+            (self.raw.height as usize - 1) * self.raw.pitch as usize + self.raw.width as usize
+        } else {
+            0
+        };
+        unsafe { std::slice::from_raw_parts_mut(self.raw.pixels, len) }
+    }
+
+    /// 相邻两行间隔的像素数
+    pub fn pitch(&self) -> usize {
+        self.raw.pitch as usize
+    }
+
+    /// 用颜色填充整个分块
+    pub fn clear(&mut self, color: &Color) {
+        unsafe {
+            easyx_tile_clear(self.raw, color.as_colorref());
+        }
+    }
+
+    /// 绘制水平线 `[x1, x2]`，包含两端
+    pub fn hline(&mut self, x1: i32, x2: i32, y: i32, color: &Color) {
+        unsafe {
+            easyx_tile_hline(self.raw, x1, x2, y, color.as_colorref());
+        }
+    }
+
+    /// 绘制矩形边框，包含右边和下边
+    pub fn rectangle(&mut self, left: i32, top: i32, right: i32, bottom: i32, color: &Color) {
+        unsafe {
+            easyx_tile_rectangle(self.raw, left, top, right, bottom, color.as_colorref());
+        }
+    }
+
+    /// 填充矩形，包含右边和下边
+    pub fn fill_rect(&mut self, left: i32, top: i32, right: i32, bottom: i32, color: &Color) {
+        unsafe {
+            easyx_tile_fillrect(self.raw, left, top, right, bottom, color.as_colorref());
+        }
+    }
+
+    /// 填充圆
+    pub fn fill_circle(&mut self, x: i32, y: i32, radius: i32, color: &Color) {
+        unsafe {
+            easyx_tile_fillcircle(self.raw, x, y, radius, color.as_colorref());
+        }
+    }
+
+    /// 填充外接矩形内的椭圆，外接矩形包含右边和下边
+    pub fn fill_ellipse(&mut self, left: i32, top: i32, right: i32, bottom: i32, color: &Color) {
+        unsafe {
+            easyx_tile_fillellipse(self.raw, left, top, right, bottom, color.as_colorref());
+        }
+    }
+
+    /// 按源像素的透明度通道和全局透明度混合一块像素
+    ///
+    /// # 参数
+    /// - `x`: 目标位置x坐标（设备坐标）
+    /// - `y`: 目标位置y坐标（设备坐标）
+    /// - `src`: 源像素，格式为 0xAARRGGBB，行数由切片长度决定
+    /// - `width`: 源区域宽度
+    /// - `stride`: 源缓冲区每行的像素数，0 表示等于 `width`
+    /// - `alpha`: 全局透明度
+    pub fn blend(&mut self, x: i32, y: i32, src: &[u32], width: usize, stride: usize, alpha: u8) {
+        let stride = if stride == 0 { width } else { stride };
+        assert!(stride >= width, "stride 不能小于区域宽度");
+        if width == 0 || src.len() < width {
+            return;
+        }
+
+        let height = (src.len() - width) / stride + 1;
+        unsafe {
+            easyx_tile_blend(
+                self.raw,
+                x,
+                y,
+                src.as_ptr(),
+                width as i32,
+                height as i32,
+                stride,
+                alpha,
+            );
+        }
+    }
+}
+
+/// 传给 C++ 包装层的渲染上下文，记录第一个 panic，渲染结束后在调用线程上重新抛出
+struct TileContext<'f, F> {
+    render: &'f F,
+    panic: Mutex<Option<Box<dyn Any + Send>>>,
+}
+
+unsafe extern "C" fn tile_trampoline<F>(user: *mut std::os::raw::c_void, tile: *mut EasyXTile)
+where
+    F: Fn(&mut RenderTile) + Sync,
+{
+    let ctx = unsafe { &*(user as *const TileContext<F>) };
+    let mut tile = RenderTile {
+        raw: unsafe { &mut *tile },
+    };
+
+    // panic 不能穿过 C++ 栈帧
+    if let Err(payload) = panic::catch_unwind(AssertUnwindSafe(|| (ctx.render)(&mut tile))) {
+        let mut first = ctx.panic.lock().unwrap_or_else(|e| e.into_inner());
+        first.get_or_insert(payload);
+    }
+}
+
+/// 分块渲染，由 `App::render_tiles` 调用
+pub(crate) fn render_tiles<F>(
+    tile_width: i32,
+    tile_height: i32,
+    background: Option<&Color>,
+    render: F,
+) -> usize
+where
+    F: Fn(&mut RenderTile) + Sync,
+{
+    let ctx = TileContext {
+        render: &render,
+        panic: Mutex::new(None),
+    };
+    let (flags, color) = match background {
+        Some(color) => (EASYX_TILES_CLEAR as i32, color.as_colorref()),
+        None => (EASYX_TILES_KEEP as i32, 0),
+    };
+
+    let count = unsafe {
+        easyx_render_tiles(
+            tile_width,
+            tile_height,
+            flags,
+            color,
+            Some(tile_trampoline::<F>),
+            &ctx as *const TileContext<F> as *mut std::os::raw::c_void,
+        )
+    };
+
+    if let Some(payload) = ctx.panic.into_inner().unwrap_or_else(|e| e.into_inner()) {
+        panic::resume_unwind(payload);
+    }
+    count as usize
+}
@@ -0,0 +1,225 @@
+//! 时间序列折线图，按像素列抽稀后绘制
+
+use easyx_sys::*;
+
+/// 折线图的视口
+///
+/// 描述把哪一段样本映射到屏幕上的哪个矩形：视口左边缘对应样本 `first`，
+/// 每个像素列对应 `samples_per_pixel` 个样本，样本值 `y_min` 到 `y_max` 映射到视口的底边到顶边。
+#[derive(Debug, Clone, Copy, PartialEq)]
+pub struct PlotView {
+    /// 视口左边缘对应的样本编号（绝对编号，见 `Plot::first_index`）
+    ///
+    /// 抽稀时向下对齐到列边界，平移视口时列的划分保持不变
+    pub first: f64,
+    /// 每个像素列的样本数，小于等于 0 表示把全部样本缩放到视口宽度
+    pub samples_per_pixel: f64,
+    /// 视口底边对应的样本值
+    pub y_min: f32,
+    /// 视口顶边对应的样本值
+    pub y_max: f32,
+    /// 视口左上角x坐标
+    pub left: i32,
+    /// 视口左上角y坐标
+    pub top: i32,
+    /// 视口宽度
+    pub width: i32,
+    /// 视口高度
+    pub height: i32,
+}
+
+impl PlotView {
+    /// 创建显示全部样本的视口
+    ///
+    /// # 参数
+    /// - `left`: 视口左上角x坐标
+    /// - `top`: 视口左上角y坐标
+    /// - `width`: 视口宽度
+    /// - `height`: 视口高度
+    /// - `y_min`: 视口底边对应的样本值
+    /// - `y_max`: 视口顶边对应的样本值
+    ///
+    /// # 返回值
+    /// 新创建的 PlotView 对象
+    pub fn fit(left: i32, top: i32, width: i32, height: i32, y_min: f32, y_max: f32) -> Self {
+        Self {
+            first: 0.0,
+            samples_per_pixel: 0.0,
+            y_min,
+            y_max,
+            left,
+            top,
+            width,
+            height,
+        }
+    }
+
+    /// 设置视口左边缘对应的样本编号和每列样本数
+    ///
+    /// # 参数
+    /// - `first`: 视口左边缘对应的样本编号
+    /// - `samples_per_pixel`: 每个像素列的样本数
+    ///
+    /// # 返回值
+    /// 修改后的 PlotView 对象
+    pub fn with_range(mut self, first: f64, samples_per_pixel: f64) -> Self {
+        self.first = first;
+        self.samples_per_pixel = samples_per_pixel;
+        self
+    }
+
+    /// 视口覆盖的样本数，`samples_per_pixel` 小于等于 0 时返回 0
+    pub fn span(&self) -> f64 {
+        self.samples_per_pixel.max(0.0) * self.width.max(0) as f64
+    }
+
+    fn raw(&self) -> EasyXPlotView {
+        EasyXPlotView {
+            first: self.first,
+            samplesPerPixel: self.samples_per_pixel,
+            yMin: self.y_min,
+            yMax: self.y_max,
+            left: self.left,
+            top: self.top,
+            width: self.width,
+            height: self.height,
+        }
+    }
+}
+
+/// 时间序列折线图
+///
+/// 样本保存在 C++ 包装层中，按追加顺序编号。每个像素列的样本多于 4 个时，
+/// 每列只绘制首、最小、最大、尾四个点，百万级样本也只产生与视口宽度成正比的顶点，
+/// 并且不会丢失尖峰。抽稀结果按列缓存：平移视口时重叠部分的列直接复用，
+/// 追加样本只重新计算末尾的列，视口和数据都没有变化时直接复用上一次的顶点。
+///
+/// 使用当前线条样式和线条颜色，坐标为逻辑坐标。
+///
+/// # 注意
+/// - 固定 `samples_per_pixel` 时列缓存才能跨帧复用，缩放到全部样本时样本数变化会重新计算所有列
+/// - `trim` 丢弃最旧的样本，其余样本的编号不变，滚动显示时视口的 `first` 应从 `first_index` 开始
+///
+/// # 示例
+/// ```no_run
+/// use easyx::prelude::*;
+/// use easyx::run;
+///
+/// fn main() -> Result<(), Box<dyn std::error::Error>> {
+///     run(800, 600, |app| {
+///         let mut plot = Plot::new();
+///         let view = PlotView::fit(0, 100, 800, 400, -1.0, 1.0);
+///         let mut t = 0u64;
+///
+///         app.begin_batch_draw();
+///         loop {
+///             let chunk: Vec<f32> = (0..1000)
+///                 .map(|i| ((t + i) as f32 / 5000.0).sin())
+///                 .collect();
+///             t += 1000;
+///             plot.append(&chunk);
+///             plot.trim(1_000_000);
+///
+///             let first = (plot.first_index() + plot.len() as i64) as f64 - 800.0 * 1250.0;
+///             app.clear_device();
+///             plot.draw(&view.with_range(first, 1250.0));
+///             app.flush_batch_draw();
+///         }
+///     })
+/// }
+/// ```
+#[derive(Debug)]
+pub struct Plot {
+    ptr: *mut std::os::raw::c_void,
+}
+
+impl Plot {
+    /// 创建空的折线图
+    pub fn new() -> Self {
+        Self {
+            ptr: unsafe { easyx_plot_create() },
+        }
+    }
+
+    /// 替换全部样本，第一个样本的编号重置为 0
+    ///
+    /// # 参数
+    /// - `samples`: 样本值
+    pub fn set_data(&mut self, samples: &[f32]) {
+        unsafe {
+            easyx_plot_setdata(self.ptr, samples.as_ptr(), samples.len());
+        }
+    }
+
+    /// 在末尾追加样本，已缓存的列只有最后一列需要重新计算
+    ///
+    /// # 参数
+    /// - `samples`: 样本值
+    pub fn append(&mut self, samples: &[f32]) {
+        unsafe {
+            easyx_plot_append(self.ptr, samples.as_ptr(), samples.len());
+        }
+    }
+
+    /// 丢弃最旧的样本，只保留最新的 `keep` 个
+    ///
+    /// # 参数
+    /// - `keep`: 保留的样本数
+    pub fn trim(&mut self, keep: usize) {
+        unsafe {
+            easyx_plot_trim(self.ptr, keep);
+        }
+    }
+
+    /// 清空全部样本
+    pub fn clear(&mut self) {
+        unsafe {
+            easyx_plot_clear(self.ptr);
+        }
+    }
+
+    /// 获取样本数
+    pub fn len(&self) -> usize {
+        unsafe { easyx_plot_count(self.ptr) }
+    }
+
+    /// 判断是否没有样本
+    pub fn is_empty(&self) -> bool {
+        self.len() == 0
+    }
+
+    /// 获取第一个样本的编号
+    ///
+    /// # 返回值
+    /// 第一个样本的绝对编号，`trim` 丢弃样本后增大，`set_data` 和 `clear` 后为 0
+    pub fn first_index(&self) -> i64 {
+        unsafe { easyx_plot_firstindex(self.ptr) }
+    }
+
+    /// 在视口中绘制折线图
+    ///
+    /// # 参数
+    /// - `view`: 视口
+    ///
+    /// # 返回值
+    /// 绘制的顶点数
+    pub fn draw(&mut self, view: &PlotView) -> usize {
+        let raw = view.raw();
+        unsafe { easyx_plot_draw(self.ptr, &raw).max(0) as usize }
+    }
+}
+
+impl Default for Plot {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+impl Drop for Plot {
+    /// 释放样本和列缓存
+    fn drop(&mut self) {
+        unsafe {
+            easyx_plot_destroy(self.ptr);
+        }
+    }
+}
@@ -0,0 +1,185 @@
+//! 多缓冲呈现，由独立的呈现线程把完成的帧复制到窗口
+
+use std::marker::PhantomData;
+use std::time::Duration;
+
+use easyx_sys::*;
+
+/// 呈现模式
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Default)]
+pub enum PresentMode {
+    /// 低延迟：只呈现最新完成的帧，来不及呈现的旧帧被丢弃，绘图线程几乎不会等待
+    #[default]
+    Latency,
+    /// 高吞吐：按顺序呈现每一帧，缓冲区用尽时 `begin_frame` 等待呈现线程
+    Throughput,
+}
+
+impl PresentMode {
+    fn raw(self) -> i32 {
+        match self {
+            PresentMode::Latency => EASYX_PRESENT_LATENCY as i32,
+            PresentMode::Throughput => EASYX_PRESENT_THROUGHPUT as i32,
+        }
+    }
+}
+
+/// 呈现线程的统计信息
+#[derive(Debug, Clone, Copy, Default, PartialEq)]
+pub struct PresenterStats {
+    /// 提交的帧数
+    pub submitted: u64,
+    /// 复制到窗口的帧数
+    pub presented: u64,
+    /// 被更新的帧取代、没有呈现的帧数
+    pub dropped: u64,
+    /// `begin_frame` 因没有空闲缓冲区而等待的次数
+    pub stalls: u64,
+    /// `begin_frame` 等待空闲缓冲区的总时间
+    pub wait: Duration,
+    /// 最近一帧的复制（启用垂直同步时包括等待 DWM 合成）时间
+    pub present: Duration,
+    /// 缓冲区数量
+    pub buffers: usize,
+    /// 等待呈现的帧数
+    pub queued: usize,
+}
+
+/// 多缓冲呈现器
+///
+/// `begin_frame` 取出一个离屏缓冲区并设为工作图像，之后的绘图都画到这个缓冲区中；
+/// `submit_frame` 把它交给呈现线程复制到窗口，然后立即返回，下一帧的计算和绘制
+/// 与上一帧的复制同时进行，不再像 `flush_batch_draw` 那样等待 BitBlt 完成。
+///
+/// 同一时刻只能有一个呈现器，它在包装层中是全局的，只能在绘图线程中使用。
+/// `App::set_vsync` 启用时呈现线程每次复制后等待 DWM 合成。
+///
+/// # 注意
+/// - 缓冲区大小在启动时按窗口客户区确定，每帧需要重新绘制全部内容（缓冲区轮流使用）
+/// - 释放时把最后呈现的帧复制回窗口图像，之后可以继续使用批处理绘图
+///
+/// # 示例
+/// ```no_run
+/// use easyx::prelude::*;
+/// use easyx::run;
+///
+/// fn main() -> Result<(), Box<dyn std::error::Error>> {
+///     run(800, 600, |app| {
+///         let presenter = Presenter::start(3, PresentMode::Latency).ok_or("无法启动呈现线程")?;
+///
+///         for frame in 0..600 {
+///             presenter.begin_frame();
+///             app.clear_device();
+///             app.fill_circle(frame % 800, 300, 40);
+///             presenter.submit_frame();
+///         }
+///
+///         println!("{:?}", presenter.stats());
+///         Ok(())
+///     })
+/// }
+/// ```
+#[derive(Debug)]
+pub struct Presenter {
+    // 只能在绘图线程中使用
+    _marker: PhantomData<*mut ()>,
+}
+
+impl Presenter {
+    /// 启动呈现线程
+    ///
+    /// # 参数
+    /// - `buffers`: 离屏缓冲区数量，限制在 2 到 4 之间。2 为双缓冲，3 为三缓冲
+    /// - `mode`: 呈现模式
+    ///
+    /// # 返回值
+    /// 已有呈现器在运行或窗口未初始化时返回 None
+    pub fn start(buffers: usize, mode: PresentMode) -> Option<Self> {
+        let buffers = buffers.min(i32::MAX as usize) as i32;
+        if unsafe { easyx_presenter_start(buffers, mode.raw()) } == 0 {
+            Some(Self {
+                _marker: PhantomData,
+            })
+        } else {
+            None
+        }
+    }
+
+    /// 开始一帧，取出空闲的缓冲区并设为工作图像
+    ///
+    /// 已经开始的帧直接继续使用原来的缓冲区。缓冲区的内容是几帧之前的画面，需要重新绘制
+    pub fn begin_frame(&self) {
+        unsafe {
+            easyx_presenter_begin();
+        }
+    }
+
+    /// 提交当前帧，恢复原来的工作图像，呈现线程随后把它复制到窗口
+    pub fn submit_frame(&self) {
+        unsafe {
+            easyx_presenter_submit();
+        }
+    }
+
+    /// 绘制并提交一帧
+    ///
+    /// # 参数
+    /// - `f`: 绘制本帧的闭包
+    pub fn frame<F, R>(&self, f: F) -> R
+    where
+        F: FnOnce() -> R,
+    {
+        self.begin_frame();
+        let result = f();
+        self.submit_frame();
+        result
+    }
+
+    /// 切换呈现模式，下一次提交时生效
+    ///
+    /// # 参数
+    /// - `mode`: 呈现模式
+    pub fn set_mode(&self, mode: PresentMode) {
+        unsafe {
+            easyx_presenter_setmode(mode.raw());
+        }
+    }
+
+    /// 获取呈现模式
+    pub fn mode(&self) -> PresentMode {
+        if unsafe { easyx_presenter_getmode() } == EASYX_PRESENT_THROUGHPUT as i32 {
+            PresentMode::Throughput
+        } else {
+            PresentMode::Latency
+        }
+    }
+
+    /// 获取统计信息
+    pub fn stats(&self) -> PresenterStats {
+        let mut stats = unsafe { std::mem::zeroed::<EasyXPresenterStats>() };
+        unsafe {
+            easyx_presenter_getstats(&mut stats);
+        }
+        let ms = |v: f64| Duration::from_secs_f64(v.max(0.0) / 1000.0);
+
+        PresenterStats {
+            submitted: stats.submitted,
+            presented: stats.presented,
+            dropped: stats.dropped,
+            stalls: stats.stalls,
+            wait: ms(stats.waitMs),
+            present: ms(stats.presentMs),
+            buffers: stats.buffers.max(0) as usize,
+            queued: stats.queued.max(0) as usize,
+        }
+    }
+}
+
+impl Drop for Presenter {
+    /// 提交未完成的帧，呈现完排队的帧后停止呈现线程并释放缓冲区
+    fn drop(&mut self) {
+        unsafe {
+            easyx_presenter_stop();
+        }
+    }
+}
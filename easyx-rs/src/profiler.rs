@@ -0,0 +1,272 @@
+//! 包装层性能分析
+//!
+//! 启用 `profiler` 特性后，C++ 包装层会统计各类函数的调用次数和耗时，
+//! 用于在不借助外部工具的情况下定位每帧的时间花在了哪里。
+//! 未启用时插桩代码不参与编译，快照中的数据全部为 0。
+
+use std::time::Duration;
+
+use easyx_sys::*;
+
+use crate::app::App;
+use crate::color::Color;
+use crate::enums::BkMode;
+
+/// 性能分析类别
+///
+/// 嵌套调用的时间只计入内层函数的类别，各类别耗时之和不会重复计算
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Hash)]
+pub enum ProfileCategory {
+    /// 图元绘制，包括软件光栅化
+    Primitives = EASYX_PROF_PRIMITIVES as isize,
+
+    /// 颜色、样式、原点、裁剪区等状态设置
+    State = EASYX_PROF_STATE as isize,
+
+    /// 文本输出、文本测量和字体设置
+    Text = EASYX_PROF_TEXT as isize,
+
+    /// 图像创建、加载、保存和贴图
+    Images = EASYX_PROF_IMAGES as isize,
+
+    /// 批处理绘图的开始、刷新和结束
+    Flush = EASYX_PROF_FLUSH as isize,
+
+    /// 消息获取
+    Messages = EASYX_PROF_MESSAGES as isize,
+}
+
+impl ProfileCategory {
+    /// 所有类别，按内部索引排列
+    pub const ALL: [ProfileCategory; EASYX_PROF_CATEGORIES as usize] = [
+        ProfileCategory::Primitives,
+        ProfileCategory::State,
+        ProfileCategory::Text,
+        ProfileCategory::Images,
+        ProfileCategory::Flush,
+        ProfileCategory::Messages,
+    ];
+
+    /// 获取类别的显示名称
+    pub fn label(&self) -> &'static str {
+        match self {
+            ProfileCategory::Primitives => "图元",
+            ProfileCategory::State => "状态",
+            ProfileCategory::Text => "文本",
+            ProfileCategory::Images => "图像",
+            ProfileCategory::Flush => "刷新",
+            ProfileCategory::Messages => "消息",
+        }
+    }
+}
+
+/// 性能分析快照
+#[derive(Debug, Clone, Copy, Default, PartialEq)]
+pub struct ProfilerSnapshot {
+    /// 各类别的调用次数
+    pub calls: [u64; EASYX_PROF_CATEGORIES as usize],
+
+    /// 各类别的独占耗时
+    pub time: [Duration; EASYX_PROF_CATEGORIES as usize],
+
+    /// 自上次重置以来经过的时间
+    pub elapsed: Duration,
+}
+
+impl ProfilerSnapshot {
+    /// 获取指定类别的调用次数
+    pub fn calls(&self, category: ProfileCategory) -> u64 {
+        self.calls[category as usize]
+    }
+
+    /// 获取指定类别的耗时
+    pub fn time(&self, category: ProfileCategory) -> Duration {
+        self.time[category as usize]
+    }
+
+    /// 获取所有类别的耗时之和
+    pub fn total_time(&self) -> Duration {
+        self.time.iter().sum()
+    }
+}
+
+/// 包装层性能分析器
+///
+/// # 示例
+/// ```no_run
+/// use easyx::prelude::*;
+///
+/// if Profiler::available() {
+///     let snapshot = Profiler::snapshot(true);
+///     println!("文本耗时: {:?}", snapshot.time(ProfileCategory::Text));
+/// }
+/// ```
+#[derive(Debug, Clone, Copy)]
+pub struct Profiler;
+
+impl Profiler {
+    /// 判断包装层是否启用了插桩
+    ///
+    /// # 返回值
+    /// 启用了 `profiler` 特性时返回 true
+    pub fn available() -> bool {
+        unsafe { easyx_profiler_available() != 0 }
+    }
+
+    /// 获取当前的统计数据
+    ///
+    /// # 参数
+    /// - `reset`: 获取后是否清空统计数据，按帧统计时传入 true
+    ///
+    /// # 返回值
+    /// 自上次重置以来的统计数据
+    pub fn snapshot(reset: bool) -> ProfilerSnapshot {
+        let mut raw = EasyXProfilerSnapshot {
+            calls: [0; EASYX_PROF_CATEGORIES as usize],
+            ms: [0.0; EASYX_PROF_CATEGORIES as usize],
+            elapsedMs: 0.0,
+        };
+
+        unsafe {
+            easyx_profiler_snapshot(&mut raw, reset as i32);
+        }
+
+        let mut snapshot = ProfilerSnapshot {
+            calls: raw.calls,
+            elapsed: Duration::from_secs_f64(raw.elapsedMs.max(0.0) / 1000.0),
+            ..Default::default()
+        };
+        for (time, ms) in snapshot.time.iter_mut().zip(raw.ms) {
+            *time = Duration::from_secs_f64(ms.max(0.0) / 1000.0);
+        }
+        snapshot
+    }
+
+    /// 清空统计数据并重新开始计时
+    pub fn reset() {
+        unsafe {
+            easyx_profiler_reset();
+        }
+    }
+}
+
+/// 性能分析叠加层
+///
+/// 每帧获取一次快照并清空统计数据，在画面上绘制各类别的调用次数和耗时。
+/// 叠加层自身的绘制会计入下一帧的统计。
+///
+/// # 示例
+/// ```no_run
+/// use easyx::prelude::*;
+/// use easyx::run;
+///
+/// fn main() -> Result<(), Box<dyn std::error::Error>> {
+///     run(800, 600, |app| {
+///         let mut overlay = ProfilerOverlay::new(10, 10);
+///
+///         app.begin_batch_draw();
+///         loop {
+///             app.clear_device();
+///             // 绘制游戏画面...
+///             overlay.draw(app);
+///             app.flush_batch_draw();
+///         }
+///     })
+/// }
+/// ```
+#[derive(Debug, Clone)]
+pub struct ProfilerOverlay {
+    x: i32,
+    y: i32,
+    background: Color,
+    foreground: Color,
+    last: ProfilerSnapshot,
+}
+
+impl ProfilerOverlay {
+    /// 创建叠加层
+    ///
+    /// # 参数
+    /// - `x`: 叠加层左上角x坐标
+    /// - `y`: 叠加层左上角y坐标
+    pub fn new(x: i32, y: i32) -> Self {
+        Self {
+            x,
+            y,
+            background: Color::BLACK,
+            foreground: Color::WHITE,
+            last: ProfilerSnapshot::default(),
+        }
+    }
+
+    /// 设置叠加层的背景色和文字颜色
+    ///
+    /// # 参数
+    /// - `background`: 背景色
+    /// - `foreground`: 文字颜色
+    pub fn with_colors(mut self, background: Color, foreground: Color) -> Self {
+        self.background = background;
+        self.foreground = foreground;
+        self
+    }
+
+    /// 获取最近一次绘制时使用的快照
+    pub fn last_snapshot(&self) -> &ProfilerSnapshot {
+        &self.last
+    }
+
+    /// 获取新的快照并绘制叠加层
+    ///
+    /// 绘制后恢复填充颜色、文本颜色和背景模式
+    ///
+    /// # 参数
+    /// - `app`: 应用程序实例
+    pub fn draw(&mut self, app: &App) {
+        self.last = Profiler::snapshot(true);
+
+        let mut lines = Vec::with_capacity(ProfileCategory::ALL.len() + 1);
+        if Profiler::available() {
+            let elapsed = self.last.elapsed.as_secs_f64() * 1000.0;
+            let total = self.last.total_time().as_secs_f64() * 1000.0;
+            lines.push(format!("帧 {:.2} ms  包装层 {:.2} ms", elapsed, total));
+            for category in ProfileCategory::ALL {
+                lines.push(format!(
+                    "{} {:>6} 次 {:>8.3} ms",
+                    category.label(),
+                    self.last.calls(category),
+                    self.last.time(category).as_secs_f64() * 1000.0
+                ));
+            }
+        } else {
+            lines.push("未启用 profiler 特性".to_string());
+        }
+
+        let line_height = lines
+            .iter()
+            .map(|line| app.text_height(line))
+            .max()
+            .unwrap_or(0);
+        let width = lines
+            .iter()
+            .map(|line| app.text_width(line))
+            .max()
+            .unwrap_or(0);
+        let height = line_height * lines.len() as i32;
+
+        let fillcolor = app.get_fillcolor();
+        let textcolor = app.get_textcolor();
+        let bkmode = app.get_bkmode();
+
+        app.set_fillcolor(&self.background);
+        app.solid_rectangle(self.x, self.y, self.x + width + 8, self.y + height + 8);
+        app.set_textcolor(&self.foreground);
+        app.set_bkmode(&BkMode::Transparent);
+        for (i, line) in lines.iter().enumerate() {
+            app.out_text(self.x + 4, self.y + 4 + line_height * i as i32, line);
+        }
+
+        app.set_fillcolor(&fillcolor);
+        app.set_textcolor(&textcolor);
+        app.set_bkmode(&bkmode);
+    }
+}
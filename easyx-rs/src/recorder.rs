@@ -0,0 +1,180 @@
+//! 帧序列录制，后台线程编码，不阻塞绘图循环
+
+use std::ffi::CString;
+use std::marker::PhantomData;
+use std::time::Duration;
+
+use easyx_sys::*;
+
+use crate::image::Image;
+
+/// 录制格式
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Default)]
+pub enum RecordFormat {
+    /// 未压缩的像素，写入单个文件
+    Raw,
+    /// 只记录与上一帧不同的像素，定期写入关键帧，写入单个文件
+    #[default]
+    Delta,
+    /// 每帧一个 PNG 文件，文件名中连续的 `#` 替换为帧序号
+    Png,
+}
+
+impl RecordFormat {
+    fn raw(self) -> i32 {
+        match self {
+            RecordFormat::Raw => EASYX_RECORD_RAW as i32,
+            RecordFormat::Delta => EASYX_RECORD_DELTA as i32,
+            RecordFormat::Png => EASYX_RECORD_PNG as i32,
+        }
+    }
+}
+
+/// 录制的统计信息
+#[derive(Debug, Clone, Copy, Default, PartialEq)]
+pub struct RecorderStats {
+    /// 复制到帧池的帧数
+    pub captured: u64,
+    /// 编码并写入的帧数
+    pub written: u64,
+    /// 帧池用尽或写入失败而丢弃的帧数
+    pub dropped: u64,
+    /// 写入的字节数
+    pub bytes: u64,
+    /// 最近一帧的编码和写入时间
+    pub encode: Duration,
+    /// 等待编码的帧数
+    pub queued: usize,
+    /// 帧池的大小
+    pub pool: usize,
+    /// 第一次写入失败的 HRESULT，之后不再写入
+    pub error: Option<i32>,
+}
+
+/// 帧序列录制器
+///
+/// `capture` 把窗口（或图像）的缓冲区复制到预先分配的帧池中后立即返回，
+/// 编码和写入在后台线程中进行，不再像逐帧调用 `save_image` 那样阻塞绘图循环。
+/// 编码跟不上时丢弃新的帧而不是等待，丢弃的帧数见 `stats`。
+///
+/// 原始和差分格式的文件由 16 字节的文件头（`EXRC`、版本、格式）和逐帧记录组成，
+/// 每帧记录头为宽、高、标志、内容字节数（各 32 位）、捕获序号和微秒时间戳（各 64 位）。
+///
+/// # 注意
+/// - 只能在绘图线程中捕获
+/// - 释放时写完排队的帧
+///
+/// # 示例
+/// ```no_run
+/// use easyx::prelude::*;
+/// use easyx::run;
+///
+/// fn main() -> Result<(), Box<dyn std::error::Error>> {
+///     run(800, 600, |app| {
+///         let recorder = Recorder::new("demo.exrc", RecordFormat::Delta, 8).ok_or("无法创建录制文件")?;
+///
+///         app.begin_batch_draw();
+///         for frame in 0..600 {
+///             app.clear_device();
+///             app.fill_circle(frame % 800, 300, 40);
+///             app.flush_batch_draw();
+///             recorder.capture();
+///         }
+///         app.end_batch_draw();
+///
+///         println!("{:?}", recorder.finish());
+///         Ok(())
+///     })
+/// }
+/// ```
+#[derive(Debug)]
+pub struct Recorder {
+    ptr: *mut std::os::raw::c_void,
+    // 只能在绘图线程中使用
+    _marker: PhantomData<*mut ()>,
+}
+
+impl Recorder {
+    /// 创建录制器并启动编码线程
+    ///
+    /// # 参数
+    /// - `path`: 输出文件路径；PNG 序列为文件名模板，例如 `frames/shot_####.png`，
+    ///   没有 `#` 时在扩展名之前加上六位序号
+    /// - `format`: 录制格式
+    /// - `pool`: 帧池的大小，限制在 2 到 64 之间。越大越能吸收编码时间的波动，占用的内存也越多
+    ///
+    /// # 返回值
+    /// 无法创建输出文件时返回 None
+    pub fn new(path: &str, format: RecordFormat, pool: usize) -> Option<Self> {
+        let c_path = CString::new(path).ok()?;
+        let pool = pool.min(i32::MAX as usize) as i32;
+        let ptr = unsafe { easyx_recorder_create(c_path.as_ptr(), format.raw(), pool) };
+        (!ptr.is_null()).then_some(Self {
+            ptr,
+            _marker: PhantomData,
+        })
+    }
+
+    /// 捕获绘图窗口的当前内容
+    ///
+    /// # 返回值
+    /// 帧池用尽而丢弃这一帧或写入已经失败时返回 false
+    pub fn capture(&self) -> bool {
+        unsafe { easyx_recorder_capture(self.ptr, std::ptr::null()) == 1 }
+    }
+
+    /// 捕获图像的当前内容
+    ///
+    /// # 参数
+    /// - `image`: 要捕获的图像，大小可以与之前的帧不同
+    ///
+    /// # 返回值
+    /// 帧池用尽而丢弃这一帧或写入已经失败时返回 false
+    pub fn capture_image(&self, image: &Image) -> bool {
+        unsafe { easyx_recorder_capture(self.ptr, image.as_mut_ptr()) == 1 }
+    }
+
+    /// 获取统计信息
+    pub fn stats(&self) -> RecorderStats {
+        let mut stats = unsafe { std::mem::zeroed::<EasyXRecorderStats>() };
+        unsafe {
+            easyx_recorder_getstats(self.ptr, &mut stats);
+        }
+
+        RecorderStats {
+            captured: stats.captured,
+            written: stats.written,
+            dropped: stats.dropped,
+            bytes: stats.bytes,
+            encode: Duration::from_secs_f64(stats.encodeMs.max(0.0) / 1000.0),
+            queued: stats.queued.max(0) as usize,
+            pool: stats.pool.max(0) as usize,
+            error: (stats.error != 0).then_some(stats.error),
+        }
+    }
+
+    /// 等待排队的帧全部写入，绘图线程会被阻塞
+    pub fn flush(&self) {
+        unsafe {
+            easyx_recorder_flush(self.ptr);
+        }
+    }
+
+    /// 写完排队的帧并关闭输出文件
+    ///
+    /// # 返回值
+    /// 最终的统计信息
+    pub fn finish(self) -> RecorderStats {
+        self.flush();
+        self.stats()
+    }
+}
+
+impl Drop for Recorder {
+    /// 写完排队的帧，停止编码线程并关闭输出文件
+    fn drop(&mut self) {
+        unsafe {
+            easyx_recorder_destroy(self.ptr);
+        }
+    }
+}
@@ -0,0 +1,306 @@
+//! 保留模式的场景图层，缓存光栅化结果并只重新合成变化的区域
+
+use easyx_sys::*;
+
+use crate::app::CommandBuffer;
+use crate::color::Color;
+
+/// 图层编号
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Hash)]
+pub struct LayerId(i32);
+
+/// 场景的统计信息
+#[derive(Debug, Clone, Copy, Default, PartialEq, Eq)]
+pub struct SceneStats {
+    /// 光栅化图层的次数
+    pub rasterized: u64,
+    /// 复制或混合的图层块数
+    pub blits: u64,
+    /// 合成的区域数
+    pub regions: u64,
+    /// 呈现次数
+    pub presents: u64,
+}
+
+/// 保留模式的场景
+///
+/// 每个图层保存一段录制好的 `CommandBuffer`，第一次呈现时光栅化到缓存的图像中，
+/// 之后只有命令流或底色变化才重新光栅化。移动图层、切换可见性、调整层级或透明度
+/// 只会把旧位置和新位置登记为损坏区域，`present` 只重新合成这些区域：
+/// 先填充背景色，再按层级从低到高复制不透明图层、混合透明图层。
+///
+/// 不透明图层先填充底色再回放命令；透明图层分别在黑底和白底上回放一次，
+/// 由两次结果之差得到每个像素的透明度，抗锯齿的文本边缘也能正确混合。
+///
+/// 图层坐标为工作图像的设备坐标，不受 `set_origin` 和裁剪区影响；
+/// 命令流中的坐标以图层左上角为原点。
+///
+/// # 注意
+/// - `present` 会覆盖损坏区域中的全部像素，场景之外直接绘制的内容需要放到图层中，
+///   或者绘制后调用 `damage` 登记
+/// - 透明图层两次回放之间绘图状态会恢复默认，命令流应当自己设置需要的颜色和样式
+///
+/// # 示例
+/// ```no_run
+/// use easyx::prelude::*;
+/// use easyx::run;
+///
+/// fn main() -> Result<(), Box<dyn std::error::Error>> {
+///     run(800, 600, |app| {
+///         let mut scene = Scene::new();
+///         scene.set_background(&Color::BLACK);
+///
+///         let board = scene.add_layer(0, 0, 800, 600, 0, false);
+///         scene.record(board, |cmds| {
+///             cmds.set_fillcolor(&Color::BLUE).fill_rectangle(100, 100, 700, 500);
+///         });
+///
+///         let hud = scene.add_layer(10, 10, 300, 40, 1, true);
+///         scene.record(hud, |cmds| {
+///             cmds.set_textcolor(&Color::WHITE).out_text(0, 0, "Score: 0");
+///         });
+///
+///         app.begin_batch_draw();
+///         for x in 0..500 {
+///             // 只重新合成 HUD 的旧位置和新位置
+///             scene.set_position(hud, 10 + x, 10);
+///             scene.present();
+///             app.flush_batch_draw_dirty();
+///         }
+///         Ok(())
+///     })
+/// }
+/// ```
+#[derive(Debug)]
+pub struct Scene {
+    ptr: *mut std::os::raw::c_void,
+    cmds: CommandBuffer,
+}
+
+impl Scene {
+    /// 创建空的场景，背景色为黑色
+    pub fn new() -> Self {
+        Self {
+            ptr: unsafe { easyx_scene_create() },
+            cmds: CommandBuffer::new(),
+        }
+    }
+
+    /// 添加图层
+    ///
+    /// # 参数
+    /// - `x`: 图层左上角x坐标
+    /// - `y`: 图层左上角y坐标
+    /// - `width`: 图层宽度
+    /// - `height`: 图层高度
+    /// - `z`: 层级，较大的图层覆盖较小的，相同时后添加的在上
+    /// - `transparent`: 是否为透明图层，透明图层只绘制命令流实际画到的像素
+    ///
+    /// # 返回值
+    /// 图层编号，宽高小于等于 0 时返回 None
+    pub fn add_layer(
+        &mut self,
+        x: i32,
+        y: i32,
+        width: i32,
+        height: i32,
+        z: i32,
+        transparent: bool,
+    ) -> Option<LayerId> {
+        let flags = if transparent {
+            EASYX_LAYER_TRANSPARENT
+        } else {
+            EASYX_LAYER_OPAQUE
+        };
+        let id = unsafe { easyx_scene_addlayer(self.ptr, x, y, width, height, z, flags as i32) };
+        if id >= 0 { Some(LayerId(id)) } else { None }
+    }
+
+    /// 移除图层，下一次呈现时重新合成它覆盖的区域
+    ///
+    /// # 参数
+    /// - `layer`: 图层编号
+    pub fn remove_layer(&mut self, layer: LayerId) {
+        unsafe {
+            easyx_scene_removelayer(self.ptr, layer.0);
+        }
+    }
+
+    /// 设置图层的命令流，命令流会被复制，下一次呈现时重新光栅化
+    ///
+    /// # 参数
+    /// - `layer`: 图层编号
+    /// - `cmds`: 录制好的命令缓冲，坐标以图层左上角为原点
+    pub fn set_commands(&mut self, layer: LayerId, cmds: &CommandBuffer) {
+        let bytes = cmds.as_bytes();
+        unsafe {
+            easyx_scene_setcommands(self.ptr, layer.0, bytes.as_ptr().cast(), bytes.len());
+        }
+    }
+
+    /// 录制图层的命令流，复用场景内部的命令缓冲
+    ///
+    /// # 参数
+    /// - `layer`: 图层编号
+    /// - `f`: 录制命令的闭包
+    pub fn record<F>(&mut self, layer: LayerId, f: F)
+    where
+        F: FnOnce(&mut CommandBuffer),
+    {
+        let mut cmds = std::mem::take(&mut self.cmds);
+        cmds.clear();
+        f(&mut cmds);
+        self.set_commands(layer, &cmds);
+        self.cmds = cmds;
+    }
+
+    /// 标记图层内容失效，下一次呈现时重新光栅化
+    ///
+    /// # 参数
+    /// - `layer`: 图层编号
+    pub fn invalidate(&mut self, layer: LayerId) {
+        unsafe {
+            easyx_scene_invalidate(self.ptr, layer.0);
+        }
+    }
+
+    /// 移动图层，不需要重新光栅化
+    ///
+    /// # 参数
+    /// - `layer`: 图层编号
+    /// - `x`: 图层左上角x坐标
+    /// - `y`: 图层左上角y坐标
+    pub fn set_position(&mut self, layer: LayerId, x: i32, y: i32) {
+        unsafe {
+            easyx_scene_setposition(self.ptr, layer.0, x, y);
+        }
+    }
+
+    /// 调整图层大小，下一次呈现时重新光栅化
+    ///
+    /// # 参数
+    /// - `layer`: 图层编号
+    /// - `width`: 图层宽度
+    /// - `height`: 图层高度
+    pub fn set_size(&mut self, layer: LayerId, width: i32, height: i32) {
+        unsafe {
+            easyx_scene_setsize(self.ptr, layer.0, width, height);
+        }
+    }
+
+    /// 设置图层是否可见，隐藏的图层不会光栅化
+    ///
+    /// # 参数
+    /// - `layer`: 图层编号
+    /// - `visible`: 是否可见
+    pub fn set_visible(&mut self, layer: LayerId, visible: bool) {
+        unsafe {
+            easyx_scene_setvisible(self.ptr, layer.0, visible as i32);
+        }
+    }
+
+    /// 设置图层的层级
+    ///
+    /// # 参数
+    /// - `layer`: 图层编号
+    /// - `z`: 层级，较大的图层覆盖较小的
+    pub fn set_z(&mut self, layer: LayerId, z: i32) {
+        unsafe {
+            easyx_scene_setz(self.ptr, layer.0, z);
+        }
+    }
+
+    /// 设置图层的整体透明度，不需要重新光栅化
+    ///
+    /// # 参数
+    /// - `layer`: 图层编号
+    /// - `alpha`: 透明度，255 为不透明
+    pub fn set_alpha(&mut self, layer: LayerId, alpha: u8) {
+        unsafe {
+            easyx_scene_setalpha(self.ptr, layer.0, alpha);
+        }
+    }
+
+    /// 设置不透明图层的底色，下一次呈现时重新光栅化
+    ///
+    /// # 参数
+    /// - `layer`: 图层编号
+    /// - `color`: 底色，透明图层忽略此设置
+    pub fn set_fill(&mut self, layer: LayerId, color: &Color) {
+        unsafe {
+            easyx_scene_setfill(self.ptr, layer.0, color.as_colorref());
+        }
+    }
+
+    /// 设置场景背景色，下一次呈现时重新合成整个工作图像
+    ///
+    /// # 参数
+    /// - `color`: 背景色
+    pub fn set_background(&mut self, color: &Color) {
+        unsafe {
+            easyx_scene_setbackground(self.ptr, color.as_colorref());
+        }
+    }
+
+    /// 登记需要重新合成的区域
+    ///
+    /// # 参数
+    /// - `left`: 左边界（设备坐标）
+    /// - `top`: 上边界（设备坐标）
+    /// - `right`: 右边界（包含）
+    /// - `bottom`: 下边界（包含）
+    pub fn damage(&mut self, left: i32, top: i32, right: i32, bottom: i32) {
+        unsafe {
+            easyx_scene_damage(self.ptr, left, top, right, bottom);
+        }
+    }
+
+    /// 下一次呈现时重新合成整个工作图像，例如窗口内容被其他代码覆盖后
+    pub fn redraw_all(&mut self) {
+        unsafe {
+            easyx_scene_redraw(self.ptr);
+        }
+    }
+
+    /// 光栅化失效的图层，重新合成损坏区域并登记为脏矩形
+    ///
+    /// # 返回值
+    /// 复制或混合的图层块数，没有变化时为 0
+    pub fn present(&mut self) -> usize {
+        unsafe { easyx_scene_present(self.ptr).max(0) as usize }
+    }
+
+    /// 获取统计信息
+    pub fn stats(&self) -> SceneStats {
+        let mut stats = EasyXSceneStats {
+            rasterized: 0,
+            blits: 0,
+            regions: 0,
+            presents: 0,
+        };
+        unsafe {
+            easyx_scene_getstats(self.ptr, &mut stats);
+        }
+        SceneStats {
+            rasterized: stats.rasterized,
+            blits: stats.blits,
+            regions: stats.regions,
+            presents: stats.presents,
+        }
+    }
+}
+
+impl Default for Scene {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+impl Drop for Scene {
+    /// 释放图层和缓存的图像
+    fn drop(&mut self) {
+        unsafe {
+            easyx_scene_destroy(self.ptr);
+        }
+    }
+}
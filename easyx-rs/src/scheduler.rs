@@ -0,0 +1,515 @@
+//! 工作窃取任务调度与绘图线程消息队列
+
+use std::cell::RefCell;
+use std::collections::VecDeque;
+use std::panic::{self, AssertUnwindSafe};
+use std::sync::atomic::{AtomicBool, AtomicU64, AtomicUsize, Ordering};
+use std::sync::{Arc, Condvar, Mutex, MutexGuard};
+use std::thread::{self, JoinHandle};
+use std::time::{Duration, Instant};
+
+use easyx_sys::easyx_wake;
+
+use crate::app::{App, CommandBuffer};
+
+type Job = Box<dyn FnOnce(&TaskContext) + Send>;
+type MainJob = Box<dyn FnOnce(&App) + Send>;
+
+thread_local! {
+    /// 当前工作线程所属的调度器和编号，非工作线程为 None
+    static CURRENT_WORKER: RefCell<Option<(Arc<Shared>, usize)>> = const { RefCell::new(None) };
+}
+
+/// 任务中的 panic 不会在持有锁时发生，忽略锁中毒
+fn lock<T>(mutex: &Mutex<T>) -> MutexGuard<'_, T> {
+    mutex.lock().unwrap_or_else(|e| e.into_inner())
+}
+
+struct Shared {
+    /// 从绘图线程（或其他非工作线程）提交的任务
+    injector: Mutex<VecDeque<Job>>,
+    /// 每个工作线程的本地队列，自己从尾部取，其他线程从头部窃取
+    locals: Vec<Mutex<VecDeque<Job>>>,
+    /// 所有队列中等待执行的任务数
+    queued: AtomicUsize,
+    sleep: Mutex<()>,
+    wake: Condvar,
+    stopping: AtomicBool,
+    /// 等待在绘图线程上执行的闭包
+    main: Mutex<VecDeque<MainJob>>,
+
+    spawned: AtomicU64,
+    completed: AtomicU64,
+    stolen: AtomicU64,
+}
+
+impl Shared {
+    fn push(&self, worker: Option<usize>, job: Job) {
+        match worker {
+            Some(index) => lock(&self.locals[index]).push_back(job),
+            None => lock(&self.injector).push_back(job),
+        }
+        self.spawned.fetch_add(1, Ordering::Relaxed);
+        self.queued.fetch_add(1, Ordering::SeqCst);
+
+        // 持有锁通知，避免与检查 queued 后准备休眠的工作线程错过
+        let _guard = lock(&self.sleep);
+        self.wake.notify_one();
+    }
+
+    fn find(&self, index: usize) -> Option<Job> {
+        if let Some(job) = lock(&self.locals[index]).pop_back() {
+            return Some(job);
+        }
+        if let Some(job) = lock(&self.injector).pop_front() {
+            return Some(job);
+        }
+
+        let count = self.locals.len();
+        for offset in 1..count {
+            let victim = (index + offset) % count;
+            if let Some(job) = lock(&self.locals[victim]).pop_front() {
+                self.stolen.fetch_add(1, Ordering::Relaxed);
+                return Some(job);
+            }
+        }
+        None
+    }
+
+    fn post(&self, job: MainJob) {
+        if self.stopping.load(Ordering::Relaxed) {
+            return;
+        }
+        lock(&self.main).push_back(job);
+        // 绘图线程可能正在等待消息
+        unsafe {
+            easyx_wake();
+        }
+    }
+}
+
+fn run_job(ctx: &TaskContext, job: Job) {
+    ctx.shared.queued.fetch_sub(1, Ordering::SeqCst);
+    job(ctx);
+    ctx.shared.completed.fetch_add(1, Ordering::Relaxed);
+}
+
+fn worker_main(shared: Arc<Shared>, index: usize) {
+    CURRENT_WORKER.with(|current| *current.borrow_mut() = Some((shared.clone(), index)));
+    let ctx = TaskContext {
+        shared: &shared,
+        worker: index,
+    };
+
+    while !shared.stopping.load(Ordering::SeqCst) {
+        if let Some(job) = shared.find(index) {
+            run_job(&ctx, job);
+            continue;
+        }
+
+        let guard = lock(&shared.sleep);
+        if shared.stopping.load(Ordering::SeqCst) {
+            break;
+        }
+        if shared.queued.load(Ordering::SeqCst) == 0 {
+            drop(shared.wake.wait(guard));
+        }
+    }
+    CURRENT_WORKER.with(|current| *current.borrow_mut() = None);
+}
+
+enum TaskState<T> {
+    Pending,
+    Done(thread::Result<T>),
+    Cancelled,
+    Taken,
+}
+
+struct TaskSlot<T> {
+    state: Mutex<TaskState<T>>,
+    done: Condvar,
+}
+
+/// 任务的完成端，随任务闭包一起移动，任务未执行就被丢弃时标记为已取消
+struct Completion<T> {
+    slot: Option<Arc<TaskSlot<T>>>,
+}
+
+impl<T> Completion<T> {
+    fn complete(mut self, result: thread::Result<T>) {
+        if let Some(slot) = self.slot.take() {
+            *lock(&slot.state) = TaskState::Done(result);
+            slot.done.notify_all();
+        }
+    }
+}
+
+impl<T> Drop for Completion<T> {
+    fn drop(&mut self) {
+        if let Some(slot) = self.slot.take() {
+            *lock(&slot.state) = TaskState::Cancelled;
+            slot.done.notify_all();
+        }
+    }
+}
+
+fn task_job<T, F>(f: F) -> (TaskHandle<T>, Job)
+where
+    F: FnOnce(&TaskContext) -> T + Send + 'static,
+    T: Send + 'static,
+{
+    let slot = Arc::new(TaskSlot {
+        state: Mutex::new(TaskState::Pending),
+        done: Condvar::new(),
+    });
+    let completion = Completion {
+        slot: Some(slot.clone()),
+    };
+    let job: Job = Box::new(move |ctx| {
+        completion.complete(panic::catch_unwind(AssertUnwindSafe(|| f(ctx))));
+    });
+    (TaskHandle { slot }, job)
+}
+
+/// 后台任务的句柄
+///
+/// 丢弃句柄不会取消任务，任务照常执行，结果被丢弃
+pub struct TaskHandle<T> {
+    slot: Arc<TaskSlot<T>>,
+}
+
+impl<T> TaskHandle<T> {
+    /// 判断任务是否已经结束（完成、panic 或被取消）
+    pub fn is_done(&self) -> bool {
+        !matches!(*lock(&self.slot.state), TaskState::Pending)
+    }
+
+    /// 判断任务是否因调度器关闭而未执行
+    pub fn is_cancelled(&self) -> bool {
+        matches!(*lock(&self.slot.state), TaskState::Cancelled)
+    }
+
+    /// 非阻塞地取走任务结果
+    ///
+    /// 任务中的 panic 会在调用线程上重新抛出
+    ///
+    /// # 返回值
+    /// 任务完成时返回结果，尚未完成、已被取消或结果已取走时返回 None
+    pub fn try_take(&mut self) -> Option<T> {
+        let mut state = lock(&self.slot.state);
+        match std::mem::replace(&mut *state, TaskState::Taken) {
+            TaskState::Done(result) => {
+                drop(state);
+                Some(result.unwrap_or_else(|payload| panic::resume_unwind(payload)))
+            }
+            other => {
+                *state = other;
+                None
+            }
+        }
+    }
+
+    /// 阻塞等待任务结束
+    ///
+    /// 任务中的 panic 会在调用线程上重新抛出。
+    /// 在工作线程上（任务中）等待时，任务未完成前先执行队列中等待的任务，
+    /// 子任务排在当前线程的队列中，只有一个工作线程时也不会死锁。
+    /// 不要在绘图线程上等待依赖 `App::run_main_tasks` 才能完成的任务，否则会死锁
+    ///
+    /// # 返回值
+    /// 任务的结果，任务被取消或结果已取走时返回 None
+    pub fn wait(mut self) -> Option<T> {
+        let worker = CURRENT_WORKER.with(|current| current.borrow().clone());
+        {
+            let mut state = lock(&self.slot.state);
+            while matches!(*state, TaskState::Pending) {
+                // 队列中没有任务时，等待的任务已经在其他线程上执行，完成时会通知
+                if let Some((shared, index)) = &worker {
+                    if let Some(job) = shared.find(*index) {
+                        drop(state);
+                        let ctx = TaskContext {
+                            shared,
+                            worker: *index,
+                        };
+                        run_job(&ctx, job);
+                        state = lock(&self.slot.state);
+                        continue;
+                    }
+                }
+                state = self
+                    .slot
+                    .done
+                    .wait(state)
+                    .unwrap_or_else(|e| e.into_inner());
+            }
+        }
+        self.try_take()
+    }
+}
+
+/// 调度器的统计信息
+#[derive(Debug, Clone, Copy, Default, PartialEq, Eq)]
+pub struct SchedulerStats {
+    /// 提交的任务数
+    pub spawned: u64,
+    /// 执行完成的任务数
+    pub completed: u64,
+    /// 从其他工作线程窃取的任务数
+    pub stolen: u64,
+    /// 等待执行的任务数
+    pub queued: usize,
+    /// 等待在绘图线程上执行的闭包数
+    pub main_pending: usize,
+}
+
+/// 工作窃取线程池
+///
+/// 每个工作线程有自己的任务队列，任务中提交的子任务进入当前线程的队列（后进先出，缓存友好），
+/// 空闲的线程从其他线程队列的头部窃取较早提交的任务，负载不均时自动平衡。
+/// 从绘图线程提交的任务进入共享队列。
+///
+/// EasyX 的函数不是线程安全的，任务不能直接绘图，而是通过 `TaskContext::post`
+/// 或 `MainSender` 把闭包（或录制好的 `CommandBuffer`）发回绘图线程，
+/// 由绘图线程每帧调用 `App::run_main_tasks` 在时间预算内执行。
+///
+/// 通常通过 `App::scheduler` 使用 App 持有的调度器，第一次使用时创建。
+pub struct Scheduler {
+    shared: Arc<Shared>,
+    threads: usize,
+    // JoinHandle 不是 RefUnwindSafe，放在 Mutex 中使 &App 可以传给 App::run
+    workers: Mutex<Vec<JoinHandle<()>>>,
+}
+
+impl Scheduler {
+    /// 创建线程池
+    ///
+    /// # 参数
+    /// - `threads`: 工作线程数，0 表示 CPU 核心数减一（留一个核心给绘图线程）
+    ///
+    /// # 返回值
+    /// 新创建的 Scheduler 对象
+    pub fn new(threads: usize) -> Self {
+        let threads = if threads > 0 {
+            threads
+        } else {
+            thread::available_parallelism()
+                .map(|n| n.get().saturating_sub(1))
+                .unwrap_or(1)
+                .max(1)
+        };
+
+        let shared = Arc::new(Shared {
+            injector: Mutex::new(VecDeque::new()),
+            locals: (0..threads).map(|_| Mutex::new(VecDeque::new())).collect(),
+            queued: AtomicUsize::new(0),
+            sleep: Mutex::new(()),
+            wake: Condvar::new(),
+            stopping: AtomicBool::new(false),
+            main: Mutex::new(VecDeque::new()),
+            spawned: AtomicU64::new(0),
+            completed: AtomicU64::new(0),
+            stolen: AtomicU64::new(0),
+        });
+
+        let workers = (0..threads)
+            .map(|index| {
+                let shared = shared.clone();
+                thread::Builder::new()
+                    .name(format!("easyx-worker-{}", index))
+                    .spawn(move || worker_main(shared, index))
+                    .expect("无法创建工作线程")
+            })
+            .collect();
+
+        Self {
+            shared,
+            threads,
+            workers: Mutex::new(workers),
+        }
+    }
+
+    /// 获取工作线程数
+    pub fn threads(&self) -> usize {
+        self.threads
+    }
+
+    /// 提交后台任务
+    ///
+    /// # 参数
+    /// - `f`: 任务闭包，在工作线程上执行
+    ///
+    /// # 返回值
+    /// 任务句柄，用于获取结果
+    pub fn spawn<T, F>(&self, f: F) -> TaskHandle<T>
+    where
+        F: FnOnce(&TaskContext) -> T + Send + 'static,
+        T: Send + 'static,
+    {
+        let (handle, job) = task_job(f);
+        self.shared.push(None, job);
+        handle
+    }
+
+    /// 获取向绘图线程发送闭包的句柄
+    pub fn main_sender(&self) -> MainSender {
+        MainSender {
+            shared: self.shared.clone(),
+        }
+    }
+
+    /// 在绘图线程上执行发回的闭包，直到队列为空或超出时间预算
+    ///
+    /// 至少执行一个闭包，保证队列总能前进；执行期间新发回的闭包留到下一次调用
+    ///
+    /// # 参数
+    /// - `app`: 绘图线程的 App
+    /// - `budget`: 时间预算，None 表示执行调用时已在队列中的全部闭包
+    ///
+    /// # 返回值
+    /// 执行的闭包数
+    pub fn run_main(&self, app: &App, budget: Option<Duration>) -> usize {
+        let start = Instant::now();
+        let mut remaining = lock(&self.shared.main).len();
+        let mut count = 0;
+
+        while remaining > 0 {
+            let Some(job) = lock(&self.shared.main).pop_front() else {
+                break;
+            };
+            job(app);
+            count += 1;
+            remaining -= 1;
+
+            if budget.is_some_and(|budget| start.elapsed() >= budget) {
+                break;
+            }
+        }
+        count
+    }
+
+    /// 获取统计信息
+    pub fn stats(&self) -> SchedulerStats {
+        SchedulerStats {
+            spawned: self.shared.spawned.load(Ordering::Relaxed),
+            completed: self.shared.completed.load(Ordering::Relaxed),
+            stolen: self.shared.stolen.load(Ordering::Relaxed),
+            queued: self.shared.queued.load(Ordering::SeqCst),
+            main_pending: lock(&self.shared.main).len(),
+        }
+    }
+}
+
+impl Drop for Scheduler {
+    /// 等待正在执行的任务结束后停止工作线程，尚未执行的任务被取消
+    fn drop(&mut self) {
+        {
+            let _guard = lock(&self.shared.sleep);
+            self.shared.stopping.store(true, Ordering::SeqCst);
+            self.shared.wake.notify_all();
+        }
+        for worker in lock(&self.workers).drain(..) {
+            let _ = worker.join();
+        }
+
+        // 任务可能持有 MainSender，显式清空以打破引用循环
+        lock(&self.shared.injector).clear();
+        for local in &self.shared.locals {
+            lock(local).clear();
+        }
+        lock(&self.shared.main).clear();
+    }
+}
+
+/// 正在执行的任务的上下文
+pub struct TaskContext<'a> {
+    shared: &'a Arc<Shared>,
+    worker: usize,
+}
+
+impl TaskContext<'_> {
+    /// 当前工作线程的编号，小于 `Scheduler::threads`
+    pub fn worker(&self) -> usize {
+        self.worker
+    }
+
+    /// 调度器是否正在关闭，耗时较长的任务可以据此提前结束
+    pub fn is_stopping(&self) -> bool {
+        self.shared.stopping.load(Ordering::Relaxed)
+    }
+
+    /// 提交子任务到当前线程的队列
+    ///
+    /// # 参数
+    /// - `f`: 任务闭包
+    ///
+    /// # 返回值
+    /// 任务句柄，用于获取结果
+    pub fn spawn<T, F>(&self, f: F) -> TaskHandle<T>
+    where
+        F: FnOnce(&TaskContext) -> T + Send + 'static,
+        T: Send + 'static,
+    {
+        let (handle, job) = task_job(f);
+        self.shared.push(Some(self.worker), job);
+        handle
+    }
+
+    /// 把闭包发回绘图线程执行
+    ///
+    /// # 参数
+    /// - `f`: 在绘图线程上执行的闭包
+    pub fn post<F>(&self, f: F)
+    where
+        F: FnOnce(&App) + Send + 'static,
+    {
+        self.shared.post(Box::new(f));
+    }
+
+    /// 把录制好的绘图命令发回绘图线程回放
+    ///
+    /// # 参数
+    /// - `cmds`: 绘图命令缓冲
+    pub fn post_commands(&self, cmds: CommandBuffer) {
+        self.post(move |app| {
+            let _ = app.submit_commands(&cmds);
+        });
+    }
+
+    /// 获取向绘图线程发送闭包的句柄，可以移动到其他线程
+    pub fn main_sender(&self) -> MainSender {
+        MainSender {
+            shared: self.shared.clone(),
+        }
+    }
+}
+
+/// 向绘图线程发送闭包的句柄
+///
+/// 可以克隆并移动到任意线程，调度器销毁后发送的闭包不会执行
+#[derive(Clone)]
+pub struct MainSender {
+    shared: Arc<Shared>,
+}
+
+impl MainSender {
+    /// 把闭包发回绘图线程执行
+    ///
+    /// # 参数
+    /// - `f`: 在绘图线程上执行的闭包
+    pub fn post<F>(&self, f: F)
+    where
+        F: FnOnce(&App) + Send + 'static,
+    {
+        self.shared.post(Box::new(f));
+    }
+
+    /// 把录制好的绘图命令发回绘图线程回放
+    ///
+    /// # 参数
+    /// - `cmds`: 绘图命令缓冲
+    pub fn post_commands(&self, cmds: CommandBuffer) {
+        self.post(move |app| {
+            let _ = app.submit_commands(&cmds);
+        });
+    }
+}
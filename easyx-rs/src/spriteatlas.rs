@@ -0,0 +1,311 @@
+//! 精灵图集与批量绘制
+
+use std::error::Error;
+use std::ffi::CString;
+use std::fmt;
+
+use easyx_sys::*;
+
+use crate::image::{Image, Rop};
+
+/// 精灵图集相关错误
+#[derive(Debug, PartialEq, Eq)]
+pub enum AtlasError {
+    /// 图像文件加载失败
+    LoadFailed,
+    /// 图集剩余空间放不下
+    Full,
+    /// 参数无效，例如源区域超出图像范围
+    Invalid,
+    /// 未知错误
+    Unknown(i32),
+}
+
+impl fmt::Display for AtlasError {
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        match self {
+            AtlasError::LoadFailed => write!(f, "图像文件加载失败"),
+            AtlasError::Full => write!(f, "图集剩余空间不足"),
+            AtlasError::Invalid => write!(f, "参数无效"),
+            AtlasError::Unknown(code) => write!(f, "未知错误，错误码: {}", code),
+        }
+    }
+}
+
+impl Error for AtlasError {}
+
+impl From<i32> for AtlasError {
+    /// 从错误码转换为 AtlasError
+    fn from(code: i32) -> Self {
+        match code {
+            EASYX_ATLAS_ERR_LOAD => AtlasError::LoadFailed,
+            EASYX_ATLAS_ERR_FULL => AtlasError::Full,
+            EASYX_ATLAS_ERR_INVALID => AtlasError::Invalid,
+            _ => AtlasError::Unknown(code),
+        }
+    }
+}
+
+/// 精灵编号，由 `SpriteAtlas` 添加图像时分配
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Hash)]
+pub struct SpriteId(pub i32);
+
+/// 一次绘制的精灵实例
+///
+/// 内存布局与 `EasyXSpriteInstance` 一致，可以直接以切片传给包装层
+#[repr(C)]
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct SpriteInstance {
+    /// 精灵编号
+    pub sprite: i32,
+    /// 目标位置x坐标
+    pub x: i32,
+    /// 目标位置y坐标
+    pub y: i32,
+    /// 全局透明度，仅在混合绘制时使用
+    pub alpha: u8,
+    /// `EASYX_SPRITE_*` 标志
+    pub flags: u8,
+    reserved: u16,
+}
+
+const _: () =
+    assert!(std::mem::size_of::<SpriteInstance>() == std::mem::size_of::<EasyXSpriteInstance>());
+
+impl SpriteInstance {
+    /// 创建直接复制像素的精灵实例
+    ///
+    /// # 参数
+    /// - `sprite`: 精灵编号
+    /// - `x`: 目标位置x坐标
+    /// - `y`: 目标位置y坐标
+    pub fn new(sprite: SpriteId, x: i32, y: i32) -> Self {
+        Self {
+            sprite: sprite.0,
+            x,
+            y,
+            alpha: 255,
+            flags: 0,
+            reserved: 0,
+        }
+    }
+
+    /// 按精灵的透明度通道混合绘制
+    ///
+    /// # 参数
+    /// - `alpha`: 全局透明度，255 表示仅使用精灵自身的透明度
+    pub fn blended(mut self, alpha: u8) -> Self {
+        self.alpha = alpha;
+        self.flags |= EASYX_SPRITE_BLEND as u8;
+        self
+    }
+}
+
+/// 精灵图集
+///
+/// 使用天际线装箱将多张图像放入一张图集图像中，
+/// `draw_batch` 一次调用绘制所有实例，直接复制或混合像素缓冲区，不经过 GDI。
+///
+/// # 注意
+/// - 坐标为逻辑坐标，与 `put_image` 一致，自动裁剪到设备范围和裁剪区域的外接矩形内
+/// - 绘制到窗口时需要配合批处理绘图，在 `flush_batch_draw` 后才会显示
+///
+/// # 示例
+/// ```no_run
+/// use easyx::prelude::*;
+/// use easyx::run;
+///
+/// fn main() -> Result<(), Box<dyn std::error::Error>> {
+///     run(800, 600, |app| {
+///         let mut atlas = SpriteAtlas::new(1024, 1024);
+///         let coin = atlas.add_file("coin.png")?;
+///
+///         let particles: Vec<SpriteInstance> = (0..5000)
+///             .map(|i| SpriteInstance::new(coin, i % 800, i / 800 * 8).blended(200))
+///             .collect();
+///
+///         app.begin_batch_draw();
+///         atlas.draw_batch(&particles);
+///         app.end_batch_draw();
+///         Ok(())
+///     })
+/// }
+/// ```
+#[derive(Debug)]
+pub struct SpriteAtlas {
+    ptr: *mut std::os::raw::c_void,
+}
+
+impl SpriteAtlas {
+    /// 创建指定大小的图集
+    ///
+    /// # 参数
+    /// - `width`: 图集图像宽度
+    /// - `height`: 图集图像高度
+    ///
+    /// # 返回值
+    /// 新创建的 SpriteAtlas 对象
+    pub fn new(width: i32, height: i32) -> Self {
+        let ptr = unsafe { easyx_atlas_create(width.max(1), height.max(1)) };
+        Self { ptr }
+    }
+
+    /// 将整张图像添加到图集
+    ///
+    /// # 参数
+    /// - `image`: 源图像，添加后可以释放
+    ///
+    /// # 返回值
+    /// 成功返回精灵编号，失败返回 AtlasError
+    pub fn add_image(&mut self, image: &Image) -> Result<SpriteId, AtlasError> {
+        self.add_image_part(image, 0, 0, 0, 0)
+    }
+
+    /// 将图像的一部分添加到图集
+    ///
+    /// # 参数
+    /// - `image`: 源图像
+    /// - `src_x`: 源区域左上角x坐标
+    /// - `src_y`: 源区域左上角y坐标
+    /// - `width`: 源区域宽度，0 表示到图像右边界
+    /// - `height`: 源区域高度，0 表示到图像下边界
+    ///
+    /// # 返回值
+    /// 成功返回精灵编号，失败返回 AtlasError
+    pub fn add_image_part(
+        &mut self,
+        image: &Image,
+        src_x: i32,
+        src_y: i32,
+        width: i32,
+        height: i32,
+    ) -> Result<SpriteId, AtlasError> {
+        let id = unsafe {
+            easyx_atlas_add_image(self.ptr, image.as_mut_ptr(), src_x, src_y, width, height)
+        };
+        if id >= 0 {
+            Ok(SpriteId(id))
+        } else {
+            Err(id.into())
+        }
+    }
+
+    /// 从文件加载图像并添加到图集
+    ///
+    /// # 参数
+    /// - `path`: 图像文件路径
+    ///
+    /// # 返回值
+    /// 成功返回精灵编号，失败返回 AtlasError
+    pub fn add_file(&mut self, path: &str) -> Result<SpriteId, AtlasError> {
+        self.add_file_sized(path, 0, 0, false)
+    }
+
+    /// 从文件加载图像并按指定大小添加到图集
+    ///
+    /// # 参数
+    /// - `path`: 图像文件路径
+    /// - `width`: 图像宽度，0表示使用原始宽度
+    /// - `height`: 图像高度，0表示使用原始高度
+    /// - `resize`: 是否调整图像大小以适应指定的宽高
+    ///
+    /// # 返回值
+    /// 成功返回精灵编号，失败返回 AtlasError
+    pub fn add_file_sized(
+        &mut self,
+        path: &str,
+        width: i32,
+        height: i32,
+        resize: bool,
+    ) -> Result<SpriteId, AtlasError> {
+        let c_path = CString::new(path).map_err(|_| AtlasError::Invalid)?;
+        let id = unsafe {
+            easyx_atlas_add_file(self.ptr, c_path.as_ptr(), width, height, resize as i32)
+        };
+        if id >= 0 {
+            Ok(SpriteId(id))
+        } else {
+            Err(id.into())
+        }
+    }
+
+    /// 获取图集中的精灵数量
+    pub fn len(&self) -> usize {
+        unsafe { easyx_atlas_count(self.ptr) as usize }
+    }
+
+    /// 判断图集是否为空
+    pub fn is_empty(&self) -> bool {
+        self.len() == 0
+    }
+
+    /// 获取精灵在图集图像中的位置和大小
+    ///
+    /// # 参数
+    /// - `sprite`: 精灵编号
+    ///
+    /// # 返回值
+    /// `[x, y, width, height]`，编号无效时返回 None
+    pub fn sprite_rect(&self, sprite: SpriteId) -> Option<[i32; 4]> {
+        let mut rect = [0; 4];
+        if unsafe { easyx_atlas_getsprite(self.ptr, sprite.0, rect.as_mut_ptr()) } != 0 {
+            Some(rect)
+        } else {
+            None
+        }
+    }
+
+    /// 绘制单个精灵
+    ///
+    /// 绘制大量精灵时使用 `draw_batch`
+    ///
+    /// # 参数
+    /// - `sprite`: 精灵编号
+    /// - `x`: 目标位置x坐标
+    /// - `y`: 目标位置y坐标
+    pub fn draw(&self, sprite: SpriteId, x: i32, y: i32) {
+        self.draw_batch(&[SpriteInstance::new(sprite, x, y)]);
+    }
+
+    /// 一次调用绘制所有精灵实例
+    ///
+    /// 按切片顺序绘制，后面的实例覆盖前面的实例
+    ///
+    /// # 参数
+    /// - `instances`: 精灵实例
+    ///
+    /// # 返回值
+    /// 实际绘制的实例数，不含编号无效或完全被裁剪的实例
+    pub fn draw_batch(&self, instances: &[SpriteInstance]) -> usize {
+        let n = instances.len().min(i32::MAX as usize) as i32;
+        unsafe { easyx_atlas_draw_batch(self.ptr, instances.as_ptr().cast(), n) as usize }
+    }
+
+    /// 获取底层图集指针
+    ///
+    /// # 返回值
+    /// 指向包装层图集对象的指针
+    pub fn as_mut_ptr(&self) -> *mut std::os::raw::c_void {
+        self.ptr
+    }
+
+    /// 将整张图集图像绘制到当前工作图像，用于查看装箱结果
+    ///
+    /// # 参数
+    /// - `x`: 目标位置x坐标
+    /// - `y`: 目标位置y坐标
+    pub fn put_backing_image(&self, x: i32, y: i32) {
+        unsafe {
+            easyx_putimage(x, y, easyx_atlas_getimage(self.ptr), Rop::SrcCopy.as_u32());
+        }
+    }
+}
+
+impl Drop for SpriteAtlas {
+    /// 释放图集资源
+    fn drop(&mut self) {
+        unsafe {
+            easyx_atlas_destroy(self.ptr);
+        }
+    }
+}
@@ -0,0 +1,127 @@
+//! 字形图集文本渲染
+
+use easyx_sys::*;
+
+use crate::color::Color;
+use crate::logfont::LogFont;
+
+/// 字形图集
+///
+/// 将字体的字形一次性光栅化到图集中，之后绘制文本时直接把字形
+/// 混合到当前工作图像的像素缓冲区，不再经过 GDI 的 `outtextxy`。
+/// 文本宽度也由缓存的字形步进宽度计算，无需调用 GDI。
+///
+/// 可打印 ASCII 字符在创建时光栅化，其他字符（例如中文）在首次使用时光栅化。
+///
+/// # 注意
+/// - 坐标为设备像素坐标，不受 `App::set_origin` 和裁剪区域影响
+/// - 图集使用灰度抗锯齿，不支持 ClearType
+/// - 绘制到窗口时需要配合批处理绘图，在 `flush_batch_draw` 后才会显示
+///
+/// # 示例
+/// ```no_run
+/// use easyx::prelude::*;
+/// use easyx::run;
+///
+/// fn main() -> Result<(), Box<dyn std::error::Error>> {
+///     run(800, 600, |app| {
+///         app.set_textstyle(20, 0, "Consolas");
+///         let atlas = TextAtlas::current();
+///
+///         app.begin_batch_draw();
+///         atlas.draw(10, 10, "Score: 100", &Color::WHITE);
+///         app.end_batch_draw();
+///         Ok(())
+///     })
+/// }
+/// ```
+#[derive(Debug)]
+pub struct TextAtlas {
+    ptr: *mut std::os::raw::c_void,
+}
+
+impl TextAtlas {
+    /// 使用指定字体创建字形图集
+    ///
+    /// # 参数
+    /// - `font`: 字体样式
+    ///
+    /// # 返回值
+    /// 新创建的 TextAtlas 对象
+    pub fn new(font: &LogFont) -> Self {
+        let ptr = unsafe { easyx_textatlas_create(&font.logfont as *const _ as *const _) };
+        Self { ptr }
+    }
+
+    /// 使用当前文本样式创建字形图集
+    ///
+    /// # 返回值
+    /// 新创建的 TextAtlas 对象
+    pub fn current() -> Self {
+        let ptr = unsafe { easyx_textatlas_create(std::ptr::null()) };
+        Self { ptr }
+    }
+
+    /// 预先光栅化文本中的字符
+    ///
+    /// 避免首次绘制非 ASCII 字符时的光栅化开销
+    ///
+    /// # 参数
+    /// - `text`: 包含需要预加载字符的文本
+    pub fn preload(&self, text: &str) {
+        unsafe {
+            easyx_textatlas_preload(self.ptr, text.as_ptr().cast(), text.len());
+        }
+    }
+
+    /// 在当前工作图像上绘制文本
+    ///
+    /// # 参数
+    /// - `x`: 文本左上角x坐标
+    /// - `y`: 文本左上角y坐标
+    /// - `text`: 要绘制的文本
+    /// - `color`: 文本颜色
+    ///
+    /// # 返回值
+    /// 绘制的文本宽度，以像素为单位
+    pub fn draw(&self, x: i32, y: i32, text: &str, color: &Color) -> i32 {
+        unsafe {
+            easyx_textatlas_draw(
+                self.ptr,
+                x,
+                y,
+                text.as_ptr().cast(),
+                text.len(),
+                color.as_colorref(),
+            )
+        }
+    }
+
+    /// 获取文本宽度
+    ///
+    /// # 参数
+    /// - `text`: 要计算宽度的文本
+    ///
+    /// # 返回值
+    /// 文本的宽度，以像素为单位
+    pub fn text_width(&self, text: &str) -> i32 {
+        unsafe { easyx_textatlas_textwidth(self.ptr, text.as_ptr().cast(), text.len()) }
+    }
+
+    /// 获取文本行高
+    ///
+    /// # 返回值
+    /// 图集字体的行高，以像素为单位
+    pub fn text_height(&self) -> i32 {
+        unsafe { easyx_textatlas_textheight(self.ptr) }
+    }
+}
+
+impl Drop for TextAtlas {
+    /// 释放图集资源
+    fn drop(&mut self) {
+        unsafe {
+            easyx_textatlas_destroy(self.ptr);
+        }
+    }
+}
@@ -0,0 +1,313 @@
+//! 多行文本排版，缓存测量结果和换行位置
+
+use std::ops::Range;
+
+use easyx_sys::*;
+
+use crate::logfont::LogFont;
+
+/// 行对齐方式
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Default)]
+pub enum TextAlign {
+    /// 左对齐
+    #[default]
+    Left,
+    /// 居中
+    Center,
+    /// 右对齐
+    Right,
+}
+
+impl TextAlign {
+    fn raw(self) -> i32 {
+        match self {
+            TextAlign::Left => EASYX_TEXTLAYOUT_LEFT as i32,
+            TextAlign::Center => EASYX_TEXTLAYOUT_CENTER as i32,
+            TextAlign::Right => EASYX_TEXTLAYOUT_RIGHT as i32,
+        }
+    }
+}
+
+/// 排版后的一行
+#[derive(Debug, Clone, PartialEq, Eq)]
+pub struct LayoutLine {
+    /// 行在文本中的字节范围，包含行尾的空白
+    pub range: Range<usize>,
+    /// 行相对排版区域左边的偏移（对齐后）
+    pub x: i32,
+    /// 行相对排版区域顶部的偏移
+    pub y: i32,
+    /// 行宽，不含行尾的空白
+    pub width: i32,
+}
+
+/// 排版的统计信息
+#[derive(Debug, Clone, Copy, Default, PartialEq, Eq)]
+pub struct TextLayoutStats {
+    /// 测量段落的次数，每个段落只调用一次 GetTextExtentExPoint
+    pub measured: u64,
+    /// 段落重新换行的次数
+    pub wrapped: u64,
+    /// 修改文本时保留测量结果的段落数
+    pub reused: u64,
+    /// 绘制的行数（不含裁剪区外的行）
+    pub drawn_lines: u64,
+}
+
+/// 多行文本排版
+///
+/// 文本按换行符分为段落，每个段落只测量一次，得到每个字符位置的前缀宽度，
+/// 之后按宽度换行、命中测试和计算光标位置都只查表，不再调用 GDI。
+/// 改变宽度只重新换行；`edit` 和 `set_text` 只重新测量内容变化的段落。
+/// 绘制时每行调用一次 `ExtTextOut`，不再像 `draw_text` 那样每次绘制都重新测量和换行。
+///
+/// 空白和连字符之后、中日韩文字之间可以换行，放不下的长单词按字符截断。
+///
+/// # 注意
+/// - 文本偏移为 UTF-8 字节偏移，坐标以排版区域左上角为原点
+/// - 绘制使用当前的文本颜色和背景模式，坐标受 `App::set_origin` 影响
+/// - 字体的旋转角度被忽略
+///
+/// # 示例
+/// ```no_run
+/// use easyx::prelude::*;
+/// use easyx::run;
+///
+/// fn main() -> Result<(), Box<dyn std::error::Error>> {
+///     run(800, 600, |app| {
+///         app.set_textstyle(20, 0, "微软雅黑");
+///         let mut layout = TextLayout::new("EasyX-RS 多行文本排版，宽度改变时只重新换行。", 200);
+///         layout.set_align(TextAlign::Center);
+///
+///         layout.draw(10, 10);
+///         layout.edit(0..8, "EasyX");
+///         layout.set_width(300);
+///         layout.draw(10, 200);
+///         Ok(())
+///     })
+/// }
+/// ```
+#[derive(Debug)]
+pub struct TextLayout {
+    ptr: *mut std::os::raw::c_void,
+}
+
+impl TextLayout {
+    /// 使用当前文本样式创建排版
+    ///
+    /// # 参数
+    /// - `text`: 文本
+    /// - `width`: 换行宽度，小于等于 0 时只在换行符处换行
+    ///
+    /// # 返回值
+    /// 新创建的 TextLayout 对象
+    pub fn new(text: &str, width: i32) -> Self {
+        let ptr = unsafe {
+            easyx_textlayout_create(text.as_ptr().cast(), text.len(), std::ptr::null(), width)
+        };
+        Self { ptr }
+    }
+
+    /// 使用指定字体创建排版
+    ///
+    /// # 参数
+    /// - `text`: 文本
+    /// - `font`: 字体样式
+    /// - `width`: 换行宽度，小于等于 0 时只在换行符处换行
+    ///
+    /// # 返回值
+    /// 新创建的 TextLayout 对象
+    pub fn with_font(text: &str, font: &LogFont, width: i32) -> Self {
+        let ptr = unsafe {
+            easyx_textlayout_create(
+                text.as_ptr().cast(),
+                text.len(),
+                &font.logfont as *const _ as *const _,
+                width,
+            )
+        };
+        Self { ptr }
+    }
+
+    /// 替换全部文本，内容相同的段落保留测量结果
+    ///
+    /// # 参数
+    /// - `text`: 新的文本
+    pub fn set_text(&mut self, text: &str) {
+        unsafe {
+            easyx_textlayout_settext(self.ptr, text.as_ptr().cast(), text.len());
+        }
+    }
+
+    /// 替换一段文本，只重新测量受影响的段落
+    ///
+    /// # 参数
+    /// - `range`: 被替换的字节范围，为空时在起点插入
+    /// - `insert`: 插入的文本
+    ///
+    /// # 返回值
+    /// 范围超出文本或不在字符边界上时返回 false
+    pub fn edit(&mut self, range: Range<usize>, insert: &str) -> bool {
+        if range.end < range.start {
+            return false;
+        }
+        unsafe {
+            easyx_textlayout_edit(
+                self.ptr,
+                range.start,
+                range.end - range.start,
+                insert.as_ptr().cast(),
+                insert.len(),
+            ) == 0
+        }
+    }
+
+    /// 设置换行宽度，不需要重新测量
+    ///
+    /// # 参数
+    /// - `width`: 换行宽度，小于等于 0 时只在换行符处换行
+    pub fn set_width(&mut self, width: i32) {
+        unsafe {
+            easyx_textlayout_setwidth(self.ptr, width);
+        }
+    }
+
+    /// 设置字体，所有段落重新测量
+    ///
+    /// # 参数
+    /// - `font`: 字体样式，为 None 时使用当前文本样式
+    pub fn set_font(&mut self, font: Option<&LogFont>) {
+        let font = font.map_or(std::ptr::null(), |f| &f.logfont as *const _ as *const _);
+        unsafe {
+            easyx_textlayout_setfont(self.ptr, font);
+        }
+    }
+
+    /// 设置行对齐方式
+    ///
+    /// # 参数
+    /// - `align`: 对齐方式，没有换行宽度时按最宽的一行对齐
+    pub fn set_align(&mut self, align: TextAlign) {
+        unsafe {
+            easyx_textlayout_setalign(self.ptr, align.raw());
+        }
+    }
+
+    /// 设置行间距
+    ///
+    /// # 参数
+    /// - `spacing`: 行与行之间额外的像素数，可以为负数
+    pub fn set_line_spacing(&mut self, spacing: i32) {
+        unsafe {
+            easyx_textlayout_setlinespacing(self.ptr, spacing);
+        }
+    }
+
+    /// 获取排版区域的大小
+    ///
+    /// # 返回值
+    /// (宽, 高)，宽为换行宽度，没有换行宽度时为最宽一行的宽度
+    pub fn size(&self) -> (i32, i32) {
+        let mut size = [0i32; 2];
+        unsafe {
+            easyx_textlayout_getsize(self.ptr, size.as_mut_ptr());
+        }
+        (size[0], size[1])
+    }
+
+    /// 获取行数
+    pub fn line_count(&self) -> usize {
+        unsafe { easyx_textlayout_linecount(self.ptr).max(0) as usize }
+    }
+
+    /// 获取一行的范围和位置
+    ///
+    /// # 参数
+    /// - `index`: 行号
+    ///
+    /// # 返回值
+    /// 行号超出范围时返回 None
+    pub fn line(&self, index: usize) -> Option<LayoutLine> {
+        let index = i32::try_from(index).ok()?;
+        let mut line = [0i32; 5];
+        if unsafe { easyx_textlayout_getline(self.ptr, index, line.as_mut_ptr()) } == 0 {
+            return None;
+        }
+        let start = line[0].max(0) as usize;
+        Some(LayoutLine {
+            range: start..start + line[1].max(0) as usize,
+            x: line[2],
+            y: line[3],
+            width: line[4],
+        })
+    }
+
+    /// 获取所有行
+    pub fn lines(&self) -> Vec<LayoutLine> {
+        (0..self.line_count())
+            .filter_map(|i| self.line(i))
+            .collect()
+    }
+
+    /// 命中测试
+    ///
+    /// # 参数
+    /// - `x`: 相对排版区域左边的x坐标
+    /// - `y`: 相对排版区域顶部的y坐标
+    ///
+    /// # 返回值
+    /// 离该点最近的光标位置（字节偏移）
+    pub fn hit_test(&self, x: i32, y: i32) -> usize {
+        unsafe { easyx_textlayout_hittest(self.ptr, x, y) }
+    }
+
+    /// 获取光标位置
+    ///
+    /// # 参数
+    /// - `offset`: 字节偏移
+    ///
+    /// # 返回值
+    /// (x, y, 行高)，坐标相对排版区域左上角
+    pub fn caret_position(&self, offset: usize) -> (i32, i32, i32) {
+        let mut pos = [0i32; 3];
+        unsafe {
+            easyx_textlayout_caretpos(self.ptr, offset, pos.as_mut_ptr());
+        }
+        (pos[0], pos[1], pos[2])
+    }
+
+    /// 在当前工作图像上绘制，裁剪区外的行被跳过
+    ///
+    /// # 参数
+    /// - `x`: 排版区域左上角x坐标
+    /// - `y`: 排版区域左上角y坐标
+    pub fn draw(&self, x: i32, y: i32) {
+        unsafe {
+            easyx_textlayout_draw(self.ptr, x, y);
+        }
+    }
+
+    /// 获取统计信息
+    pub fn stats(&self) -> TextLayoutStats {
+        let mut stats = unsafe { std::mem::zeroed::<EasyXTextLayoutStats>() };
+        unsafe {
+            easyx_textlayout_getstats(self.ptr, &mut stats);
+        }
+
+        TextLayoutStats {
+            measured: stats.measured,
+            wrapped: stats.wrapped,
+            reused: stats.reused,
+            drawn_lines: stats.drawnLines,
+        }
+    }
+}
+
+impl Drop for TextLayout {
+    /// 释放排版和字体资源
+    fn drop(&mut self) {
+        unsafe {
+            easyx_textlayout_destroy(self.ptr);
+        }
+    }
+}
@@ -0,0 +1,293 @@
+//! 按区块缓存的瓦片地图
+
+use std::marker::PhantomData;
+
+use easyx_sys::*;
+
+use crate::color::Color;
+use crate::spriteatlas::{SpriteAtlas, SpriteId};
+
+/// 瓦片编号，0 表示空瓦片，使用背景色
+pub type TileId = u16;
+
+/// 瓦片地图
+///
+/// 瓦片编号按行存放在连续数组中，地图按 `chunk_size x chunk_size` 个瓦片划分区块，
+/// 每个区块的渲染结果缓存在一张图像中。修改瓦片只会标记所在的区块，
+/// `draw` 重新渲染可见的脏区块后直接复制区块像素，不经过 GDI，
+/// 每帧的开销与变化的区块数而不是格子数成正比。
+///
+/// 纯色瓦片和精灵瓦片都需要先定义，引用的精灵图集必须比地图活得更久。
+///
+/// # 注意
+/// - 坐标为逻辑坐标，与 `put_image` 一致，自动裁剪到设备范围和裁剪区域的外接矩形内
+/// - 视口中超出地图范围的部分不会被绘制
+/// - 修改图集中精灵的像素后需要调用 `invalidate`
+///
+/// # 示例
+/// ```no_run
+/// use easyx::prelude::*;
+/// use easyx::run;
+///
+/// fn main() -> Result<(), Box<dyn std::error::Error>> {
+///     run(800, 600, |app| {
+///         let mut map = TileMap::new(100, 100, 16, 16);
+///         map.define_color(1, &Color::GREEN);
+///         map.define_color(2, &Color::BLUE);
+///         map.fill(0, 50, 100, 50, 2);
+///
+///         let (mut scroll_x, mut scroll_y) = (0, 0);
+///         app.begin_batch_draw();
+///         loop {
+///             scroll_x = (scroll_x + 1) % 800;
+///             scroll_y = (scroll_y + 1) % 1000;
+///             map.draw_view(0, 0, scroll_x, scroll_y, 800, 600);
+///             app.flush_batch_draw();
+///         }
+///     })
+/// }
+/// ```
+#[derive(Debug)]
+pub struct TileMap<'a> {
+    ptr: *mut std::os::raw::c_void,
+    cols: i32,
+    rows: i32,
+    _atlas: PhantomData<&'a SpriteAtlas>,
+}
+
+impl<'a> TileMap<'a> {
+    /// 创建瓦片地图，使用默认的区块大小（16 x 16 个瓦片）
+    ///
+    /// # 参数
+    /// - `cols`: 列数
+    /// - `rows`: 行数
+    /// - `tile_width`: 瓦片宽度
+    /// - `tile_height`: 瓦片高度
+    ///
+    /// # 返回值
+    /// 新创建的 TileMap 对象，所有瓦片为 0
+    pub fn new(cols: i32, rows: i32, tile_width: i32, tile_height: i32) -> Self {
+        Self::with_chunk_size(cols, rows, tile_width, tile_height, 0)
+    }
+
+    /// 创建瓦片地图并指定区块大小
+    ///
+    /// 区块越小，修改少量瓦片时重新渲染的像素越少，但绘制时复制的区块数越多
+    ///
+    /// # 参数
+    /// - `cols`: 列数
+    /// - `rows`: 行数
+    /// - `tile_width`: 瓦片宽度
+    /// - `tile_height`: 瓦片高度
+    /// - `chunk_size`: 区块边长（瓦片数），0 表示使用默认值
+    ///
+    /// # 返回值
+    /// 新创建的 TileMap 对象，所有瓦片为 0
+    pub fn with_chunk_size(
+        cols: i32,
+        rows: i32,
+        tile_width: i32,
+        tile_height: i32,
+        chunk_size: i32,
+    ) -> Self {
+        let cols = cols.max(1);
+        let rows = rows.max(1);
+        let ptr = unsafe {
+            easyx_tilemap_create(
+                cols,
+                rows,
+                tile_width.max(1),
+                tile_height.max(1),
+                chunk_size,
+            )
+        };
+        Self {
+            ptr,
+            cols,
+            rows,
+            _atlas: PhantomData,
+        }
+    }
+
+    /// 获取列数
+    pub fn cols(&self) -> i32 {
+        self.cols
+    }
+
+    /// 获取行数
+    pub fn rows(&self) -> i32 {
+        self.rows
+    }
+
+    /// 将瓦片编号定义为纯色瓦片
+    ///
+    /// 会使所有区块重新渲染
+    ///
+    /// # 参数
+    /// - `tile`: 瓦片编号，0 保留给空瓦片，会被忽略
+    /// - `color`: 瓦片颜色
+    pub fn define_color(&mut self, tile: TileId, color: &Color) {
+        unsafe {
+            easyx_tilemap_definecolor(self.ptr, tile, color.as_colorref());
+        }
+    }
+
+    /// 将瓦片编号定义为精灵瓦片
+    ///
+    /// 精灵从瓦片左上角开始绘制，超出瓦片的部分被裁掉，
+    /// 带透明度的精灵与背景色混合。会使所有区块重新渲染
+    ///
+    /// # 参数
+    /// - `tile`: 瓦片编号，0 保留给空瓦片，会被忽略
+    /// - `atlas`: 精灵所在的图集
+    /// - `sprite`: 精灵编号
+    pub fn define_sprite(&mut self, tile: TileId, atlas: &'a SpriteAtlas, sprite: SpriteId) {
+        unsafe {
+            easyx_tilemap_definesprite(self.ptr, tile, atlas.as_mut_ptr(), sprite.0);
+        }
+    }
+
+    /// 设置背景色，用于空瓦片和未定义的瓦片
+    ///
+    /// # 参数
+    /// - `color`: 背景色
+    pub fn set_background(&mut self, color: &Color) {
+        unsafe {
+            easyx_tilemap_setbackground(self.ptr, color.as_colorref());
+        }
+    }
+
+    /// 设置单个瓦片，编号不变时不会标记区块
+    ///
+    /// # 参数
+    /// - `col`: 列号
+    /// - `row`: 行号
+    /// - `tile`: 瓦片编号
+    pub fn set(&mut self, col: i32, row: i32, tile: TileId) {
+        unsafe {
+            easyx_tilemap_settile(self.ptr, col, row, tile);
+        }
+    }
+
+    /// 获取单个瓦片
+    ///
+    /// # 参数
+    /// - `col`: 列号
+    /// - `row`: 行号
+    ///
+    /// # 返回值
+    /// 瓦片编号，超出地图范围时返回 None
+    pub fn get(&self, col: i32, row: i32) -> Option<TileId> {
+        let tile = unsafe { easyx_tilemap_gettile(self.ptr, col, row) };
+        if tile >= 0 {
+            Some(tile as TileId)
+        } else {
+            None
+        }
+    }
+
+    /// 批量设置一个矩形区域的瓦片，只标记编号发生变化的区块
+    ///
+    /// 适合每帧把游戏状态整体同步到地图，超出地图范围的部分被忽略
+    ///
+    /// # 参数
+    /// - `col`: 区域左上角列号
+    /// - `row`: 区域左上角行号
+    /// - `width`: 区域列数
+    /// - `tiles`: 按行存放的瓦片编号，行数由切片长度决定
+    /// - `stride`: 相邻两行在 `tiles` 中的间隔，不小于 `width`
+    pub fn set_region(
+        &mut self,
+        col: i32,
+        row: i32,
+        width: usize,
+        tiles: &[TileId],
+        stride: usize,
+    ) {
+        assert!(stride >= width, "stride 不能小于区域宽度");
+        if width == 0 || tiles.len() < width {
+            return;
+        }
+
+        let height = (tiles.len() - width) / stride + 1;
+        unsafe {
+            easyx_tilemap_settiles(
+                self.ptr,
+                col,
+                row,
+                width as i32,
+                height as i32,
+                tiles.as_ptr(),
+                stride,
+            );
+        }
+    }
+
+    /// 用同一个瓦片填充矩形区域
+    ///
+    /// # 参数
+    /// - `col`: 区域左上角列号
+    /// - `row`: 区域左上角行号
+    /// - `width`: 区域列数
+    /// - `height`: 区域行数
+    /// - `tile`: 瓦片编号
+    pub fn fill(&mut self, col: i32, row: i32, width: i32, height: i32, tile: TileId) {
+        unsafe {
+            easyx_tilemap_fill(self.ptr, col, row, width, height, tile);
+        }
+    }
+
+    /// 标记所有区块需要重新渲染
+    pub fn invalidate(&mut self) {
+        unsafe {
+            easyx_tilemap_invalidate(self.ptr);
+        }
+    }
+
+    /// 将整张地图绘制到当前工作图像
+    ///
+    /// # 参数
+    /// - `x`: 目标位置x坐标
+    /// - `y`: 目标位置y坐标
+    ///
+    /// # 返回值
+    /// 本次重新渲染的区块数
+    pub fn draw(&mut self, x: i32, y: i32) -> usize {
+        self.draw_view(x, y, 0, 0, 0, 0)
+    }
+
+    /// 将地图的一部分绘制到当前工作图像，用于滚动显示
+    ///
+    /// 只渲染和复制视口内可见的区块
+    ///
+    /// # 参数
+    /// - `x`: 目标位置x坐标
+    /// - `y`: 目标位置y坐标
+    /// - `scroll_x`: 视口左上角在地图中的x坐标（像素）
+    /// - `scroll_y`: 视口左上角在地图中的y坐标（像素）
+    /// - `width`: 视口宽度，0 表示地图宽度
+    /// - `height`: 视口高度，0 表示地图高度
+    ///
+    /// # 返回值
+    /// 本次重新渲染的区块数
+    pub fn draw_view(
+        &mut self,
+        x: i32,
+        y: i32,
+        scroll_x: i32,
+        scroll_y: i32,
+        width: i32,
+        height: i32,
+    ) -> usize {
+        unsafe { easyx_tilemap_draw(self.ptr, x, y, scroll_x, scroll_y, width, height) as usize }
+    }
+}
+
+impl Drop for TileMap<'_> {
+    /// 释放瓦片地图及缓存的区块图像
+    fn drop(&mut self) {
+        unsafe {
+            easyx_tilemap_destroy(self.ptr);
+        }
+    }
+}
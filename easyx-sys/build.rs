@@ -18,11 +18,35 @@ fn main() {
     };
 
     // 编译 C++ 包装层
-    cc::Build::new()
+    let mut build = cc::Build::new();
+
+    // 启用 profiler 特性时为包装层函数插桩
+    if env::var_os("CARGO_FEATURE_PROFILER").is_some() {
+        build.define("EASYX_PROFILER", None);
+    }
+
+    build
         .cpp(true) // 使用
         .define("UNICODE", None) // C++ 编译器
         .include(&include_dir)
         .file(build_dir.join("cpp/easyx_wrapper.cpp"))
+        .file(build_dir.join("cpp/easyx_textatlas.cpp"))
+        .file(build_dir.join("cpp/easyx_raster.cpp"))
+        .file(build_dir.join("cpp/easyx_frame.cpp"))
+        .file(build_dir.join("cpp/easyx_profiler.cpp"))
+        .file(build_dir.join("cpp/easyx_atlas.cpp"))
+        .file(build_dir.join("cpp/easyx_tilemap.cpp"))
+        .file(build_dir.join("cpp/easyx_loader.cpp"))
+        .file(build_dir.join("cpp/easyx_assets.cpp"))
+        .file(build_dir.join("cpp/easyx_tiles.cpp"))
+        .file(build_dir.join("cpp/easyx_plot.cpp"))
+        .file(build_dir.join("cpp/easyx_transform.cpp"))
+        .file(build_dir.join("cpp/easyx_scene.cpp"))
+        .file(build_dir.join("cpp/easyx_present.cpp"))
+        .file(build_dir.join("cpp/easyx_wait.cpp"))
+        .file(build_dir.join("cpp/easyx_ring.cpp"))
+        .file(build_dir.join("cpp/easyx_textlayout.cpp"))
+        .file(build_dir.join("cpp/easyx_record.cpp"))
         .compile("easyx_wrapper");
 
     // 设置库目录（只用于查找 EasyXw.lib）
@@ -34,6 +58,9 @@ fn main() {
     println!("cargo:rustc-link-lib=gdi32");
     println!("cargo:rustc-link-lib=msimg32");
     println!("cargo:rustc-link-lib=shell32");
+    println!("cargo:rustc-link-lib=dwmapi");
+    println!("cargo:rustc-link-lib=ole32");
+    println!("cargo:rustc-link-lib=windowscodecs");
 
     // 生成绑定
     let bindings = bindgen::Builder::default()
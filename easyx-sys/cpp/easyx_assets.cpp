@@ -0,0 +1,520 @@
+// easyx_assets.cpp
+// 按文件内容索引的解码图像缓存，以及预解码像素的资源包（内存映射后直接复制到 IMAGE 缓冲区）
+
+#include "easyx_wrapper.h"
+#include "easyx_profiler.h"
+#include <string.h>
+#include <algorithm>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <windows.h>
+#include <tchar.h>
+#include "../EasyX_26.1.1/include/easyx.h"
+
+// 解码图像缓存的默认内存预算
+#define IMAGECACHE_DEFAULT_BUDGET (64u * 1024 * 1024)
+
+// 资源包格式：文件头，按 64 字节对齐的像素数据，按名称哈希排序的索引，以 NUL 结尾的名称
+#define PACK_MAGIC "EXPK"
+#define PACK_VERSION 1
+#define PACK_ALIGN 64
+
+struct PackHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t count;
+    uint32_t reserved;
+    uint64_t indexOffset;
+    uint64_t namesOffset;
+};
+
+struct PackEntry
+{
+    uint64_t nameHash;
+    uint32_t nameOffset; // 相对名称区的偏移
+    uint32_t nameLength; // 不含结尾的 NUL
+    int32_t width, height;
+    uint64_t pixelOffset; // 相对文件开头的偏移，按 PACK_ALIGN 对齐
+};
+
+struct MappedFile
+{
+    HANDLE file;
+    HANDLE mapping;
+    const BYTE *data;
+    size_t size;
+};
+
+struct AssetPack
+{
+    MappedFile file;
+    const PackEntry *entries;
+    const char *names;
+    uint32_t count;
+};
+
+struct PackWriterEntry
+{
+    std::string name;
+    int width, height;
+    std::vector<DWORD> pixels;
+};
+
+struct PackWriter
+{
+    std::vector<PackWriterEntry> entries;
+};
+
+struct CacheEntry
+{
+    uint64_t key;
+    uint64_t contentHash;
+    size_t fileSize;
+    int nWidth, nHeight, bResize;
+    int dstWidth, dstHeight; // 不调整大小时结果取决于目标图像原来的大小
+    int width, height;
+    std::vector<DWORD> pixels;
+};
+
+struct ImageCache
+{
+    std::list<CacheEntry> lru; // 最近使用的在前
+    std::unordered_map<uint64_t, std::list<CacheEntry>::iterator> index;
+    size_t budget;
+    size_t bytes;
+    EasyXImageCacheStats stats;
+};
+
+static ImageCache g_imagecache = {std::list<CacheEntry>(), std::unordered_map<uint64_t, std::list<CacheEntry>::iterator>(), IMAGECACHE_DEFAULT_BUDGET, 0, {}};
+
+static std::wstring utf8_to_wstring(const char *str)
+{
+    int len = MultiByteToWideChar(CP_UTF8, 0, str, -1, NULL, 0);
+    if (len <= 0)
+        return std::wstring();
+
+    std::wstring wstr(len - 1, 0);
+    MultiByteToWideChar(CP_UTF8, 0, str, -1, &wstr[0], len);
+    return wstr;
+}
+
+static bool map_file(const char *path, MappedFile *out)
+{
+    std::wstring wpath = utf8_to_wstring(path);
+    out->file = CreateFileW(wpath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    out->mapping = NULL;
+    out->data = NULL;
+    out->size = 0;
+    if (out->file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER size;
+    if (GetFileSizeEx(out->file, &size) && size.QuadPart > 0)
+    {
+        out->size = static_cast<size_t>(size.QuadPart);
+        out->mapping = CreateFileMappingW(out->file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (out->mapping)
+            out->data = reinterpret_cast<const BYTE *>(MapViewOfFile(out->mapping, FILE_MAP_READ, 0, 0, 0));
+    }
+
+    if (!out->data)
+    {
+        if (out->mapping)
+            CloseHandle(out->mapping);
+        CloseHandle(out->file);
+        return false;
+    }
+    return true;
+}
+
+static void unmap_file(MappedFile *file)
+{
+    UnmapViewOfFile(file->data);
+    CloseHandle(file->mapping);
+    CloseHandle(file->file);
+}
+
+static uint64_t hash_mix(uint64_t h, uint64_t value)
+{
+    h ^= value;
+    h *= 0x9E3779B97F4A7C15ull;
+    return h ^ (h >> 29);
+}
+
+// 按 8 字节分块的内容哈希，用于识别内容相同的文件
+static uint64_t hash_bytes(const BYTE *data, size_t size)
+{
+    uint64_t h = 0xCBF29CE484222325ull ^ size;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8)
+    {
+        uint64_t word;
+        memcpy(&word, data + i, 8);
+        h = hash_mix(h, word);
+    }
+
+    uint64_t tail = 0;
+    memcpy(&tail, data + i, size - i);
+    return hash_mix(h, tail);
+}
+
+// FNV-1a，用于资源包中的名称
+static uint64_t hash_name(const char *name, size_t length)
+{
+    uint64_t h = 0xCBF29CE484222325ull;
+    for (size_t i = 0; i < length; ++i)
+    {
+        h ^= static_cast<BYTE>(name[i]);
+        h *= 0x100000001B3ull;
+    }
+    return h;
+}
+
+static void imagecache_evict(size_t budget)
+{
+    while (g_imagecache.bytes > budget && !g_imagecache.lru.empty())
+    {
+        CacheEntry &entry = g_imagecache.lru.back();
+        g_imagecache.bytes -= entry.pixels.size() * sizeof(DWORD);
+        g_imagecache.index.erase(entry.key);
+        g_imagecache.lru.pop_back();
+        ++g_imagecache.stats.evictions;
+    }
+}
+
+void easyx_imagecache_setbudget(size_t bytes)
+{
+    g_imagecache.budget = bytes;
+    imagecache_evict(bytes);
+}
+
+size_t easyx_imagecache_getbudget()
+{
+    return g_imagecache.budget;
+}
+
+void easyx_imagecache_clear()
+{
+    g_imagecache.lru.clear();
+    g_imagecache.index.clear();
+    g_imagecache.bytes = 0;
+}
+
+void easyx_imagecache_getstats(EasyXImageCacheStats *pStats)
+{
+    if (!pStats)
+        return;
+
+    *pStats = g_imagecache.stats;
+    pStats->bytes = g_imagecache.bytes;
+    pStats->entries = static_cast<int>(g_imagecache.lru.size());
+}
+
+int easyx_imagecache_load(void *pDstImg, const char *pImgFile, int nWidth, int nHeight, int bResize)
+{
+    PROFILE_SCOPE(EASYX_PROF_IMAGES);
+    // 直接加载到窗口时没有可缓存的目标图像
+    if (!pDstImg || !pImgFile)
+        return easyx_loadimage_file(pDstImg, pImgFile, nWidth, nHeight, bResize);
+
+    MappedFile file;
+    if (!map_file(pImgFile, &file))
+        return easyx_loadimage_file(pDstImg, pImgFile, nWidth, nHeight, bResize);
+
+    IMAGE *dst = reinterpret_cast<IMAGE *>(pDstImg);
+    CacheEntry probe;
+    probe.contentHash = hash_bytes(file.data, file.size);
+    probe.fileSize = file.size;
+    probe.nWidth = nWidth;
+    probe.nHeight = nHeight;
+    probe.bResize = bResize != 0;
+    probe.dstWidth = probe.bResize ? 0 : dst->getwidth();
+    probe.dstHeight = probe.bResize ? 0 : dst->getheight();
+    unmap_file(&file);
+
+    uint64_t key = hash_mix(probe.contentHash, probe.fileSize);
+    key = hash_mix(key, (static_cast<uint64_t>(static_cast<uint32_t>(nWidth)) << 32) | static_cast<uint32_t>(nHeight));
+    key = hash_mix(key, (static_cast<uint64_t>(static_cast<uint32_t>(probe.dstWidth)) << 32) | static_cast<uint32_t>(probe.dstHeight));
+    key = hash_mix(key, probe.bResize);
+    probe.key = key;
+
+    std::unordered_map<uint64_t, std::list<CacheEntry>::iterator>::iterator found = g_imagecache.index.find(key);
+    if (found != g_imagecache.index.end())
+    {
+        CacheEntry &entry = *found->second;
+        if (entry.contentHash == probe.contentHash && entry.fileSize == probe.fileSize &&
+            entry.nWidth == nWidth && entry.nHeight == nHeight && entry.bResize == probe.bResize &&
+            entry.dstWidth == probe.dstWidth && entry.dstHeight == probe.dstHeight)
+        {
+            g_imagecache.lru.splice(g_imagecache.lru.begin(), g_imagecache.lru, found->second);
+            easyx_image_resize(dst, entry.width, entry.height);
+            memcpy(GetImageBuffer(dst), entry.pixels.data(), entry.pixels.size() * sizeof(DWORD));
+            ++g_imagecache.stats.hits;
+            return 0;
+        }
+
+        // 64 位键冲突，丢弃旧条目
+        g_imagecache.bytes -= entry.pixels.size() * sizeof(DWORD);
+        g_imagecache.lru.erase(found->second);
+        g_imagecache.index.erase(found);
+    }
+
+    ++g_imagecache.stats.misses;
+    int result = easyx_loadimage_file(pDstImg, pImgFile, nWidth, nHeight, bResize);
+    if (result != 0)
+        return result;
+
+    size_t bytes = static_cast<size_t>(dst->getwidth()) * dst->getheight() * sizeof(DWORD);
+    if (bytes == 0 || bytes > g_imagecache.budget)
+        return 0;
+
+    imagecache_evict(g_imagecache.budget - bytes);
+    g_imagecache.lru.push_front(probe);
+
+    CacheEntry &entry = g_imagecache.lru.front();
+    entry.width = dst->getwidth();
+    entry.height = dst->getheight();
+    entry.pixels.assign(GetImageBuffer(dst), GetImageBuffer(dst) + bytes / sizeof(DWORD));
+    g_imagecache.index[key] = g_imagecache.lru.begin();
+    g_imagecache.bytes += bytes;
+    return 0;
+}
+
+void *easyx_pack_open(const char *pPackFile)
+{
+    if (!pPackFile)
+        return NULL;
+
+    MappedFile file;
+    if (!map_file(pPackFile, &file))
+        return NULL;
+
+    // 校验文件头、索引和每个条目的范围，之后读取时不再检查
+    const PackHeader *header = reinterpret_cast<const PackHeader *>(file.data);
+    bool valid = file.size >= sizeof(PackHeader) &&
+                 memcmp(header->magic, PACK_MAGIC, 4) == 0 &&
+                 header->version == PACK_VERSION &&
+                 header->indexOffset % sizeof(uint64_t) == 0 &&
+                 header->indexOffset <= file.size &&
+                 header->count <= (file.size - header->indexOffset) / sizeof(PackEntry) &&
+                 header->namesOffset <= file.size;
+
+    const PackEntry *entries = valid ? reinterpret_cast<const PackEntry *>(file.data + header->indexOffset) : NULL;
+    for (uint32_t i = 0; valid && i < header->count; ++i)
+    {
+        const PackEntry &entry = entries[i];
+        uint64_t pixelBytes = static_cast<uint64_t>(entry.width) * static_cast<uint64_t>(entry.height) * sizeof(DWORD);
+        valid = entry.width > 0 && entry.height > 0 &&
+                entry.pixelOffset % PACK_ALIGN == 0 &&
+                entry.pixelOffset <= file.size && pixelBytes <= file.size - entry.pixelOffset &&
+                static_cast<uint64_t>(entry.nameOffset) + entry.nameLength < file.size - header->namesOffset &&
+                file.data[header->namesOffset + entry.nameOffset + entry.nameLength] == '\0';
+    }
+
+    if (!valid)
+    {
+        unmap_file(&file);
+        return NULL;
+    }
+
+    AssetPack *pack = new AssetPack();
+    pack->file = file;
+    pack->entries = entries;
+    pack->names = reinterpret_cast<const char *>(file.data + header->namesOffset);
+    pack->count = header->count;
+    return pack;
+}
+
+void easyx_pack_close(void *pack)
+{
+    AssetPack *self = reinterpret_cast<AssetPack *>(pack);
+    if (!self)
+        return;
+
+    unmap_file(&self->file);
+    delete self;
+}
+
+int easyx_pack_count(void *pack)
+{
+    AssetPack *self = reinterpret_cast<AssetPack *>(pack);
+    return self ? static_cast<int>(self->count) : 0;
+}
+
+int easyx_pack_find(void *pack, const char *pName)
+{
+    AssetPack *self = reinterpret_cast<AssetPack *>(pack);
+    if (!self || !pName)
+        return EASYX_PACK_ERR_NOTFOUND;
+
+    size_t length = strlen(pName);
+    uint64_t h = hash_name(pName, length);
+
+    // 索引按名称哈希排序，二分查找第一个哈希相同的条目
+    uint32_t lo = 0, hi = self->count;
+    while (lo < hi)
+    {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (self->entries[mid].nameHash < h)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    for (uint32_t i = lo; i < self->count && self->entries[i].nameHash == h; ++i)
+    {
+        const PackEntry &entry = self->entries[i];
+        if (entry.nameLength == length && memcmp(self->names + entry.nameOffset, pName, length) == 0)
+            return static_cast<int>(i);
+    }
+    return EASYX_PACK_ERR_NOTFOUND;
+}
+
+const char *easyx_pack_getname(void *pack, int index)
+{
+    AssetPack *self = reinterpret_cast<AssetPack *>(pack);
+    if (!self || index < 0 || static_cast<uint32_t>(index) >= self->count)
+        return NULL;
+
+    return self->names + self->entries[index].nameOffset;
+}
+
+int easyx_pack_getsize(void *pack, int index, int32_t *pSize)
+{
+    AssetPack *self = reinterpret_cast<AssetPack *>(pack);
+    if (!self || !pSize || index < 0 || static_cast<uint32_t>(index) >= self->count)
+        return 0;
+
+    pSize[0] = self->entries[index].width;
+    pSize[1] = self->entries[index].height;
+    return 1;
+}
+
+int easyx_pack_load(void *pack, int index, void *pDstImg)
+{
+    PROFILE_SCOPE(EASYX_PROF_IMAGES);
+    AssetPack *self = reinterpret_cast<AssetPack *>(pack);
+    if (!self || !pDstImg)
+        return EASYX_PACK_ERR_INVALID;
+    if (index < 0 || static_cast<uint32_t>(index) >= self->count)
+        return EASYX_PACK_ERR_NOTFOUND;
+
+    const PackEntry &entry = self->entries[index];
+    IMAGE *dst = reinterpret_cast<IMAGE *>(pDstImg);
+    easyx_image_resize(dst, entry.width, entry.height);
+    memcpy(GetImageBuffer(dst), self->file.data + entry.pixelOffset, static_cast<size_t>(entry.width) * entry.height * sizeof(DWORD));
+    return 0;
+}
+
+void *easyx_packwriter_create()
+{
+    return new PackWriter();
+}
+
+void easyx_packwriter_destroy(void *writer)
+{
+    delete reinterpret_cast<PackWriter *>(writer);
+}
+
+int easyx_packwriter_add(void *writer, const char *pName, const void *pImg)
+{
+    PackWriter *self = reinterpret_cast<PackWriter *>(writer);
+    const IMAGE *img = reinterpret_cast<const IMAGE *>(pImg);
+    if (!self || !pName || !img || img->getwidth() <= 0 || img->getheight() <= 0)
+        return EASYX_PACK_ERR_INVALID;
+
+    self->entries.push_back(PackWriterEntry());
+    PackWriterEntry &entry = self->entries.back();
+    entry.name = pName;
+    entry.width = img->getwidth();
+    entry.height = img->getheight();
+
+    const DWORD *pixels = GetImageBuffer(img);
+    entry.pixels.assign(pixels, pixels + static_cast<size_t>(entry.width) * entry.height);
+    return 0;
+}
+
+static bool pack_write(HANDLE file, const void *data, size_t size, uint64_t *offset)
+{
+    DWORD written = 0;
+    if (size > 0 && (!WriteFile(file, data, static_cast<DWORD>(size), &written, NULL) || written != size))
+        return false;
+    *offset += size;
+    return true;
+}
+
+static bool pack_pad(HANDLE file, uint64_t *offset)
+{
+    static const BYTE zeros[PACK_ALIGN] = {0};
+    size_t padding = static_cast<size_t>((PACK_ALIGN - *offset % PACK_ALIGN) % PACK_ALIGN);
+    return pack_write(file, zeros, padding, offset);
+}
+
+static bool pack_entry_less(const PackEntry &a, const PackEntry &b)
+{
+    return a.nameHash < b.nameHash;
+}
+
+int easyx_packwriter_save(void *writer, const char *pPackFile)
+{
+    PackWriter *self = reinterpret_cast<PackWriter *>(writer);
+    if (!self || !pPackFile)
+        return EASYX_PACK_ERR_INVALID;
+
+    // 先确定布局：文件头之后依次存放对齐的像素数据，然后是索引和名称
+    std::vector<PackEntry> index(self->entries.size());
+    std::string names;
+    uint64_t offset = sizeof(PackHeader);
+    for (size_t i = 0; i < self->entries.size(); ++i)
+    {
+        const PackWriterEntry &source = self->entries[i];
+        offset = (offset + PACK_ALIGN - 1) / PACK_ALIGN * PACK_ALIGN;
+        index[i].nameHash = hash_name(source.name.c_str(), source.name.size());
+        index[i].nameOffset = static_cast<uint32_t>(names.size());
+        index[i].nameLength = static_cast<uint32_t>(source.name.size());
+        index[i].width = source.width;
+        index[i].height = source.height;
+        index[i].pixelOffset = offset;
+        offset += source.pixels.size() * sizeof(DWORD);
+        names += source.name;
+        names += '\0';
+    }
+
+    PackHeader header;
+    memcpy(header.magic, PACK_MAGIC, 4);
+    header.version = PACK_VERSION;
+    header.count = static_cast<uint32_t>(index.size());
+    header.reserved = 0;
+    header.indexOffset = (offset + PACK_ALIGN - 1) / PACK_ALIGN * PACK_ALIGN;
+    header.namesOffset = header.indexOffset + index.size() * sizeof(PackEntry);
+
+    // 按名称哈希排序，打开后可以直接二分查找
+    std::stable_sort(index.begin(), index.end(), pack_entry_less);
+
+    std::wstring wpath = utf8_to_wstring(pPackFile);
+    HANDLE file = CreateFileW(wpath.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return EASYX_PACK_ERR_IO;
+
+    offset = 0;
+    bool ok = pack_write(file, &header, sizeof(header), &offset);
+    for (size_t i = 0; ok && i < self->entries.size(); ++i)
+    {
+        ok = pack_pad(file, &offset) &&
+             pack_write(file, self->entries[i].pixels.data(), self->entries[i].pixels.size() * sizeof(DWORD), &offset);
+    }
+    ok = ok && pack_pad(file, &offset) &&
+         pack_write(file, index.data(), index.size() * sizeof(PackEntry), &offset) &&
+         pack_write(file, names.data(), names.size(), &offset);
+    CloseHandle(file);
+
+    if (!ok)
+    {
+        DeleteFileW(wpath.c_str());
+        return EASYX_PACK_ERR_IO;
+    }
+    return 0;
+}
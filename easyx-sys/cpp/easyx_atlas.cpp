@@ -0,0 +1,325 @@
+// easyx_atlas.cpp
+// 精灵图集，将多张图像装箱到一张 IMAGE 中并批量绘制，绕过逐个精灵的 putimage
+
+#include "easyx_wrapper.h"
+#include "easyx_profiler.h"
+#include "easyx_atlas.h"
+#include "easyx_raster.h"
+#include <string.h>
+#include <vector>
+#include <windows.h>
+#include <tchar.h>
+#include "../EasyX_26.1.1/include/easyx.h"
+
+// 精灵之间留 1 像素间隔
+#define ATLAS_PADDING 1
+
+// 天际线上的一段：[x, x + width) 范围内已占用到 y
+struct SkylineNode
+{
+    int x, y, width;
+};
+
+struct AtlasSprite
+{
+    int x, y;
+    int width, height;
+    bool opaque; // 所有像素透明度均为 255，混合时可以退化为复制
+};
+
+struct SpriteAtlas
+{
+    IMAGE *image;
+    int width, height;
+    std::vector<SkylineNode> skyline;
+    std::vector<AtlasSprite> sprites;
+};
+
+// 计算宽 width 的矩形放在第 index 段起点时的 y 坐标，放不下返回 -1
+static int atlas_skyline_fit(const SpriteAtlas *atlas, size_t index, int width, int height)
+{
+    int x = atlas->skyline[index].x;
+    if (x + width > atlas->width)
+        return -1;
+
+    int y = 0;
+    int remaining = width;
+    for (size_t i = index; remaining > 0; ++i)
+    {
+        if (i >= atlas->skyline.size())
+            return -1;
+        if (atlas->skyline[i].y > y)
+            y = atlas->skyline[i].y;
+        if (y + height > atlas->height)
+            return -1;
+        remaining -= atlas->skyline[i].width;
+    }
+    return y;
+}
+
+// 天际线装箱，选择放置后顶边最低的位置，相同时选择最靠左的位置
+static bool atlas_allocate(SpriteAtlas *atlas, int width, int height, int *px, int *py)
+{
+    int bestIndex = -1, bestTop = 0, bestX = 0, bestY = 0;
+    for (size_t i = 0; i < atlas->skyline.size(); ++i)
+    {
+        int y = atlas_skyline_fit(atlas, i, width, height);
+        if (y < 0)
+            continue;
+        if (bestIndex < 0 || y + height < bestTop)
+        {
+            bestIndex = static_cast<int>(i);
+            bestTop = y + height;
+            bestX = atlas->skyline[i].x;
+            bestY = y;
+        }
+    }
+    if (bestIndex < 0)
+        return false;
+
+    SkylineNode node = {bestX, bestY + height, width};
+    atlas->skyline.insert(atlas->skyline.begin() + bestIndex, node);
+
+    // 截断或删除被新段覆盖的后续段
+    size_t i = bestIndex + 1;
+    while (i < atlas->skyline.size())
+    {
+        SkylineNode &next = atlas->skyline[i];
+        int overlap = node.x + node.width - next.x;
+        if (overlap <= 0)
+            break;
+        if (overlap < next.width)
+        {
+            next.x += overlap;
+            next.width -= overlap;
+            break;
+        }
+        atlas->skyline.erase(atlas->skyline.begin() + i);
+    }
+
+    // 合并高度相同的相邻段
+    for (i = 0; i + 1 < atlas->skyline.size();)
+    {
+        if (atlas->skyline[i].y == atlas->skyline[i + 1].y)
+        {
+            atlas->skyline[i].width += atlas->skyline[i + 1].width;
+            atlas->skyline.erase(atlas->skyline.begin() + i + 1);
+        }
+        else
+            ++i;
+    }
+
+    *px = bestX;
+    *py = bestY;
+    return true;
+}
+
+bool atlas_sprite_pixels(void *atlas, int sprite, AtlasPixels *out)
+{
+    SpriteAtlas *self = reinterpret_cast<SpriteAtlas *>(atlas);
+    if (!self || sprite < 0 || sprite >= static_cast<int>(self->sprites.size()))
+        return false;
+
+    const AtlasSprite &s = self->sprites[sprite];
+    out->pixels = GetImageBuffer(self->image) + static_cast<size_t>(s.y) * self->width + s.x;
+    out->pitch = self->width;
+    out->width = s.width;
+    out->height = s.height;
+    out->opaque = s.opaque;
+    return true;
+}
+
+void *easyx_atlas_create(int width, int height)
+{
+    if (width <= 0 || height <= 0)
+        return NULL;
+
+    SpriteAtlas *atlas = new SpriteAtlas();
+    atlas->image = reinterpret_cast<IMAGE *>(easyx_create_image(width, height));
+    atlas->width = width;
+    atlas->height = height;
+
+    SkylineNode root = {0, 0, width};
+    atlas->skyline.push_back(root);
+
+    // 未使用的区域保持全透明
+    DWORD *buffer = GetImageBuffer(atlas->image);
+    memset(buffer, 0, static_cast<size_t>(width) * height * sizeof(DWORD));
+
+    return atlas;
+}
+
+void easyx_atlas_destroy(void *atlas)
+{
+    SpriteAtlas *self = reinterpret_cast<SpriteAtlas *>(atlas);
+    if (!self)
+        return;
+
+    easyx_destroy_image(self->image);
+    delete self;
+}
+
+int easyx_atlas_add_image(void *atlas, const void *pSrcImg, int srcX, int srcY, int width, int height)
+{
+    PROFILE_SCOPE(EASYX_PROF_IMAGES);
+    SpriteAtlas *self = reinterpret_cast<SpriteAtlas *>(atlas);
+    const IMAGE *srcImg = reinterpret_cast<const IMAGE *>(pSrcImg);
+    if (!self || !srcImg)
+        return EASYX_ATLAS_ERR_INVALID;
+
+    int srcWidth = srcImg->getwidth();
+    int srcHeight = srcImg->getheight();
+    if (width <= 0)
+        width = srcWidth - srcX;
+    if (height <= 0)
+        height = srcHeight - srcY;
+    if (srcX < 0 || srcY < 0 || width <= 0 || height <= 0 || srcX + width > srcWidth || srcY + height > srcHeight)
+        return EASYX_ATLAS_ERR_INVALID;
+
+    // 靠右和靠下的精灵允许省略间隔
+    int allocWidth = width + ATLAS_PADDING > self->width ? width : width + ATLAS_PADDING;
+    int allocHeight = height + ATLAS_PADDING > self->height ? height : height + ATLAS_PADDING;
+
+    AtlasSprite sprite;
+    if (!atlas_allocate(self, allocWidth, allocHeight, &sprite.x, &sprite.y))
+        return EASYX_ATLAS_ERR_FULL;
+    sprite.width = width;
+    sprite.height = height;
+    sprite.opaque = true;
+
+    const DWORD *src = GetImageBuffer(srcImg) + static_cast<size_t>(srcY) * srcWidth + srcX;
+    DWORD *dst = GetImageBuffer(self->image) + static_cast<size_t>(sprite.y) * self->width + sprite.x;
+    for (int row = 0; row < height; ++row, src += srcWidth, dst += self->width)
+    {
+        memcpy(dst, src, width * sizeof(DWORD));
+        for (int col = 0; col < width && sprite.opaque; ++col)
+            sprite.opaque = (src[col] >> 24) == 0xFF;
+    }
+
+    self->sprites.push_back(sprite);
+    return static_cast<int>(self->sprites.size()) - 1;
+}
+
+int easyx_atlas_add_file(void *atlas, const char *pImgFile, int nWidth, int nHeight, int bResize)
+{
+    if (!atlas || !pImgFile)
+        return EASYX_ATLAS_ERR_INVALID;
+
+    IMAGE image;
+    if (easyx_loadimage_file(&image, pImgFile, nWidth, nHeight, bResize) != 0)
+        return EASYX_ATLAS_ERR_LOAD;
+
+    return easyx_atlas_add_image(atlas, &image, 0, 0, 0, 0);
+}
+
+int easyx_atlas_count(void *atlas)
+{
+    SpriteAtlas *self = reinterpret_cast<SpriteAtlas *>(atlas);
+    return self ? static_cast<int>(self->sprites.size()) : 0;
+}
+
+int easyx_atlas_getsprite(void *atlas, int sprite, int32_t *pRect)
+{
+    SpriteAtlas *self = reinterpret_cast<SpriteAtlas *>(atlas);
+    if (!self || !pRect || sprite < 0 || sprite >= static_cast<int>(self->sprites.size()))
+        return 0;
+
+    const AtlasSprite &s = self->sprites[sprite];
+    pRect[0] = s.x;
+    pRect[1] = s.y;
+    pRect[2] = s.width;
+    pRect[3] = s.height;
+    return 1;
+}
+
+void *easyx_atlas_getimage(void *atlas)
+{
+    SpriteAtlas *self = reinterpret_cast<SpriteAtlas *>(atlas);
+    return self ? self->image : NULL;
+}
+
+int easyx_atlas_draw_batch(void *atlas, const EasyXSpriteInstance *instances, int n)
+{
+    PROFILE_SCOPE(EASYX_PROF_IMAGES);
+    SpriteAtlas *self = reinterpret_cast<SpriteAtlas *>(atlas);
+    if (!self || !instances || n <= 0)
+        return 0;
+
+    RasterTarget target = raster_target();
+    RasterClip clip;
+    if (!target.buffer || !raster_clip(target, &clip))
+        return 0;
+
+    const DWORD *pixels = GetImageBuffer(self->image);
+    int sprites = static_cast<int>(self->sprites.size());
+
+    // 所有实例的并集，最后一次性记为脏矩形
+    int dirtyLeft = clip.right, dirtyTop = clip.bottom, dirtyRight = clip.left, dirtyBottom = clip.top;
+    int drawn = 0;
+
+    for (int i = 0; i < n; ++i)
+    {
+        const EasyXSpriteInstance &instance = instances[i];
+        if (instance.sprite < 0 || instance.sprite >= sprites)
+            continue;
+
+        bool blend = (instance.flags & EASYX_SPRITE_BLEND) != 0;
+        if (blend && instance.alpha == 0)
+            continue;
+
+        const AtlasSprite &sprite = self->sprites[instance.sprite];
+        int dstX = instance.x + clip.originX;
+        int dstY = instance.y + clip.originY;
+        int srcX = 0, srcY = 0;
+        int width = sprite.width, height = sprite.height;
+
+        if (dstX < clip.left)
+        {
+            srcX = clip.left - dstX;
+            width -= srcX;
+            dstX = clip.left;
+        }
+        if (dstY < clip.top)
+        {
+            srcY = clip.top - dstY;
+            height -= srcY;
+            dstY = clip.top;
+        }
+        if (dstX + width > clip.right)
+            width = clip.right - dstX;
+        if (dstY + height > clip.bottom)
+            height = clip.bottom - dstY;
+        if (width <= 0 || height <= 0)
+            continue;
+
+        const DWORD *src = pixels + static_cast<size_t>(sprite.y + srcY) * self->width + sprite.x + srcX;
+        DWORD *dst = target.buffer + static_cast<size_t>(dstY) * target.width + dstX;
+
+        // 不透明精灵在全局透明度为 255 时直接复制
+        if (!blend || (sprite.opaque && instance.alpha == 255))
+        {
+            for (int row = 0; row < height; ++row, src += self->width, dst += target.width)
+                memcpy(dst, src, width * sizeof(DWORD));
+        }
+        else
+        {
+            for (int row = 0; row < height; ++row, src += self->width, dst += target.width)
+                raster_blend_row(dst, src, width, instance.alpha);
+        }
+
+        if (dstX < dirtyLeft)
+            dirtyLeft = dstX;
+        if (dstY < dirtyTop)
+            dirtyTop = dstY;
+        if (dstX + width > dirtyRight)
+            dirtyRight = dstX + width;
+        if (dstY + height > dirtyBottom)
+            dirtyBottom = dstY + height;
+        ++drawn;
+    }
+
+    if (drawn > 0)
+        easyx_dirty_add(dirtyLeft, dirtyTop, dirtyRight - 1, dirtyBottom - 1);
+
+    return drawn;
+}
@@ -0,0 +1,21 @@
+// easyx_atlas.h
+// 精灵图集的内部接口，供瓦片地图等模块直接读取精灵像素，不参与绑定生成
+
+#ifndef EASYX_ATLAS_H
+#define EASYX_ATLAS_H
+
+#include <windows.h>
+
+// 精灵在图集图像中的像素
+struct AtlasPixels
+{
+    const DWORD *pixels; // 精灵左上角像素
+    int pitch;           // 图集图像每行的像素数
+    int width, height;
+    bool opaque; // 所有像素透明度均为 255
+};
+
+// 获取精灵的像素，编号无效时返回 false
+bool atlas_sprite_pixels(void *atlas, int sprite, AtlasPixels *out);
+
+#endif // EASYX_ATLAS_H
@@ -0,0 +1,203 @@
+// easyx_frame.cpp
+// 帧节奏调度，使用 QueryPerformanceCounter 和高精度可等待计时器按目标帧率提交画面
+
+#include "easyx_wrapper.h"
+#include <windows.h>
+#include <dwmapi.h>
+#include <tchar.h>
+#include "../EasyX_26.1.1/include/easyx.h"
+
+// 旧版 SDK 中没有定义，Windows 10 1803 之前的系统创建时会失败并回退到普通计时器
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+
+// 普通计时器的唤醒误差约为一个系统时钟周期，剩余时间在此范围内改为自旋等待
+#define FRAME_SPIN_MS_HIGH_RES 0.5
+#define FRAME_SPIN_MS_LOW_RES 2.0
+
+struct FrameScheduler
+{
+    bool started;
+    bool vsync;
+    double targetFps;
+
+    LONGLONG frequency;
+    LONGLONG period;     // 目标帧间隔，0 表示不限帧率
+    LONGLONG deadline;   // 本帧的提交时刻
+    LONGLONG frameStart; // 本帧开始时刻（上一帧提交完成）
+
+    HANDLE timer;
+    bool highResTimer;
+
+    EasyXFrameStats stats;
+};
+
+static FrameScheduler g_frame = {};
+
+static inline LONGLONG frame_now()
+{
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    return counter.QuadPart;
+}
+
+static inline double frame_ms(LONGLONG ticks)
+{
+    return static_cast<double>(ticks) * 1000.0 / static_cast<double>(g_frame.frequency);
+}
+
+static void frame_init()
+{
+    if (g_frame.frequency != 0)
+        return;
+
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    g_frame.frequency = frequency.QuadPart;
+
+    g_frame.timer = CreateWaitableTimerExW(NULL, NULL, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+    g_frame.highResTimer = g_frame.timer != NULL;
+    if (!g_frame.timer)
+        g_frame.timer = CreateWaitableTimerW(NULL, TRUE, NULL);
+}
+
+static void frame_restart(LONGLONG now)
+{
+    g_frame.started = true;
+    g_frame.frameStart = now;
+    g_frame.deadline = now + g_frame.period;
+}
+
+// 等待到指定时刻：先用计时器休眠，最后一小段自旋以获得亚毫秒精度
+static void frame_wait_until(LONGLONG deadline)
+{
+    double spinMs = g_frame.highResTimer ? FRAME_SPIN_MS_HIGH_RES : FRAME_SPIN_MS_LOW_RES;
+
+    for (;;)
+    {
+        LONGLONG now = frame_now();
+        if (now >= deadline)
+            return;
+
+        double remaining = frame_ms(deadline - now);
+        if (remaining <= spinMs)
+            break;
+
+        if (g_frame.timer)
+        {
+            // 相对时间，以 100 纳秒为单位，负数表示相对当前时刻
+            LARGE_INTEGER due;
+            due.QuadPart = -static_cast<LONGLONG>((remaining - spinMs) * 10000.0);
+            if (SetWaitableTimer(g_frame.timer, &due, 0, NULL, NULL, FALSE))
+            {
+                WaitForSingleObject(g_frame.timer, INFINITE);
+                continue;
+            }
+        }
+
+        Sleep(static_cast<DWORD>(remaining - spinMs));
+    }
+
+    while (frame_now() < deadline)
+        YieldProcessor();
+}
+
+void easyx_frame_settargetfps(double fps)
+{
+    frame_init();
+
+    g_frame.targetFps = fps > 0 ? fps : 0;
+    g_frame.period = fps > 0 ? static_cast<LONGLONG>(static_cast<double>(g_frame.frequency) / fps) : 0;
+    if (g_frame.started)
+        g_frame.deadline = g_frame.frameStart + g_frame.period;
+}
+
+double easyx_frame_gettargetfps()
+{
+    return g_frame.targetFps;
+}
+
+void easyx_frame_setvsync(int enabled)
+{
+    g_frame.vsync = enabled != 0;
+}
+
+int easyx_frame_getvsync()
+{
+    return g_frame.vsync ? 1 : 0;
+}
+
+void easyx_frame_reset()
+{
+    frame_init();
+    frame_restart(frame_now());
+
+    EasyXFrameStats empty = {};
+    g_frame.stats = empty;
+}
+
+int easyx_frame_present(int dirtyOnly)
+{
+    frame_init();
+
+    LONGLONG now = frame_now();
+    if (!g_frame.started)
+        frame_restart(now);
+
+    EasyXFrameStats &stats = g_frame.stats;
+    stats.cpuMs = frame_ms(now - g_frame.frameStart);
+
+    // 等待到本帧的提交时刻
+    bool missed = g_frame.period > 0 && now > g_frame.deadline;
+    if (g_frame.period > 0 && !missed)
+        frame_wait_until(g_frame.deadline);
+
+    LONGLONG presentStart = frame_now();
+    stats.waitMs = frame_ms(presentStart - now);
+
+    if (dirtyOnly)
+        easyx_flushbatchdraw_dirty();
+    else
+        easyx_flushbatchdraw();
+
+    // 等待 DWM 完成下一次合成，使提交与显示器刷新对齐
+    if (g_frame.vsync)
+        DwmFlush();
+
+    LONGLONG end = frame_now();
+    stats.presentMs = frame_ms(end - presentStart);
+    stats.frameMs = frame_ms(end - g_frame.frameStart);
+    stats.frameIndex++;
+    if (missed)
+        stats.missedFrames++;
+
+    // 计算下一帧的提交时刻。落后超过一帧时重新对齐，避免为追赶进度连续不等待
+    g_frame.frameStart = end;
+    if (g_frame.period > 0)
+    {
+        g_frame.deadline += g_frame.period;
+        if (g_frame.deadline <= end)
+            g_frame.deadline = end + g_frame.period;
+    }
+
+    return missed ? 1 : 0;
+}
+
+double easyx_frame_getremaining()
+{
+    if (g_frame.period == 0)
+        return -1.0;
+
+    frame_init();
+    LONGLONG now = frame_now();
+    if (!g_frame.started)
+        frame_restart(now);
+    return g_frame.deadline > now ? frame_ms(g_frame.deadline - now) : 0.0;
+}
+
+void easyx_frame_getstats(EasyXFrameStats *pStats)
+{
+    if (pStats)
+        *pStats = g_frame.stats;
+}
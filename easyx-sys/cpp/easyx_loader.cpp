@@ -0,0 +1,379 @@
+// easyx_loader.cpp
+// 异步图像加载，在工作线程中用 WIC 解码为像素缓冲区，再在绘图线程中分批创建 IMAGE
+
+#include "easyx_wrapper.h"
+#include "easyx_profiler.h"
+#include <string.h>
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <windows.h>
+#include <wincodec.h>
+#include <tchar.h>
+#include "../EasyX_26.1.1/include/easyx.h"
+
+// 解码线程数的上限，解码主要受磁盘和内存带宽限制，更多线程收益不大
+#define LOADER_MAX_THREADS 4
+
+struct LoadRequest
+{
+    int id;
+    std::wstring path;
+    int width, height; // 0 表示原始大小
+    int state;         // EASYX_LOAD_*
+    int error;         // 失败时的错误码
+    bool cancelled;    // 解码期间被取消，由工作线程释放
+    bool finalizing;   // 正在绘图线程中创建图像，期间被取消时由 finalize 释放
+    std::vector<DWORD> pixels;
+    int pixelWidth, pixelHeight;
+    IMAGE *image;
+};
+
+struct ImageLoader
+{
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::vector<std::thread> workers;
+    bool stopping;
+
+    std::deque<LoadRequest *> queue;   // 等待解码
+    std::deque<LoadRequest *> decoded; // 等待在绘图线程中创建图像
+    std::unordered_map<int, LoadRequest *> requests;
+    int nextId;
+
+    EasyXLoadProgress progress;
+
+    ImageLoader() : stopping(false), nextId(1)
+    {
+        memset(&progress, 0, sizeof(progress));
+    }
+
+    ~ImageLoader()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (size_t i = 0; i < workers.size(); ++i)
+            workers[i].join();
+
+        for (std::unordered_map<int, LoadRequest *>::iterator it = requests.begin(); it != requests.end(); ++it)
+        {
+            delete it->second->image;
+            delete it->second;
+        }
+    }
+};
+
+static ImageLoader g_loader;
+
+static std::wstring utf8_to_wstring(const char *str)
+{
+    int len = MultiByteToWideChar(CP_UTF8, 0, str, -1, NULL, 0);
+    if (len <= 0)
+        return std::wstring();
+
+    std::wstring wstr(len - 1, 0);
+    MultiByteToWideChar(CP_UTF8, 0, str, -1, &wstr[0], len);
+    return wstr;
+}
+
+// 用 WIC 解码为 32 位 BGRA，内存布局与 IMAGE 缓冲区的 0xAARRGGBB 相同
+static HRESULT loader_decode(IWICImagingFactory *factory, LoadRequest *request)
+{
+    IWICBitmapDecoder *decoder = NULL;
+    IWICBitmapFrameDecode *frame = NULL;
+    IWICBitmapScaler *scaler = NULL;
+    IWICFormatConverter *converter = NULL;
+    IWICBitmapSource *source = NULL;
+    UINT width = 0, height = 0;
+
+    HRESULT hr = factory->CreateDecoderFromFilename(request->path.c_str(), NULL, GENERIC_READ, WICDecodeMetadataCacheOnDemand, &decoder);
+    if (SUCCEEDED(hr))
+        hr = decoder->GetFrame(0, &frame);
+    if (SUCCEEDED(hr))
+        hr = frame->GetSize(&width, &height);
+
+    if (SUCCEEDED(hr))
+    {
+        source = frame;
+        UINT scaledWidth = request->width > 0 ? request->width : width;
+        UINT scaledHeight = request->height > 0 ? request->height : height;
+        if (scaledWidth != width || scaledHeight != height)
+        {
+            hr = factory->CreateBitmapScaler(&scaler);
+            if (SUCCEEDED(hr))
+                hr = scaler->Initialize(frame, scaledWidth, scaledHeight, WICBitmapInterpolationModeFant);
+            source = scaler;
+            width = scaledWidth;
+            height = scaledHeight;
+        }
+    }
+    if (SUCCEEDED(hr))
+        hr = factory->CreateFormatConverter(&converter);
+    if (SUCCEEDED(hr))
+        hr = converter->Initialize(source, GUID_WICPixelFormat32bppBGRA, WICBitmapDitherTypeNone, NULL, 0.0, WICBitmapPaletteTypeCustom);
+    if (SUCCEEDED(hr))
+    {
+        request->pixels.resize(static_cast<size_t>(width) * height);
+        request->pixelWidth = width;
+        request->pixelHeight = height;
+        hr = converter->CopyPixels(NULL, width * sizeof(DWORD), static_cast<UINT>(request->pixels.size() * sizeof(DWORD)), reinterpret_cast<BYTE *>(request->pixels.data()));
+    }
+
+    if (converter)
+        converter->Release();
+    if (scaler)
+        scaler->Release();
+    if (frame)
+        frame->Release();
+    if (decoder)
+        decoder->Release();
+    return hr;
+}
+
+// 与 loadimage 的返回值保持一致：文件不存在为 2，其余为 HRESULT
+static int loader_error(HRESULT hr)
+{
+    if (HRESULT_FACILITY(hr) == FACILITY_WIN32)
+        return HRESULT_CODE(hr);
+    return static_cast<int>(hr);
+}
+
+static void loader_worker()
+{
+    HRESULT init = CoInitializeEx(NULL, COINIT_MULTITHREADED);
+    IWICImagingFactory *factory = NULL;
+    HRESULT created = CoCreateInstance(CLSID_WICImagingFactory, NULL, CLSCTX_INPROC_SERVER, IID_PPV_ARGS(&factory));
+
+    std::unique_lock<std::mutex> lock(g_loader.mutex);
+    for (;;)
+    {
+        while (!g_loader.stopping && g_loader.queue.empty())
+            g_loader.wake.wait(lock);
+        if (g_loader.stopping)
+            break;
+
+        LoadRequest *request = g_loader.queue.front();
+        g_loader.queue.pop_front();
+
+        lock.unlock();
+        HRESULT hr = SUCCEEDED(created) ? loader_decode(factory, request) : created;
+        lock.lock();
+
+        if (request->cancelled)
+        {
+            delete request;
+            continue;
+        }
+
+        if (SUCCEEDED(hr))
+        {
+            request->state = EASYX_LOAD_DECODED;
+            g_loader.decoded.push_back(request);
+        }
+        else
+        {
+            request->state = EASYX_LOAD_FAILED;
+            request->error = loader_error(hr);
+            request->pixels.clear();
+            ++g_loader.progress.finished;
+            ++g_loader.progress.failed;
+        }
+    }
+    lock.unlock();
+
+    if (factory)
+        factory->Release();
+    if (SUCCEEDED(init))
+        CoUninitialize();
+}
+
+// 首次提交请求时启动工作线程，调用时需持有锁
+static void loader_start()
+{
+    if (!g_loader.workers.empty())
+        return;
+
+    unsigned threads = std::thread::hardware_concurrency();
+    threads = threads > 1 ? threads - 1 : 1; // 留一个核心给绘图线程
+    if (threads > LOADER_MAX_THREADS)
+        threads = LOADER_MAX_THREADS;
+
+    for (unsigned i = 0; i < threads; ++i)
+        g_loader.workers.push_back(std::thread(loader_worker));
+}
+
+int easyx_loadimage_async(const char *pImgFile, int nWidth, int nHeight)
+{
+    PROFILE_SCOPE(EASYX_PROF_IMAGES);
+    if (!pImgFile)
+        return 0;
+
+    LoadRequest *request = new LoadRequest();
+    request->path = utf8_to_wstring(pImgFile);
+    request->width = nWidth > 0 ? nWidth : 0;
+    request->height = nHeight > 0 ? nHeight : 0;
+    request->state = EASYX_LOAD_PENDING;
+    request->error = 0;
+    request->cancelled = false;
+    request->finalizing = false;
+    request->pixelWidth = request->pixelHeight = 0;
+    request->image = NULL;
+
+    int id;
+    {
+        std::lock_guard<std::mutex> lock(g_loader.mutex);
+        loader_start();
+
+        ++g_loader.progress.requested;
+
+        id = request->id = g_loader.nextId++;
+        if (g_loader.nextId <= 0)
+            g_loader.nextId = 1;
+        g_loader.requests[id] = request;
+        g_loader.queue.push_back(request);
+    }
+    g_loader.wake.notify_one();
+
+    return id;
+}
+
+int easyx_loadimage_status(int id)
+{
+    std::lock_guard<std::mutex> lock(g_loader.mutex);
+    std::unordered_map<int, LoadRequest *>::iterator it = g_loader.requests.find(id);
+    return it != g_loader.requests.end() ? it->second->state : EASYX_LOAD_NONE;
+}
+
+void *easyx_loadimage_take(int id, int *pError)
+{
+    std::lock_guard<std::mutex> lock(g_loader.mutex);
+    if (pError)
+        *pError = 0;
+
+    std::unordered_map<int, LoadRequest *>::iterator it = g_loader.requests.find(id);
+    if (it == g_loader.requests.end())
+        return NULL;
+
+    LoadRequest *request = it->second;
+    if (request->state != EASYX_LOAD_READY && request->state != EASYX_LOAD_FAILED)
+        return NULL;
+
+    IMAGE *image = request->image;
+    if (pError)
+        *pError = request->error;
+    g_loader.requests.erase(it);
+    delete request;
+    return image;
+}
+
+int easyx_loadimage_cancel(int id)
+{
+    std::lock_guard<std::mutex> lock(g_loader.mutex);
+    std::unordered_map<int, LoadRequest *>::iterator it = g_loader.requests.find(id);
+    if (it == g_loader.requests.end())
+        return 0;
+
+    LoadRequest *request = it->second;
+    g_loader.requests.erase(it);
+
+    if (request->state == EASYX_LOAD_PENDING)
+    {
+        std::deque<LoadRequest *>::iterator queued = std::find(g_loader.queue.begin(), g_loader.queue.end(), request);
+        if (queued == g_loader.queue.end())
+        {
+            // 已被工作线程取出，正在解码
+            request->cancelled = true;
+            ++g_loader.progress.cancelled;
+            return 1;
+        }
+        g_loader.queue.erase(queued);
+        ++g_loader.progress.cancelled;
+    }
+    else if (request->state == EASYX_LOAD_DECODED)
+    {
+        ++g_loader.progress.cancelled;
+        if (request->finalizing)
+            return 1;
+        g_loader.decoded.erase(std::find(g_loader.decoded.begin(), g_loader.decoded.end(), request));
+    }
+
+    delete request->image;
+    delete request;
+    return 1;
+}
+
+int easyx_loadimage_finalize(double budgetMs)
+{
+    PROFILE_SCOPE(EASYX_PROF_IMAGES);
+    LARGE_INTEGER frequency, start, now;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&start);
+    LONGLONG budget = budgetMs > 0 ? static_cast<LONGLONG>(budgetMs * frequency.QuadPart / 1000.0) : 0;
+
+    int finalized = 0;
+    for (;;)
+    {
+        LoadRequest *request;
+        {
+            std::lock_guard<std::mutex> lock(g_loader.mutex);
+            if (g_loader.decoded.empty())
+                break;
+            request = g_loader.decoded.front();
+            g_loader.decoded.pop_front();
+            request->finalizing = true;
+        }
+
+        // IMAGE 持有 GDI 对象，只在绘图线程中创建
+        IMAGE *image = new IMAGE(request->pixelWidth, request->pixelHeight);
+        memcpy(GetImageBuffer(image), request->pixels.data(), request->pixels.size() * sizeof(DWORD));
+        ++finalized;
+
+        {
+            std::lock_guard<std::mutex> lock(g_loader.mutex);
+            if (g_loader.requests.count(request->id))
+            {
+                std::vector<DWORD>().swap(request->pixels);
+                request->finalizing = false;
+                request->image = image;
+                request->state = EASYX_LOAD_READY;
+                ++g_loader.progress.finished;
+            }
+            else
+            {
+                // 创建期间被取消
+                delete image;
+                delete request;
+            }
+        }
+
+        // 至少创建一张，之后超出预算就留到下一次调用
+        QueryPerformanceCounter(&now);
+        if (budget > 0 && now.QuadPart - start.QuadPart >= budget)
+            break;
+    }
+
+    return finalized;
+}
+
+void easyx_loadimage_progress(EasyXLoadProgress *pProgress)
+{
+    if (!pProgress)
+        return;
+
+    std::lock_guard<std::mutex> lock(g_loader.mutex);
+    *pProgress = g_loader.progress;
+}
+
+void easyx_loadimage_resetprogress()
+{
+    std::lock_guard<std::mutex> lock(g_loader.mutex);
+    memset(&g_loader.progress, 0, sizeof(g_loader.progress));
+}
@@ -0,0 +1,335 @@
+// easyx_plot.cpp
+// 时间序列折线图，按像素列做最小/最大值抽稀后交给 easyx_polyline，抽稀结果按列缓存
+
+#include "easyx_wrapper.h"
+#include "easyx_profiler.h"
+#include <math.h>
+#include <string.h>
+#include <vector>
+#include <windows.h>
+#include <tchar.h>
+#include "../EasyX_26.1.1/include/easyx.h"
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define PLOT_X86 1
+#include <emmintrin.h>
+#endif
+
+// 每列的样本数少于此值时直接绘制原始样本，抽稀每列最多输出 4 个点，不再划算
+#define PLOT_DECIMATE_MIN_SPP 4.0
+
+// 一个像素列内样本的聚合：首尾样本连接相邻的列，最小/最大值决定列内的竖线范围
+struct PlotBucket
+{
+    float first, last, min, max;
+};
+
+struct Plot
+{
+    std::vector<float> samples;
+    size_t head;   // samples 中第一个有效样本的位置，丢弃旧样本时前移，过半时压缩
+    int64_t base;  // 第一个有效样本的绝对编号，丢弃旧样本不改变其余样本的编号
+    uint64_t version; // 已有样本被改写（而不只是追加）时递增
+
+    // 按绝对编号对齐的列缓存：第 k 列覆盖样本 [floor(k * spp), floor((k + 1) * spp))，
+    // 平移视口时重叠部分的列可以直接复用，追加样本只需重新计算最后一列之后的部分
+    double spp;
+    int64_t bucketFirst; // buckets[0] 对应的列号
+    std::vector<PlotBucket> buckets;
+    std::vector<PlotBucket> scratch; // 更新 buckets 时交换使用，避免每帧分配
+    int64_t bucketBase;  // 计算 buckets 时的第一个样本编号
+    int64_t bucketEnd;   // 计算 buckets 时的样本结束编号，之后追加的样本会影响最后一列
+    uint64_t bucketVersion;
+
+    // 上一次绘制的顶点，视口和数据都没有变化时直接复用
+    std::vector<POINT> points;
+    EasyXPlotView pointsView;
+    int64_t pointsEnd;
+    int64_t pointsBase;
+    uint64_t pointsVersion;
+    bool pointsValid;
+
+    Plot() : head(0), base(0), version(0), spp(0), bucketFirst(0), bucketBase(0), bucketEnd(0), bucketVersion(0),
+             pointsEnd(0), pointsBase(0), pointsVersion(0), pointsValid(false)
+    {
+        memset(&pointsView, 0, sizeof(pointsView));
+    }
+
+    size_t count() const
+    {
+        return samples.size() - head;
+    }
+
+    int64_t end() const
+    {
+        return base + static_cast<int64_t>(count());
+    }
+
+    const float *at(int64_t index) const
+    {
+        return samples.data() + head + static_cast<size_t>(index - base);
+    }
+};
+
+// 求 [p, p + n) 的最小值和最大值，n > 0
+static void plot_minmax(const float *p, size_t n, float *pMin, float *pMax)
+{
+    size_t i = 0;
+    float lo = p[0], hi = p[0];
+#ifdef PLOT_X86
+    if (n >= 8)
+    {
+        __m128 vmin = _mm_loadu_ps(p), vmax = vmin;
+        for (i = 4; i + 4 <= n; i += 4)
+        {
+            __m128 v = _mm_loadu_ps(p + i);
+            vmin = _mm_min_ps(vmin, v);
+            vmax = _mm_max_ps(vmax, v);
+        }
+        // 水平归约
+        vmin = _mm_min_ps(vmin, _mm_shuffle_ps(vmin, vmin, _MM_SHUFFLE(1, 0, 3, 2)));
+        vmin = _mm_min_ps(vmin, _mm_shuffle_ps(vmin, vmin, _MM_SHUFFLE(2, 3, 0, 1)));
+        vmax = _mm_max_ps(vmax, _mm_shuffle_ps(vmax, vmax, _MM_SHUFFLE(1, 0, 3, 2)));
+        vmax = _mm_max_ps(vmax, _mm_shuffle_ps(vmax, vmax, _MM_SHUFFLE(2, 3, 0, 1)));
+        lo = _mm_cvtss_f32(vmin);
+        hi = _mm_cvtss_f32(vmax);
+    }
+#endif
+    for (; i < n; ++i)
+    {
+        if (p[i] < lo)
+            lo = p[i];
+        if (p[i] > hi)
+            hi = p[i];
+    }
+    *pMin = lo;
+    *pMax = hi;
+}
+
+static inline int64_t plot_bucket_start(double spp, int64_t k)
+{
+    return static_cast<int64_t>(floor(static_cast<double>(k) * spp));
+}
+
+// 计算第 k 列，与有效样本没有交集时返回 false
+static bool plot_bucket(const Plot *plot, double spp, int64_t k, PlotBucket *bucket)
+{
+    int64_t first = plot_bucket_start(spp, k);
+    int64_t last = plot_bucket_start(spp, k + 1);
+    if (first < plot->base)
+        first = plot->base;
+    if (last > plot->end())
+        last = plot->end();
+    if (first >= last)
+        return false;
+
+    const float *p = plot->at(first);
+    size_t n = static_cast<size_t>(last - first);
+    bucket->first = p[0];
+    bucket->last = p[n - 1];
+    plot_minmax(p, n, &bucket->min, &bucket->max);
+    return true;
+}
+
+// 保证 buckets 覆盖 [k0, k1)，复用仍然有效的列
+static void plot_update_buckets(Plot *plot, double spp, int64_t k0, int64_t k1)
+{
+    bool reusable = plot->spp == spp && plot->bucketVersion == plot->version;
+    int64_t cachedFirst = plot->bucketFirst;
+    int64_t cachedLast = plot->bucketFirst + static_cast<int64_t>(plot->buckets.size());
+    // 计算时样本完整的列才能复用：不含当时已丢弃的样本，也不含当时之后追加的样本
+    int64_t validFrom = plot->bucketBase > plot->base ? plot->bucketBase : plot->base;
+
+    std::vector<PlotBucket> &next = plot->scratch;
+    next.resize(static_cast<size_t>(k1 - k0));
+    for (int64_t k = k0; k < k1; ++k)
+    {
+        PlotBucket &bucket = next[static_cast<size_t>(k - k0)];
+        if (reusable && k >= cachedFirst && k < cachedLast &&
+            plot_bucket_start(spp, k) >= validFrom && plot_bucket_start(spp, k + 1) <= plot->bucketEnd)
+            bucket = plot->buckets[static_cast<size_t>(k - cachedFirst)];
+        else if (!plot_bucket(plot, spp, k, &bucket))
+            bucket.first = bucket.last = bucket.min = bucket.max = NAN;
+    }
+
+    plot->buckets.swap(next);
+    plot->bucketFirst = k0;
+    plot->bucketBase = plot->base;
+    plot->bucketEnd = plot->end();
+    plot->bucketVersion = plot->version;
+    plot->spp = spp;
+}
+
+static inline LONG plot_y(const EasyXPlotView *view, float v)
+{
+    double range = static_cast<double>(view->yMax) - view->yMin;
+    double t = range != 0 ? (static_cast<double>(view->yMax) - v) / range : 0.5;
+    return view->top + static_cast<LONG>(floor(t * (view->height - 1) + 0.5));
+}
+
+static void plot_build(Plot *plot, const EasyXPlotView *view)
+{
+    std::vector<POINT> &points = plot->points;
+    points.clear();
+    if (plot->count() == 0)
+        return;
+
+    // 缩放全部样本时视口从第一个有效样本开始，丢弃旧样本后 base 不再为 0
+    double spp = view->samplesPerPixel;
+    double origin = view->first;
+    bool fit = spp <= 0;
+    if (fit)
+    {
+        spp = static_cast<double>(plot->count()) / view->width;
+        origin = static_cast<double>(plot->base);
+    }
+
+    if (spp < PLOT_DECIMATE_MIN_SPP)
+    {
+        // 样本稀疏，按原始样本绘制，两侧各多画一个样本，使折线延伸到视口边缘
+        int64_t first = static_cast<int64_t>(floor(origin)) - 1;
+        int64_t last = static_cast<int64_t>(ceil(origin + view->width * spp)) + 1;
+        if (first < plot->base)
+            first = plot->base;
+        if (last > plot->end())
+            last = plot->end();
+        for (int64_t i = first; i < last; ++i)
+        {
+            POINT pt;
+            pt.x = view->left + static_cast<LONG>(floor((i - origin) / spp + 0.5));
+            pt.y = plot_y(view, *plot->at(i));
+            points.push_back(pt);
+        }
+        return;
+    }
+
+    // 视口起点对齐到列边界，平移时列的划分不变
+    int64_t k0 = static_cast<int64_t>(floor(origin / spp));
+    // 起点向下对齐后最后一列可能盖不到最新的样本，缩放全部样本时少用一列，保证末尾不被截掉
+    if (fit && view->width > 1 && static_cast<double>(k0 + view->width) * spp < static_cast<double>(plot->end()))
+    {
+        spp = static_cast<double>(plot->count()) / (view->width - 1);
+        k0 = static_cast<int64_t>(floor(origin / spp));
+        // 第一列可能完全落在 base 之前，跳过它，多出的一列足够盖住末尾
+        if (plot_bucket_start(spp, k0 + 1) <= plot->base)
+            ++k0;
+    }
+    plot_update_buckets(plot, spp, k0, k0 + view->width);
+
+    for (int c = 0; c < view->width; ++c)
+    {
+        const PlotBucket &b = plot->buckets[c];
+        if (b.first != b.first) // NaN，没有样本
+            continue;
+
+        // 同一列的点 x 相同，首、最小、最大、尾依次连接就覆盖了列内的全部竖线范围
+        POINT pt;
+        pt.x = view->left + c;
+        LONG ys[4] = {plot_y(view, b.first), plot_y(view, b.min), plot_y(view, b.max), plot_y(view, b.last)};
+        for (int i = 0; i < 4; ++i)
+        {
+            if (i > 0 && ys[i] == ys[i - 1])
+                continue;
+            pt.y = ys[i];
+            points.push_back(pt);
+        }
+    }
+}
+
+void *easyx_plot_create()
+{
+    return new Plot();
+}
+
+void easyx_plot_destroy(void *plot)
+{
+    delete reinterpret_cast<Plot *>(plot);
+}
+
+void easyx_plot_setdata(void *plot, const float *samples, size_t count)
+{
+    Plot *p = reinterpret_cast<Plot *>(plot);
+    if (!p)
+        return;
+
+    p->samples.assign(samples, samples ? samples + count : samples);
+    p->head = 0;
+    p->base = 0;
+    ++p->version;
+}
+
+void easyx_plot_append(void *plot, const float *samples, size_t count)
+{
+    Plot *p = reinterpret_cast<Plot *>(plot);
+    if (!p || !samples || count == 0)
+        return;
+
+    // 追加不改变已有样本，列缓存只需更新末尾
+    p->samples.insert(p->samples.end(), samples, samples + count);
+}
+
+void easyx_plot_trim(void *plot, size_t keep)
+{
+    Plot *p = reinterpret_cast<Plot *>(plot);
+    if (!p || p->count() <= keep)
+        return;
+
+    size_t drop = p->count() - keep;
+    p->head += drop;
+    p->base += static_cast<int64_t>(drop);
+
+    if (p->head > p->samples.size() / 2)
+    {
+        p->samples.erase(p->samples.begin(), p->samples.begin() + p->head);
+        p->head = 0;
+    }
+}
+
+void easyx_plot_clear(void *plot)
+{
+    Plot *p = reinterpret_cast<Plot *>(plot);
+    if (!p)
+        return;
+
+    p->samples.clear();
+    p->head = 0;
+    p->base = 0;
+    ++p->version;
+}
+
+size_t easyx_plot_count(void *plot)
+{
+    Plot *p = reinterpret_cast<Plot *>(plot);
+    return p ? p->count() : 0;
+}
+
+int64_t easyx_plot_firstindex(void *plot)
+{
+    Plot *p = reinterpret_cast<Plot *>(plot);
+    return p ? p->base : 0;
+}
+
+int easyx_plot_draw(void *plot, const EasyXPlotView *view)
+{
+    PROFILE_SCOPE(EASYX_PROF_PRIMITIVES);
+    Plot *p = reinterpret_cast<Plot *>(plot);
+    if (!p || !view || view->width <= 0 || view->height <= 0)
+        return 0;
+
+    bool reuse = p->pointsValid && memcmp(&p->pointsView, view, sizeof(*view)) == 0 &&
+                 p->pointsEnd == p->end() && p->pointsBase == p->base && p->pointsVersion == p->version;
+    if (!reuse)
+    {
+        plot_build(p, view);
+        p->pointsView = *view;
+        p->pointsEnd = p->end();
+        p->pointsBase = p->base;
+        p->pointsVersion = p->version;
+        p->pointsValid = true;
+    }
+
+    int count = static_cast<int>(p->points.size());
+    if (count >= 2)
+        easyx_polyline(p->points.data(), count);
+    return count;
+}
@@ -0,0 +1,341 @@
+// easyx_present.cpp
+// 多缓冲呈现：绘图线程渲染到离屏图像，呈现线程把已完成的帧 BitBlt 到窗口
+
+#include "easyx_wrapper.h"
+#include "easyx_profiler.h"
+#include <string.h>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <windows.h>
+#include <dwmapi.h>
+#include <tchar.h>
+#include "../EasyX_26.1.1/include/easyx.h"
+
+#define PRESENT_MIN_BUFFERS 2
+#define PRESENT_MAX_BUFFERS 4
+
+enum PresentState
+{
+    PRESENT_FREE,       // 可以渲染
+    PRESENT_RENDERING,  // 绘图线程正在渲染
+    PRESENT_READY,      // 已完成，等待呈现
+    PRESENT_PRESENTING, // 呈现线程正在复制到窗口
+};
+
+struct PresentBuffer
+{
+    IMAGE *image;
+    HDC hdc;
+    int state;
+};
+
+struct Presenter
+{
+    std::mutex mutex;
+    std::condition_variable ready; // 有帧等待呈现或需要停止
+    std::condition_variable freed; // 有缓冲区变为空闲
+    std::thread thread;
+    bool running;
+    bool stopping;
+
+    HWND hwnd;
+    int width, height;
+    int mode;
+    bool vsync; // 提交时从帧调度取得，呈现线程不直接读取帧调度的状态
+    std::vector<PresentBuffer> buffers;
+    std::deque<int> queue; // 等待呈现的缓冲区，按完成顺序
+    int rendering;         // 绘图线程持有的缓冲区，-1 表示没有
+    int last;              // 最近呈现且尚未被重新取出的缓冲区，-1 表示没有
+    void *savedWorking;    // begin 之前的工作图像
+
+    LONGLONG frequency;
+    EasyXPresenterStats stats;
+
+    Presenter() : running(false), stopping(false), hwnd(NULL), width(0), height(0), mode(EASYX_PRESENT_LATENCY),
+                  vsync(false), rendering(-1), last(-1), savedWorking(NULL), frequency(0)
+    {
+        memset(&stats, 0, sizeof(stats));
+    }
+
+    ~Presenter()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        ready.notify_all();
+        if (thread.joinable())
+            thread.join();
+    }
+};
+
+static Presenter g_presenter;
+
+static inline LONGLONG present_now()
+{
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    return counter.QuadPart;
+}
+
+static inline double present_ms(LONGLONG ticks)
+{
+    return static_cast<double>(ticks) * 1000.0 / static_cast<double>(g_presenter.frequency);
+}
+
+// 呈现线程：取出最早完成的帧复制到窗口。缓冲区的状态保证同一时刻只有一个线程使用它的 HDC
+static void presenter_thread()
+{
+    std::unique_lock<std::mutex> lock(g_presenter.mutex);
+    for (;;)
+    {
+        while (!g_presenter.stopping && g_presenter.queue.empty())
+            g_presenter.ready.wait(lock);
+        if (g_presenter.stopping)
+            break;
+
+        int index = g_presenter.queue.front();
+        g_presenter.queue.pop_front();
+        PresentBuffer &buffer = g_presenter.buffers[index];
+        buffer.state = PRESENT_PRESENTING;
+        bool vsync = g_presenter.vsync;
+
+        lock.unlock();
+        LONGLONG start = present_now();
+        HDC window = GetDC(g_presenter.hwnd);
+        if (window)
+        {
+            BitBlt(window, 0, 0, g_presenter.width, g_presenter.height, buffer.hdc, 0, 0, SRCCOPY);
+            ReleaseDC(g_presenter.hwnd, window);
+        }
+        // 等待 DWM 完成合成，每次刷新最多呈现一帧，多余的帧在低延迟模式下被替换
+        if (vsync)
+            DwmFlush();
+        double elapsed = present_ms(present_now() - start);
+        lock.lock();
+
+        buffer.state = PRESENT_FREE;
+        g_presenter.last = index;
+        g_presenter.stats.presented++;
+        g_presenter.stats.presentMs = elapsed;
+        g_presenter.freed.notify_one();
+    }
+}
+
+// 取出空闲的缓冲区，优先不取最近呈现的一个，停止时可以用它恢复窗口内容。调用时需持有锁
+static int presenter_take_free()
+{
+    int found = -1;
+    for (size_t i = 0; i < g_presenter.buffers.size(); ++i)
+    {
+        if (g_presenter.buffers[i].state != PRESENT_FREE)
+            continue;
+        found = static_cast<int>(i);
+        if (found != g_presenter.last)
+            break;
+    }
+    if (found == g_presenter.last)
+        g_presenter.last = -1;
+    return found;
+}
+
+int easyx_presenter_start(int buffers, int mode)
+{
+    PROFILE_SCOPE(EASYX_PROF_FLUSH);
+    if (g_presenter.running)
+        return EASYX_PRESENT_ERR_RUNNING;
+
+    // getwidth 返回的是工作图像的大小，窗口大小从客户区取得
+    HWND hwnd = easyx_gethwnd();
+    RECT client = {0, 0, 0, 0};
+    if (hwnd)
+        GetClientRect(hwnd, &client);
+    int width = client.right - client.left;
+    int height = client.bottom - client.top;
+    if (!hwnd || width <= 0 || height <= 0)
+        return EASYX_PRESENT_ERR_INVALID;
+
+    if (buffers < PRESENT_MIN_BUFFERS)
+        buffers = PRESENT_MIN_BUFFERS;
+    if (buffers > PRESENT_MAX_BUFFERS)
+        buffers = PRESENT_MAX_BUFFERS;
+
+    if (g_presenter.frequency == 0)
+    {
+        LARGE_INTEGER frequency;
+        QueryPerformanceFrequency(&frequency);
+        g_presenter.frequency = frequency.QuadPart;
+    }
+
+    // 图像在绘图线程中创建，呈现线程只使用它们的 HDC。
+    // 缓冲区会被设为工作图像，通过包装层创建和销毁，销毁时清除状态缓存中以它为键的项
+    g_presenter.buffers.resize(buffers);
+    for (int i = 0; i < buffers; ++i)
+    {
+        PresentBuffer &buffer = g_presenter.buffers[i];
+        buffer.image = reinterpret_cast<IMAGE *>(easyx_create_image(width, height));
+        buffer.hdc = GetImageHDC(buffer.image);
+        buffer.state = PRESENT_FREE;
+    }
+
+    g_presenter.hwnd = hwnd;
+    g_presenter.width = width;
+    g_presenter.height = height;
+    g_presenter.mode = mode == EASYX_PRESENT_THROUGHPUT ? EASYX_PRESENT_THROUGHPUT : EASYX_PRESENT_LATENCY;
+    g_presenter.queue.clear();
+    g_presenter.rendering = -1;
+    g_presenter.last = -1;
+    g_presenter.stopping = false;
+    memset(&g_presenter.stats, 0, sizeof(g_presenter.stats));
+    g_presenter.running = true;
+    g_presenter.thread = std::thread(presenter_thread);
+    return 0;
+}
+
+void easyx_presenter_stop()
+{
+    PROFILE_SCOPE(EASYX_PROF_FLUSH);
+    if (!g_presenter.running)
+        return;
+
+    if (g_presenter.rendering >= 0)
+        easyx_presenter_submit();
+
+    // 先呈现完排队的帧，再停止线程
+    {
+        std::unique_lock<std::mutex> lock(g_presenter.mutex);
+        while (!g_presenter.queue.empty())
+            g_presenter.freed.wait(lock);
+        g_presenter.stopping = true;
+    }
+    g_presenter.ready.notify_all();
+    g_presenter.thread.join();
+
+    // 把最后呈现的帧复制到窗口图像，窗口重绘时显示的内容保持一致。
+    // 缓冲区按客户区大小创建，窗口图像可能与之不同，只复制重叠的部分
+    if (g_presenter.last >= 0)
+    {
+        IMAGE *image = g_presenter.buffers[g_presenter.last].image;
+        DWORD *dst = GetImageBuffer(NULL);
+        int dstWidth = 0, dstHeight = 0;
+        easyx_getdevicesize(NULL, &dstWidth, &dstHeight);
+        if (dst)
+        {
+            const DWORD *src = GetImageBuffer(image);
+            int width = dstWidth < g_presenter.width ? dstWidth : g_presenter.width;
+            int height = dstHeight < g_presenter.height ? dstHeight : g_presenter.height;
+            for (int y = 0; y < height; ++y)
+                memcpy(dst + static_cast<size_t>(y) * dstWidth, src + static_cast<size_t>(y) * g_presenter.width, sizeof(DWORD) * width);
+            easyx_dirty_markall();
+        }
+    }
+
+    for (size_t i = 0; i < g_presenter.buffers.size(); ++i)
+        easyx_destroy_image(g_presenter.buffers[i].image);
+    g_presenter.buffers.clear();
+    g_presenter.queue.clear();
+    g_presenter.running = false;
+    g_presenter.stopping = false;
+}
+
+int easyx_presenter_running()
+{
+    return g_presenter.running ? 1 : 0;
+}
+
+void *easyx_presenter_begin()
+{
+    PROFILE_SCOPE(EASYX_PROF_FLUSH);
+    if (!g_presenter.running)
+        return NULL;
+    if (g_presenter.rendering >= 0)
+        return g_presenter.buffers[g_presenter.rendering].image;
+
+    int index;
+    {
+        std::unique_lock<std::mutex> lock(g_presenter.mutex);
+        index = presenter_take_free();
+
+        // 低延迟模式下没有空闲缓冲区时，取回最早排队的帧重新渲染，它被更新的一帧取代
+        if (index < 0 && g_presenter.mode == EASYX_PRESENT_LATENCY && !g_presenter.queue.empty())
+        {
+            index = g_presenter.queue.front();
+            g_presenter.queue.pop_front();
+            g_presenter.stats.dropped++;
+        }
+
+        if (index < 0)
+        {
+            LONGLONG start = present_now();
+            g_presenter.stats.stalls++;
+            while ((index = presenter_take_free()) < 0)
+                g_presenter.freed.wait(lock);
+            g_presenter.stats.waitMs += present_ms(present_now() - start);
+        }
+        g_presenter.buffers[index].state = PRESENT_RENDERING;
+    }
+
+    g_presenter.rendering = index;
+    g_presenter.savedWorking = easyx_getworkingimage();
+    IMAGE *image = g_presenter.buffers[index].image;
+    easyx_setworkingimage(image);
+    return image;
+}
+
+void easyx_presenter_submit()
+{
+    PROFILE_SCOPE(EASYX_PROF_FLUSH);
+    if (!g_presenter.running || g_presenter.rendering < 0)
+        return;
+
+    int index = g_presenter.rendering;
+    g_presenter.rendering = -1;
+    easyx_setworkingimage(g_presenter.savedWorking);
+    g_presenter.savedWorking = NULL;
+
+    {
+        std::lock_guard<std::mutex> lock(g_presenter.mutex);
+        // 低延迟模式只保留最新完成的一帧，呈现线程还没取走的旧帧直接丢弃
+        if (g_presenter.mode == EASYX_PRESENT_LATENCY)
+        {
+            while (!g_presenter.queue.empty())
+            {
+                g_presenter.buffers[g_presenter.queue.front()].state = PRESENT_FREE;
+                g_presenter.queue.pop_front();
+                g_presenter.stats.dropped++;
+            }
+            g_presenter.freed.notify_one();
+        }
+        g_presenter.buffers[index].state = PRESENT_READY;
+        g_presenter.queue.push_back(index);
+        g_presenter.vsync = easyx_frame_getvsync() != 0;
+        g_presenter.stats.submitted++;
+    }
+    g_presenter.ready.notify_one();
+}
+
+void easyx_presenter_setmode(int mode)
+{
+    std::lock_guard<std::mutex> lock(g_presenter.mutex);
+    g_presenter.mode = mode == EASYX_PRESENT_THROUGHPUT ? EASYX_PRESENT_THROUGHPUT : EASYX_PRESENT_LATENCY;
+}
+
+int easyx_presenter_getmode()
+{
+    std::lock_guard<std::mutex> lock(g_presenter.mutex);
+    return g_presenter.mode;
+}
+
+void easyx_presenter_getstats(EasyXPresenterStats *pStats)
+{
+    if (!pStats)
+        return;
+
+    std::lock_guard<std::mutex> lock(g_presenter.mutex);
+    *pStats = g_presenter.stats;
+    pStats->buffers = static_cast<int>(g_presenter.buffers.size());
+    pStats->queued = static_cast<int>(g_presenter.queue.size());
+}
@@ -0,0 +1,70 @@
+// easyx_profiler.cpp
+// 包装层性能分析数据的快照和重置
+
+#include "easyx_profiler.h"
+#include <windows.h>
+
+#ifdef EASYX_PROFILER
+// 静态存储期的对象零初始化
+ProfilerState g_profiler;
+thread_local ProfileScope *t_profile_top = NULL;
+#endif
+
+int easyx_profiler_available()
+{
+#ifdef EASYX_PROFILER
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+void easyx_profiler_reset()
+{
+#ifdef EASYX_PROFILER
+    for (int i = 0; i < EASYX_PROF_CATEGORIES; ++i)
+    {
+        g_profiler.calls[i].store(0, std::memory_order_relaxed);
+        g_profiler.ticks[i].store(0, std::memory_order_relaxed);
+    }
+    g_profiler.resetAt.store(profile_now(), std::memory_order_relaxed);
+#endif
+}
+
+void easyx_profiler_snapshot(EasyXProfilerSnapshot *pSnapshot, int reset)
+{
+    if (!pSnapshot)
+        return;
+
+    EasyXProfilerSnapshot empty = {};
+    *pSnapshot = empty;
+
+#ifdef EASYX_PROFILER
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    double toMs = 1000.0 / static_cast<double>(frequency.QuadPart);
+
+    // 重置时用 exchange 取出计数，读取和清零之间其他线程累加的部分不会丢失
+    for (int i = 0; i < EASYX_PROF_CATEGORIES; ++i)
+    {
+        uint64_t calls = reset ? g_profiler.calls[i].exchange(0, std::memory_order_relaxed)
+                               : g_profiler.calls[i].load(std::memory_order_relaxed);
+        LONGLONG ticks = reset ? g_profiler.ticks[i].exchange(0, std::memory_order_relaxed)
+                               : g_profiler.ticks[i].load(std::memory_order_relaxed);
+        pSnapshot->calls[i] = calls;
+        pSnapshot->ms[i] = static_cast<double>(ticks) * toMs;
+    }
+
+    // 首次快照前没有重置过时，从第一次调用快照开始计时
+    LONGLONG now = profile_now();
+    LONGLONG resetAt = 0;
+    if (g_profiler.resetAt.compare_exchange_strong(resetAt, now, std::memory_order_relaxed))
+        resetAt = now;
+    pSnapshot->elapsedMs = static_cast<double>(now - resetAt) * toMs;
+
+    if (reset)
+        g_profiler.resetAt.store(now, std::memory_order_relaxed);
+#else
+    (void)reset;
+#endif
+}
@@ -0,0 +1,67 @@
+// easyx_profiler.h
+// 包装层内部使用的性能分析作用域，不参与绑定生成。
+// 只有定义 EASYX_PROFILER 时才会插桩（easyx-sys 的 profiler 特性），否则 PROFILE_SCOPE 为空
+
+#ifndef EASYX_PROFILER_H
+#define EASYX_PROFILER_H
+
+#include "easyx_wrapper.h"
+
+#ifdef EASYX_PROFILER
+#include <windows.h>
+#include <atomic>
+
+// 插桩的函数也在分块渲染、解码、编码和队列消费等线程上运行，计数器使用 relaxed 原子操作累加
+struct ProfilerState
+{
+    std::atomic<uint64_t> calls[EASYX_PROF_CATEGORIES];
+    std::atomic<LONGLONG> ticks[EASYX_PROF_CATEGORIES];
+    std::atomic<LONGLONG> resetAt;
+};
+
+extern ProfilerState g_profiler;
+
+struct ProfileScope;
+extern thread_local ProfileScope *t_profile_top;
+
+static inline LONGLONG profile_now()
+{
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    return counter.QuadPart;
+}
+
+// 记录所在函数的调用次数和独占时间，嵌套调用的时间只计入内层函数的类别
+struct ProfileScope
+{
+    int category;
+    LONGLONG start;
+    LONGLONG child;
+    ProfileScope *parent;
+
+    explicit ProfileScope(int cat) : category(cat), child(0), parent(t_profile_top)
+    {
+        t_profile_top = this;
+        start = profile_now();
+    }
+
+    ~ProfileScope()
+    {
+        LONGLONG elapsed = profile_now() - start;
+        g_profiler.calls[category].fetch_add(1, std::memory_order_relaxed);
+        g_profiler.ticks[category].fetch_add(elapsed - child, std::memory_order_relaxed);
+        if (parent)
+            parent->child += elapsed;
+        t_profile_top = parent;
+    }
+
+    ProfileScope(const ProfileScope &) = delete;
+    ProfileScope &operator=(const ProfileScope &) = delete;
+};
+
+#define PROFILE_SCOPE(category) ProfileScope profile_scope_(category)
+#else
+#define PROFILE_SCOPE(category) ((void)0)
+#endif
+
+#endif // EASYX_PROFILER_H
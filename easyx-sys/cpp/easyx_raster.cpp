@@ -0,0 +1,1025 @@
+// easyx_raster.cpp
+// 软件光栅化，直接写入当前工作图像的像素缓冲区，绕过 GDI
+
+#include "easyx_wrapper.h"
+#include "easyx_profiler.h"
+#include "easyx_raster.h"
+#include <math.h>
+#include <string.h>
+#include <windows.h>
+#include <tchar.h>
+#include "../EasyX_26.1.1/include/easyx.h"
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define RASTER_X86 1
+#include <emmintrin.h>
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+// GCC/Clang 需要为 AVX2 内核单独开启指令集，MSVC 无需开关即可使用内部函数
+#if defined(__GNUC__) || defined(__clang__)
+#define RASTER_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define RASTER_TARGET_AVX2
+#endif
+
+typedef void (*RasterSpanFn)(DWORD *dst, int count, DWORD pixel);
+typedef void (*RasterBlendFn)(DWORD *dst, const DWORD *src, int count, DWORD globalAlpha);
+typedef void (*RasterSwapFn)(DWORD *dst, const DWORD *src, int count);
+
+// 一行像素的比较结果，first/last 为超出容差的第一个和最后一个像素，没有时为 -1
+struct RasterDiffRow
+{
+    int first, last;
+    DWORD maxDelta;
+};
+typedef int (*RasterDiffFn)(const DWORD *a, const DWORD *b, int count, DWORD tolerance, RasterDiffRow *row);
+
+// 标量内核
+static void raster_span_scalar(DWORD *dst, int count, DWORD pixel)
+{
+    for (int i = 0; i < count; ++i)
+        dst[i] = pixel;
+}
+
+// 源像素为非预乘的 ARGB，有效透明度 a = srcA * globalAlpha / 255。
+// 按预乘形式计算 out = src * a + dst * (255 - a)，目标透明度按 255 参与混合，
+// 结果与 "源预乘后叠加" 一致。除以 255 使用 (t + (t >> 8)) >> 8 的精确近似
+static inline DWORD raster_div255(DWORD t)
+{
+    t += 128;
+    return (t + (t >> 8)) >> 8;
+}
+
+static void raster_blend_scalar(DWORD *dst, const DWORD *src, int count, DWORD globalAlpha)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        DWORD s = src[i];
+        DWORD a = raster_div255((s >> 24) * globalAlpha);
+        if (a == 0)
+            continue;
+        if (a == 255)
+        {
+            dst[i] = s | 0xFF000000;
+            continue;
+        }
+
+        DWORD d = dst[i];
+        DWORD inv = 255 - a;
+        DWORD r = raster_div255(((s >> 16) & 0xFF) * a + ((d >> 16) & 0xFF) * inv);
+        DWORD g = raster_div255(((s >> 8) & 0xFF) * a + ((d >> 8) & 0xFF) * inv);
+        DWORD b = raster_div255((s & 0xFF) * a + (d & 0xFF) * inv);
+        DWORD da = raster_div255(255 * a + (d >> 24) * inv);
+        dst[i] = (da << 24) | (r << 16) | (g << 8) | b;
+    }
+}
+
+// 交换红蓝通道，用于 0xAARRGGBB 与 0xAABBGGRR 之间的转换，dst 可以与 src 相同
+static void raster_swap_scalar(DWORD *dst, const DWORD *src, int count)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        DWORD p = src[i];
+        dst[i] = (p & 0xFF00FF00) | ((p >> 16) & 0xFF) | ((p & 0xFF) << 16);
+    }
+}
+
+// 红、绿、蓝通道差值的最大值，透明度通道不参与比较（GDI 绘制后透明度通常为 0）
+static inline DWORD raster_delta(DWORD x, DWORD y)
+{
+    DWORD delta = 0;
+    for (int shift = 0; shift < 24; shift += 8)
+    {
+        int cx = (x >> shift) & 0xFF;
+        int cy = (y >> shift) & 0xFF;
+        DWORD d = static_cast<DWORD>(cx > cy ? cx - cy : cy - cx);
+        if (d > delta)
+            delta = d;
+    }
+    return delta;
+}
+
+// 比较 [start, count) 的像素，返回超出容差的像素数
+static int raster_diff_tail(const DWORD *a, const DWORD *b, int start, int count, DWORD tolerance, RasterDiffRow *row)
+{
+    int differ = 0;
+    for (int i = start; i < count; ++i)
+    {
+        if (((a[i] ^ b[i]) & 0x00FFFFFF) == 0)
+            continue;
+        DWORD delta = raster_delta(a[i], b[i]);
+        if (delta > row->maxDelta)
+            row->maxDelta = delta;
+        if (delta > tolerance)
+        {
+            if (row->first < 0)
+                row->first = i;
+            row->last = i;
+            ++differ;
+        }
+    }
+    return differ;
+}
+
+static int raster_diff_scalar(const DWORD *a, const DWORD *b, int count, DWORD tolerance, RasterDiffRow *row)
+{
+    return raster_diff_tail(a, b, 0, count, tolerance, row);
+}
+
+// 按向量比较结果的位掩码记录超出容差的像素
+static inline int raster_diff_mask(int mask, int base, RasterDiffRow *row)
+{
+    int differ = 0;
+    for (int k = 0; mask; ++k, mask >>= 1)
+    {
+        if (!(mask & 1))
+            continue;
+        if (row->first < 0)
+            row->first = base + k;
+        row->last = base + k;
+        ++differ;
+    }
+    return differ;
+}
+
+#ifdef RASTER_X86
+// SSE2 内核，每次写入 4 个像素
+static void raster_span_sse2(DWORD *dst, int count, DWORD pixel)
+{
+    // 先按标量写到 16 字节对齐
+    while (count > 0 && (reinterpret_cast<uintptr_t>(dst) & 15) != 0)
+    {
+        *dst++ = pixel;
+        --count;
+    }
+
+    __m128i v = _mm_set1_epi32(static_cast<int>(pixel));
+    for (; count >= 8; count -= 8, dst += 8)
+    {
+        _mm_store_si128(reinterpret_cast<__m128i *>(dst), v);
+        _mm_store_si128(reinterpret_cast<__m128i *>(dst + 4), v);
+    }
+    if (count >= 4)
+    {
+        _mm_store_si128(reinterpret_cast<__m128i *>(dst), v);
+        dst += 4;
+        count -= 4;
+    }
+
+    for (int i = 0; i < count; ++i)
+        dst[i] = pixel;
+}
+
+// AVX2 内核，每次写入 8 个像素
+RASTER_TARGET_AVX2 static void raster_span_avx2(DWORD *dst, int count, DWORD pixel)
+{
+    if (count < 8)
+    {
+        for (int i = 0; i < count; ++i)
+            dst[i] = pixel;
+        return;
+    }
+
+    __m256i v = _mm256_set1_epi32(static_cast<int>(pixel));
+    // 首尾各写一次非对齐的 8 像素，中间部分按 32 字节对齐写入
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst), v);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + count - 8), v);
+
+    DWORD *p = reinterpret_cast<DWORD *>((reinterpret_cast<uintptr_t>(dst) + 32) & ~static_cast<uintptr_t>(31));
+    DWORD *end = dst + count - 8;
+    for (; p + 16 <= end; p += 16)
+    {
+        _mm256_store_si256(reinterpret_cast<__m256i *>(p), v);
+        _mm256_store_si256(reinterpret_cast<__m256i *>(p + 8), v);
+    }
+    for (; p < end; p += 8)
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), v);
+}
+
+// 混合 2 个像素（16 位通道），s16 的透明度通道已置为 255
+static inline __m128i raster_blend2_sse2(__m128i s16, __m128i d16, __m128i a16)
+{
+    const __m128i c128 = _mm_set1_epi16(128);
+    const __m128i c255 = _mm_set1_epi16(255);
+
+    __m128i inv = _mm_sub_epi16(c255, a16);
+    __m128i t = _mm_add_epi16(_mm_mullo_epi16(s16, a16), _mm_mullo_epi16(d16, inv));
+    t = _mm_add_epi16(t, c128);
+    return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+// SSE2 混合内核，每次混合 4 个像素
+static void raster_blend_sse2(DWORD *dst, const DWORD *src, int count, DWORD globalAlpha)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i alphaMask = _mm_set1_epi32(static_cast<int>(0xFF000000));
+    const __m128i ga = _mm_set1_epi16(static_cast<short>(globalAlpha));
+    const __m128i c128 = _mm_set1_epi16(128);
+
+    int i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        __m128i sa = _mm_and_si128(s, alphaMask);
+
+        // 整组全透明直接跳过，整组不透明直接复制
+        int opaque = _mm_movemask_epi8(_mm_cmpeq_epi32(sa, alphaMask));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(sa, zero)) == 0xFFFF)
+            continue;
+        if (opaque == 0xFFFF && globalAlpha == 255)
+        {
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), s);
+            continue;
+        }
+
+        __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i *>(dst + i));
+        __m128i so = _mm_or_si128(s, alphaMask);
+
+        __m128i slo = _mm_unpacklo_epi8(so, zero), shi = _mm_unpackhi_epi8(so, zero);
+        __m128i dlo = _mm_unpacklo_epi8(d, zero), dhi = _mm_unpackhi_epi8(d, zero);
+
+        // 把每个像素的透明度广播到它的 4 个通道，再乘以全局透明度
+        __m128i alo = _mm_unpacklo_epi8(s, zero), ahi = _mm_unpackhi_epi8(s, zero);
+        alo = _mm_shufflehi_epi16(_mm_shufflelo_epi16(alo, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+        ahi = _mm_shufflehi_epi16(_mm_shufflelo_epi16(ahi, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+        alo = _mm_add_epi16(_mm_mullo_epi16(alo, ga), c128);
+        ahi = _mm_add_epi16(_mm_mullo_epi16(ahi, ga), c128);
+        alo = _mm_srli_epi16(_mm_add_epi16(alo, _mm_srli_epi16(alo, 8)), 8);
+        ahi = _mm_srli_epi16(_mm_add_epi16(ahi, _mm_srli_epi16(ahi, 8)), 8);
+
+        __m128i lo = raster_blend2_sse2(slo, dlo, alo);
+        __m128i hi = raster_blend2_sse2(shi, dhi, ahi);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_packus_epi16(lo, hi));
+    }
+
+    raster_blend_scalar(dst + i, src + i, count - i, globalAlpha);
+}
+
+RASTER_TARGET_AVX2 static inline __m256i raster_blend2_avx2(__m256i s16, __m256i d16, __m256i a16)
+{
+    const __m256i c128 = _mm256_set1_epi16(128);
+    const __m256i c255 = _mm256_set1_epi16(255);
+
+    __m256i inv = _mm256_sub_epi16(c255, a16);
+    __m256i t = _mm256_add_epi16(_mm256_mullo_epi16(s16, a16), _mm256_mullo_epi16(d16, inv));
+    t = _mm256_add_epi16(t, c128);
+    return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+}
+
+// AVX2 混合内核，每次混合 8 个像素。解包和打包都在 128 位通道内进行，像素顺序保持不变
+RASTER_TARGET_AVX2 static void raster_blend_avx2(DWORD *dst, const DWORD *src, int count, DWORD globalAlpha)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i alphaMask = _mm256_set1_epi32(static_cast<int>(0xFF000000));
+    const __m256i ga = _mm256_set1_epi16(static_cast<short>(globalAlpha));
+    const __m256i c128 = _mm256_set1_epi16(128);
+
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+        __m256i sa = _mm256_and_si256(s, alphaMask);
+
+        unsigned int opaque = static_cast<unsigned int>(_mm256_movemask_epi8(_mm256_cmpeq_epi32(sa, alphaMask)));
+        if (static_cast<unsigned int>(_mm256_movemask_epi8(_mm256_cmpeq_epi32(sa, zero))) == 0xFFFFFFFFu)
+            continue;
+        if (opaque == 0xFFFFFFFFu && globalAlpha == 255)
+        {
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), s);
+            continue;
+        }
+
+        __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(dst + i));
+        __m256i so = _mm256_or_si256(s, alphaMask);
+
+        __m256i slo = _mm256_unpacklo_epi8(so, zero), shi = _mm256_unpackhi_epi8(so, zero);
+        __m256i dlo = _mm256_unpacklo_epi8(d, zero), dhi = _mm256_unpackhi_epi8(d, zero);
+
+        __m256i alo = _mm256_unpacklo_epi8(s, zero), ahi = _mm256_unpackhi_epi8(s, zero);
+        alo = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(alo, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+        ahi = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(ahi, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+        alo = _mm256_add_epi16(_mm256_mullo_epi16(alo, ga), c128);
+        ahi = _mm256_add_epi16(_mm256_mullo_epi16(ahi, ga), c128);
+        alo = _mm256_srli_epi16(_mm256_add_epi16(alo, _mm256_srli_epi16(alo, 8)), 8);
+        ahi = _mm256_srli_epi16(_mm256_add_epi16(ahi, _mm256_srli_epi16(ahi, 8)), 8);
+
+        __m256i lo = raster_blend2_avx2(slo, dlo, alo);
+        __m256i hi = raster_blend2_avx2(shi, dhi, ahi);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), _mm256_packus_epi16(lo, hi));
+    }
+
+    raster_blend_scalar(dst + i, src + i, count - i, globalAlpha);
+}
+
+// SSE2 通道交换内核，每次转换 4 个像素
+static void raster_swap_sse2(DWORD *dst, const DWORD *src, int count)
+{
+    const __m128i keep = _mm_set1_epi32(static_cast<int>(0xFF00FF00));
+    const __m128i low = _mm_set1_epi32(0xFF);
+
+    int i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        __m128i r = _mm_and_si128(_mm_srli_epi32(p, 16), low);
+        __m128i b = _mm_slli_epi32(_mm_and_si128(p, low), 16);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_or_si128(_mm_and_si128(p, keep), _mm_or_si128(r, b)));
+    }
+
+    raster_swap_scalar(dst + i, src + i, count - i);
+}
+
+// AVX2 通道交换内核，每次转换 8 个像素
+RASTER_TARGET_AVX2 static void raster_swap_avx2(DWORD *dst, const DWORD *src, int count)
+{
+    const __m256i keep = _mm256_set1_epi32(static_cast<int>(0xFF00FF00));
+    const __m256i low = _mm256_set1_epi32(0xFF);
+
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256i p = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+        __m256i r = _mm256_and_si256(_mm256_srli_epi32(p, 16), low);
+        __m256i b = _mm256_slli_epi32(_mm256_and_si256(p, low), 16);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), _mm256_or_si256(_mm256_and_si256(p, keep), _mm256_or_si256(r, b)));
+    }
+
+    raster_swap_scalar(dst + i, src + i, count - i);
+}
+
+// SSE2 比较内核，每次比较 4 个像素。两个方向的饱和减法相或得到每个通道的差值，
+// 再减去容差，结果不为 0 的像素超出容差
+static int raster_diff_sse2(const DWORD *a, const DWORD *b, int count, DWORD tolerance, RasterDiffRow *row)
+{
+    const __m128i rgb = _mm_set1_epi32(0x00FFFFFF);
+    const __m128i tol = _mm_set1_epi8(static_cast<char>(tolerance));
+    const __m128i zero = _mm_setzero_si128();
+    __m128i maxDelta = zero;
+
+    int differ = 0;
+    int i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+        __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i));
+        __m128i d = _mm_and_si128(_mm_or_si128(_mm_subs_epu8(x, y), _mm_subs_epu8(y, x)), rgb);
+        maxDelta = _mm_max_epu8(maxDelta, d);
+        __m128i over = _mm_cmpeq_epi32(_mm_subs_epu8(d, tol), zero);
+        int mask = ~_mm_movemask_ps(_mm_castsi128_ps(over)) & 0xF;
+        if (mask)
+            differ += raster_diff_mask(mask, i, row);
+    }
+
+    uint8_t lanes[16];
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(lanes), maxDelta);
+    for (int k = 0; k < 16; ++k)
+        if (lanes[k] > row->maxDelta)
+            row->maxDelta = lanes[k];
+
+    return differ + raster_diff_tail(a, b, i, count, tolerance, row);
+}
+
+// AVX2 比较内核，每次比较 8 个像素
+RASTER_TARGET_AVX2 static int raster_diff_avx2(const DWORD *a, const DWORD *b, int count, DWORD tolerance, RasterDiffRow *row)
+{
+    const __m256i rgb = _mm256_set1_epi32(0x00FFFFFF);
+    const __m256i tol = _mm256_set1_epi8(static_cast<char>(tolerance));
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i maxDelta = zero;
+
+    int differ = 0;
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+        __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i));
+        __m256i d = _mm256_and_si256(_mm256_or_si256(_mm256_subs_epu8(x, y), _mm256_subs_epu8(y, x)), rgb);
+        maxDelta = _mm256_max_epu8(maxDelta, d);
+        __m256i over = _mm256_cmpeq_epi32(_mm256_subs_epu8(d, tol), zero);
+        int mask = ~_mm256_movemask_ps(_mm256_castsi256_ps(over)) & 0xFF;
+        if (mask)
+            differ += raster_diff_mask(mask, i, row);
+    }
+
+    uint8_t lanes[32];
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(lanes), maxDelta);
+    for (int k = 0; k < 32; ++k)
+        if (lanes[k] > row->maxDelta)
+            row->maxDelta = lanes[k];
+
+    return differ + raster_diff_tail(a, b, i, count, tolerance, row);
+}
+#endif
+
+// 检测 CPU 支持的最高内核级别
+static int raster_detect()
+{
+#ifdef RASTER_X86
+    int level = EASYX_RASTER_SCALAR;
+    unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    unsigned int maxLeaf = static_cast<unsigned int>(info[0]);
+    __cpuid(info, 1);
+    ecx = static_cast<unsigned int>(info[2]);
+    edx = static_cast<unsigned int>(info[3]);
+#else
+    unsigned int maxLeaf = __get_cpuid_max(0, 0);
+    __get_cpuid(1, &eax, &ebx, &ecx, &edx);
+#endif
+
+    if (edx & (1u << 26))
+        level = EASYX_RASTER_SSE2;
+
+    // AVX 需要操作系统通过 XSAVE 保存 YMM 寄存器
+    bool osxsave = (ecx & (1u << 27)) != 0;
+    bool avx = (ecx & (1u << 28)) != 0;
+    if (osxsave && avx && maxLeaf >= 7)
+    {
+#if defined(_MSC_VER)
+        unsigned long long xcr0 = _xgetbv(0);
+        __cpuidex(info, 7, 0);
+        ebx = static_cast<unsigned int>(info[1]);
+#else
+        unsigned int xlo, xhi;
+        __asm__ volatile("xgetbv" : "=a"(xlo), "=d"(xhi) : "c"(0));
+        unsigned long long xcr0 = (static_cast<unsigned long long>(xhi) << 32) | xlo;
+        __cpuid_count(7, 0, eax, ebx, ecx, edx);
+#endif
+        if ((xcr0 & 6) == 6 && (ebx & (1u << 5)))
+            level = EASYX_RASTER_AVX2;
+    }
+
+    return level;
+#else
+    return EASYX_RASTER_SCALAR;
+#endif
+}
+
+struct RasterState
+{
+    bool ready;
+    int supported;
+    int level;
+    RasterSpanFn span;
+    RasterBlendFn blend;
+    RasterSwapFn swap;
+    RasterDiffFn diff;
+};
+
+static RasterState g_raster = {false, EASYX_RASTER_SCALAR, EASYX_RASTER_SCALAR, raster_span_scalar, raster_blend_scalar, raster_swap_scalar, raster_diff_scalar};
+
+static void raster_select(int level)
+{
+    g_raster.level = level;
+    switch (level)
+    {
+#ifdef RASTER_X86
+    case EASYX_RASTER_AVX2:
+        g_raster.span = raster_span_avx2;
+        g_raster.blend = raster_blend_avx2;
+        g_raster.swap = raster_swap_avx2;
+        g_raster.diff = raster_diff_avx2;
+        break;
+    case EASYX_RASTER_SSE2:
+        g_raster.span = raster_span_sse2;
+        g_raster.blend = raster_blend_sse2;
+        g_raster.swap = raster_swap_sse2;
+        g_raster.diff = raster_diff_sse2;
+        break;
+#endif
+    default:
+        g_raster.level = EASYX_RASTER_SCALAR;
+        g_raster.span = raster_span_scalar;
+        g_raster.blend = raster_blend_scalar;
+        g_raster.swap = raster_swap_scalar;
+        g_raster.diff = raster_diff_scalar;
+        break;
+    }
+}
+
+static void raster_init()
+{
+    if (g_raster.ready)
+        return;
+    g_raster.supported = raster_detect();
+    raster_select(g_raster.supported);
+    g_raster.ready = true;
+}
+
+RasterTarget raster_target()
+{
+    raster_init();
+
+    RasterTarget target;
+    target.buffer = GetImageBuffer(GetWorkingImage());
+    target.width = getwidth();
+    target.height = getheight();
+    if (!target.buffer)
+        target.width = target.height = 0;
+    return target;
+}
+
+// 指定图像的像素缓冲区，img 为 NULL 时使用当前工作图像
+static RasterTarget raster_image(const IMAGE *img)
+{
+    if (!img)
+        return raster_target();
+
+    raster_init();
+
+    RasterTarget target;
+    target.buffer = GetImageBuffer(img);
+    target.width = img->getwidth();
+    target.height = img->getheight();
+    if (!target.buffer)
+        target.width = target.height = 0;
+    return target;
+}
+
+bool raster_clip(const RasterTarget &target, RasterClip *clip)
+{
+    HDC hdc = GetImageHDC(GetWorkingImage());
+    POINT origin = {0, 0};
+    GetViewportOrgEx(hdc, &origin);
+
+    clip->originX = origin.x;
+    clip->originY = origin.y;
+    clip->left = 0;
+    clip->top = 0;
+    clip->right = target.width;
+    clip->bottom = target.height;
+
+    RECT box;
+    int region = GetClipBox(hdc, &box);
+    if (region == NULLREGION)
+        return false;
+    if (region != ERROR)
+    {
+        if (box.left + origin.x > clip->left)
+            clip->left = box.left + origin.x;
+        if (box.top + origin.y > clip->top)
+            clip->top = box.top + origin.y;
+        if (box.right + origin.x < clip->right)
+            clip->right = box.right + origin.x;
+        if (box.bottom + origin.y < clip->bottom)
+            clip->bottom = box.bottom + origin.y;
+    }
+    return clip->left < clip->right && clip->top < clip->bottom;
+}
+
+void raster_span_row(DWORD *dst, int count, DWORD pixel)
+{
+    raster_init();
+    g_raster.span(dst, count, pixel);
+}
+
+void raster_blend_row(DWORD *dst, const DWORD *src, int count, DWORD globalAlpha)
+{
+    raster_init();
+    g_raster.blend(dst, src, count, globalAlpha);
+}
+
+// 将 [left, left + width) x [top, top + height) 裁剪到图像范围内，
+// skipX/skipY 返回外部缓冲区中被裁掉的列数和行数
+static bool raster_clip_pixels(const RasterTarget &target, int &left, int &top, int &width, int &height, int &skipX, int &skipY)
+{
+    skipX = left < 0 ? -left : 0;
+    skipY = top < 0 ? -top : 0;
+    left += skipX;
+    top += skipY;
+    width -= skipX;
+    height -= skipY;
+    if (left + width > target.width)
+        width = target.width - left;
+    if (top + height > target.height)
+        height = target.height - top;
+    return width > 0 && height > 0;
+}
+
+// 复制一行像素，必要时交换红蓝通道
+static inline void raster_copy_row(DWORD *dst, const DWORD *src, int count, int format)
+{
+    if (format == EASYX_PIXEL_ABGR)
+        g_raster.swap(dst, src, count);
+    else
+        memcpy(dst, src, count * sizeof(DWORD));
+}
+
+// 填充一行 [x1, x2]，包含两端，自动裁剪
+static inline void raster_hspan(const RasterTarget &target, int x1, int x2, int y, DWORD pixel)
+{
+    if (y < 0 || y >= target.height)
+        return;
+    if (x1 > x2)
+    {
+        int t = x1;
+        x1 = x2;
+        x2 = t;
+    }
+    if (x1 < 0)
+        x1 = 0;
+    if (x2 >= target.width)
+        x2 = target.width - 1;
+    if (x1 > x2)
+        return;
+
+    g_raster.span(target.buffer + static_cast<size_t>(y) * target.width + x1, x2 - x1 + 1, pixel);
+}
+
+static void raster_fillrect(const RasterTarget &target, int left, int top, int right, int bottom, DWORD pixel)
+{
+    if (left > right)
+    {
+        int t = left;
+        left = right;
+        right = t;
+    }
+    if (top > bottom)
+    {
+        int t = top;
+        top = bottom;
+        bottom = t;
+    }
+    if (left < 0)
+        left = 0;
+    if (top < 0)
+        top = 0;
+    if (right >= target.width)
+        right = target.width - 1;
+    if (bottom >= target.height)
+        bottom = target.height - 1;
+    if (left > right || top > bottom)
+        return;
+
+    // 覆盖整行时合并为一次连续填充
+    if (left == 0 && right == target.width - 1)
+    {
+        g_raster.span(target.buffer + static_cast<size_t>(top) * target.width, (bottom - top + 1) * target.width, pixel);
+        return;
+    }
+
+    DWORD *row = target.buffer + static_cast<size_t>(top) * target.width + left;
+    int count = right - left + 1;
+    for (int y = top; y <= bottom; ++y, row += target.width)
+        g_raster.span(row, count, pixel);
+}
+
+int easyx_raster_getsupported()
+{
+    raster_init();
+    return g_raster.supported;
+}
+
+int easyx_raster_getlevel()
+{
+    raster_init();
+    return g_raster.level;
+}
+
+int easyx_raster_setlevel(int level)
+{
+    raster_init();
+    if (level > g_raster.supported)
+        level = g_raster.supported;
+    raster_select(level);
+    return g_raster.level;
+}
+
+void easyx_raster_clear(uint32_t color)
+{
+    PROFILE_SCOPE(EASYX_PROF_PRIMITIVES);
+    RasterTarget target = raster_target();
+    g_raster.span(target.buffer, target.width * target.height, BGR(color));
+    easyx_dirty_markall();
+}
+
+void easyx_raster_hline(int x1, int x2, int y, uint32_t color)
+{
+    PROFILE_SCOPE(EASYX_PROF_PRIMITIVES);
+    raster_hspan(raster_target(), x1, x2, y, BGR(color));
+    easyx_dirty_add(x1, y, x2, y);
+}
+
+void easyx_raster_rectangle(int left, int top, int right, int bottom, uint32_t color)
+{
+    PROFILE_SCOPE(EASYX_PROF_PRIMITIVES);
+    RasterTarget target = raster_target();
+    DWORD pixel = BGR(color);
+
+    if (top > bottom)
+    {
+        int t = top;
+        top = bottom;
+        bottom = t;
+    }
+
+    raster_hspan(target, left, right, top, pixel);
+    raster_hspan(target, left, right, bottom, pixel);
+    raster_fillrect(target, left, top + 1, left, bottom - 1, pixel);
+    raster_fillrect(target, right, top + 1, right, bottom - 1, pixel);
+    easyx_dirty_add(left, top, right, bottom);
+}
+
+void easyx_raster_fillrect(int left, int top, int right, int bottom, uint32_t color)
+{
+    PROFILE_SCOPE(EASYX_PROF_PRIMITIVES);
+    raster_fillrect(raster_target(), left, top, right, bottom, BGR(color));
+    easyx_dirty_add(left, top, right, bottom);
+}
+
+void easyx_raster_fillrects(const int32_t *rects, size_t count, uint32_t color)
+{
+    PROFILE_SCOPE(EASYX_PROF_PRIMITIVES);
+    if (!rects)
+        return;
+
+    RasterTarget target = raster_target();
+    DWORD pixel = BGR(color);
+
+    for (size_t i = 0; i < count; ++i, rects += 4)
+    {
+        raster_fillrect(target, rects[0], rects[1], rects[2], rects[3], pixel);
+        easyx_dirty_add(rects[0], rects[1], rects[2], rects[3]);
+    }
+}
+
+void easyx_raster_fillcircle(int x, int y, int radius, uint32_t color)
+{
+    PROFILE_SCOPE(EASYX_PROF_PRIMITIVES);
+    if (radius < 0)
+        return;
+
+    RasterTarget target = raster_target();
+    DWORD pixel = BGR(color);
+
+    // 只遍历落在设备内的行
+    int top = -y > -radius ? -y : -radius;
+    int bottom = target.height - 1 - y < radius ? target.height - 1 - y : radius;
+    // 以像素中心判断是否落在半径 radius + 0.5 的圆内，避免上下顶点只剩一个像素
+    double r2 = (radius + 0.5) * (radius + 0.5);
+
+    for (int dy = top; dy <= bottom; ++dy)
+    {
+        int half = static_cast<int>(sqrt(r2 - static_cast<double>(dy) * dy));
+        raster_hspan(target, x - half, x + half, y + dy, pixel);
+    }
+
+    easyx_dirty_add(x - radius, y - radius, x + radius, y + radius);
+}
+
+void easyx_raster_fillellipse(int left, int top, int right, int bottom, uint32_t color)
+{
+    PROFILE_SCOPE(EASYX_PROF_PRIMITIVES);
+    if (left > right)
+    {
+        int t = left;
+        left = right;
+        right = t;
+    }
+    if (top > bottom)
+    {
+        int t = top;
+        top = bottom;
+        bottom = t;
+    }
+
+    RasterTarget target = raster_target();
+    DWORD pixel = BGR(color);
+
+    double cx = (left + right) * 0.5, cy = (top + bottom) * 0.5;
+    // 外接矩形包含边界像素，半径按像素边缘计算
+    double rx = (right - left + 1) * 0.5, ry = (bottom - top + 1) * 0.5;
+
+    int y0 = top < 0 ? 0 : top;
+    int y1 = bottom >= target.height ? target.height - 1 : bottom;
+
+    for (int y = y0; y <= y1; ++y)
+    {
+        double dy = (y - cy) / ry;
+        double t = 1.0 - dy * dy;
+        double half = t > 0 ? rx * sqrt(t) : 0;
+        int x1 = static_cast<int>(ceil(cx - half));
+        int x2 = static_cast<int>(floor(cx + half));
+        // 过窄的行至少保留中心像素
+        if (x1 > x2)
+            x1 = x2 = static_cast<int>(floor(cx));
+        raster_hspan(target, x1, x2, y, pixel);
+    }
+
+    easyx_dirty_add(left, top, right, bottom);
+}
+
+void easyx_putimage_alpha(int dstX, int dstY, const void *pSrcImg, int srcX, int srcY, int width, int height, uint8_t globalAlpha)
+{
+    PROFILE_SCOPE(EASYX_PROF_IMAGES);
+    const IMAGE *srcImg = reinterpret_cast<const IMAGE *>(pSrcImg);
+    if (!srcImg || globalAlpha == 0)
+        return;
+
+    RasterTarget target = raster_target();
+    const DWORD *src = GetImageBuffer(srcImg);
+    int srcWidth = srcImg->getwidth();
+    int srcHeight = srcImg->getheight();
+    if (!target.buffer || !src)
+        return;
+
+    // 与 putimage 一致，目标坐标为逻辑坐标，需要加上 setorigin 设置的原点
+    RasterClip clip;
+    if (!raster_clip(target, &clip))
+        return;
+    dstX += clip.originX;
+    dstY += clip.originY;
+
+    // 先裁剪到源图像范围
+    if (srcX < 0)
+    {
+        width += srcX;
+        dstX -= srcX;
+        srcX = 0;
+    }
+    if (srcY < 0)
+    {
+        height += srcY;
+        dstY -= srcY;
+        srcY = 0;
+    }
+    if (srcX + width > srcWidth)
+        width = srcWidth - srcX;
+    if (srcY + height > srcHeight)
+        height = srcHeight - srcY;
+
+    // 再裁剪到目标区域
+    if (dstX < clip.left)
+    {
+        width -= clip.left - dstX;
+        srcX += clip.left - dstX;
+        dstX = clip.left;
+    }
+    if (dstY < clip.top)
+    {
+        height -= clip.top - dstY;
+        srcY += clip.top - dstY;
+        dstY = clip.top;
+    }
+    if (dstX + width > clip.right)
+        width = clip.right - dstX;
+    if (dstY + height > clip.bottom)
+        height = clip.bottom - dstY;
+    if (width <= 0 || height <= 0)
+        return;
+
+    for (int row = 0; row < height; ++row)
+        g_raster.blend(target.buffer + static_cast<size_t>(dstY + row) * target.width + dstX,
+                       src + static_cast<size_t>(srcY + row) * srcWidth + srcX, width, globalAlpha);
+
+    easyx_dirty_add(dstX, dstY, dstX + width - 1, dstY + height - 1);
+}
+
+int easyx_read_pixels(const void *pImg, int left, int top, int width, int height, uint32_t *dst, size_t stride, int format)
+{
+    PROFILE_SCOPE(EASYX_PROF_IMAGES);
+    if (!dst || (format != EASYX_PIXEL_ARGB && format != EASYX_PIXEL_ABGR))
+        return 0;
+    if (stride == 0)
+        stride = width > 0 ? width : 0;
+
+    RasterTarget target = raster_image(reinterpret_cast<const IMAGE *>(pImg));
+    int skipX, skipY;
+    if (!target.buffer || !raster_clip_pixels(target, left, top, width, height, skipX, skipY))
+        return 0;
+
+    uint32_t *out = dst + skipY * stride + skipX;
+    const DWORD *in = target.buffer + static_cast<size_t>(top) * target.width + left;
+    for (int row = 0; row < height; ++row, out += stride, in += target.width)
+        raster_copy_row(reinterpret_cast<DWORD *>(out), in, width, format);
+
+    return width * height;
+}
+
+int easyx_write_pixels(void *pImg, int left, int top, int width, int height, const uint32_t *src, size_t stride, int format)
+{
+    PROFILE_SCOPE(EASYX_PROF_IMAGES);
+    if (!src || (format != EASYX_PIXEL_ARGB && format != EASYX_PIXEL_ABGR))
+        return 0;
+    if (stride == 0)
+        stride = width > 0 ? width : 0;
+
+    const IMAGE *img = reinterpret_cast<const IMAGE *>(pImg);
+    RasterTarget target = raster_image(img);
+    int skipX, skipY;
+    if (!target.buffer || !raster_clip_pixels(target, left, top, width, height, skipX, skipY))
+        return 0;
+
+    const uint32_t *in = src + skipY * stride + skipX;
+    DWORD *out = target.buffer + static_cast<size_t>(top) * target.width + left;
+    for (int row = 0; row < height; ++row, in += stride, out += target.width)
+        raster_copy_row(out, reinterpret_cast<const DWORD *>(in), width, format);
+
+    if (!img || img == GetWorkingImage())
+        easyx_dirty_add(left, top, left + width - 1, top + height - 1);
+
+    return width * height;
+}
+
+// 差异图：超出容差的像素为红色，有差异但在容差内的为黄色，其余为变淡的灰度
+static void raster_diff_image_row(DWORD *out, const DWORD *a, const DWORD *b, int count, DWORD tolerance)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        DWORD x = a[i];
+        if (((x ^ b[i]) & 0x00FFFFFF) != 0)
+        {
+            out[i] = raster_delta(x, b[i]) > tolerance ? 0xFFFF0000 : 0xFFFFFF00;
+            continue;
+        }
+        DWORD luma = (((x >> 16) & 0xFF) * 77 + ((x >> 8) & 0xFF) * 150 + (x & 0xFF) * 29) >> 8;
+        DWORD v = 191 + (luma >> 2);
+        out[i] = 0xFF000000 | (v << 16) | (v << 8) | v;
+    }
+}
+
+int easyx_image_compare(const void *pImgA, const void *pImgB, int tolerance, void *pDiffImg, EasyXImageDiff *pDiff)
+{
+    PROFILE_SCOPE(EASYX_PROF_IMAGES);
+    if (pDiff)
+    {
+        pDiff->pixels = 0;
+        pDiff->maxDelta = 0;
+        pDiff->left = pDiff->top = pDiff->right = pDiff->bottom = -1;
+    }
+
+    const IMAGE *imgA = reinterpret_cast<const IMAGE *>(pImgA);
+    const IMAGE *imgB = reinterpret_cast<const IMAGE *>(pImgB);
+    RasterTarget a = raster_image(imgA);
+    RasterTarget b = raster_image(imgB);
+    if (!a.buffer || !b.buffer)
+        return EASYX_COMPARE_ERR_INVALID;
+    if (a.width != b.width || a.height != b.height)
+        return EASYX_COMPARE_ERR_SIZE;
+
+    // 差异图不能是参与比较的图像
+    DWORD *diffBuffer = NULL;
+    if (pDiffImg)
+    {
+        IMAGE *diffImg = reinterpret_cast<IMAGE *>(pDiffImg);
+        if (GetImageBuffer(diffImg) == a.buffer || GetImageBuffer(diffImg) == b.buffer)
+            return EASYX_COMPARE_ERR_INVALID;
+        easyx_image_resize(pDiffImg, a.width, a.height);
+        diffBuffer = GetImageBuffer(diffImg);
+    }
+
+    if (tolerance < 0)
+        tolerance = 0;
+    if (tolerance > 255)
+        tolerance = 255;
+
+    uint64_t pixels = 0;
+    DWORD maxDelta = 0;
+    int left = a.width, top = -1, right = -1, bottom = -1;
+    for (int y = 0; y < a.height; ++y)
+    {
+        const DWORD *rowA = a.buffer + static_cast<size_t>(y) * a.width;
+        const DWORD *rowB = b.buffer + static_cast<size_t>(y) * b.width;
+        RasterDiffRow row = {-1, -1, 0};
+        int differ = g_raster.diff(rowA, rowB, a.width, static_cast<DWORD>(tolerance), &row);
+
+        if (row.maxDelta > maxDelta)
+            maxDelta = row.maxDelta;
+        if (differ > 0)
+        {
+            pixels += static_cast<uint64_t>(differ);
+            if (top < 0)
+                top = y;
+            bottom = y;
+            if (row.first < left)
+                left = row.first;
+            if (row.last > right)
+                right = row.last;
+        }
+        if (diffBuffer)
+            raster_diff_image_row(diffBuffer + static_cast<size_t>(y) * a.width, rowA, rowB, a.width, static_cast<DWORD>(tolerance));
+    }
+
+    if (pDiff)
+    {
+        pDiff->pixels = pixels;
+        pDiff->maxDelta = static_cast<int>(maxDelta);
+        if (pixels > 0)
+        {
+            pDiff->left = left;
+            pDiff->top = top;
+            pDiff->right = right;
+            pDiff->bottom = bottom;
+        }
+    }
+    return pixels > 0 ? 1 : 0;
+}
@@ -0,0 +1,36 @@
+// easyx_raster.h
+// 软件光栅化的内部接口，供包装层的其他模块直接写入像素缓冲区，不参与绑定生成
+
+#ifndef EASYX_RASTER_H
+#define EASYX_RASTER_H
+
+#include <windows.h>
+
+// 像素缓冲区，width/height 为 0 表示不可用
+struct RasterTarget
+{
+    DWORD *buffer;
+    int width;
+    int height;
+};
+
+// 逻辑坐标到设备坐标的偏移，以及设备范围与裁剪区域外接矩形的交集 [left, right) x [top, bottom)
+struct RasterClip
+{
+    int originX, originY;
+    int left, top, right, bottom;
+};
+
+// 当前工作图像的像素缓冲区
+RasterTarget raster_target();
+
+// 获取当前工作图像的原点和裁剪范围，裁剪区域为空时返回 false
+bool raster_clip(const RasterTarget &target, RasterClip *clip);
+
+// 用单一像素值填充一行，使用当前选择的内核
+void raster_span_row(DWORD *dst, int count, DWORD pixel);
+
+// 按源像素的透明度通道和全局透明度混合一行像素，使用当前选择的内核
+void raster_blend_row(DWORD *dst, const DWORD *src, int count, DWORD globalAlpha);
+
+#endif // EASYX_RASTER_H
@@ -0,0 +1,518 @@
+// easyx_record.cpp
+// 帧序列录制：绘图线程把图像缓冲区复制到帧池中，编码线程编码并写入文件，帧池用尽时丢帧而不等待
+
+#include "easyx_wrapper.h"
+#include "easyx_profiler.h"
+#include <string.h>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <windows.h>
+#include <wincodec.h>
+#include <tchar.h>
+#include "../EasyX_26.1.1/include/easyx.h"
+
+#define RECORD_MAGIC "EXRC"
+#define RECORD_VERSION 1
+#define RECORD_MIN_POOL 2
+#define RECORD_MAX_POOL 64
+// 差分格式每隔这么多帧写入一个完整的关键帧，便于从中间开始解码
+#define RECORD_KEY_INTERVAL 120
+
+// 原始和差分格式的文件头
+#pragma pack(push, 1)
+struct RecordFileHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t format; // EASYX_RECORD_RAW 或 EASYX_RECORD_DELTA
+    uint32_t reserved;
+};
+
+// 每一帧之前的记录头，payloadBytes 字节的内容紧随其后
+struct RecordFrameHeader
+{
+    uint32_t width;
+    uint32_t height;
+    uint32_t flags; // EASYX_RECORD_KEYFRAME
+    uint32_t payloadBytes;
+    uint64_t index;       // 捕获序号，被丢弃的帧不写入，序号会跳过
+    uint64_t timestampUs; // 相对第一次捕获的时间
+};
+#pragma pack(pop)
+
+enum RecordFrameState
+{
+    RECORD_FREE,
+    RECORD_QUEUED, // 已复制，等待编码
+    RECORD_ENCODING,
+};
+
+struct RecordFrame
+{
+    std::vector<DWORD> pixels;
+    int width, height;
+    uint64_t index;
+    uint64_t timestampUs;
+    int state;
+};
+
+struct Recorder
+{
+    std::mutex mutex;
+    std::condition_variable ready; // 有帧等待编码或需要停止
+    std::condition_variable idle;  // 一帧编码完成
+    bool encoding;
+    std::thread thread;
+    bool stopping;
+
+    int format;
+    std::wstring path; // PNG 序列为文件名模板
+    HANDLE file;
+    std::vector<RecordFrame> frames;
+    std::deque<int> queue;
+
+    // 以下只由编码线程使用
+    std::vector<DWORD> previous; // 差分格式的上一帧
+    int previousWidth, previousHeight;
+    uint64_t sinceKey;
+    std::vector<uint8_t> payload;
+
+    LONGLONG frequency;
+    LONGLONG start;
+    uint64_t nextIndex;
+    EasyXRecorderStats stats;
+};
+
+static inline LONGLONG record_now()
+{
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    return counter.QuadPart;
+}
+
+static std::wstring record_widen(const char *str)
+{
+    int len = MultiByteToWideChar(CP_UTF8, 0, str, -1, NULL, 0);
+    if (len <= 0)
+        return std::wstring();
+
+    std::wstring wstr(len - 1, 0);
+    MultiByteToWideChar(CP_UTF8, 0, str, -1, &wstr[0], len);
+    return wstr;
+}
+
+static bool record_write(HANDLE file, const void *data, size_t size)
+{
+    DWORD written = 0;
+    return size == 0 || (WriteFile(file, data, static_cast<DWORD>(size), &written, NULL) && written == size);
+}
+
+// 模板中连续的 '#' 替换为补零的帧序号，没有 '#' 时在扩展名之前加上六位序号
+static std::wstring record_png_path(const std::wstring &pattern, uint64_t index)
+{
+    size_t first = pattern.find(L'#');
+    size_t count = 0;
+    std::wstring head, tail;
+    if (first != std::wstring::npos)
+    {
+        while (first + count < pattern.size() && pattern[first + count] == L'#')
+            ++count;
+        head = pattern.substr(0, first);
+        tail = pattern.substr(first + count);
+    }
+    else
+    {
+        size_t dot = pattern.find_last_of(L'.');
+        size_t slash = pattern.find_last_of(L"\\/");
+        if (dot == std::wstring::npos || (slash != std::wstring::npos && dot < slash))
+            dot = pattern.size();
+        head = pattern.substr(0, dot) + L"_";
+        tail = pattern.substr(dot);
+        count = 6;
+    }
+
+    std::wstring digits;
+    for (uint64_t v = index; v > 0 || digits.empty(); v /= 10)
+        digits.insert(digits.begin(), static_cast<wchar_t>(L'0' + v % 10));
+    while (digits.size() < count)
+        digits.insert(digits.begin(), L'0');
+    return head + digits + tail;
+}
+
+// 用 WIC 编码为 24 位 PNG。IMAGE 缓冲区的透明度通常为 0，按不透明处理
+static HRESULT record_encode_png(IWICImagingFactory *factory, const std::wstring &path, const RecordFrame &frame, std::vector<uint8_t> &rows)
+{
+    UINT stride = (static_cast<UINT>(frame.width) * 3 + 3) & ~3u;
+    rows.resize(static_cast<size_t>(stride) * frame.height);
+    for (int y = 0; y < frame.height; ++y)
+    {
+        const DWORD *src = frame.pixels.data() + static_cast<size_t>(y) * frame.width;
+        uint8_t *dst = rows.data() + static_cast<size_t>(y) * stride;
+        for (int x = 0; x < frame.width; ++x)
+        {
+            dst[x * 3 + 0] = static_cast<uint8_t>(src[x]);
+            dst[x * 3 + 1] = static_cast<uint8_t>(src[x] >> 8);
+            dst[x * 3 + 2] = static_cast<uint8_t>(src[x] >> 16);
+        }
+    }
+
+    IWICStream *stream = NULL;
+    IWICBitmapEncoder *encoder = NULL;
+    IWICBitmapFrameEncode *target = NULL;
+    IPropertyBag2 *options = NULL;
+    WICPixelFormatGUID pixelFormat = GUID_WICPixelFormat24bppBGR;
+
+    HRESULT hr = factory->CreateStream(&stream);
+    if (SUCCEEDED(hr))
+        hr = stream->InitializeFromFilename(path.c_str(), GENERIC_WRITE);
+    if (SUCCEEDED(hr))
+        hr = factory->CreateEncoder(GUID_ContainerFormatPng, NULL, &encoder);
+    if (SUCCEEDED(hr))
+        hr = encoder->Initialize(stream, WICBitmapEncoderNoCache);
+    if (SUCCEEDED(hr))
+        hr = encoder->CreateNewFrame(&target, &options);
+    if (SUCCEEDED(hr))
+        hr = target->Initialize(options);
+    if (SUCCEEDED(hr))
+        hr = target->SetSize(frame.width, frame.height);
+    if (SUCCEEDED(hr))
+        hr = target->SetPixelFormat(&pixelFormat);
+    if (SUCCEEDED(hr) && !IsEqualGUID(pixelFormat, GUID_WICPixelFormat24bppBGR))
+        hr = E_FAIL;
+    if (SUCCEEDED(hr))
+        hr = target->WritePixels(frame.height, stride, static_cast<UINT>(rows.size()), rows.data());
+    if (SUCCEEDED(hr))
+        hr = target->Commit();
+    if (SUCCEEDED(hr))
+        hr = encoder->Commit();
+
+    if (options)
+        options->Release();
+    if (target)
+        target->Release();
+    if (encoder)
+        encoder->Release();
+    if (stream)
+        stream->Release();
+    return hr;
+}
+
+// 差分格式：与上一帧相同的像素只记录数量。内容为若干段 [相同像素数][变化像素数][变化的像素]，
+// 均为 32 位。返回 true 表示关键帧，直接存放全部像素，不写入 payload
+static bool record_encode_delta(Recorder *rec, const RecordFrame &frame)
+{
+    size_t count = static_cast<size_t>(frame.width) * frame.height;
+    bool key = rec->previousWidth != frame.width || rec->previousHeight != frame.height || rec->sinceKey >= RECORD_KEY_INTERVAL;
+
+    rec->payload.clear();
+    if (key)
+    {
+        rec->sinceKey = 0;
+    }
+    else
+    {
+        const DWORD *cur = frame.pixels.data();
+        const DWORD *prev = rec->previous.data();
+        size_t i = 0;
+        while (i < count)
+        {
+            size_t same = i;
+            while (same < count && cur[same] == prev[same])
+                ++same;
+            size_t changed = same;
+            // 夹在变化像素之间的少量相同像素直接写入，避免段数过多
+            while (changed < count)
+            {
+                if (cur[changed] != prev[changed])
+                {
+                    ++changed;
+                    continue;
+                }
+                size_t run = changed;
+                while (run < count && run - changed < 3 && cur[run] == prev[run])
+                    ++run;
+                if (run == count || run - changed >= 3)
+                    break;
+                changed = run;
+            }
+            if (same == count)
+                break;
+
+            uint32_t header[2] = {static_cast<uint32_t>(same - i), static_cast<uint32_t>(changed - same)};
+            size_t offset = rec->payload.size();
+            rec->payload.resize(offset + sizeof(header) + (changed - same) * sizeof(DWORD));
+            memcpy(rec->payload.data() + offset, header, sizeof(header));
+            memcpy(rec->payload.data() + offset + sizeof(header), cur + same, (changed - same) * sizeof(DWORD));
+            i = changed;
+        }
+    }
+
+    rec->previous.assign(frame.pixels.begin(), frame.pixels.begin() + count);
+    rec->previousWidth = frame.width;
+    rec->previousHeight = frame.height;
+    ++rec->sinceKey;
+    return key;
+}
+
+static HRESULT record_encode(Recorder *rec, IWICImagingFactory *factory, const RecordFrame &frame, uint64_t *bytes)
+{
+    if (rec->format == EASYX_RECORD_PNG)
+    {
+        if (!factory)
+            return E_FAIL;
+        std::wstring path = record_png_path(rec->path, frame.index);
+        HRESULT hr = record_encode_png(factory, path, frame, rec->payload);
+        if (SUCCEEDED(hr))
+        {
+            WIN32_FILE_ATTRIBUTE_DATA info;
+            if (GetFileAttributesExW(path.c_str(), GetFileExInfoStandard, &info))
+                *bytes = (static_cast<uint64_t>(info.nFileSizeHigh) << 32) | info.nFileSizeLow;
+        }
+        return hr;
+    }
+
+    RecordFrameHeader header;
+    header.width = frame.width;
+    header.height = frame.height;
+    header.flags = EASYX_RECORD_KEYFRAME;
+    header.index = frame.index;
+    header.timestampUs = frame.timestampUs;
+
+    const void *payload = frame.pixels.data();
+    size_t size = static_cast<size_t>(frame.width) * frame.height * sizeof(DWORD);
+    if (rec->format == EASYX_RECORD_DELTA && !record_encode_delta(rec, frame))
+    {
+        header.flags = 0;
+        payload = rec->payload.data();
+        size = rec->payload.size();
+    }
+    header.payloadBytes = static_cast<uint32_t>(size);
+
+    if (!record_write(rec->file, &header, sizeof(header)) || !record_write(rec->file, payload, size))
+        return HRESULT_FROM_WIN32(GetLastError());
+    *bytes = sizeof(header) + size;
+    return S_OK;
+}
+
+static void record_thread(Recorder *rec)
+{
+    HRESULT init = E_FAIL;
+    IWICImagingFactory *factory = NULL;
+    if (rec->format == EASYX_RECORD_PNG)
+    {
+        init = CoInitializeEx(NULL, COINIT_MULTITHREADED);
+        if (FAILED(CoCreateInstance(CLSID_WICImagingFactory, NULL, CLSCTX_INPROC_SERVER, IID_PPV_ARGS(&factory))))
+            factory = NULL;
+    }
+
+    std::unique_lock<std::mutex> lock(rec->mutex);
+    for (;;)
+    {
+        while (!rec->stopping && rec->queue.empty())
+            rec->ready.wait(lock);
+        // 停止时写完排队的帧再退出
+        if (rec->queue.empty())
+            break;
+
+        int index = rec->queue.front();
+        rec->queue.pop_front();
+        RecordFrame &frame = rec->frames[index];
+        frame.state = RECORD_ENCODING;
+        rec->encoding = true;
+        bool failed = rec->stats.error != 0;
+
+        lock.unlock();
+        LONGLONG start = record_now();
+        uint64_t bytes = 0;
+        HRESULT hr = failed ? S_OK : record_encode(rec, factory, frame, &bytes);
+        double elapsed = static_cast<double>(record_now() - start) * 1000.0 / static_cast<double>(rec->frequency);
+        lock.lock();
+
+        frame.state = RECORD_FREE;
+        rec->encoding = false;
+        rec->idle.notify_all();
+        if (failed)
+        {
+            // 出错之后只回收帧，不再写入
+            ++rec->stats.dropped;
+        }
+        else if (FAILED(hr))
+        {
+            rec->stats.error = static_cast<int>(hr);
+            ++rec->stats.dropped;
+        }
+        else
+        {
+            ++rec->stats.written;
+            rec->stats.bytes += bytes;
+            rec->stats.encodeMs = elapsed;
+        }
+    }
+    lock.unlock();
+
+    if (factory)
+        factory->Release();
+    if (SUCCEEDED(init))
+        CoUninitialize();
+}
+
+void *easyx_recorder_create(const char *path, int format, int poolFrames)
+{
+    PROFILE_SCOPE(EASYX_PROF_IMAGES);
+    if (!path || (format != EASYX_RECORD_RAW && format != EASYX_RECORD_DELTA && format != EASYX_RECORD_PNG))
+        return NULL;
+
+    Recorder *rec = new Recorder();
+    rec->stopping = false;
+    rec->encoding = false;
+    rec->format = format;
+    rec->path = record_widen(path);
+    rec->file = INVALID_HANDLE_VALUE;
+    rec->previousWidth = rec->previousHeight = 0;
+    rec->sinceKey = 0;
+    rec->start = 0;
+    rec->nextIndex = 0;
+    memset(&rec->stats, 0, sizeof(rec->stats));
+
+    if (format != EASYX_RECORD_PNG)
+    {
+        rec->file = CreateFileW(rec->path.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+        RecordFileHeader header;
+        memcpy(header.magic, RECORD_MAGIC, 4);
+        header.version = RECORD_VERSION;
+        header.format = static_cast<uint32_t>(format);
+        header.reserved = 0;
+        if (rec->file == INVALID_HANDLE_VALUE || !record_write(rec->file, &header, sizeof(header)))
+        {
+            if (rec->file != INVALID_HANDLE_VALUE)
+                CloseHandle(rec->file);
+            delete rec;
+            return NULL;
+        }
+        rec->stats.bytes = sizeof(header);
+    }
+
+    if (poolFrames < RECORD_MIN_POOL)
+        poolFrames = RECORD_MIN_POOL;
+    if (poolFrames > RECORD_MAX_POOL)
+        poolFrames = RECORD_MAX_POOL;
+    // 像素缓冲区在第一次捕获时按图像大小分配
+    rec->frames.resize(poolFrames);
+    for (int i = 0; i < poolFrames; ++i)
+    {
+        rec->frames[i].width = rec->frames[i].height = 0;
+        rec->frames[i].state = RECORD_FREE;
+    }
+
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    rec->frequency = frequency.QuadPart;
+    rec->thread = std::thread(record_thread, rec);
+    return rec;
+}
+
+int easyx_recorder_capture(void *recorder, const void *img)
+{
+    PROFILE_SCOPE(EASYX_PROF_IMAGES);
+    Recorder *rec = reinterpret_cast<Recorder *>(recorder);
+    if (!rec)
+        return EASYX_RECORD_ERR_INVALID;
+
+    // NULL 表示绘图窗口（无窗口模式下为画布），大小取自图像本身而不是客户区，与缓冲区一致
+    int width = 0, height = 0;
+    easyx_getdevicesize(img, &width, &height);
+    const DWORD *pixels = reinterpret_cast<const DWORD *>(easyx_getimagebuffer(img));
+    if (!pixels || width <= 0 || height <= 0)
+        return EASYX_RECORD_ERR_INVALID;
+
+    LONGLONG now = record_now();
+    int index = -1;
+    {
+        std::lock_guard<std::mutex> lock(rec->mutex);
+        if (rec->start == 0)
+            rec->start = now;
+        uint64_t captureIndex = rec->nextIndex++;
+        if (rec->stats.error != 0)
+            return EASYX_RECORD_ERR_IO;
+
+        for (size_t i = 0; i < rec->frames.size(); ++i)
+        {
+            if (rec->frames[i].state == RECORD_FREE)
+            {
+                index = static_cast<int>(i);
+                break;
+            }
+        }
+        // 编码跟不上时丢弃这一帧，绘图线程不等待
+        if (index < 0)
+        {
+            ++rec->stats.dropped;
+            return 0;
+        }
+        rec->frames[index].state = RECORD_QUEUED;
+        rec->frames[index].index = captureIndex;
+    }
+
+    // 空闲帧只属于绘图线程，复制时不需要持有锁
+    RecordFrame &frame = rec->frames[index];
+    frame.pixels.resize(static_cast<size_t>(width) * height);
+    memcpy(frame.pixels.data(), pixels, frame.pixels.size() * sizeof(DWORD));
+    frame.width = width;
+    frame.height = height;
+    frame.timestampUs = static_cast<uint64_t>((now - rec->start) * 1000000 / rec->frequency);
+
+    {
+        std::lock_guard<std::mutex> lock(rec->mutex);
+        rec->queue.push_back(index);
+        ++rec->stats.captured;
+    }
+    rec->ready.notify_one();
+    return 1;
+}
+
+void easyx_recorder_flush(void *recorder)
+{
+    PROFILE_SCOPE(EASYX_PROF_IMAGES);
+    Recorder *rec = reinterpret_cast<Recorder *>(recorder);
+    if (!rec)
+        return;
+
+    std::unique_lock<std::mutex> lock(rec->mutex);
+    while (!rec->queue.empty() || rec->encoding)
+        rec->idle.wait(lock);
+}
+
+void easyx_recorder_destroy(void *recorder)
+{
+    PROFILE_SCOPE(EASYX_PROF_IMAGES);
+    Recorder *rec = reinterpret_cast<Recorder *>(recorder);
+    if (!rec)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(rec->mutex);
+        rec->stopping = true;
+    }
+    rec->ready.notify_one();
+    rec->thread.join();
+
+    if (rec->file != INVALID_HANDLE_VALUE)
+        CloseHandle(rec->file);
+    delete rec;
+}
+
+void easyx_recorder_getstats(void *recorder, EasyXRecorderStats *pStats)
+{
+    Recorder *rec = reinterpret_cast<Recorder *>(recorder);
+    if (!rec || !pStats)
+        return;
+
+    std::lock_guard<std::mutex> lock(rec->mutex);
+    *pStats = rec->stats;
+    pStats->queued = static_cast<int>(rec->queue.size());
+    pStats->pool = static_cast<int>(rec->frames.size());
+}
@@ -0,0 +1,302 @@
+// easyx_ring.cpp
+// 跨线程的无锁环形队列：多生产者单消费者的命令队列，单生产者单消费者的消息队列
+
+#include "easyx_wrapper.h"
+#include "easyx_profiler.h"
+#include <string.h>
+#include <atomic>
+#include <vector>
+#include <windows.h>
+#include <tchar.h>
+#include "../EasyX_26.1.1/include/easyx.h"
+
+// 命令队列的单元为 64 字节（其中 48 字节为命令数据），与缓存行对齐，一段命令流占用连续的若干个单元
+#define RING_CELL_BYTES 48
+#define RING_MIN_CELLS 16
+
+struct alignas(64) RingCell
+{
+    // 写入完成时设为单元位置加 1，位置单调递增，不会与上一圈的值混淆
+    std::atomic<uint64_t> seq;
+    uint32_t length; // 命令流的字节数，只在一段命令流的第一个单元中有效
+    uint32_t cells;  // 命令流占用的单元数，只在第一个单元中有效
+    uint8_t data[RING_CELL_BYTES];
+};
+
+struct CommandRing
+{
+    RingCell *cells;
+    uint64_t mask;
+    alignas(64) std::atomic<uint64_t> head; // 生产者预留的下一个位置
+    alignas(64) std::atomic<uint64_t> tail; // 消费者读取的下一个位置
+    std::atomic<uint64_t> posted;
+    std::atomic<uint64_t> rejected;
+    std::atomic<uint64_t> drained;
+    std::vector<uint8_t> scratch; // 消费者重新拼接命令流
+};
+
+// 单生产者单消费者，生产者和消费者各自只写自己的位置
+struct MessageRing
+{
+    CExMessage *slots;
+    uint64_t mask;
+    alignas(64) std::atomic<uint64_t> head;
+    alignas(64) std::atomic<uint64_t> tail;
+    std::atomic<uint64_t> pushed;
+    std::atomic<uint64_t> popped;
+    std::atomic<uint64_t> rejected;
+};
+
+static uint64_t ring_capacity(uint64_t requested, uint64_t minimum)
+{
+    uint64_t capacity = minimum;
+    while (capacity < requested && capacity < (1ull << 40))
+        capacity <<= 1;
+    return capacity;
+}
+
+static uint64_t ring_cells_for(size_t len)
+{
+    return len == 0 ? 1 : (len + RING_CELL_BYTES - 1) / RING_CELL_BYTES;
+}
+
+void *easyx_cmdring_create(size_t bytes)
+{
+    CommandRing *ring = new CommandRing();
+    uint64_t count = ring_capacity(ring_cells_for(bytes), RING_MIN_CELLS);
+    ring->cells = new RingCell[count];
+    for (uint64_t i = 0; i < count; ++i)
+        ring->cells[i].seq.store(0, std::memory_order_relaxed);
+    ring->mask = count - 1;
+    ring->head.store(0, std::memory_order_relaxed);
+    ring->tail.store(0, std::memory_order_relaxed);
+    ring->posted.store(0, std::memory_order_relaxed);
+    ring->rejected.store(0, std::memory_order_relaxed);
+    ring->drained.store(0, std::memory_order_relaxed);
+    return ring;
+}
+
+void easyx_cmdring_destroy(void *ring)
+{
+    CommandRing *r = reinterpret_cast<CommandRing *>(ring);
+    if (!r)
+        return;
+    delete[] r->cells;
+    delete r;
+}
+
+int easyx_cmdring_post(void *ring, const void *buf, size_t len)
+{
+    CommandRing *r = reinterpret_cast<CommandRing *>(ring);
+    if (!r || (!buf && len > 0))
+        return EASYX_RING_ERR_INVALID;
+
+    uint64_t need = ring_cells_for(len);
+    if (need > r->mask + 1)
+        return EASYX_RING_ERR_TOOBIG;
+
+    // 预留连续的单元：空间按消费者的位置判断，预留成功后这些单元只属于当前生产者。
+    // pos 可能早于 tail 读取而已经过时（其他生产者提交后消费者越过了它），
+    // 不能用 pos + need - tail 判断，否则无符号减法下溢，空队列也会被判为已满；
+    // 过时的 pos 只会让比较通过，随后的 CAS 失败并重新读取 head
+    uint64_t pos = r->head.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        uint64_t tail = r->tail.load(std::memory_order_acquire);
+        if (pos + need > tail + r->mask + 1)
+        {
+            r->rejected.fetch_add(1, std::memory_order_relaxed);
+            return EASYX_RING_ERR_FULL;
+        }
+        if (r->head.compare_exchange_weak(pos, pos + need, std::memory_order_relaxed, std::memory_order_relaxed))
+            break;
+    }
+
+    const uint8_t *src = static_cast<const uint8_t *>(buf);
+    size_t remaining = len;
+    for (uint64_t i = 0; i < need; ++i)
+    {
+        RingCell &cell = r->cells[(pos + i) & r->mask];
+        size_t chunk = remaining < RING_CELL_BYTES ? remaining : RING_CELL_BYTES;
+        if (chunk > 0)
+            memcpy(cell.data, src + i * RING_CELL_BYTES, chunk);
+        remaining -= chunk;
+    }
+
+    RingCell &first = r->cells[pos & r->mask];
+    first.length = static_cast<uint32_t>(len);
+    first.cells = static_cast<uint32_t>(need);
+    // 最后发布第一个单元，消费者看到序号时整段命令流都已写完
+    first.seq.store(pos + 1, std::memory_order_release);
+    r->posted.fetch_add(1, std::memory_order_relaxed);
+    return 0;
+}
+
+int easyx_cmdring_drain(void *ring, int maxStreams)
+{
+    PROFILE_SCOPE(EASYX_PROF_PRIMITIVES);
+    CommandRing *r = reinterpret_cast<CommandRing *>(ring);
+    if (!r)
+        return 0;
+
+    int streams = 0;
+    uint64_t pos = r->tail.load(std::memory_order_relaxed);
+    while (maxStreams <= 0 || streams < maxStreams)
+    {
+        RingCell &first = r->cells[pos & r->mask];
+        // 还没有发布，之后的命令流即使已经写完也要按顺序等待
+        if (first.seq.load(std::memory_order_acquire) != pos + 1)
+            break;
+
+        uint32_t length = first.length;
+        uint32_t count = first.cells;
+        r->scratch.resize(length);
+        size_t remaining = length;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            size_t chunk = remaining < RING_CELL_BYTES ? remaining : RING_CELL_BYTES;
+            if (chunk > 0)
+                memcpy(r->scratch.data() + static_cast<size_t>(i) * RING_CELL_BYTES, r->cells[(pos + i) & r->mask].data, chunk);
+            remaining -= chunk;
+        }
+
+        // 复制完立即归还单元，回放期间生产者可以继续提交
+        pos += count;
+        r->tail.store(pos, std::memory_order_release);
+
+        if (length > 0)
+            easyx_submit_commands(r->scratch.data(), length);
+        ++streams;
+    }
+
+    r->drained.fetch_add(streams, std::memory_order_relaxed);
+    return streams;
+}
+
+void easyx_cmdring_getstats(void *ring, EasyXRingStats *pStats)
+{
+    CommandRing *r = reinterpret_cast<CommandRing *>(ring);
+    if (!r || !pStats)
+        return;
+
+    uint64_t head = r->head.load(std::memory_order_relaxed);
+    uint64_t tail = r->tail.load(std::memory_order_relaxed);
+    pStats->pushed = r->posted.load(std::memory_order_relaxed);
+    pStats->popped = r->drained.load(std::memory_order_relaxed);
+    pStats->rejected = r->rejected.load(std::memory_order_relaxed);
+    pStats->used = static_cast<size_t>((head > tail ? head - tail : 0) * RING_CELL_BYTES);
+    pStats->capacity = static_cast<size_t>((r->mask + 1) * RING_CELL_BYTES);
+}
+
+void *easyx_msgring_create(int capacity)
+{
+    MessageRing *ring = new MessageRing();
+    uint64_t count = ring_capacity(capacity > 0 ? static_cast<uint64_t>(capacity) : 0, RING_MIN_CELLS);
+    ring->slots = new CExMessage[count];
+    ring->mask = count - 1;
+    ring->head.store(0, std::memory_order_relaxed);
+    ring->tail.store(0, std::memory_order_relaxed);
+    ring->pushed.store(0, std::memory_order_relaxed);
+    ring->popped.store(0, std::memory_order_relaxed);
+    ring->rejected.store(0, std::memory_order_relaxed);
+    return ring;
+}
+
+void easyx_msgring_destroy(void *ring)
+{
+    MessageRing *r = reinterpret_cast<MessageRing *>(ring);
+    if (!r)
+        return;
+    delete[] r->slots;
+    delete r;
+}
+
+// 生产者的剩余空间，只由生产者调用，结果不会因消费者并发读取而变小
+static uint64_t msgring_free(MessageRing *r, uint64_t head)
+{
+    return r->mask + 1 - (head - r->tail.load(std::memory_order_acquire));
+}
+
+int easyx_msgring_push(void *ring, const CExMessage *pMsg)
+{
+    MessageRing *r = reinterpret_cast<MessageRing *>(ring);
+    if (!r || !pMsg)
+        return EASYX_RING_ERR_INVALID;
+
+    uint64_t head = r->head.load(std::memory_order_relaxed);
+    if (msgring_free(r, head) == 0)
+    {
+        r->rejected.fetch_add(1, std::memory_order_relaxed);
+        return EASYX_RING_ERR_FULL;
+    }
+
+    r->slots[head & r->mask] = *pMsg;
+    r->head.store(head + 1, std::memory_order_release);
+    r->pushed.fetch_add(1, std::memory_order_relaxed);
+    return 0;
+}
+
+int easyx_msgring_pump(void *ring, unsigned char filter)
+{
+    PROFILE_SCOPE(EASYX_PROF_MESSAGES);
+    MessageRing *r = reinterpret_cast<MessageRing *>(ring);
+    // 无窗口模式下没有 EasyX 的消息队列
+    if (!r || easyx_getcanvas())
+        return 0;
+
+    // 只取出放得下的消息，其余留在 EasyX 的队列中等下一次
+    uint64_t head = r->head.load(std::memory_order_relaxed);
+    uint64_t space = msgring_free(r, head);
+    uint64_t moved = 0;
+    ExMessage msg;
+    while (moved < space && peekmessage(&msg, filter, true))
+    {
+        *reinterpret_cast<ExMessage *>(&r->slots[(head + moved) & r->mask]) = msg;
+        ++moved;
+    }
+
+    if (moved > 0)
+    {
+        r->head.store(head + moved, std::memory_order_release);
+        r->pushed.fetch_add(moved, std::memory_order_relaxed);
+    }
+    return static_cast<int>(moved);
+}
+
+int easyx_msgring_pop(void *ring, CExMessage *pMsgs, int capacity)
+{
+    MessageRing *r = reinterpret_cast<MessageRing *>(ring);
+    if (!r || !pMsgs || capacity <= 0)
+        return 0;
+
+    uint64_t tail = r->tail.load(std::memory_order_relaxed);
+    uint64_t head = r->head.load(std::memory_order_acquire);
+    uint64_t count = head - tail;
+    if (count > static_cast<uint64_t>(capacity))
+        count = static_cast<uint64_t>(capacity);
+
+    for (uint64_t i = 0; i < count; ++i)
+        pMsgs[i] = r->slots[(tail + i) & r->mask];
+
+    if (count > 0)
+    {
+        r->tail.store(tail + count, std::memory_order_release);
+        r->popped.fetch_add(count, std::memory_order_relaxed);
+    }
+    return static_cast<int>(count);
+}
+
+void easyx_msgring_getstats(void *ring, EasyXRingStats *pStats)
+{
+    MessageRing *r = reinterpret_cast<MessageRing *>(ring);
+    if (!r || !pStats)
+        return;
+
+    uint64_t head = r->head.load(std::memory_order_relaxed);
+    uint64_t tail = r->tail.load(std::memory_order_relaxed);
+    pStats->pushed = r->pushed.load(std::memory_order_relaxed);
+    pStats->popped = r->popped.load(std::memory_order_relaxed);
+    pStats->rejected = r->rejected.load(std::memory_order_relaxed);
+    pStats->used = static_cast<size_t>(head > tail ? head - tail : 0);
+    pStats->capacity = static_cast<size_t>(r->mask + 1);
+}
@@ -0,0 +1,497 @@
+// easyx_scene.cpp
+// 保留模式的图层：图层录制一次命令流，光栅化到缓存的图像中，呈现时只重新合成变化的区域
+
+#include "easyx_wrapper.h"
+#include "easyx_profiler.h"
+#include "easyx_raster.h"
+#include <string.h>
+#include <algorithm>
+#include <vector>
+#include <windows.h>
+#include <tchar.h>
+#include "../EasyX_26.1.1/include/easyx.h"
+
+// 损坏矩形超过此数量时合并为外接矩形，避免合成时逐个遍历图层的开销
+#define SCENE_MAX_DAMAGE 8
+
+struct SceneLayer
+{
+    bool alive;
+    bool visible;
+    bool contentValid; // 缓存的图像与命令流一致
+    bool changed;      // 位置、可见性、层级或透明度变化后尚未呈现
+    bool translucent;  // 缓存的像素含透明度，需要混合
+    int x, y, width, height;
+    int z;
+    int flags;
+    uint8_t alpha;
+    DWORD fill; // 不透明图层的底色，0x00RRGGBB
+    std::vector<uint8_t> commands;
+    IMAGE *image;
+    RECT presented; // 上一次呈现时覆盖的范围，right/bottom 不包含
+    bool hasPresented;
+};
+
+struct Scene
+{
+    std::vector<SceneLayer> layers;
+    std::vector<int> order; // 按 z、编号排序的图层编号
+    bool orderValid;
+    bool full; // 下一次呈现重新合成整个工作图像
+    DWORD background;
+    std::vector<RECT> damage;
+    std::vector<DWORD> scratch; // 透明图层光栅化时保存黑底的结果
+    EasyXSceneStats stats;
+};
+
+static Scene *scene_cast(void *scene)
+{
+    return reinterpret_cast<Scene *>(scene);
+}
+
+static SceneLayer *scene_layer(Scene *scene, int layer)
+{
+    if (!scene || layer < 0 || layer >= static_cast<int>(scene->layers.size()) || !scene->layers[layer].alive)
+        return NULL;
+    return &scene->layers[layer];
+}
+
+static bool rect_empty(const RECT &r)
+{
+    return r.left >= r.right || r.top >= r.bottom;
+}
+
+static bool rect_touch(const RECT &a, const RECT &b)
+{
+    return a.left <= b.right && b.left <= a.right && a.top <= b.bottom && b.top <= a.bottom;
+}
+
+static void rect_union(RECT *a, const RECT &b)
+{
+    a->left = b.left < a->left ? b.left : a->left;
+    a->top = b.top < a->top ? b.top : a->top;
+    a->right = b.right > a->right ? b.right : a->right;
+    a->bottom = b.bottom > a->bottom ? b.bottom : a->bottom;
+}
+
+// 登记需要重新合成的区域，与相交或相邻的矩形合并
+static void scene_damage(Scene *scene, RECT r)
+{
+    if (rect_empty(r))
+        return;
+
+    for (size_t i = 0; i < scene->damage.size();)
+    {
+        if (rect_touch(scene->damage[i], r))
+        {
+            rect_union(&r, scene->damage[i]);
+            scene->damage[i] = scene->damage.back();
+            scene->damage.pop_back();
+            i = 0;
+        }
+        else
+        {
+            ++i;
+        }
+    }
+    scene->damage.push_back(r);
+
+    if (scene->damage.size() > SCENE_MAX_DAMAGE)
+    {
+        RECT all = scene->damage[0];
+        for (size_t i = 1; i < scene->damage.size(); ++i)
+            rect_union(&all, scene->damage[i]);
+        scene->damage.assign(1, all);
+    }
+}
+
+static RECT layer_rect(const SceneLayer &layer)
+{
+    RECT r = {layer.x, layer.y, layer.x + layer.width, layer.y + layer.height};
+    return r;
+}
+
+// 回放命令流到图层图像中，命令流中的坐标以图层左上角为原点
+static void layer_replay(SceneLayer *layer, IMAGE *image)
+{
+    void *saved = easyx_getworkingimage();
+    easyx_setworkingimage(image);
+    if (!layer->commands.empty())
+        easyx_submit_commands(layer->commands.data(), layer->commands.size());
+    easyx_setworkingimage(saved);
+}
+
+static void layer_fill(IMAGE *image, DWORD pixel)
+{
+    DWORD *buffer = GetImageBuffer(image);
+    size_t count = static_cast<size_t>(image->getwidth()) * image->getheight();
+    for (size_t i = 0; i < count; ++i)
+        buffer[i] = pixel;
+}
+
+// 光栅化图层。透明图层分别在黑底和白底上回放一次，由两次结果的差得到每个像素的覆盖率，
+// 不需要颜色键，GDI 的抗锯齿文本边缘也能得到正确的透明度
+static void layer_rasterize(Scene *scene, SceneLayer *layer)
+{
+    size_t count = static_cast<size_t>(layer->width) * layer->height;
+    if (layer->image)
+        easyx_image_release(layer->image);
+    layer->image = reinterpret_cast<IMAGE *>(easyx_image_acquire(layer->width, layer->height));
+    DWORD *buffer = GetImageBuffer(layer->image);
+    if (!buffer)
+        return;
+
+    if (!(layer->flags & EASYX_LAYER_TRANSPARENT))
+    {
+        layer_fill(layer->image, layer->fill);
+        layer_replay(layer, layer->image);
+        // GDI 不写透明度通道，补为不透明，整体透明度小于 255 时才能混合
+        for (size_t i = 0; i < count; ++i)
+            buffer[i] |= 0xFF000000;
+        layer->translucent = layer->alpha < 255;
+    }
+    else
+    {
+        layer_replay(layer, layer->image);
+        scene->scratch.assign(buffer, buffer + count);
+
+        // 重新取出图像，绘图状态恢复默认后在白底上再回放一次
+        easyx_image_release(layer->image);
+        layer->image = reinterpret_cast<IMAGE *>(easyx_image_acquire(layer->width, layer->height));
+        buffer = GetImageBuffer(layer->image);
+        if (!buffer)
+            return;
+        layer_fill(layer->image, 0x00FFFFFF);
+        layer_replay(layer, layer->image);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            DWORD black = scene->scratch[i];
+            DWORD white = buffer[i];
+            int g = static_cast<int>((white >> 8) & 0xFF) - static_cast<int>((black >> 8) & 0xFF);
+            int a = 255 - (g < 0 ? 0 : g);
+            if (a <= 0)
+            {
+                buffer[i] = 0;
+                continue;
+            }
+
+            // 黑底结果为颜色乘以覆盖率，除回得到非预乘的颜色
+            DWORD out = static_cast<DWORD>(a) << 24;
+            for (int shift = 0; shift < 24; shift += 8)
+            {
+                int c = static_cast<int>((black >> shift) & 0xFF) * 255 / a;
+                out |= static_cast<DWORD>(c > 255 ? 255 : c) << shift;
+            }
+            buffer[i] = out;
+        }
+        layer->translucent = true;
+    }
+
+    layer->contentValid = true;
+    ++scene->stats.rasterized;
+}
+
+// 合成一个区域：先填充背景，再按层级从低到高复制或混合相交的图层
+static void scene_composite(Scene *scene, const RasterTarget &target, RECT r)
+{
+    if (r.left < 0)
+        r.left = 0;
+    if (r.top < 0)
+        r.top = 0;
+    if (r.right > target.width)
+        r.right = target.width;
+    if (r.bottom > target.height)
+        r.bottom = target.height;
+    if (rect_empty(r))
+        return;
+
+    int width = r.right - r.left;
+    for (int y = r.top; y < r.bottom; ++y)
+        raster_span_row(target.buffer + static_cast<size_t>(y) * target.width + r.left, width, scene->background);
+
+    for (size_t i = 0; i < scene->order.size(); ++i)
+    {
+        SceneLayer &layer = scene->layers[scene->order[i]];
+        if (!layer.visible || !layer.image || !layer.contentValid)
+            continue;
+
+        RECT part = layer_rect(layer);
+        part.left = part.left > r.left ? part.left : r.left;
+        part.top = part.top > r.top ? part.top : r.top;
+        part.right = part.right < r.right ? part.right : r.right;
+        part.bottom = part.bottom < r.bottom ? part.bottom : r.bottom;
+        if (rect_empty(part))
+            continue;
+
+        const DWORD *src = GetImageBuffer(layer.image);
+        int count = part.right - part.left;
+        for (int y = part.top; y < part.bottom; ++y)
+        {
+            DWORD *dst = target.buffer + static_cast<size_t>(y) * target.width + part.left;
+            const DWORD *row = src + static_cast<size_t>(y - layer.y) * layer.width + (part.left - layer.x);
+            if (layer.translucent)
+                raster_blend_row(dst, row, count, layer.alpha);
+            else
+                memcpy(dst, row, sizeof(DWORD) * count);
+        }
+        ++scene->stats.blits;
+    }
+
+    easyx_dirty_add(r.left, r.top, r.right - 1, r.bottom - 1);
+    ++scene->stats.regions;
+}
+
+static bool scene_order_less(const Scene *scene, int a, int b)
+{
+    const SceneLayer &la = scene->layers[a];
+    const SceneLayer &lb = scene->layers[b];
+    return la.z != lb.z ? la.z < lb.z : a < b;
+}
+
+void *easyx_scene_create()
+{
+    Scene *scene = new Scene();
+    scene->orderValid = true;
+    scene->full = true;
+    scene->background = 0;
+    memset(&scene->stats, 0, sizeof(scene->stats));
+    return scene;
+}
+
+void easyx_scene_destroy(void *scene)
+{
+    Scene *s = scene_cast(scene);
+    if (!s)
+        return;
+    for (size_t i = 0; i < s->layers.size(); ++i)
+    {
+        if (s->layers[i].image)
+            easyx_image_release(s->layers[i].image);
+    }
+    delete s;
+}
+
+int easyx_scene_addlayer(void *scene, int x, int y, int width, int height, int z, int flags)
+{
+    Scene *s = scene_cast(scene);
+    if (!s || width <= 0 || height <= 0)
+        return -1;
+
+    SceneLayer layer;
+    layer.alive = true;
+    layer.visible = true;
+    layer.contentValid = false;
+    layer.changed = true;
+    layer.translucent = false;
+    layer.x = x;
+    layer.y = y;
+    layer.width = width;
+    layer.height = height;
+    layer.z = z;
+    layer.flags = flags;
+    layer.alpha = 255;
+    layer.fill = 0;
+    layer.image = NULL;
+    layer.hasPresented = false;
+    memset(&layer.presented, 0, sizeof(layer.presented));
+    s->layers.push_back(layer);
+    s->orderValid = false;
+    return static_cast<int>(s->layers.size()) - 1;
+}
+
+void easyx_scene_removelayer(void *scene, int layer)
+{
+    Scene *s = scene_cast(scene);
+    SceneLayer *l = scene_layer(s, layer);
+    if (!l)
+        return;
+
+    if (l->hasPresented)
+        scene_damage(s, l->presented);
+    if (l->image)
+        easyx_image_release(l->image);
+    l->image = NULL;
+    l->alive = false;
+    l->commands.clear();
+    l->commands.shrink_to_fit();
+    s->orderValid = false;
+}
+
+void easyx_scene_setcommands(void *scene, int layer, const void *buf, size_t len)
+{
+    SceneLayer *l = scene_layer(scene_cast(scene), layer);
+    if (!l)
+        return;
+
+    const uint8_t *bytes = static_cast<const uint8_t *>(buf);
+    l->commands.assign(bytes, bytes ? bytes + len : bytes);
+    l->contentValid = false;
+}
+
+void easyx_scene_invalidate(void *scene, int layer)
+{
+    SceneLayer *l = scene_layer(scene_cast(scene), layer);
+    if (l)
+        l->contentValid = false;
+}
+
+void easyx_scene_setposition(void *scene, int layer, int x, int y)
+{
+    Scene *s = scene_cast(scene);
+    SceneLayer *l = scene_layer(s, layer);
+    if (!l || (l->x == x && l->y == y))
+        return;
+    l->x = x;
+    l->y = y;
+    l->changed = true;
+}
+
+void easyx_scene_setsize(void *scene, int layer, int width, int height)
+{
+    Scene *s = scene_cast(scene);
+    SceneLayer *l = scene_layer(s, layer);
+    if (!l || width <= 0 || height <= 0 || (l->width == width && l->height == height))
+        return;
+    l->width = width;
+    l->height = height;
+    l->contentValid = false;
+    l->changed = true;
+}
+
+void easyx_scene_setvisible(void *scene, int layer, int visible)
+{
+    Scene *s = scene_cast(scene);
+    SceneLayer *l = scene_layer(s, layer);
+    if (!l || l->visible == (visible != 0))
+        return;
+    l->visible = visible != 0;
+    l->changed = true;
+}
+
+void easyx_scene_setz(void *scene, int layer, int z)
+{
+    Scene *s = scene_cast(scene);
+    SceneLayer *l = scene_layer(s, layer);
+    if (!l || l->z == z)
+        return;
+    l->z = z;
+    s->orderValid = false;
+    l->changed = true;
+}
+
+void easyx_scene_setalpha(void *scene, int layer, uint8_t alpha)
+{
+    Scene *s = scene_cast(scene);
+    SceneLayer *l = scene_layer(s, layer);
+    if (!l || l->alpha == alpha)
+        return;
+    l->alpha = alpha;
+    if (!(l->flags & EASYX_LAYER_TRANSPARENT))
+        l->translucent = alpha < 255;
+    l->changed = true;
+}
+
+void easyx_scene_setfill(void *scene, int layer, uint32_t color)
+{
+    SceneLayer *l = scene_layer(scene_cast(scene), layer);
+    DWORD pixel = BGR(color) & 0x00FFFFFF;
+    if (!l || l->fill == pixel)
+        return;
+    l->fill = pixel;
+    l->contentValid = false;
+}
+
+void easyx_scene_setbackground(void *scene, uint32_t color)
+{
+    Scene *s = scene_cast(scene);
+    DWORD pixel = BGR(color) & 0x00FFFFFF;
+    if (!s || s->background == pixel)
+        return;
+    s->background = pixel;
+    s->full = true;
+}
+
+void easyx_scene_damage(void *scene, int left, int top, int right, int bottom)
+{
+    Scene *s = scene_cast(scene);
+    if (!s)
+        return;
+    RECT r = {left < right ? left : right, top < bottom ? top : bottom, (left < right ? right : left) + 1, (top < bottom ? bottom : top) + 1};
+    scene_damage(s, r);
+}
+
+void easyx_scene_redraw(void *scene)
+{
+    Scene *s = scene_cast(scene);
+    if (s)
+        s->full = true;
+}
+
+int easyx_scene_present(void *scene)
+{
+    PROFILE_SCOPE(EASYX_PROF_IMAGES);
+    Scene *s = scene_cast(scene);
+    if (!s)
+        return 0;
+
+    RasterTarget target = raster_target();
+    if (!target.buffer)
+        return 0;
+
+    if (!s->orderValid)
+    {
+        s->order.clear();
+        for (size_t i = 0; i < s->layers.size(); ++i)
+        {
+            if (s->layers[i].alive)
+                s->order.push_back(static_cast<int>(i));
+        }
+        std::stable_sort(s->order.begin(), s->order.end(), [s](int a, int b) { return scene_order_less(s, a, b); });
+        s->orderValid = true;
+    }
+
+    // 只有可见的图层需要光栅化，内容变化或属性变化时重新合成旧范围和新范围
+    for (size_t i = 0; i < s->order.size(); ++i)
+    {
+        SceneLayer &layer = s->layers[s->order[i]];
+        if (layer.visible && !layer.contentValid)
+        {
+            layer_rasterize(s, &layer);
+            layer.changed = true;
+        }
+        if (!layer.changed)
+            continue;
+
+        if (layer.hasPresented)
+            scene_damage(s, layer.presented);
+        layer.hasPresented = layer.visible;
+        if (layer.visible)
+        {
+            layer.presented = layer_rect(layer);
+            scene_damage(s, layer.presented);
+        }
+        layer.changed = false;
+    }
+
+    if (s->full)
+    {
+        RECT all = {0, 0, target.width, target.height};
+        s->damage.assign(1, all);
+        s->full = false;
+    }
+
+    uint64_t blits = s->stats.blits;
+    for (size_t i = 0; i < s->damage.size(); ++i)
+        scene_composite(s, target, s->damage[i]);
+    s->damage.clear();
+    ++s->stats.presents;
+    return static_cast<int>(s->stats.blits - blits);
+}
+
+void easyx_scene_getstats(void *scene, EasyXSceneStats *pStats)
+{
+    Scene *s = scene_cast(scene);
+    if (s && pStats)
+        *pStats = s->stats;
+}
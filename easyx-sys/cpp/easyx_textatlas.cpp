@@ -0,0 +1,362 @@
+// easyx_textatlas.cpp
+// 字形图集文本渲染，绕过 GDI 的 outtextxy 直接写入图像缓冲区
+
+#include "easyx_wrapper.h"
+#include "easyx_profiler.h"
+#include <unordered_map>
+#include <vector>
+#include <windows.h>
+#include <tchar.h>
+#include "../EasyX_26.1.1/include/easyx.h"
+
+// 图集页尺寸
+#define ATLAS_PAGE_SIZE 512
+
+// 字形在图集中的位置
+struct AtlasGlyph
+{
+    int page;
+    int x, y;
+    int width, height;
+    int advance;
+};
+
+struct TextAtlas
+{
+    LOGFONT font;
+    int lineHeight;
+
+    std::vector<IMAGE *> pages;
+    int cursorX, cursorY, shelfHeight; // 当前页的货架式装箱游标
+
+    IMAGE *scratch; // 光栅化单个字形用的暂存图像
+
+    AtlasGlyph ascii[128];
+    bool asciiReady[128];
+    std::unordered_map<uint32_t, AtlasGlyph> glyphs;
+};
+
+// 解码一个 UTF-8 码点，非法序列返回 U+FFFD
+static uint32_t atlas_decode_utf8(const unsigned char *&p, const unsigned char *end)
+{
+    uint32_t c = *p++;
+    int extra = 0;
+
+    if (c < 0x80)
+        return c;
+    else if ((c & 0xE0) == 0xC0)
+        c &= 0x1F, extra = 1;
+    else if ((c & 0xF0) == 0xE0)
+        c &= 0x0F, extra = 2;
+    else if ((c & 0xF8) == 0xF0)
+        c &= 0x07, extra = 3;
+    else
+        return 0xFFFD;
+
+    for (; extra > 0; --extra)
+    {
+        if (p >= end || (*p & 0xC0) != 0x80)
+            return 0xFFFD;
+        c = (c << 6) | (*p++ & 0x3F);
+    }
+
+    return c > 0x10FFFF ? 0xFFFD : c;
+}
+
+// 码点转换为以 0 结尾的 TCHAR 字符串
+static void atlas_codepoint_to_tchar(uint32_t c, TCHAR out[3])
+{
+#ifdef UNICODE
+    if (c >= 0x10000)
+    {
+        c -= 0x10000;
+        out[0] = static_cast<TCHAR>(0xD800 + (c >> 10));
+        out[1] = static_cast<TCHAR>(0xDC00 + (c & 0x3FF));
+        out[2] = 0;
+        return;
+    }
+    out[0] = static_cast<TCHAR>(c);
+#else
+    out[0] = static_cast<TCHAR>(c < 0x80 ? c : '?');
+#endif
+    out[1] = 0;
+}
+
+// 在图集中为 width x height 的字形分配位置，必要时新建一页
+static int atlas_allocate(TextAtlas *atlas, int width, int height, int *px, int *py)
+{
+    if (atlas->pages.empty() || atlas->cursorX + width > ATLAS_PAGE_SIZE)
+    {
+        atlas->cursorX = 0;
+        atlas->cursorY += atlas->shelfHeight;
+        atlas->shelfHeight = 0;
+    }
+
+    if (atlas->pages.empty() || atlas->cursorY + height > ATLAS_PAGE_SIZE)
+    {
+        atlas->pages.push_back(reinterpret_cast<IMAGE *>(easyx_create_image(ATLAS_PAGE_SIZE, ATLAS_PAGE_SIZE)));
+        atlas->cursorX = 0;
+        atlas->cursorY = 0;
+        atlas->shelfHeight = 0;
+    }
+
+    *px = atlas->cursorX;
+    *py = atlas->cursorY;
+
+    // 字形之间留 1 像素间隔
+    atlas->cursorX += width + 1;
+    if (height + 1 > atlas->shelfHeight)
+        atlas->shelfHeight = height + 1;
+
+    return static_cast<int>(atlas->pages.size()) - 1;
+}
+
+// 光栅化一个字形并写入图集，只保存覆盖率（0-255）
+static AtlasGlyph atlas_rasterize(TextAtlas *atlas, uint32_t c)
+{
+    TCHAR str[3];
+    atlas_codepoint_to_tchar(c, str);
+
+    void *previous = easyx_getworkingimage();
+    easyx_setworkingimage(atlas->scratch);
+
+    settextstyle(&atlas->font);
+
+    AtlasGlyph glyph = {};
+    glyph.advance = textwidth(str);
+    glyph.height = textheight(str);
+    // 斜体字形会伸出步进宽度之外
+    glyph.width = glyph.advance + (atlas->font.lfItalic ? glyph.height / 2 : 0);
+
+    if (glyph.width > 0 && glyph.height > 0 && glyph.width <= ATLAS_PAGE_SIZE && glyph.height <= ATLAS_PAGE_SIZE)
+    {
+        if (atlas->scratch->getwidth() < glyph.width || atlas->scratch->getheight() < glyph.height)
+        {
+            easyx_image_resize(atlas->scratch, glyph.width, glyph.height);
+            settextstyle(&atlas->font);
+        }
+
+        // 黑底白字绘制，像素亮度即覆盖率
+        setbkcolor(BLACK);
+        cleardevice();
+        setbkmode(TRANSPARENT);
+        settextcolor(WHITE);
+        outtextxy(0, 0, str);
+
+        glyph.page = atlas_allocate(atlas, glyph.width, glyph.height, &glyph.x, &glyph.y);
+
+        const DWORD *src = GetImageBuffer(atlas->scratch);
+        int srcPitch = atlas->scratch->getwidth();
+        DWORD *dst = GetImageBuffer(atlas->pages[glyph.page]);
+
+        for (int row = 0; row < glyph.height; ++row)
+        {
+            const DWORD *s = src + row * srcPitch;
+            DWORD *d = dst + (glyph.y + row) * ATLAS_PAGE_SIZE + glyph.x;
+            for (int col = 0; col < glyph.width; ++col)
+            {
+                DWORD r = (s[col] >> 16) & 0xFF, g = (s[col] >> 8) & 0xFF, b = s[col] & 0xFF;
+                DWORD coverage = r > g ? (r > b ? r : b) : (g > b ? g : b);
+                d[col] = coverage;
+            }
+        }
+    }
+    else
+    {
+        // 空白字符（或超出一页的字形）只记录步进宽度
+        glyph.width = 0;
+        glyph.height = 0;
+    }
+
+    easyx_setworkingimage(previous);
+    return glyph;
+}
+
+static const AtlasGlyph &atlas_glyph(TextAtlas *atlas, uint32_t c)
+{
+    if (c < 128)
+    {
+        if (!atlas->asciiReady[c])
+        {
+            atlas->ascii[c] = atlas_rasterize(atlas, c);
+            atlas->asciiReady[c] = true;
+        }
+        return atlas->ascii[c];
+    }
+
+    std::unordered_map<uint32_t, AtlasGlyph>::iterator it = atlas->glyphs.find(c);
+    if (it == atlas->glyphs.end())
+        it = atlas->glyphs.insert(std::make_pair(c, atlas_rasterize(atlas, c))).first;
+    return it->second;
+}
+
+// 按覆盖率将颜色混合到目标像素
+static void atlas_blend(DWORD *dst, const DWORD *coverage, int count, DWORD color)
+{
+    DWORD sr = (color >> 16) & 0xFF, sg = (color >> 8) & 0xFF, sb = color & 0xFF;
+
+    for (int i = 0; i < count; ++i)
+    {
+        DWORD a = coverage[i];
+        if (a == 0)
+            continue;
+        if (a == 255)
+        {
+            dst[i] = color;
+            continue;
+        }
+
+        DWORD d = dst[i];
+        DWORD dr = (d >> 16) & 0xFF, dg = (d >> 8) & 0xFF, db = d & 0xFF;
+        // (s * a + d * (255 - a)) / 255，使用 +128 和 *257 >> 16 近似除法
+        DWORD r = sr * a + dr * (255 - a) + 128;
+        DWORD g = sg * a + dg * (255 - a) + 128;
+        DWORD b = sb * a + db * (255 - a) + 128;
+        r = (r + (r >> 8)) >> 8;
+        g = (g + (g >> 8)) >> 8;
+        b = (b + (b >> 8)) >> 8;
+        dst[i] = (r << 16) | (g << 8) | b;
+    }
+}
+
+void *easyx_textatlas_create(const void *pLogFont)
+{
+    TextAtlas *atlas = new TextAtlas();
+
+    if (pLogFont)
+        atlas->font = *reinterpret_cast<const LOGFONT *>(pLogFont);
+    else
+        easyx_gettextstyle(&atlas->font);
+
+    // 图集只保存灰度覆盖率，ClearType 的彩色边缘无法表示
+    atlas->font.lfQuality = ANTIALIASED_QUALITY;
+
+    atlas->cursorX = 0;
+    atlas->cursorY = 0;
+    atlas->shelfHeight = 0;
+    atlas->scratch = reinterpret_cast<IMAGE *>(easyx_create_image(1, 1));
+
+    for (int i = 0; i < 128; ++i)
+        atlas->asciiReady[i] = false;
+
+    // 预先光栅化可打印 ASCII 字符
+    for (uint32_t c = 32; c < 127; ++c)
+        atlas_glyph(atlas, c);
+
+    atlas->lineHeight = 0;
+    for (uint32_t c = 32; c < 127; ++c)
+        if (atlas->ascii[c].height > atlas->lineHeight)
+            atlas->lineHeight = atlas->ascii[c].height;
+
+    return atlas;
+}
+
+void easyx_textatlas_destroy(void *atlas)
+{
+    TextAtlas *self = reinterpret_cast<TextAtlas *>(atlas);
+    if (!self)
+        return;
+
+    for (size_t i = 0; i < self->pages.size(); ++i)
+        easyx_destroy_image(self->pages[i]);
+    easyx_destroy_image(self->scratch);
+
+    delete self;
+}
+
+void easyx_textatlas_preload(void *atlas, const char *str, size_t len)
+{
+    PROFILE_SCOPE(EASYX_PROF_TEXT);
+    TextAtlas *self = reinterpret_cast<TextAtlas *>(atlas);
+    if (!self)
+        return;
+
+    const unsigned char *p = reinterpret_cast<const unsigned char *>(str);
+    const unsigned char *end = p + (str ? len : 0);
+
+    while (p < end)
+        atlas_glyph(self, atlas_decode_utf8(p, end));
+}
+
+int easyx_textatlas_draw(void *atlas, int x, int y, const char *str, size_t len, uint32_t color)
+{
+    PROFILE_SCOPE(EASYX_PROF_TEXT);
+    TextAtlas *self = reinterpret_cast<TextAtlas *>(atlas);
+    if (!self)
+        return 0;
+
+    const unsigned char *p = reinterpret_cast<const unsigned char *>(str);
+    const unsigned char *end = p + (str ? len : 0);
+
+    // 没有可写的工作图像时不绘制，画笔停在起点
+    IMAGE *target = GetWorkingImage();
+    DWORD *buffer = GetImageBuffer(target);
+    if (!buffer)
+        return 0;
+
+    int width = getwidth();
+    int height = getheight();
+
+    // COLORREF 为 0x00BBGGRR，缓冲区像素为 0x00RRGGBB
+    DWORD pixel = BGR(color);
+    int penX = x;
+    int extent = x; // 斜体字形可能超出步进宽度
+
+    while (p < end)
+    {
+        const AtlasGlyph &glyph = atlas_glyph(self, atlas_decode_utf8(p, end));
+
+        // 裁剪到目标设备范围内
+        int left = penX < 0 ? -penX : 0;
+        int top = y < 0 ? -y : 0;
+        int right = glyph.width < width - penX ? glyph.width : width - penX;
+        int bottom = glyph.height < height - y ? glyph.height : height - y;
+
+        if (left < right && top < bottom)
+        {
+            const DWORD *page = GetImageBuffer(self->pages[glyph.page]);
+            for (int row = top; row < bottom; ++row)
+            {
+                const DWORD *coverage = page + (glyph.y + row) * ATLAS_PAGE_SIZE + glyph.x + left;
+                atlas_blend(buffer + (y + row) * width + penX + left, coverage, right - left, pixel);
+            }
+        }
+
+        if (penX + glyph.width > extent)
+            extent = penX + glyph.width;
+        penX += glyph.advance;
+    }
+
+    if (penX > extent)
+        extent = penX;
+    if (extent > x)
+        easyx_dirty_add(x, y, extent - 1, y + self->lineHeight - 1);
+
+    return penX - x;
+}
+
+int easyx_textatlas_textwidth(void *atlas, const char *str, size_t len)
+{
+    PROFILE_SCOPE(EASYX_PROF_TEXT);
+    TextAtlas *self = reinterpret_cast<TextAtlas *>(atlas);
+    if (!self)
+        return 0;
+
+    const unsigned char *p = reinterpret_cast<const unsigned char *>(str);
+    const unsigned char *end = p + (str ? len : 0);
+
+    int width = 0;
+    while (p < end)
+        width += atlas_glyph(self, atlas_decode_utf8(p, end)).advance;
+
+    return width;
+}
+
+int easyx_textatlas_textheight(void *atlas)
+{
+    TextAtlas *self = reinterpret_cast<TextAtlas *>(atlas);
+    if (!self)
+        return 0;
+
+    return self->lineHeight;
+}
@@ -0,0 +1,626 @@
+// easyx_textlayout.cpp
+// 文本排版：按段落缓存测量结果和换行位置，每行用一次 ExtTextOut 绘制
+
+#include "easyx_wrapper.h"
+#include "easyx_profiler.h"
+#include <string.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <windows.h>
+#include <tchar.h>
+#include "../EasyX_26.1.1/include/easyx.h"
+
+struct LayoutLine
+{
+    int start;  // 段落内的起始位置（UTF-16 码元）
+    int length; // 包含行尾空白的长度
+    int visible; // 不含行尾空白的长度，绘制和计算宽度只用这一部分
+    int width;
+};
+
+struct LayoutParagraph
+{
+    std::string utf8;
+    std::wstring text;
+    std::vector<int> extents; // extents[i] 为前 i + 1 个码元的宽度
+    bool measured;
+    int wrapWidth; // lines 对应的换行宽度，-1 表示需要重新换行
+    std::vector<LayoutLine> lines;
+};
+
+struct TextLayout
+{
+    LOGFONT font;
+    void *cached; // 字体缓存中的字体，与其他排版和 easyx_font_acquire 共享
+    int width; // 换行宽度，小于等于 0 表示只在换行符处换行
+    int align;
+    int spacing;
+    int lineHeight; // 0 表示需要重新取得字体度量
+
+    std::vector<LayoutParagraph> paragraphs;
+    bool flatValid; // 以下汇总信息与段落一致
+    int lineCount;
+    int maxWidth;
+
+    EasyXTextLayoutStats stats;
+};
+
+static TextLayout *layout_cast(void *layout)
+{
+    return reinterpret_cast<TextLayout *>(layout);
+}
+
+static std::wstring layout_widen(const char *str, size_t len)
+{
+    std::wstring out;
+    if (len == 0)
+        return out;
+    out.resize(len);
+    int n = MultiByteToWideChar(CP_UTF8, 0, str, static_cast<int>(len), &out[0], static_cast<int>(len));
+    out.resize(n > 0 ? n : 0);
+    return out;
+}
+
+// 段落内前 units 个 UTF-16 码元对应的 UTF-8 字节数
+static size_t layout_bytes(const LayoutParagraph &p, int units)
+{
+    if (units <= 0)
+        return 0;
+    if (units >= static_cast<int>(p.text.size()))
+        return p.utf8.size();
+    int n = WideCharToMultiByte(CP_UTF8, 0, p.text.data(), units, NULL, 0, NULL, NULL);
+    return n > 0 ? static_cast<size_t>(n) : 0;
+}
+
+static int layout_units(const LayoutParagraph &p, size_t bytes)
+{
+    if (bytes == 0)
+        return 0;
+    if (bytes >= p.utf8.size())
+        return static_cast<int>(p.text.size());
+    return MultiByteToWideChar(CP_UTF8, 0, p.utf8.data(), static_cast<int>(bytes), NULL, 0);
+}
+
+static inline bool layout_space(wchar_t c)
+{
+    return c == L' ' || c == L'\t' || c == 0x3000;
+}
+
+static inline bool layout_low_surrogate(wchar_t c)
+{
+    return c >= 0xDC00 && c <= 0xDFFF;
+}
+
+// 中日韩文字每个字之间都可以换行
+static inline bool layout_cjk(wchar_t c)
+{
+    return (c >= 0x2E80 && c <= 0x9FFF) || (c >= 0xAC00 && c <= 0xD7AF) || (c >= 0xF900 && c <= 0xFAFF) || (c >= 0xFF00 && c <= 0xFFEF);
+}
+
+// 不能出现在行首的标点
+static inline bool layout_no_start(wchar_t c)
+{
+    return wcschr(L"，。、；：！？）》」』】〕,.;:!?)]}", c) != NULL && c != 0;
+}
+
+// 能否在 text[i] 之前换行
+static bool layout_can_break(const std::wstring &text, size_t i)
+{
+    wchar_t prev = text[i - 1], cur = text[i];
+    if (layout_low_surrogate(cur) || layout_space(cur) || layout_no_start(cur))
+        return false;
+    return layout_space(prev) || prev == L'-' || layout_cjk(prev) || layout_cjk(cur);
+}
+
+static inline int layout_extent(const LayoutParagraph &p, int end)
+{
+    return end > 0 ? p.extents[end - 1] : 0;
+}
+
+// 用一次 GetTextExtentExPoint 取得段落中每个前缀的宽度，之后换行只做查表
+static void layout_measure(TextLayout *layout, LayoutParagraph &p, HDC hdc)
+{
+    int n = static_cast<int>(p.text.size());
+    p.extents.resize(n);
+    if (n > 0)
+    {
+        SIZE size;
+        if (!GetTextExtentExPointW(hdc, p.text.data(), n, 0, NULL, p.extents.data(), &size))
+            std::fill(p.extents.begin(), p.extents.end(), 0);
+        ++layout->stats.measured;
+    }
+    p.measured = true;
+    p.wrapWidth = -1;
+}
+
+static void layout_wrap(TextLayout *layout, LayoutParagraph &p)
+{
+    int n = static_cast<int>(p.text.size());
+    p.lines.clear();
+    p.wrapWidth = layout->width > 0 ? layout->width : 0;
+    ++layout->stats.wrapped;
+
+    int start = 0;
+    do
+    {
+        int base = layout_extent(p, start);
+        int end = n;
+        if (layout->width > 0)
+        {
+            // 前缀宽度单调不减，二分查找放得下的最远位置
+            end = static_cast<int>(std::upper_bound(p.extents.begin() + start, p.extents.end(), base + layout->width) - p.extents.begin());
+            if (end <= start && start < n)
+                end = start + 1;
+        }
+
+        int next = end;
+        if (end < n)
+        {
+            if (layout_space(p.text[end]))
+            {
+                // 溢出的是空白，空白挂在行尾
+                next = end;
+            }
+            else
+            {
+                int brk = end;
+                while (brk > start && !layout_can_break(p.text, brk))
+                    --brk;
+                // 没有换行机会的长单词按字符截断，不拆开代理对
+                if (brk == start)
+                {
+                    brk = end;
+                    if (brk < n && layout_low_surrogate(p.text[brk]))
+                        brk = brk - 1 > start ? brk - 1 : brk + 1;
+                }
+                next = brk;
+            }
+            while (next < n && layout_space(p.text[next]))
+                ++next;
+        }
+
+        LayoutLine line;
+        line.start = start;
+        line.length = next - start;
+        line.visible = line.length;
+        while (line.visible > 0 && layout_space(p.text[start + line.visible - 1]))
+            --line.visible;
+        line.width = layout_extent(p, start + line.visible) - base;
+        p.lines.push_back(line);
+        start = next;
+    } while (start < n);
+}
+
+static HDC layout_hdc()
+{
+    return GetImageHDC(GetWorkingImage());
+}
+
+// 测量、换行并汇总。只处理内容、字体或宽度改变过的段落
+static void layout_update(TextLayout *layout)
+{
+    bool needMeasure = layout->lineHeight == 0 || !layout->cached;
+    for (size_t i = 0; i < layout->paragraphs.size() && !needMeasure; ++i)
+        needMeasure = !layout->paragraphs[i].measured;
+
+    if (needMeasure)
+    {
+        if (!layout->cached)
+            layout->cached = easyx_font_acquire(&layout->font);
+        HDC hdc = layout_hdc();
+        if (!hdc)
+        {
+            // 还没有绘图环境时按零宽度排版，之后再测量
+            for (size_t i = 0; i < layout->paragraphs.size(); ++i)
+            {
+                LayoutParagraph &p = layout->paragraphs[i];
+                if (!p.measured && p.extents.size() != p.text.size())
+                {
+                    p.extents.assign(p.text.size(), 0);
+                    p.wrapWidth = -1;
+                }
+            }
+            needMeasure = false;
+        }
+    }
+
+    if (needMeasure)
+    {
+        HDC hdc = layout_hdc();
+        HGDIOBJ old = SelectObject(hdc, easyx_font_gethandle(layout->cached));
+        if (layout->lineHeight == 0)
+        {
+            TEXTMETRIC tm;
+            layout->lineHeight = GetTextMetrics(hdc, &tm) ? tm.tmHeight + tm.tmExternalLeading : 16;
+            if (layout->lineHeight <= 0)
+                layout->lineHeight = 1;
+        }
+        for (size_t i = 0; i < layout->paragraphs.size(); ++i)
+        {
+            if (!layout->paragraphs[i].measured)
+                layout_measure(layout, layout->paragraphs[i], hdc);
+        }
+        SelectObject(hdc, old);
+    }
+
+    int wrapWidth = layout->width > 0 ? layout->width : 0;
+    for (size_t i = 0; i < layout->paragraphs.size(); ++i)
+    {
+        LayoutParagraph &p = layout->paragraphs[i];
+        if (p.wrapWidth != wrapWidth)
+        {
+            layout_wrap(layout, p);
+            layout->flatValid = false;
+        }
+    }
+
+    if (layout->flatValid)
+        return;
+
+    layout->lineCount = 0;
+    layout->maxWidth = 0;
+    for (size_t i = 0; i < layout->paragraphs.size(); ++i)
+    {
+        const LayoutParagraph &p = layout->paragraphs[i];
+        layout->lineCount += static_cast<int>(p.lines.size());
+        for (size_t j = 0; j < p.lines.size(); ++j)
+            layout->maxWidth = p.lines[j].width > layout->maxWidth ? p.lines[j].width : layout->maxWidth;
+    }
+    layout->flatValid = true;
+}
+
+static inline int layout_pitch(const TextLayout *layout)
+{
+    return layout->lineHeight + layout->spacing;
+}
+
+static int layout_box_width(const TextLayout *layout)
+{
+    return layout->width > 0 ? layout->width : layout->maxWidth;
+}
+
+static int layout_line_x(const TextLayout *layout, const LayoutLine &line)
+{
+    int box = layout_box_width(layout);
+    if (layout->align == EASYX_TEXTLAYOUT_CENTER)
+        return (box - line.width) / 2;
+    if (layout->align == EASYX_TEXTLAYOUT_RIGHT)
+        return box - line.width;
+    return 0;
+}
+
+// 替换全部文本。内容没有变化的段落（编辑位置之前和之后的段落）保留测量和换行结果
+static void layout_assign(TextLayout *layout, const char *str, size_t len)
+{
+    std::vector<std::string> parts;
+    size_t begin = 0;
+    for (size_t i = 0; i <= len; ++i)
+    {
+        if (i == len || str[i] == '\n')
+        {
+            size_t end = i > begin && str[i - 1] == '\r' ? i - 1 : i;
+            parts.push_back(std::string(str + begin, end - begin));
+            begin = i + 1;
+        }
+    }
+
+    std::vector<LayoutParagraph> &old = layout->paragraphs;
+    size_t prefix = 0;
+    while (prefix < old.size() && prefix < parts.size() && old[prefix].utf8 == parts[prefix])
+        ++prefix;
+    size_t suffix = 0;
+    while (suffix < old.size() - prefix && suffix < parts.size() - prefix && old[old.size() - 1 - suffix].utf8 == parts[parts.size() - 1 - suffix])
+        ++suffix;
+
+    std::vector<LayoutParagraph> next(parts.size());
+    for (size_t i = 0; i < prefix; ++i)
+        next[i] = std::move(old[i]);
+    for (size_t i = 0; i < suffix; ++i)
+        next[parts.size() - 1 - i] = std::move(old[old.size() - 1 - i]);
+    for (size_t i = prefix; i < parts.size() - suffix; ++i)
+    {
+        LayoutParagraph &p = next[i];
+        p.utf8.swap(parts[i]);
+        p.text = layout_widen(p.utf8.data(), p.utf8.size());
+        p.measured = false;
+        p.wrapWidth = -1;
+    }
+
+    layout->stats.reused += prefix + suffix;
+    layout->paragraphs.swap(next);
+    layout->flatValid = false;
+}
+
+static std::string layout_join(const TextLayout *layout)
+{
+    std::string out;
+    for (size_t i = 0; i < layout->paragraphs.size(); ++i)
+    {
+        if (i > 0)
+            out.push_back('\n');
+        out.append(layout->paragraphs[i].utf8);
+    }
+    return out;
+}
+
+static void layout_setfont(TextLayout *layout, const void *pLogFont)
+{
+    if (pLogFont)
+        layout->font = *reinterpret_cast<const LOGFONT *>(pLogFont);
+    else
+        easyx_gettextstyle(&layout->font);
+    // 旋转的文本无法按行排版
+    layout->font.lfEscapement = 0;
+    layout->font.lfOrientation = 0;
+
+    easyx_font_release(layout->cached);
+    layout->cached = NULL;
+    layout->lineHeight = 0;
+    for (size_t i = 0; i < layout->paragraphs.size(); ++i)
+        layout->paragraphs[i].measured = false;
+    layout->flatValid = false;
+}
+
+void *easyx_textlayout_create(const char *str, size_t len, const void *pLogFont, int width)
+{
+    TextLayout *layout = new TextLayout();
+    layout->cached = NULL;
+    layout->width = width;
+    layout->align = EASYX_TEXTLAYOUT_LEFT;
+    layout->spacing = 0;
+    layout->lineHeight = 0;
+    layout->flatValid = false;
+    layout->lineCount = 0;
+    layout->maxWidth = 0;
+    memset(&layout->stats, 0, sizeof(layout->stats));
+    layout_setfont(layout, pLogFont);
+    layout_assign(layout, str ? str : "", str ? len : 0);
+    return layout;
+}
+
+void easyx_textlayout_destroy(void *layout)
+{
+    TextLayout *l = layout_cast(layout);
+    if (!l)
+        return;
+    easyx_font_release(l->cached);
+    delete l;
+}
+
+void easyx_textlayout_settext(void *layout, const char *str, size_t len)
+{
+    TextLayout *l = layout_cast(layout);
+    if (l)
+        layout_assign(l, str ? str : "", str ? len : 0);
+}
+
+int easyx_textlayout_edit(void *layout, size_t start, size_t removeLen, const char *str, size_t len)
+{
+    TextLayout *l = layout_cast(layout);
+    if (!l || (!str && len > 0))
+        return EASYX_TEXTLAYOUT_ERR_RANGE;
+
+    std::string text = layout_join(l);
+    if (start > text.size() || removeLen > text.size() - start)
+        return EASYX_TEXTLAYOUT_ERR_RANGE;
+    // 编辑位置必须在 UTF-8 字符边界上
+    size_t end = start + removeLen;
+    if ((start < text.size() && (text[start] & 0xC0) == 0x80) || (end < text.size() && (text[end] & 0xC0) == 0x80))
+        return EASYX_TEXTLAYOUT_ERR_RANGE;
+
+    text.replace(start, removeLen, str ? str : "", len);
+    layout_assign(l, text.data(), text.size());
+    return 0;
+}
+
+void easyx_textlayout_setwidth(void *layout, int width)
+{
+    TextLayout *l = layout_cast(layout);
+    if (l)
+        l->width = width;
+}
+
+void easyx_textlayout_setfont(void *layout, const void *pLogFont)
+{
+    TextLayout *l = layout_cast(layout);
+    if (l)
+        layout_setfont(l, pLogFont);
+}
+
+void easyx_textlayout_setalign(void *layout, int align)
+{
+    TextLayout *l = layout_cast(layout);
+    if (l)
+        l->align = align;
+}
+
+void easyx_textlayout_setlinespacing(void *layout, int spacing)
+{
+    TextLayout *l = layout_cast(layout);
+    if (l)
+        l->spacing = spacing;
+}
+
+void easyx_textlayout_getsize(void *layout, int *pSize)
+{
+    PROFILE_SCOPE(EASYX_PROF_TEXT);
+    TextLayout *l = layout_cast(layout);
+    if (!l || !pSize)
+        return;
+    layout_update(l);
+    pSize[0] = layout_box_width(l);
+    pSize[1] = l->lineCount > 0 ? l->lineCount * layout_pitch(l) - l->spacing : 0;
+}
+
+int easyx_textlayout_linecount(void *layout)
+{
+    PROFILE_SCOPE(EASYX_PROF_TEXT);
+    TextLayout *l = layout_cast(layout);
+    if (!l)
+        return 0;
+    layout_update(l);
+    return l->lineCount;
+}
+
+int easyx_textlayout_getline(void *layout, int index, int *pLine)
+{
+    PROFILE_SCOPE(EASYX_PROF_TEXT);
+    TextLayout *l = layout_cast(layout);
+    if (!l || !pLine || index < 0)
+        return 0;
+    layout_update(l);
+
+    size_t offset = 0;
+    int row = 0;
+    for (size_t i = 0; i < l->paragraphs.size(); ++i)
+    {
+        const LayoutParagraph &p = l->paragraphs[i];
+        if (index < row + static_cast<int>(p.lines.size()))
+        {
+            const LayoutLine &line = p.lines[index - row];
+            size_t begin = layout_bytes(p, line.start);
+            pLine[0] = static_cast<int>(offset + begin);
+            pLine[1] = static_cast<int>(layout_bytes(p, line.start + line.length) - begin);
+            pLine[2] = layout_line_x(l, line);
+            pLine[3] = index * layout_pitch(l);
+            pLine[4] = line.width;
+            return 1;
+        }
+        row += static_cast<int>(p.lines.size());
+        offset += p.utf8.size() + 1;
+    }
+    return 0;
+}
+
+size_t easyx_textlayout_hittest(void *layout, int x, int y)
+{
+    PROFILE_SCOPE(EASYX_PROF_TEXT);
+    TextLayout *l = layout_cast(layout);
+    if (!l)
+        return 0;
+    layout_update(l);
+    if (l->lineCount == 0)
+        return 0;
+
+    int target = y < 0 ? 0 : y / layout_pitch(l);
+    if (target >= l->lineCount)
+        target = l->lineCount - 1;
+
+    size_t offset = 0;
+    int row = 0;
+    for (size_t i = 0; i < l->paragraphs.size(); ++i)
+    {
+        const LayoutParagraph &p = l->paragraphs[i];
+        if (target < row + static_cast<int>(p.lines.size()))
+        {
+            const LayoutLine &line = p.lines[target - row];
+            int base = layout_extent(p, line.start);
+            int local = x - layout_line_x(l, line);
+            // 落在字符的左半边时光标放在字符之前
+            int pos = line.start;
+            while (pos < line.start + line.visible)
+            {
+                int left = layout_extent(p, pos) - base;
+                int right = layout_extent(p, pos + 1) - base;
+                if (local < (left + right) / 2)
+                    break;
+                ++pos;
+                if (pos < line.start + line.visible && layout_low_surrogate(p.text[pos]))
+                    ++pos;
+            }
+            return offset + layout_bytes(p, pos);
+        }
+        row += static_cast<int>(p.lines.size());
+        offset += p.utf8.size() + 1;
+    }
+    return offset > 0 ? offset - 1 : 0;
+}
+
+void easyx_textlayout_caretpos(void *layout, size_t offset, int *pPos)
+{
+    PROFILE_SCOPE(EASYX_PROF_TEXT);
+    TextLayout *l = layout_cast(layout);
+    if (!l || !pPos)
+        return;
+    layout_update(l);
+
+    pPos[0] = pPos[1] = 0;
+    pPos[2] = l->lineHeight;
+    int row = 0;
+    for (size_t i = 0; i < l->paragraphs.size(); ++i)
+    {
+        const LayoutParagraph &p = l->paragraphs[i];
+        if (offset <= p.utf8.size() || i + 1 == l->paragraphs.size())
+        {
+            int units = layout_units(p, offset);
+            // 换行处的光标属于下一行
+            size_t j = 0;
+            while (j + 1 < p.lines.size() && units >= p.lines[j + 1].start)
+                ++j;
+            const LayoutLine &line = p.lines[j];
+            int end = units < line.start + line.visible ? units : line.start + line.visible;
+            pPos[0] = layout_line_x(l, line) + layout_extent(p, end) - layout_extent(p, line.start);
+            pPos[1] = (row + static_cast<int>(j)) * layout_pitch(l);
+            return;
+        }
+        offset -= p.utf8.size() + 1;
+        row += static_cast<int>(p.lines.size());
+    }
+}
+
+void easyx_textlayout_draw(void *layout, int x, int y)
+{
+    PROFILE_SCOPE(EASYX_PROF_TEXT);
+    TextLayout *l = layout_cast(layout);
+    if (!l)
+        return;
+    layout_update(l);
+
+    HDC hdc = layout_hdc();
+    if (!hdc || !l->cached)
+        return;
+
+    // 只绘制与裁剪区相交的行
+    RECT clip;
+    bool clipped = GetClipBox(hdc, &clip) != ERROR;
+    int pitch = layout_pitch(l);
+
+    HGDIOBJ oldFont = SelectObject(hdc, easyx_font_gethandle(l->cached));
+    COLORREF oldColor = SetTextColor(hdc, gettextcolor());
+    COLORREF oldBk = SetBkColor(hdc, getbkcolor());
+    int oldMode = SetBkMode(hdc, getbkmode());
+
+    int row = 0;
+    for (size_t i = 0; i < l->paragraphs.size(); ++i)
+    {
+        const LayoutParagraph &p = l->paragraphs[i];
+        for (size_t j = 0; j < p.lines.size(); ++j, ++row)
+        {
+            const LayoutLine &line = p.lines[j];
+            int top = y + row * pitch;
+            if (clipped && (top >= clip.bottom || top + l->lineHeight <= clip.top))
+                continue;
+            if (line.visible > 0)
+                ExtTextOutW(hdc, x + layout_line_x(l, line), top, 0, NULL, p.text.data() + line.start, line.visible, NULL);
+            ++l->stats.drawnLines;
+        }
+    }
+
+    SetBkMode(hdc, oldMode);
+    SetBkColor(hdc, oldBk);
+    SetTextColor(hdc, oldColor);
+    SelectObject(hdc, oldFont);
+
+    // 斜体和字形悬垂可能超出步进宽度
+    int pad = l->lineHeight / 4 + 1;
+    int height = l->lineCount > 0 ? l->lineCount * pitch - l->spacing : 0;
+    easyx_dirty_addlogical(x, y, x + layout_box_width(l), y + height, pad);
+}
+
+void easyx_textlayout_getstats(void *layout, EasyXTextLayoutStats *pStats)
+{
+    TextLayout *l = layout_cast(layout);
+    if (l && pStats)
+        *pStats = l->stats;
+}
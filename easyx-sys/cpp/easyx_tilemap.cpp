@@ -0,0 +1,359 @@
+// easyx_tilemap.cpp
+// 瓦片地图，按区块缓存预渲染的图像，只重新渲染瓦片发生变化的区块
+
+#include "easyx_wrapper.h"
+#include "easyx_profiler.h"
+#include "easyx_atlas.h"
+#include "easyx_raster.h"
+#include <string.h>
+#include <vector>
+#include <windows.h>
+#include <tchar.h>
+#include "../EasyX_26.1.1/include/easyx.h"
+
+// 区块默认边长（瓦片数）
+#define TILEMAP_DEFAULT_CHUNK 16
+
+enum TileKind
+{
+    TILE_EMPTY,  // 未定义，使用背景色
+    TILE_COLOR,  // 纯色
+    TILE_SPRITE, // 图集中的精灵
+};
+
+struct TileDef
+{
+    TileKind kind;
+    DWORD pixel; // 纯色瓦片的像素值，0x00RRGGBB
+    void *atlas;
+    int sprite;
+};
+
+struct TileChunk
+{
+    IMAGE *image; // 首次绘制时创建
+    bool dirty;
+};
+
+struct TileMap
+{
+    int cols, rows;
+    int tileWidth, tileHeight;
+    int chunkSize;
+    int chunkCols, chunkRows;
+    std::vector<uint16_t> tiles; // 按行存放的瓦片编号
+    std::vector<TileDef> defs;   // 按瓦片编号索引，超出范围视为未定义
+    std::vector<TileChunk> chunks;
+    DWORD background;
+};
+
+static void tilemap_invalidate_all(TileMap *map)
+{
+    for (size_t i = 0; i < map->chunks.size(); ++i)
+        map->chunks[i].dirty = true;
+}
+
+static TileDef *tilemap_define(TileMap *map, uint16_t tile)
+{
+    if (tile >= map->defs.size())
+    {
+        TileDef empty = {TILE_EMPTY, 0, NULL, 0};
+        map->defs.resize(static_cast<size_t>(tile) + 1, empty);
+    }
+    return &map->defs[tile];
+}
+
+static void tilemap_mark(TileMap *map, int col, int row)
+{
+    map->chunks[(row / map->chunkSize) * map->chunkCols + col / map->chunkSize].dirty = true;
+}
+
+// 将瓦片渲染到区块图像的 dst 处，pitch 为区块图像每行的像素数
+static void tilemap_render_tile(const TileMap *map, uint16_t tile, DWORD *dst, int pitch)
+{
+    int width = map->tileWidth, height = map->tileHeight;
+    const TileDef *def = tile != 0 && tile < map->defs.size() ? &map->defs[tile] : NULL;
+
+    if (def && def->kind == TILE_COLOR)
+    {
+        for (int row = 0; row < height; ++row, dst += pitch)
+            raster_span_row(dst, width, def->pixel);
+        return;
+    }
+
+    AtlasPixels sprite;
+    if (!def || def->kind != TILE_SPRITE || !atlas_sprite_pixels(def->atlas, def->sprite, &sprite))
+    {
+        for (int row = 0; row < height; ++row, dst += pitch)
+            raster_span_row(dst, width, map->background);
+        return;
+    }
+
+    // 精灵从瓦片左上角开始绘制，超出瓦片的部分被裁掉，不足的部分为背景色
+    int copyWidth = sprite.width < width ? sprite.width : width;
+    int copyHeight = sprite.height < height ? sprite.height : height;
+    const DWORD *src = sprite.pixels;
+    for (int row = 0; row < height; ++row, dst += pitch)
+    {
+        if (row >= copyHeight || !sprite.opaque || copyWidth < width)
+            raster_span_row(dst, width, map->background);
+        if (row >= copyHeight)
+            continue;
+
+        if (sprite.opaque)
+            memcpy(dst, src, copyWidth * sizeof(DWORD));
+        else
+            raster_blend_row(dst, src, copyWidth, 255);
+        src += sprite.pitch;
+    }
+}
+
+static void tilemap_render_chunk(TileMap *map, int chunkCol, int chunkRow)
+{
+    TileChunk &chunk = map->chunks[chunkRow * map->chunkCols + chunkCol];
+
+    int firstCol = chunkCol * map->chunkSize;
+    int firstRow = chunkRow * map->chunkSize;
+    int cols = map->cols - firstCol < map->chunkSize ? map->cols - firstCol : map->chunkSize;
+    int rows = map->rows - firstRow < map->chunkSize ? map->rows - firstRow : map->chunkSize;
+    int pitch = cols * map->tileWidth;
+
+    if (!chunk.image)
+        chunk.image = reinterpret_cast<IMAGE *>(easyx_create_image(pitch, rows * map->tileHeight));
+
+    DWORD *buffer = GetImageBuffer(chunk.image);
+    for (int row = 0; row < rows; ++row)
+    {
+        const uint16_t *tiles = &map->tiles[static_cast<size_t>(firstRow + row) * map->cols + firstCol];
+        DWORD *dst = buffer + static_cast<size_t>(row) * map->tileHeight * pitch;
+        for (int col = 0; col < cols; ++col, dst += map->tileWidth)
+            tilemap_render_tile(map, tiles[col], dst, pitch);
+    }
+
+    chunk.dirty = false;
+}
+
+void *easyx_tilemap_create(int cols, int rows, int tileWidth, int tileHeight, int chunkSize)
+{
+    if (cols <= 0 || rows <= 0 || tileWidth <= 0 || tileHeight <= 0)
+        return NULL;
+    if (chunkSize <= 0)
+        chunkSize = TILEMAP_DEFAULT_CHUNK;
+
+    TileMap *map = new TileMap();
+    map->cols = cols;
+    map->rows = rows;
+    map->tileWidth = tileWidth;
+    map->tileHeight = tileHeight;
+    map->chunkSize = chunkSize;
+    map->chunkCols = (cols + chunkSize - 1) / chunkSize;
+    map->chunkRows = (rows + chunkSize - 1) / chunkSize;
+    map->tiles.assign(static_cast<size_t>(cols) * rows, 0);
+
+    TileChunk chunk = {NULL, true};
+    map->chunks.assign(static_cast<size_t>(map->chunkCols) * map->chunkRows, chunk);
+    map->background = 0;
+
+    return map;
+}
+
+void easyx_tilemap_destroy(void *tilemap)
+{
+    TileMap *map = reinterpret_cast<TileMap *>(tilemap);
+    if (!map)
+        return;
+
+    for (size_t i = 0; i < map->chunks.size(); ++i)
+        easyx_destroy_image(map->chunks[i].image);
+    delete map;
+}
+
+void easyx_tilemap_definecolor(void *tilemap, uint16_t tile, uint32_t color)
+{
+    TileMap *map = reinterpret_cast<TileMap *>(tilemap);
+    if (!map || tile == 0)
+        return;
+
+    TileDef *def = tilemap_define(map, tile);
+    def->kind = TILE_COLOR;
+    def->pixel = BGR(color);
+    tilemap_invalidate_all(map);
+}
+
+void easyx_tilemap_definesprite(void *tilemap, uint16_t tile, void *atlas, int sprite)
+{
+    TileMap *map = reinterpret_cast<TileMap *>(tilemap);
+    if (!map || tile == 0)
+        return;
+
+    TileDef *def = tilemap_define(map, tile);
+    def->kind = atlas ? TILE_SPRITE : TILE_EMPTY;
+    def->atlas = atlas;
+    def->sprite = sprite;
+    tilemap_invalidate_all(map);
+}
+
+void easyx_tilemap_setbackground(void *tilemap, uint32_t color)
+{
+    TileMap *map = reinterpret_cast<TileMap *>(tilemap);
+    if (!map || map->background == BGR(color))
+        return;
+
+    map->background = BGR(color);
+    tilemap_invalidate_all(map);
+}
+
+void easyx_tilemap_settile(void *tilemap, int col, int row, uint16_t tile)
+{
+    TileMap *map = reinterpret_cast<TileMap *>(tilemap);
+    if (!map || col < 0 || row < 0 || col >= map->cols || row >= map->rows)
+        return;
+
+    uint16_t &cell = map->tiles[static_cast<size_t>(row) * map->cols + col];
+    if (cell == tile)
+        return;
+
+    cell = tile;
+    tilemap_mark(map, col, row);
+}
+
+int easyx_tilemap_gettile(void *tilemap, int col, int row)
+{
+    TileMap *map = reinterpret_cast<TileMap *>(tilemap);
+    if (!map || col < 0 || row < 0 || col >= map->cols || row >= map->rows)
+        return -1;
+
+    return map->tiles[static_cast<size_t>(row) * map->cols + col];
+}
+
+void easyx_tilemap_settiles(void *tilemap, int col, int row, int width, int height, const uint16_t *tiles, size_t stride)
+{
+    TileMap *map = reinterpret_cast<TileMap *>(tilemap);
+    if (!map || !tiles || width <= 0 || height <= 0)
+        return;
+
+    for (int y = 0; y < height; ++y)
+    {
+        int r = row + y;
+        if (r < 0 || r >= map->rows)
+            continue;
+
+        const uint16_t *src = tiles + static_cast<size_t>(y) * stride;
+        uint16_t *dst = &map->tiles[static_cast<size_t>(r) * map->cols];
+        for (int x = 0; x < width; ++x)
+        {
+            int c = col + x;
+            if (c < 0 || c >= map->cols || dst[c] == src[x])
+                continue;
+
+            dst[c] = src[x];
+            tilemap_mark(map, c, r);
+        }
+    }
+}
+
+void easyx_tilemap_fill(void *tilemap, int col, int row, int width, int height, uint16_t tile)
+{
+    TileMap *map = reinterpret_cast<TileMap *>(tilemap);
+    if (!map)
+        return;
+
+    for (int r = row < 0 ? 0 : row; r < row + height && r < map->rows; ++r)
+    {
+        uint16_t *dst = &map->tiles[static_cast<size_t>(r) * map->cols];
+        for (int c = col < 0 ? 0 : col; c < col + width && c < map->cols; ++c)
+        {
+            if (dst[c] == tile)
+                continue;
+
+            dst[c] = tile;
+            tilemap_mark(map, c, r);
+        }
+    }
+}
+
+void easyx_tilemap_invalidate(void *tilemap)
+{
+    TileMap *map = reinterpret_cast<TileMap *>(tilemap);
+    if (map)
+        tilemap_invalidate_all(map);
+}
+
+int easyx_tilemap_draw(void *tilemap, int x, int y, int scrollX, int scrollY, int viewWidth, int viewHeight)
+{
+    PROFILE_SCOPE(EASYX_PROF_IMAGES);
+    TileMap *map = reinterpret_cast<TileMap *>(tilemap);
+    if (!map)
+        return 0;
+
+    RasterTarget target = raster_target();
+    RasterClip clip;
+    if (!target.buffer || !raster_clip(target, &clip))
+        return 0;
+
+    int mapWidth = map->cols * map->tileWidth;
+    int mapHeight = map->rows * map->tileHeight;
+    if (viewWidth <= 0)
+        viewWidth = mapWidth;
+    if (viewHeight <= 0)
+        viewHeight = mapHeight;
+
+    // 视口在设备坐标中的范围，与裁剪范围以及地图范围求交
+    int dstX = x + clip.originX;
+    int dstY = y + clip.originY;
+    int left = dstX > clip.left ? dstX : clip.left;
+    int top = dstY > clip.top ? dstY : clip.top;
+    int right = dstX + viewWidth < clip.right ? dstX + viewWidth : clip.right;
+    int bottom = dstY + viewHeight < clip.bottom ? dstY + viewHeight : clip.bottom;
+    if (left < dstX - scrollX)
+        left = dstX - scrollX;
+    if (top < dstY - scrollY)
+        top = dstY - scrollY;
+    if (right > dstX - scrollX + mapWidth)
+        right = dstX - scrollX + mapWidth;
+    if (bottom > dstY - scrollY + mapHeight)
+        bottom = dstY - scrollY + mapHeight;
+    if (left >= right || top >= bottom)
+        return 0;
+
+    // 设备坐标到地图像素坐标的偏移
+    int offsetX = scrollX - dstX;
+    int offsetY = scrollY - dstY;
+    int chunkWidth = map->chunkSize * map->tileWidth;
+    int chunkHeight = map->chunkSize * map->tileHeight;
+    int firstChunkCol = (left + offsetX) / chunkWidth;
+    int lastChunkCol = (right - 1 + offsetX) / chunkWidth;
+    int firstChunkRow = (top + offsetY) / chunkHeight;
+    int lastChunkRow = (bottom - 1 + offsetY) / chunkHeight;
+
+    int rendered = 0;
+    for (int chunkRow = firstChunkRow; chunkRow <= lastChunkRow; ++chunkRow)
+    {
+        for (int chunkCol = firstChunkCol; chunkCol <= lastChunkCol; ++chunkCol)
+        {
+            TileChunk &chunk = map->chunks[chunkRow * map->chunkCols + chunkCol];
+            if (chunk.dirty)
+            {
+                tilemap_render_chunk(map, chunkCol, chunkRow);
+                ++rendered;
+            }
+
+            // 区块在设备坐标中的范围与可见范围求交
+            int chunkLeft = chunkCol * chunkWidth - offsetX;
+            int chunkTop = chunkRow * chunkHeight - offsetY;
+            int pitch = chunk.image->getwidth();
+            int l = chunkLeft > left ? chunkLeft : left;
+            int t = chunkTop > top ? chunkTop : top;
+            int r = chunkLeft + pitch < right ? chunkLeft + pitch : right;
+            int b = chunkTop + chunk.image->getheight() < bottom ? chunkTop + chunk.image->getheight() : bottom;
+
+            const DWORD *src = GetImageBuffer(chunk.image) + static_cast<size_t>(t - chunkTop) * pitch + (l - chunkLeft);
+            DWORD *dst = target.buffer + static_cast<size_t>(t) * target.width + l;
+            for (int row = t; row < b; ++row, src += pitch, dst += target.width)
+                memcpy(dst, src, (r - l) * sizeof(DWORD));
+        }
+    }
+
+    easyx_dirty_add(left, top, right - 1, bottom - 1);
+    return rendered;
+}
@@ -0,0 +1,378 @@
+// easyx_tiles.cpp
+// 并行分块渲染，把工作图像划分为分块，由多个线程各自渲染到私有缓冲区后合成回工作图像
+
+#include "easyx_wrapper.h"
+#include "easyx_raster.h"
+#include "easyx_profiler.h"
+#include <math.h>
+#include <string.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <windows.h>
+#include <tchar.h>
+#include "../EasyX_26.1.1/include/easyx.h"
+
+// 默认分块边长，64 x 64 x 4 字节的分块缓冲区能放进 L1/L2 缓存
+#define TILES_DEFAULT_SIZE 64
+
+struct TileJob
+{
+    EasyXTileRenderFn fn;
+    void *user;
+    RasterTarget target;
+    int tileWidth, tileHeight;
+    int cols;
+    int count;
+    int flags;
+    DWORD background;
+    std::atomic<int> next; // 下一个待领取的分块
+};
+
+struct TileRenderer
+{
+    std::mutex mutex;
+    std::condition_variable wake; // 有新任务或需要退出
+    std::condition_variable done; // 工作线程都已完成当前任务
+    std::vector<std::thread> workers;
+    bool stopping;
+    int threads;  // 包括调用线程在内的线程数，0 表示按 CPU 核心数
+    unsigned generation;
+    int active;   // 尚未完成当前任务的工作线程数
+    TileJob *job;
+    std::vector<DWORD> scratch; // 调用线程的分块缓冲区
+
+    TileRenderer() : stopping(false), threads(0), generation(0), active(0), job(NULL) {}
+
+    ~TileRenderer()
+    {
+        stop();
+    }
+
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (size_t i = 0; i < workers.size(); ++i)
+            workers[i].join();
+        workers.clear();
+        stopping = false;
+    }
+};
+
+static TileRenderer g_tiles;
+
+static int tiles_threadcount()
+{
+    if (g_tiles.threads > 0)
+        return g_tiles.threads;
+    unsigned threads = std::thread::hardware_concurrency();
+    return threads > 0 ? static_cast<int>(threads) : 1;
+}
+
+// 领取并渲染分块直到全部领完，各分块的目标区域互不重叠，合成时不需要加锁
+static void tiles_run(TileJob *job, int thread, std::vector<DWORD> &scratch)
+{
+    scratch.resize(static_cast<size_t>(job->tileWidth) * job->tileHeight);
+
+    for (;;)
+    {
+        int index = job->next.fetch_add(1, std::memory_order_relaxed);
+        if (index >= job->count)
+            break;
+
+        EasyXTile tile;
+        tile.index = index;
+        tile.thread = thread;
+        tile.x = index % job->cols * job->tileWidth;
+        tile.y = index / job->cols * job->tileHeight;
+        tile.width = job->target.width - tile.x < job->tileWidth ? job->target.width - tile.x : job->tileWidth;
+        tile.height = job->target.height - tile.y < job->tileHeight ? job->target.height - tile.y : job->tileHeight;
+        tile.pitch = tile.width;
+        tile.pixels = reinterpret_cast<uint32_t *>(scratch.data());
+
+        DWORD *dst = job->target.buffer + static_cast<size_t>(tile.y) * job->target.width + tile.x;
+        DWORD *row = scratch.data();
+        if (job->flags & EASYX_TILES_CLEAR)
+            raster_span_row(row, tile.width * tile.height, job->background);
+        else
+            for (int y = 0; y < tile.height; ++y, row += tile.pitch)
+                memcpy(row, dst + static_cast<size_t>(y) * job->target.width, tile.width * sizeof(DWORD));
+
+        job->fn(job->user, &tile);
+
+        row = scratch.data();
+        for (int y = 0; y < tile.height; ++y, row += tile.pitch)
+            memcpy(dst + static_cast<size_t>(y) * job->target.width, row, tile.width * sizeof(DWORD));
+    }
+}
+
+// seen 为启动时的任务代数，之前的任务与新线程无关
+static void tiles_worker(int thread, unsigned seen)
+{
+    std::vector<DWORD> scratch;
+
+    std::unique_lock<std::mutex> lock(g_tiles.mutex);
+    for (;;)
+    {
+        while (!g_tiles.stopping && g_tiles.generation == seen)
+            g_tiles.wake.wait(lock);
+        if (g_tiles.stopping)
+            break;
+
+        seen = g_tiles.generation;
+        TileJob *job = g_tiles.job;
+
+        lock.unlock();
+        tiles_run(job, thread, scratch);
+        lock.lock();
+
+        if (--g_tiles.active == 0)
+            g_tiles.done.notify_one();
+    }
+}
+
+// 按需启动工作线程，调用线程也参与渲染，所以只需要 threads - 1 个
+static void tiles_start()
+{
+    int workers = tiles_threadcount() - 1;
+    if (static_cast<int>(g_tiles.workers.size()) == workers)
+        return;
+
+    g_tiles.stop();
+    std::lock_guard<std::mutex> lock(g_tiles.mutex);
+    for (int i = 0; i < workers; ++i)
+        g_tiles.workers.push_back(std::thread(tiles_worker, i + 1, g_tiles.generation));
+}
+
+int easyx_render_tiles(int tileWidth, int tileHeight, int flags, uint32_t background, EasyXTileRenderFn render, void *user)
+{
+    PROFILE_SCOPE(EASYX_PROF_PRIMITIVES);
+    if (!render)
+        return 0;
+
+    RasterTarget target = raster_target();
+    if (!target.buffer)
+        return 0;
+
+    TileJob job;
+    job.fn = render;
+    job.user = user;
+    job.target = target;
+    job.tileWidth = tileWidth > 0 ? tileWidth : TILES_DEFAULT_SIZE;
+    job.tileHeight = tileHeight > 0 ? tileHeight : TILES_DEFAULT_SIZE;
+    job.cols = (target.width + job.tileWidth - 1) / job.tileWidth;
+    job.count = job.cols * ((target.height + job.tileHeight - 1) / job.tileHeight);
+    job.flags = flags;
+    job.background = BGR(background);
+    job.next.store(0, std::memory_order_relaxed);
+
+    // 分块太少时不值得唤醒工作线程
+    tiles_start();
+    bool parallel = !g_tiles.workers.empty() && job.count > 1;
+    if (parallel)
+    {
+        std::lock_guard<std::mutex> lock(g_tiles.mutex);
+        g_tiles.job = &job;
+        g_tiles.active = static_cast<int>(g_tiles.workers.size());
+        ++g_tiles.generation;
+    }
+    if (parallel)
+        g_tiles.wake.notify_all();
+
+    tiles_run(&job, 0, g_tiles.scratch);
+
+    if (parallel)
+    {
+        std::unique_lock<std::mutex> lock(g_tiles.mutex);
+        while (g_tiles.active > 0)
+            g_tiles.done.wait(lock);
+        g_tiles.job = NULL;
+    }
+
+    easyx_dirty_markall();
+    return job.count;
+}
+
+void easyx_render_setthreads(int threads)
+{
+    g_tiles.threads = threads > 0 ? threads : 0;
+    tiles_start();
+}
+
+int easyx_render_getthreads()
+{
+    return tiles_threadcount();
+}
+
+// 以下函数在渲染回调中调用，可能运行在任意线程上，只访问分块缓冲区，
+// 不调用 EasyX 和 GDI。坐标为设备坐标，自动裁剪到分块范围内
+
+// 将 [left, right] x [top, bottom] 裁剪到分块范围内并转换为分块内坐标，返回 false 表示完全在分块之外
+static bool tile_clip(const EasyXTile *tile, int &left, int &top, int &right, int &bottom)
+{
+    if (left > right)
+    {
+        int t = left;
+        left = right;
+        right = t;
+    }
+    if (top > bottom)
+    {
+        int t = top;
+        top = bottom;
+        bottom = t;
+    }
+
+    left -= tile->x;
+    right -= tile->x;
+    top -= tile->y;
+    bottom -= tile->y;
+    if (left < 0)
+        left = 0;
+    if (top < 0)
+        top = 0;
+    if (right >= tile->width)
+        right = tile->width - 1;
+    if (bottom >= tile->height)
+        bottom = tile->height - 1;
+    return left <= right && top <= bottom;
+}
+
+static inline DWORD *tile_row(const EasyXTile *tile, int y)
+{
+    return reinterpret_cast<DWORD *>(tile->pixels) + static_cast<size_t>(y) * tile->pitch;
+}
+
+static void tile_fill(const EasyXTile *tile, int left, int top, int right, int bottom, DWORD pixel)
+{
+    if (!tile_clip(tile, left, top, right, bottom))
+        return;
+
+    int count = right - left + 1;
+    for (int y = top; y <= bottom; ++y)
+        raster_span_row(tile_row(tile, y) + left, count, pixel);
+}
+
+void easyx_tile_clear(EasyXTile *tile, uint32_t color)
+{
+    if (!tile)
+        return;
+    DWORD pixel = BGR(color);
+    for (int y = 0; y < tile->height; ++y)
+        raster_span_row(tile_row(tile, y), tile->width, pixel);
+}
+
+void easyx_tile_hline(EasyXTile *tile, int x1, int x2, int y, uint32_t color)
+{
+    if (tile)
+        tile_fill(tile, x1, y, x2, y, BGR(color));
+}
+
+void easyx_tile_rectangle(EasyXTile *tile, int left, int top, int right, int bottom, uint32_t color)
+{
+    if (!tile)
+        return;
+    if (top > bottom)
+    {
+        int t = top;
+        top = bottom;
+        bottom = t;
+    }
+
+    DWORD pixel = BGR(color);
+    tile_fill(tile, left, top, right, top, pixel);
+    tile_fill(tile, left, bottom, right, bottom, pixel);
+    if (bottom - top > 1)
+    {
+        tile_fill(tile, left, top + 1, left, bottom - 1, pixel);
+        tile_fill(tile, right, top + 1, right, bottom - 1, pixel);
+    }
+}
+
+void easyx_tile_fillrect(EasyXTile *tile, int left, int top, int right, int bottom, uint32_t color)
+{
+    if (tile)
+        tile_fill(tile, left, top, right, bottom, BGR(color));
+}
+
+void easyx_tile_fillcircle(EasyXTile *tile, int x, int y, int radius, uint32_t color)
+{
+    if (!tile || radius < 0)
+        return;
+
+    DWORD pixel = BGR(color);
+
+    // 只遍历落在分块内的行，形状与 easyx_raster_fillcircle 相同
+    int top = tile->y - y > -radius ? tile->y - y : -radius;
+    int bottom = tile->y + tile->height - 1 - y < radius ? tile->y + tile->height - 1 - y : radius;
+    double r2 = (radius + 0.5) * (radius + 0.5);
+
+    for (int dy = top; dy <= bottom; ++dy)
+    {
+        int half = static_cast<int>(sqrt(r2 - static_cast<double>(dy) * dy));
+        tile_fill(tile, x - half, y + dy, x + half, y + dy, pixel);
+    }
+}
+
+void easyx_tile_fillellipse(EasyXTile *tile, int left, int top, int right, int bottom, uint32_t color)
+{
+    if (!tile)
+        return;
+    if (left > right)
+    {
+        int t = left;
+        left = right;
+        right = t;
+    }
+    if (top > bottom)
+    {
+        int t = top;
+        top = bottom;
+        bottom = t;
+    }
+
+    DWORD pixel = BGR(color);
+
+    // 形状与 easyx_raster_fillellipse 相同
+    double cx = (left + right) * 0.5, cy = (top + bottom) * 0.5;
+    double rx = (right - left + 1) * 0.5, ry = (bottom - top + 1) * 0.5;
+
+    int y0 = top < tile->y ? tile->y : top;
+    int y1 = bottom >= tile->y + tile->height ? tile->y + tile->height - 1 : bottom;
+
+    for (int y = y0; y <= y1; ++y)
+    {
+        double dy = (y - cy) / ry;
+        double t = 1.0 - dy * dy;
+        double half = t > 0 ? rx * sqrt(t) : 0;
+        int x1 = static_cast<int>(ceil(cx - half));
+        int x2 = static_cast<int>(floor(cx + half));
+        if (x1 > x2)
+            x1 = x2 = static_cast<int>(floor(cx));
+        tile_fill(tile, x1, y, x2, y, pixel);
+    }
+}
+
+void easyx_tile_blend(EasyXTile *tile, int dstX, int dstY, const uint32_t *src, int width, int height, size_t stride, uint8_t globalAlpha)
+{
+    if (!tile || !src || globalAlpha == 0 || width <= 0 || height <= 0)
+        return;
+    if (stride == 0)
+        stride = width;
+
+    int left = dstX, top = dstY, right = dstX + width - 1, bottom = dstY + height - 1;
+    if (!tile_clip(tile, left, top, right, bottom))
+        return;
+
+    // 裁剪后的区域对应源缓冲区中的起点
+    const DWORD *in = reinterpret_cast<const DWORD *>(src) + (top + tile->y - dstY) * stride + (left + tile->x - dstX);
+    int count = right - left + 1;
+    for (int y = top; y <= bottom; ++y, in += stride)
+        raster_blend_row(tile_row(tile, y) + left, in, count, globalAlpha);
+}
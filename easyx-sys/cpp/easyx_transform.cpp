@@ -0,0 +1,518 @@
+// easyx_transform.cpp
+// 图像的仿射变换绘制：旋转、缩放和平移一次完成，按行求出落在源图像内的区间后直接写入目标缓冲区，
+// 以及按量化角度缓存的预旋转帧
+
+#include "easyx_wrapper.h"
+#include "easyx_profiler.h"
+#include "easyx_raster.h"
+#include <math.h>
+#include <string.h>
+#include <vector>
+#include <windows.h>
+#include <tchar.h>
+#include "../EasyX_26.1.1/include/easyx.h"
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define TRANSFORM_X86 1
+#include <emmintrin.h>
+#endif
+
+#define TRANSFORM_PI 3.14159265358979323846
+
+// 源像素缓冲区
+struct TransformSource
+{
+    const DWORD *pixels;
+    int width;
+    int height;
+};
+
+// 混合绘制时暂存一行采样结果，直接复制时采样结果直接写入目标
+static thread_local std::vector<DWORD> t_transformRow;
+
+static inline int transform_clamp(int64_t v, int hi)
+{
+    return v < 0 ? 0 : (v > hi ? hi : static_cast<int>(v));
+}
+
+// 按 7 位权重在两个像素间插值，与 SSE2 版本逐位一致
+static inline DWORD transform_lerp(DWORD a, DWORD b, int f)
+{
+    DWORD out = 0;
+    for (int shift = 0; shift < 32; shift += 8)
+    {
+        int ca = static_cast<int>((a >> shift) & 0xFF);
+        int cb = static_cast<int>((b >> shift) & 0xFF);
+        out |= static_cast<DWORD>(ca + (((cb - ca) * f) >> 7)) << shift;
+    }
+    return out;
+}
+
+static inline DWORD transform_bilinear_scalar(DWORD p00, DWORD p01, DWORD p10, DWORD p11, int fx, int fy)
+{
+    return transform_lerp(transform_lerp(p00, p10, fy), transform_lerp(p01, p11, fy), fx);
+}
+
+#ifdef TRANSFORM_X86
+// 四个相邻像素展开为 16 位后先纵向再横向插值，一次处理全部四个通道
+static inline DWORD transform_bilinear_sse2(DWORD p00, DWORD p01, DWORD p10, DWORD p11, int fx, int fy)
+{
+    __m128i zero = _mm_setzero_si128();
+    __m128i top = _mm_unpacklo_epi8(_mm_unpacklo_epi32(_mm_cvtsi32_si128(static_cast<int>(p00)), _mm_cvtsi32_si128(static_cast<int>(p01))), zero);
+    __m128i bottom = _mm_unpacklo_epi8(_mm_unpacklo_epi32(_mm_cvtsi32_si128(static_cast<int>(p10)), _mm_cvtsi32_si128(static_cast<int>(p11))), zero);
+    __m128i column = _mm_add_epi16(top, _mm_srai_epi16(_mm_mullo_epi16(_mm_sub_epi16(bottom, top), _mm_set1_epi16(static_cast<short>(fy))), 7));
+    __m128i right = _mm_unpackhi_epi64(column, column);
+    __m128i result = _mm_add_epi16(column, _mm_srai_epi16(_mm_mullo_epi16(_mm_sub_epi16(right, column), _mm_set1_epi16(static_cast<short>(fx))), 7));
+    return static_cast<DWORD>(_mm_cvtsi128_si32(_mm_packus_epi16(result, result)));
+}
+#endif
+
+// 最近邻采样一行，坐标为 16.16 定点数，越界的坐标钳制到边缘
+static void transform_row_nearest(DWORD *dst, int count, const TransformSource &src, int64_t fu, int64_t fv, int64_t du, int64_t dv)
+{
+    int maxX = src.width - 1, maxY = src.height - 1;
+    for (int i = 0; i < count; ++i)
+    {
+        int sx = transform_clamp(fu >> 16, maxX);
+        int sy = transform_clamp(fv >> 16, maxY);
+        dst[i] = src.pixels[static_cast<size_t>(sy) * src.width + sx];
+        fu += du;
+        fv += dv;
+    }
+}
+
+// 双线性采样一行，坐标已减去半个像素，越界的邻居钳制到边缘
+static void transform_row_bilinear(DWORD *dst, int count, const TransformSource &src, int64_t fu, int64_t fv, int64_t du, int64_t dv)
+{
+    int maxX = src.width - 1, maxY = src.height - 1;
+#ifdef TRANSFORM_X86
+    bool sse2 = easyx_raster_getlevel() >= EASYX_RASTER_SSE2;
+#endif
+    for (int i = 0; i < count; ++i)
+    {
+        int64_t ix = fu >> 16, iy = fv >> 16;
+        int fx = static_cast<int>((fu >> 9) & 0x7F);
+        int fy = static_cast<int>((fv >> 9) & 0x7F);
+        int x0 = transform_clamp(ix, maxX), x1 = transform_clamp(ix + 1, maxX);
+        const DWORD *row0 = src.pixels + static_cast<size_t>(transform_clamp(iy, maxY)) * src.width;
+        const DWORD *row1 = src.pixels + static_cast<size_t>(transform_clamp(iy + 1, maxY)) * src.width;
+#ifdef TRANSFORM_X86
+        if (sse2)
+            dst[i] = transform_bilinear_sse2(row0[x0], row0[x1], row1[x0], row1[x1], fx, fy);
+        else
+#endif
+            dst[i] = transform_bilinear_scalar(row0[x0], row0[x1], row1[x0], row1[x1], fx, fy);
+        fu += du;
+        fv += dv;
+    }
+}
+
+// 把满足 0 <= u0 + du * x < size 的 x 限制到 [lo, hi] 内
+static inline void transform_limit(double u0, double du, double size, double *lo, double *hi)
+{
+    if (fabs(du) < 1e-12)
+    {
+        if (u0 < 0 || u0 >= size)
+            *hi = *lo - 1;
+        return;
+    }
+    double t1 = -u0 / du, t2 = (size - u0) / du;
+    if (t1 > t2)
+    {
+        double t = t1;
+        t1 = t2;
+        t2 = t;
+    }
+    if (t1 > *lo)
+        *lo = t1;
+    if (t2 < *hi)
+        *hi = t2;
+}
+
+// 按 m（源坐标到目标设备坐标：x' = m[0] * u + m[1] * v + m[2]，y' = m[3] * u + m[4] * v + m[5]）
+// 把源图像绘制到 target 的 clip 范围内。spans 非 NULL 时记录每行写入的 [x0, x1)。
+// 返回是否写入了像素，bounds 为写入范围，包含右下边界
+static bool transform_draw(const RasterTarget &target, const RECT &clip, const TransformSource &src, const double *m,
+                           int flags, DWORD globalAlpha, RECT *bounds, int32_t *spans)
+{
+    double det = m[0] * m[4] - m[1] * m[3];
+    if (fabs(det) < 1e-12 || src.width <= 0 || src.height <= 0)
+        return false;
+
+    // 逆变换：目标像素中心到源坐标
+    double ia = m[4] / det, ib = -m[1] / det;
+    double ic = -m[3] / det, id = m[0] / det;
+
+    // 源图像四个角在目标中的外接矩形
+    double cornersU[4] = {0, static_cast<double>(src.width), 0, static_cast<double>(src.width)};
+    double cornersV[4] = {0, 0, static_cast<double>(src.height), static_cast<double>(src.height)};
+    double minX = 1e300, minY = 1e300, maxX = -1e300, maxY = -1e300;
+    for (int i = 0; i < 4; ++i)
+    {
+        double x = m[0] * cornersU[i] + m[1] * cornersV[i] + m[2];
+        double y = m[3] * cornersU[i] + m[4] * cornersV[i] + m[5];
+        minX = x < minX ? x : minX;
+        maxX = x > maxX ? x : maxX;
+        minY = y < minY ? y : minY;
+        maxY = y > maxY ? y : maxY;
+    }
+
+    int left = minX > clip.left ? static_cast<int>(floor(minX)) : clip.left;
+    int top = minY > clip.top ? static_cast<int>(floor(minY)) : clip.top;
+    int right = maxX < clip.right ? static_cast<int>(ceil(maxX)) : clip.right;
+    int bottom = maxY < clip.bottom ? static_cast<int>(ceil(maxY)) : clip.bottom;
+    if (left >= right || top >= bottom)
+        return false;
+
+    bool bilinear = (flags & EASYX_TRANSFORM_BILINEAR) != 0;
+    bool blend = (flags & EASYX_TRANSFORM_BLEND) != 0;
+    double offset = bilinear ? 0.5 : 0.0;
+    int64_t du = llrint(ia * 65536.0), dv = llrint(ic * 65536.0);
+    std::vector<DWORD> &row = t_transformRow;
+
+    bounds->left = right;
+    bounds->right = left - 1;
+    bounds->top = bottom;
+    bounds->bottom = top - 1;
+    for (int y = top; y < bottom; ++y)
+    {
+        double dy = y + 0.5 - m[5];
+        double u0 = ia * (0.5 - m[2]) + ib * dy;
+        double v0 = ic * (0.5 - m[2]) + id * dy;
+
+        // 这一行中源坐标落在图像内的区间
+        double lo = left, hi = right - 1;
+        transform_limit(u0, ia, src.width, &lo, &hi);
+        transform_limit(v0, ic, src.height, &lo, &hi);
+        int x0 = static_cast<int>(ceil(lo - 1e-9));
+        int x1 = static_cast<int>(floor(hi + 1e-9)) + 1;
+        if (x0 < left)
+            x0 = left;
+        if (x1 > right)
+            x1 = right;
+        if (x0 >= x1)
+            continue;
+
+        int count = x1 - x0;
+        int64_t fu = llrint((u0 + ia * x0 - offset) * 65536.0);
+        int64_t fv = llrint((v0 + ic * x0 - offset) * 65536.0);
+        DWORD *out = target.buffer + static_cast<size_t>(y) * target.width + x0;
+        DWORD *dst = out;
+        if (blend)
+        {
+            if (row.size() < static_cast<size_t>(count))
+                row.resize(count);
+            dst = row.data();
+        }
+
+        if (bilinear)
+            transform_row_bilinear(dst, count, src, fu, fv, du, dv);
+        else
+            transform_row_nearest(dst, count, src, fu, fv, du, dv);
+        if (blend)
+            raster_blend_row(out, dst, count, globalAlpha);
+
+        if (spans)
+        {
+            spans[2 * y] = x0;
+            spans[2 * y + 1] = x1;
+        }
+        bounds->left = x0 < bounds->left ? x0 : bounds->left;
+        bounds->right = x1 - 1 > bounds->right ? x1 - 1 : bounds->right;
+        bounds->top = y < bounds->top ? y : bounds->top;
+        bounds->bottom = y;
+    }
+    return bounds->left <= bounds->right;
+}
+
+static bool transform_source(const IMAGE *img, TransformSource *src)
+{
+    if (!img)
+        return false;
+    src->pixels = GetImageBuffer(img);
+    src->width = img->getwidth();
+    src->height = img->getheight();
+    return src->pixels && src->width > 0 && src->height > 0;
+}
+
+// 以源图像中 (pivotX, pivotY) 为中心先缩放再逆时针旋转，然后把中心放到 (x, y)
+static void transform_matrix(double x, double y, double radian, double scaleX, double scaleY, double pivotX, double pivotY, double *m)
+{
+    double c = cos(radian), s = sin(radian);
+    m[0] = c * scaleX;
+    m[1] = s * scaleY;
+    m[3] = -s * scaleX;
+    m[4] = c * scaleY;
+    m[2] = x - m[0] * pivotX - m[1] * pivotY;
+    m[5] = y - m[3] * pivotX - m[4] * pivotY;
+}
+
+// 把变换绘制到当前工作图像，矩阵为逻辑坐标，受原点和裁剪区域影响
+static void transform_put(const IMAGE *srcImg, const double *matrix, int flags, uint8_t globalAlpha)
+{
+    TransformSource src;
+    if (!transform_source(srcImg, &src) || ((flags & EASYX_TRANSFORM_BLEND) && globalAlpha == 0))
+        return;
+
+    RasterTarget target = raster_target();
+    RasterClip rasterClip;
+    if (!target.buffer || !raster_clip(target, &rasterClip))
+        return;
+
+    double m[6];
+    memcpy(m, matrix, sizeof(m));
+    m[2] += rasterClip.originX;
+    m[5] += rasterClip.originY;
+    RECT clip = {rasterClip.left, rasterClip.top, rasterClip.right, rasterClip.bottom};
+
+    RECT bounds;
+    if (transform_draw(target, clip, src, m, flags, globalAlpha, &bounds, NULL))
+        easyx_dirty_add(bounds.left, bounds.top, bounds.right, bounds.bottom);
+}
+
+void easyx_putimage_affine(const void *pSrcImg, const double *matrix, int flags, uint8_t globalAlpha)
+{
+    PROFILE_SCOPE(EASYX_PROF_IMAGES);
+    if (!matrix)
+        return;
+    transform_put(reinterpret_cast<const IMAGE *>(pSrcImg), matrix, flags, globalAlpha);
+}
+
+void easyx_putimage_transform(double x, double y, const void *pSrcImg, double radian, double scaleX, double scaleY,
+                              double pivotX, double pivotY, int flags, uint8_t globalAlpha)
+{
+    PROFILE_SCOPE(EASYX_PROF_IMAGES);
+    double m[6];
+    transform_matrix(x, y, radian, scaleX, scaleY, pivotX, pivotY, m);
+    transform_put(reinterpret_cast<const IMAGE *>(pSrcImg), m, flags, globalAlpha);
+}
+
+void easyx_transformimage(void *pDstImg, const void *pSrcImg, const double *matrix, int flags, uint8_t globalAlpha)
+{
+    PROFILE_SCOPE(EASYX_PROF_IMAGES);
+    IMAGE *dstImg = reinterpret_cast<IMAGE *>(pDstImg);
+    TransformSource src;
+    if (!dstImg || !matrix || !transform_source(reinterpret_cast<const IMAGE *>(pSrcImg), &src))
+        return;
+
+    RasterTarget target;
+    target.buffer = GetImageBuffer(dstImg);
+    target.width = dstImg->getwidth();
+    target.height = dstImg->getheight();
+    if (!target.buffer)
+        return;
+
+    RECT clip = {0, 0, target.width, target.height};
+    RECT bounds;
+    transform_draw(target, clip, src, matrix, flags, globalAlpha, &bounds, NULL);
+}
+
+void easyx_scaleimage(void *pDstImg, const void *pSrcImg, int width, int height, int flags)
+{
+    PROFILE_SCOPE(EASYX_PROF_IMAGES);
+    IMAGE *dstImg = reinterpret_cast<IMAGE *>(pDstImg);
+    TransformSource src;
+    if (!dstImg || width <= 0 || height <= 0 || !transform_source(reinterpret_cast<const IMAGE *>(pSrcImg), &src))
+        return;
+
+    dstImg->Resize(width, height);
+    RasterTarget target;
+    target.buffer = GetImageBuffer(dstImg);
+    target.width = width;
+    target.height = height;
+    if (!target.buffer)
+        return;
+
+    double m[6] = {static_cast<double>(width) / src.width, 0, 0, 0, static_cast<double>(height) / src.height, 0};
+    RECT clip = {0, 0, width, height};
+    RECT bounds;
+    transform_draw(target, clip, src, m, flags & EASYX_TRANSFORM_BILINEAR, 255, &bounds, NULL);
+}
+
+// 旋转并缩放后的外接矩形大小，角度为 0 时与缩放后的源图像大小一致
+static void transform_rotated_size(const TransformSource &src, double radian, double scale, int *width, int *height)
+{
+    double c = fabs(cos(radian)), s = fabs(sin(radian));
+    double w = (c * src.width + s * src.height) * scale;
+    double h = (s * src.width + c * src.height) * scale;
+    *width = w > 1 ? static_cast<int>(ceil(w - 1e-6)) : 1;
+    *height = h > 1 ? static_cast<int>(ceil(h - 1e-6)) : 1;
+}
+
+// 把源图像旋转到 dst 中，dst 调整为外接矩形大小，未覆盖的像素为透明（0）
+static void transform_rotate_into(IMAGE *dstImg, const TransformSource &src, double radian, double scale, int flags, int32_t *spans)
+{
+    int width, height;
+    transform_rotated_size(src, radian, scale, &width, &height);
+    dstImg->Resize(width, height);
+
+    RasterTarget target;
+    target.buffer = GetImageBuffer(dstImg);
+    target.width = width;
+    target.height = height;
+    if (!target.buffer)
+        return;
+    memset(target.buffer, 0, sizeof(DWORD) * static_cast<size_t>(width) * height);
+
+    double m[6];
+    transform_matrix(width * 0.5, height * 0.5, radian, scale, scale, src.width * 0.5, src.height * 0.5, m);
+    RECT clip = {0, 0, width, height};
+    RECT bounds;
+    transform_draw(target, clip, src, m, flags & EASYX_TRANSFORM_BILINEAR, 255, &bounds, spans);
+}
+
+void easyx_rotateimage_fast(void *pDstImg, const void *pSrcImg, double radian, double scale, int flags)
+{
+    PROFILE_SCOPE(EASYX_PROF_IMAGES);
+    IMAGE *dstImg = reinterpret_cast<IMAGE *>(pDstImg);
+    TransformSource src;
+    if (!dstImg || scale <= 0 || !transform_source(reinterpret_cast<const IMAGE *>(pSrcImg), &src))
+        return;
+    transform_rotate_into(dstImg, src, radian, scale, flags, NULL);
+}
+
+// 预旋转的一帧，spans 记录每行被源图像覆盖的 [x0, x1)，直接复制时只复制覆盖的部分
+struct RotationFrame
+{
+    IMAGE *image;
+    std::vector<int32_t> spans;
+};
+
+struct RotationCache
+{
+    const IMAGE *source;
+    int steps;
+    double scale;
+    int flags;
+    std::vector<RotationFrame> frames;
+};
+
+static void rotcache_release(RotationCache *cache)
+{
+    for (size_t i = 0; i < cache->frames.size(); ++i)
+    {
+        delete cache->frames[i].image;
+        cache->frames[i].image = NULL;
+        cache->frames[i].spans.clear();
+    }
+}
+
+// 获取第 step 帧，第一次使用时渲染
+static RotationFrame *rotcache_frame(RotationCache *cache, int step)
+{
+    RotationFrame &frame = cache->frames[step];
+    if (frame.image)
+        return &frame;
+
+    TransformSource src;
+    if (!transform_source(cache->source, &src))
+        return NULL;
+
+    double radian = 2.0 * TRANSFORM_PI * step / cache->steps;
+    int width, height;
+    transform_rotated_size(src, radian, cache->scale, &width, &height);
+    frame.image = new IMAGE(width, height);
+    frame.spans.assign(static_cast<size_t>(height) * 2, 0);
+    transform_rotate_into(frame.image, src, radian, cache->scale, cache->flags, frame.spans.data());
+    return &frame;
+}
+
+void *easyx_rotcache_create(const void *pSrcImg, int steps, double scale, int flags)
+{
+    if (!pSrcImg || steps <= 0 || scale <= 0)
+        return NULL;
+
+    RotationCache *cache = new RotationCache();
+    cache->source = reinterpret_cast<const IMAGE *>(pSrcImg);
+    cache->steps = steps;
+    cache->scale = scale;
+    cache->flags = flags & EASYX_TRANSFORM_BILINEAR;
+    cache->frames.resize(steps);
+    for (int i = 0; i < steps; ++i)
+        cache->frames[i].image = NULL;
+    return cache;
+}
+
+void easyx_rotcache_destroy(void *cache)
+{
+    RotationCache *c = reinterpret_cast<RotationCache *>(cache);
+    if (!c)
+        return;
+    rotcache_release(c);
+    delete c;
+}
+
+void easyx_rotcache_invalidate(void *cache)
+{
+    RotationCache *c = reinterpret_cast<RotationCache *>(cache);
+    if (c)
+        rotcache_release(c);
+}
+
+int easyx_rotcache_getcached(void *cache)
+{
+    RotationCache *c = reinterpret_cast<RotationCache *>(cache);
+    if (!c)
+        return 0;
+    int count = 0;
+    for (size_t i = 0; i < c->frames.size(); ++i)
+        count += c->frames[i].image != NULL;
+    return count;
+}
+
+void easyx_rotcache_draw(void *cache, double x, double y, double radian, int flags, uint8_t globalAlpha)
+{
+    PROFILE_SCOPE(EASYX_PROF_IMAGES);
+    RotationCache *c = reinterpret_cast<RotationCache *>(cache);
+    if (!c || ((flags & EASYX_TRANSFORM_BLEND) && globalAlpha == 0))
+        return;
+
+    // 角度量化到最近的一帧
+    double turns = radian / (2.0 * TRANSFORM_PI);
+    int step = static_cast<int>(llrint((turns - floor(turns)) * c->steps)) % c->steps;
+    RotationFrame *frame = rotcache_frame(c, step);
+    if (!frame)
+        return;
+
+    const DWORD *pixels = GetImageBuffer(frame->image);
+    int width = frame->image->getwidth();
+    int height = frame->image->getheight();
+    RasterTarget target = raster_target();
+    RasterClip clip;
+    if (!pixels || !target.buffer || !raster_clip(target, &clip))
+        return;
+
+    // 源图像中心放到 (x, y)
+    int left = static_cast<int>(floor(x - width * 0.5 + 0.5)) + clip.originX;
+    int top = static_cast<int>(floor(y - height * 0.5 + 0.5)) + clip.originY;
+    bool blend = (flags & EASYX_TRANSFORM_BLEND) != 0;
+
+    int minX = clip.right, maxX = clip.left - 1, minY = clip.bottom, maxY = clip.top - 1;
+    for (int row = 0; row < height; ++row)
+    {
+        int y0 = top + row;
+        if (y0 < clip.top || y0 >= clip.bottom)
+            continue;
+        int x0 = left + frame->spans[2 * row];
+        int x1 = left + frame->spans[2 * row + 1];
+        x0 = x0 < clip.left ? clip.left : x0;
+        x1 = x1 > clip.right ? clip.right : x1;
+        if (x0 >= x1)
+            continue;
+
+        DWORD *dst = target.buffer + static_cast<size_t>(y0) * target.width + x0;
+        const DWORD *src = pixels + static_cast<size_t>(row) * width + (x0 - left);
+        if (blend)
+            raster_blend_row(dst, src, x1 - x0, globalAlpha);
+        else
+            memcpy(dst, src, sizeof(DWORD) * (x1 - x0));
+
+        minX = x0 < minX ? x0 : minX;
+        maxX = x1 - 1 > maxX ? x1 - 1 : maxX;
+        minY = y0 < minY ? y0 : minY;
+        maxY = y0;
+    }
+
+    if (minX <= maxX)
+        easyx_dirty_add(minX, minY, maxX, maxY);
+}
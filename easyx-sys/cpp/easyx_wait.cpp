@@ -0,0 +1,157 @@
+// easyx_wait.cpp
+// 事件驱动的消息等待：用 MsgWaitForMultipleObjectsEx 休眠到有输入、超时或被其他线程唤醒
+
+#include "easyx_wrapper.h"
+#include "easyx_profiler.h"
+#include <atomic>
+#include <windows.h>
+#include <tchar.h>
+#include "../EasyX_26.1.1/include/easyx.h"
+
+struct MessageWaiter
+{
+    HANDLE wake;  // easyx_wake 设置，自动复位
+    HANDLE input; // 窗口过程处理完消息后设置，自动复位
+    HWND hwnd;
+    // 被替换的 EasyX 窗口过程，在 EasyX 的窗口线程中读取。
+    // 恢复窗口过程后仍保留，已经进入子类化窗口过程的消息还会用到它
+    std::atomic<WNDPROC> prevProc;
+    bool installed; // 当前窗口是否使用子类化的窗口过程，只在绘图线程中访问
+    DWORD windowThread;
+
+    MessageWaiter() : hwnd(NULL), prevProc(NULL), installed(false), windowThread(0)
+    {
+        // 在静态初始化时创建，easyx_wake 可以在任意线程中调用而不需要加锁
+        wake = CreateEventW(NULL, FALSE, FALSE, NULL);
+        input = CreateEventW(NULL, FALSE, FALSE, NULL);
+    }
+
+    ~MessageWaiter();
+};
+
+static MessageWaiter g_waiter;
+
+// EasyX 会放入消息队列的消息：鼠标、按键、字符和窗口消息
+static bool wait_is_message(UINT message)
+{
+    return (message >= WM_MOUSEFIRST && message <= WM_MOUSELAST) || (message >= WM_KEYFIRST && message <= WM_KEYLAST) ||
+           message == WM_ACTIVATE || message == WM_MOVE || message == WM_SIZE;
+}
+
+// 子类化的窗口过程：投递和发送的消息都在 EasyX 的窗口过程返回后才唤醒等待的线程，
+// 此时消息已经进入 EasyX 的队列，peekmessage 一定能取到
+static LRESULT CALLBACK wait_window_proc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam)
+{
+    WNDPROC prevProc = g_waiter.prevProc.load(std::memory_order_acquire);
+    LRESULT result = prevProc ? CallWindowProc(prevProc, hwnd, message, wParam, lParam)
+                              : DefWindowProc(hwnd, message, wParam, lParam);
+    if (wait_is_message(message))
+        SetEvent(g_waiter.input);
+    return result;
+}
+
+// 窗口仍然存在且仍使用子类化的窗口过程时恢复 EasyX 的窗口过程。
+// prevProc 不清空：窗口线程可能正在子类化的窗口过程中，恢复后还会调用它
+static void wait_restore_proc()
+{
+    if (g_waiter.installed && IsWindow(g_waiter.hwnd) &&
+        reinterpret_cast<WNDPROC>(GetWindowLongPtr(g_waiter.hwnd, GWLP_WNDPROC)) == wait_window_proc)
+        SetWindowLongPtr(g_waiter.hwnd, GWLP_WNDPROC,
+                         reinterpret_cast<LONG_PTR>(g_waiter.prevProc.load(std::memory_order_relaxed)));
+    g_waiter.installed = false;
+}
+
+MessageWaiter::~MessageWaiter()
+{
+    wait_restore_proc();
+    if (wake)
+        CloseHandle(wake);
+    if (input)
+        CloseHandle(input);
+}
+
+// 窗口由 EasyX 的线程创建时替换它的窗口过程；窗口重新创建后重新替换
+static void wait_install_proc()
+{
+    HWND hwnd = easyx_gethwnd();
+    if (hwnd == g_waiter.hwnd &&
+        (!g_waiter.installed || reinterpret_cast<WNDPROC>(GetWindowLongPtr(hwnd, GWLP_WNDPROC)) == wait_window_proc))
+        return;
+
+    wait_restore_proc();
+    g_waiter.hwnd = hwnd;
+    g_waiter.windowThread = hwnd ? GetWindowThreadProcessId(hwnd, NULL) : 0;
+
+    // 窗口属于当前线程时 MsgWaitForMultipleObjectsEx 本身就会被输入唤醒
+    if (!hwnd || g_waiter.windowThread == GetCurrentThreadId())
+        return;
+
+    // 窗口属于同一进程，可以在其他线程中替换窗口过程。
+    // 替换前先记录原来的窗口过程，替换后窗口线程立即分发的消息也能转交给它
+    // 窗口已经使用子类化的窗口过程时保留之前记录的 prevProc，避免转交给自己
+    WNDPROC current = reinterpret_cast<WNDPROC>(GetWindowLongPtr(hwnd, GWLP_WNDPROC));
+    if (current != wait_window_proc)
+    {
+        g_waiter.prevProc.store(current, std::memory_order_release);
+        WNDPROC replaced = reinterpret_cast<WNDPROC>(
+            SetWindowLongPtr(hwnd, GWLP_WNDPROC, reinterpret_cast<LONG_PTR>(wait_window_proc)));
+        if (replaced != current && replaced != wait_window_proc)
+            g_waiter.prevProc.store(replaced, std::memory_order_release);
+    }
+    g_waiter.installed = true;
+}
+
+// 无窗口模式下没有 EasyX 的消息队列，只等待唤醒和超时
+static bool wait_has_message(unsigned char filter)
+{
+    if (easyx_getcanvas())
+        return false;
+    ExMessage msg;
+    return peekmessage(&msg, filter, false);
+}
+
+int easyx_waitmessage(int timeoutMs, unsigned char filter)
+{
+    PROFILE_SCOPE(EASYX_PROF_MESSAGES);
+    if (!easyx_getcanvas())
+        wait_install_proc();
+
+    if (wait_has_message(filter))
+        return EASYX_WAIT_MESSAGE;
+
+    ULONGLONG start = GetTickCount64();
+    HANDLE handles[2] = {g_waiter.wake, g_waiter.input};
+    for (;;)
+    {
+        DWORD timeout = INFINITE;
+        if (timeoutMs >= 0)
+        {
+            ULONGLONG elapsed = GetTickCount64() - start;
+            if (elapsed >= static_cast<ULONGLONG>(timeoutMs))
+                return EASYX_WAIT_TIMEOUT;
+            timeout = static_cast<DWORD>(timeoutMs - elapsed);
+        }
+
+        DWORD result = MsgWaitForMultipleObjectsEx(2, handles, timeout, QS_ALLINPUT, 0);
+        if (result == WAIT_OBJECT_0)
+            return EASYX_WAIT_WAKE;
+        if (result == WAIT_TIMEOUT)
+            return EASYX_WAIT_TIMEOUT;
+        if (result == WAIT_FAILED)
+        {
+            // 句柄无效时退化为按超时休眠，避免空转
+            Sleep(timeout == INFINITE ? 1 : timeout);
+            return wait_has_message(filter) ? EASYX_WAIT_MESSAGE : EASYX_WAIT_TIMEOUT;
+        }
+
+        // 有输入到达，不符合过滤条件的消息继续等待
+        if (wait_has_message(filter))
+            return EASYX_WAIT_MESSAGE;
+    }
+}
+
+void easyx_wake()
+{
+    if (g_waiter.wake)
+        SetEvent(g_waiter.wake);
+}
@@ -2,12 +2,23 @@
 // C++ 实现，包装 EasyX 库的函数，提供 C 风格接口
 
 #include "easyx_wrapper.h"
+#include "easyx_profiler.h"
+#include <math.h>
+#include <atomic>
+#include <string.h>
+#include <mutex>
 #include <string>
+#include <unordered_map>
+#include <vector>
 #include <windows.h>
 #include <tchar.h>
 #include "../EasyX_26.1.1/include/easyx.h"
 #include "../EasyX_26.1.1/include/graphics.h"
 
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#include <emmintrin.h>
+#endif
+
 // 字符串转换辅助函数
 inline std::basic_string<TCHAR> ansi_to_tstring(const char *str)
 {
@@ -29,36 +40,930 @@ inline std::basic_string<TCHAR> ansi_to_tstring(const char *str)
 #endif
 }
 
+// 文本转换缓存
+// 每帧重复绘制的短文本（标题、分数等）命中 LRU 缓存后无需再次转换；
+// 未命中或过长的文本转换到线程局部的暂存区，稳态下不产生堆分配
+#define TEXT_CACHE_ENTRIES 64
+#define TEXT_CACHE_MAX_BYTES 256
+
+struct TextCacheEntry
+{
+    uint32_t hash = 0;
+    uint64_t tick = 0;              // 最近一次使用的时间戳，0 表示空槽
+    std::string key;                // UTF-8 原文
+    std::basic_string<TCHAR> value; // 转换结果
+};
+
+struct TextCache
+{
+    TextCacheEntry entries[TEXT_CACHE_ENTRIES];
+    uint64_t tick = 0;
+    std::vector<TCHAR> scratch;
+};
+
+static thread_local TextCache t_text_cache;
+
+static uint32_t text_hash(const char *str, size_t len)
+{
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < len; ++i)
+    {
+        hash ^= static_cast<unsigned char>(str[i]);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// 将 len 字节的 UTF-8 文本转换到 out，复用 out 已有的容量
+template <typename Out>
+static void text_convert(const char *str, size_t len, Out &out)
+{
+#ifdef UNICODE
+    // UTF-16 码元数不会超过 UTF-8 字节数，只需调用一次 MultiByteToWideChar
+    out.resize(len + 1);
+    int n = len > 0 ? MultiByteToWideChar(CP_UTF8, 0, str, static_cast<int>(len), reinterpret_cast<LPWSTR>(&out[0]), static_cast<int>(len)) : 0;
+    out.resize(static_cast<size_t>(n) + 1);
+    out[n] = 0;
+#else
+    out.assign(str, str + len);
+    out.push_back(0);
+#endif
+}
+
+// 获取 UTF-8 文本对应的 TCHAR 字符串，返回的指针在下一次调用前有效
+static const TCHAR *text_lookup(const char *str, size_t len, bool cacheable = true)
+{
+    TextCache &cache = t_text_cache;
+
+    if (!str)
+        len = 0;
+
+    if (!cacheable || len > TEXT_CACHE_MAX_BYTES)
+    {
+        text_convert(str, len, cache.scratch);
+        return &cache.scratch[0];
+    }
+
+    uint32_t hash = text_hash(str, len);
+    TextCacheEntry *victim = &cache.entries[0];
+
+    for (int i = 0; i < TEXT_CACHE_ENTRIES; ++i)
+    {
+        TextCacheEntry &entry = cache.entries[i];
+        if (entry.tick != 0 && entry.hash == hash && entry.key.size() == len && memcmp(entry.key.data(), str, len) == 0)
+        {
+            entry.tick = ++cache.tick;
+            return entry.value.c_str();
+        }
+        if (entry.tick < victim->tick)
+            victim = &entry;
+    }
+
+    // 替换最久未使用的槽位，assign 复用槽位原有的容量
+    victim->hash = hash;
+    victim->tick = ++cache.tick;
+    victim->key.assign(str, len);
+    text_convert(str, len, victim->value);
+    victim->value.pop_back(); // basic_string 自带结尾的 0
+    return victim->value.c_str();
+}
+
+static const TCHAR *text_lookup(const char *str)
+{
+    return text_lookup(str, str ? strlen(str) : 0);
+}
+
+// 绘图状态影子缓存
+// 按当前工作图像（NULL 表示绘图窗口）记录最近一次下发给 EasyX 的状态，
+// 重复设置相同的值时直接跳过，避免 EasyX 反复重建 GDI 画笔和画刷
+enum ShadowField
+{
+    SHADOW_LINECOLOR = 1 << 0,
+    SHADOW_FILLCOLOR = 1 << 1,
+    SHADOW_TEXTCOLOR = 1 << 2,
+    SHADOW_BKCOLOR = 1 << 3,
+    SHADOW_BKMODE = 1 << 4,
+    SHADOW_LINESTYLE = 1 << 5,
+    SHADOW_FILLSTYLE = 1 << 6,
+};
+
+// 样式数组在原地比较和覆盖，命中时不分配内存
+struct ShadowLineStyle
+{
+    int style;
+    int thickness;
+    std::vector<uint32_t> userstyle;
+
+    bool equals(int s, int t, const uint32_t *user, uint32_t count) const
+    {
+        return style == s && thickness == t && userstyle.size() == count &&
+               (count == 0 || memcmp(userstyle.data(), user, sizeof(uint32_t) * count) == 0);
+    }
+
+    void assign(int s, int t, const uint32_t *user, uint32_t count)
+    {
+        style = s;
+        thickness = t;
+        userstyle.assign(user, user + count);
+    }
+};
+
+struct ShadowFillStyle
+{
+    int style;
+    long hatch;
+
+    bool operator==(const ShadowFillStyle &other) const
+    {
+        return style == other.style && hatch == other.hatch;
+    }
+};
+
+struct ShadowState
+{
+    unsigned valid = 0; // ShadowField 位掩码，标记哪些字段已知
+    uint32_t linecolor = 0;
+    uint32_t fillcolor = 0;
+    uint32_t textcolor = 0;
+    uint32_t bkcolor = 0;
+    int bkmode = 0;
+    ShadowLineStyle linestyle = {};
+    ShadowFillStyle fillstyle = {};
+};
+
+struct ShadowCache
+{
+    bool enabled = true;
+    std::unordered_map<const void *, ShadowState> devices;
+    const void *key = NULL;      // 当前工作图像
+    const void *window = NULL;   // 绘图窗口对应的设备指针
+    ShadowState *current = NULL; // devices[key] 的缓存指针
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+};
+
+static ShadowCache g_shadow;
+
+static ShadowState &shadow_current()
+{
+    // unordered_map 的元素引用在 rehash 后依然有效
+    if (!g_shadow.current)
+        g_shadow.current = &g_shadow.devices[g_shadow.key];
+    return *g_shadow.current;
+}
+
+// 返回 true 表示该状态与缓存一致，可以跳过本次设置
+template <typename T>
+static bool shadow_skip(unsigned field, T ShadowState::*member, const T &value)
+{
+    if (!g_shadow.enabled)
+        return false;
+
+    ShadowState &state = shadow_current();
+    if ((state.valid & field) && state.*member == value)
+    {
+        ++g_shadow.hits;
+        return true;
+    }
+
+    state.*member = value;
+    state.valid |= field;
+    ++g_shadow.misses;
+    return false;
+}
+
+// 当前设备的指定状态被其他途径修改，缓存失效
+static void shadow_invalidate(unsigned fields)
+{
+    std::unordered_map<const void *, ShadowState>::iterator it = g_shadow.devices.find(g_shadow.key);
+    if (it != g_shadow.devices.end())
+        it->second.valid &= ~fields;
+}
+
+static void font_forget(const void *img);
+
+// 指定设备的全部状态失效（图像被销毁、重建或重新加载）
+static void shadow_forget(const void *img)
+{
+    // EasyX 中 NULL 表示绘图窗口
+    if (!img)
+        img = g_shadow.window;
+
+    font_forget(img);
+    g_shadow.devices.erase(img);
+    if (img == g_shadow.key)
+        g_shadow.current = NULL;
+}
+
+static void shadow_reset()
+{
+    g_shadow.devices.clear();
+    g_shadow.current = NULL;
+}
+
+void easyx_statecache_setenabled(int enabled)
+{
+    g_shadow.enabled = enabled != 0;
+    shadow_reset();
+}
+
+int easyx_statecache_getenabled()
+{
+    return g_shadow.enabled ? 1 : 0;
+}
+
+void easyx_statecache_invalidate()
+{
+    shadow_reset();
+}
+
+void easyx_statecache_getstats(uint64_t *phits, uint64_t *pmisses)
+{
+    if (phits)
+        *phits = g_shadow.hits;
+    if (pmisses)
+        *pmisses = g_shadow.misses;
+}
+
+void easyx_statecache_resetstats()
+{
+    g_shadow.hits = 0;
+    g_shadow.misses = 0;
+}
+
+// 脏矩形跟踪
+// 批处理绘图期间记录绘制到窗口的每个图元的外接矩形（设备坐标，包含右下边界），
+// 合并为少量矩形后由 easyx_flushbatchdraw_dirty 只刷新这些区域。
+// 记录文本范围需要额外的 GDI 调用，因此跟踪默认关闭，第一次调用 easyx_flushbatchdraw_dirty 时开启
+#define DIRTY_DEFAULT_MERGE_THRESHOLD 1.5f
+
+struct DirtyRect
+{
+    int left, top, right, bottom;
+};
+
+struct DirtyTracker
+{
+    bool enabled = false;
+    bool batching = false;
+    bool all = false; // 整个窗口都需要刷新
+    int width = 0, height = 0;
+    float mergeThreshold = DIRTY_DEFAULT_MERGE_THRESHOLD;
+
+    DirtyRect rects[EASYX_DIRTY_MAX_RECTS];
+    int count = 0;
+
+    // 窗口的坐标变换和线宽，用于把逻辑坐标换算为设备坐标
+    int originX = 0, originY = 0;
+    float xasp = 1.0f, yasp = 1.0f;
+    int thickness = 1;
+    bool textRotated = false;
+};
+
+static DirtyTracker g_dirty;
+
+static inline long long dirty_area(const DirtyRect &r)
+{
+    return static_cast<long long>(r.right - r.left + 1) * (r.bottom - r.top + 1);
+}
+
+static inline DirtyRect dirty_union(const DirtyRect &a, const DirtyRect &b)
+{
+    DirtyRect r;
+    r.left = a.left < b.left ? a.left : b.left;
+    r.top = a.top < b.top ? a.top : b.top;
+    r.right = a.right > b.right ? a.right : b.right;
+    r.bottom = a.bottom > b.bottom ? a.bottom : b.bottom;
+    return r;
+}
+
+// 当前是否在批处理中绘制窗口
+static inline bool dirty_active()
+{
+    return g_dirty.enabled && g_dirty.batching && g_dirty.width > 0 && g_shadow.key == g_shadow.window;
+}
+
+// 窗口设备是否为当前工作设备（用于记录窗口的坐标变换）
+static inline bool dirty_window_current()
+{
+    return g_shadow.key == g_shadow.window;
+}
+
+static void dirty_clear()
+{
+    g_dirty.all = false;
+    g_dirty.count = 0;
+}
+
+static void dirty_reset_transform()
+{
+    g_dirty.originX = 0;
+    g_dirty.originY = 0;
+    g_dirty.xasp = 1.0f;
+    g_dirty.yasp = 1.0f;
+    g_dirty.thickness = 1;
+    g_dirty.textRotated = false;
+}
+
+static void dirty_all()
+{
+    if (dirty_active())
+        g_dirty.all = true;
+}
+
+// 插入一个设备坐标矩形，与合并代价低的已有矩形合并
+static void dirty_insert(DirtyRect r)
+{
+    if (r.left < 0)
+        r.left = 0;
+    if (r.top < 0)
+        r.top = 0;
+    if (r.right >= g_dirty.width)
+        r.right = g_dirty.width - 1;
+    if (r.bottom >= g_dirty.height)
+        r.bottom = g_dirty.height - 1;
+    if (r.left > r.right || r.top > r.bottom)
+        return;
+
+    // 合并后的面积不超过两者面积之和的 mergeThreshold 倍时合并，合并结果可能继续与其他矩形合并
+    for (int i = 0; i < g_dirty.count;)
+    {
+        DirtyRect u = dirty_union(g_dirty.rects[i], r);
+        if (dirty_area(u) <= (dirty_area(g_dirty.rects[i]) + dirty_area(r)) * g_dirty.mergeThreshold)
+        {
+            r = u;
+            g_dirty.rects[i] = g_dirty.rects[--g_dirty.count];
+            i = 0;
+        }
+        else
+        {
+            ++i;
+        }
+    }
+
+    // 已满时并入面积增长最小的矩形
+    if (g_dirty.count == EASYX_DIRTY_MAX_RECTS)
+    {
+        int best = 0;
+        long long bestGrowth = -1;
+        for (int i = 0; i < g_dirty.count; ++i)
+        {
+            long long growth = dirty_area(dirty_union(g_dirty.rects[i], r)) - dirty_area(g_dirty.rects[i]);
+            if (bestGrowth < 0 || growth < bestGrowth)
+            {
+                best = i;
+                bestGrowth = growth;
+            }
+        }
+        g_dirty.rects[best] = dirty_union(g_dirty.rects[best], r);
+        return;
+    }
+
+    g_dirty.rects[g_dirty.count++] = r;
+}
+
+// 记录逻辑坐标矩形，pad 为向外扩展的像素数（线宽、取整误差）
+static void dirty_logical(int left, int top, int right, int bottom, int pad)
+{
+    if (!dirty_active() || g_dirty.all)
+        return;
+
+    float x1 = left * g_dirty.xasp, x2 = right * g_dirty.xasp;
+    float y1 = top * g_dirty.yasp, y2 = bottom * g_dirty.yasp;
+
+    DirtyRect r;
+    r.left = static_cast<int>(x1 < x2 ? x1 : x2) + g_dirty.originX - pad;
+    r.right = static_cast<int>(x1 < x2 ? x2 : x1) + g_dirty.originX + pad;
+    r.top = static_cast<int>(y1 < y2 ? y1 : y2) + g_dirty.originY - pad;
+    r.bottom = static_cast<int>(y1 < y2 ? y2 : y1) + g_dirty.originY + pad;
+    dirty_insert(r);
+}
+
+// 带边框的图元按线宽扩展
+static inline int dirty_line_pad()
+{
+    return g_dirty.thickness / 2 + 1;
+}
+
+static void dirty_points(const POINT *points, int num, int pad)
+{
+    if (!dirty_active() || g_dirty.all || !points || num <= 0)
+        return;
+
+    int left = points[0].x, right = points[0].x, top = points[0].y, bottom = points[0].y;
+    for (int i = 1; i < num; ++i)
+    {
+        if (points[i].x < left)
+            left = points[i].x;
+        if (points[i].x > right)
+            right = points[i].x;
+        if (points[i].y < top)
+            top = points[i].y;
+        if (points[i].y > bottom)
+            bottom = points[i].y;
+    }
+    dirty_logical(left, top, right, bottom, pad);
+}
+
+// 文本按当前字体的宽高记录，旋转的文本无法简单估计范围，刷新整个窗口
+static void dirty_text(int x, int y, const TCHAR *str)
+{
+    if (!dirty_active() || g_dirty.all)
+        return;
+    if (g_dirty.textRotated)
+    {
+        g_dirty.all = true;
+        return;
+    }
+
+    int height = textheight(str);
+    // 斜体和字形悬垂可能超出步进宽度
+    dirty_logical(x, y, x + textwidth(str), y + height, height / 4 + 1);
+}
+
+static void dirty_drawtext(const RECT *rect, unsigned int uFormat)
+{
+    // DT_CALCRECT 只计算不绘制
+    if (!rect || (uFormat & DT_CALCRECT))
+        return;
+    if (g_dirty.textRotated || (uFormat & DT_NOCLIP))
+    {
+        dirty_all();
+        return;
+    }
+    dirty_logical(rect->left, rect->top, rect->right, rect->bottom, 1);
+}
+
+// 记录窗口上当前文本样式是否旋转
+static void dirty_textstyle(int escapement)
+{
+    if (dirty_window_current())
+        g_dirty.textRotated = escapement != 0;
+}
+
+void easyx_dirty_add(int left, int top, int right, int bottom)
+{
+    if (!dirty_active() || g_dirty.all)
+        return;
+
+    DirtyRect r = {left < right ? left : right, top < bottom ? top : bottom, left < right ? right : left, top < bottom ? bottom : top};
+    dirty_insert(r);
+}
+
+void easyx_dirty_addlogical(int left, int top, int right, int bottom, int pad)
+{
+    dirty_logical(left, top, right, bottom, pad);
+}
+
+void easyx_dirty_markall()
+{
+    dirty_all();
+}
+
+void easyx_dirty_enable(int enable)
+{
+    if (enable && !g_dirty.enabled)
+    {
+        // 开启前的绘制没有记录，下一次刷新整个窗口
+        g_dirty.enabled = true;
+        g_dirty.all = true;
+    }
+    else if (!enable)
+    {
+        g_dirty.enabled = false;
+        dirty_clear();
+    }
+}
+
+int easyx_dirty_isenabled()
+{
+    return g_dirty.enabled;
+}
+
+void easyx_dirty_setmergethreshold(float ratio)
+{
+    g_dirty.mergeThreshold = ratio > 0 ? ratio : DIRTY_DEFAULT_MERGE_THRESHOLD;
+}
+
+int easyx_dirty_getrects(int32_t *rects, int capacity)
+{
+    if (g_dirty.all)
+    {
+        if (rects && capacity >= 1)
+        {
+            rects[0] = 0;
+            rects[1] = 0;
+            rects[2] = g_dirty.width - 1;
+            rects[3] = g_dirty.height - 1;
+        }
+        return 1;
+    }
+
+    for (int i = 0; rects && i < g_dirty.count && i < capacity; ++i)
+    {
+        rects[i * 4 + 0] = g_dirty.rects[i].left;
+        rects[i * 4 + 1] = g_dirty.rects[i].top;
+        rects[i * 4 + 2] = g_dirty.rects[i].right;
+        rects[i * 4 + 3] = g_dirty.rects[i].bottom;
+    }
+    return g_dirty.count;
+}
+
+// 字体缓存
+// 按完整的 LOGFONT 缓存 HFONT，切换字体时直接把缓存的字体选入工作图像的设备上下文，
+// 不再经过 EasyX 每次都调用 CreateFontIndirect 的 settextstyle。选入时保存 EasyX 自己的字体，
+// 调用 EasyX 的文本样式函数或图像被销毁、重建之前先选回，EasyX 不会看到或删除缓存的字体
+#define FONTCACHE_DEFAULT_CAPACITY 64
+
+struct FontEntry
+{
+    LOGFONT logfont; // 字体名之后的字节清零，可以按字节比较
+    HFONT hfont;
+    uint64_t hash;
+    int refs; // easyx_font_acquire 的引用数加上选入该字体的设备数
+    uint64_t lastUse;
+};
+
+struct FontSelection
+{
+    FontEntry *entry;
+    HGDIOBJ original; // 选入缓存字体之前 EasyX 的字体
+};
+
+struct FontCache
+{
+    std::unordered_map<uint64_t, std::vector<FontEntry *>> entries;
+    std::unordered_map<const void *, FontSelection> selections; // 键与 g_shadow.key 相同
+    size_t count = 0;
+    size_t capacity = FONTCACHE_DEFAULT_CAPACITY;
+    uint64_t clock = 0;
+    EasyXFontCacheStats stats = {};
+};
+
+static FontCache g_fonts;
+
+static void font_normalize(const LOGFONT *src, LOGFONT *dst)
+{
+    *dst = *src;
+    size_t len = 0;
+    while (len < LF_FACESIZE && dst->lfFaceName[len])
+        ++len;
+    if (len == LF_FACESIZE)
+        len = LF_FACESIZE - 1;
+    memset(dst->lfFaceName + len, 0, sizeof(TCHAR) * (LF_FACESIZE - len));
+}
+
+static uint64_t font_hash(const LOGFONT *lf)
+{
+    // FNV-1a
+    const unsigned char *p = reinterpret_cast<const unsigned char *>(lf);
+    uint64_t hash = 1469598103934665603ull;
+    for (size_t i = 0; i < sizeof(LOGFONT); ++i)
+        hash = (hash ^ p[i]) * 1099511628211ull;
+    return hash;
+}
+
+// 删除最久没有使用、没有被引用的字体，直到不超过容量
+static void font_evict(size_t capacity)
+{
+    while (g_fonts.count > capacity)
+    {
+        std::unordered_map<uint64_t, std::vector<FontEntry *>>::iterator oldestBucket = g_fonts.entries.end();
+        size_t oldestIndex = 0;
+        for (std::unordered_map<uint64_t, std::vector<FontEntry *>>::iterator it = g_fonts.entries.begin(); it != g_fonts.entries.end(); ++it)
+        {
+            for (size_t i = 0; i < it->second.size(); ++i)
+            {
+                FontEntry *entry = it->second[i];
+                if (entry->refs == 0 && (oldestBucket == g_fonts.entries.end() || entry->lastUse < oldestBucket->second[oldestIndex]->lastUse))
+                {
+                    oldestBucket = it;
+                    oldestIndex = i;
+                }
+            }
+        }
+        if (oldestBucket == g_fonts.entries.end())
+            return;
+
+        FontEntry *entry = oldestBucket->second[oldestIndex];
+        DeleteObject(entry->hfont);
+        delete entry;
+        oldestBucket->second.erase(oldestBucket->second.begin() + oldestIndex);
+        if (oldestBucket->second.empty())
+            g_fonts.entries.erase(oldestBucket);
+        --g_fonts.count;
+        ++g_fonts.stats.evictions;
+    }
+}
+
+// 查找或创建字体，不增加引用
+static FontEntry *font_lookup(const LOGFONT *lf)
+{
+    LOGFONT key;
+    font_normalize(lf, &key);
+    uint64_t hash = font_hash(&key);
+
+    std::vector<FontEntry *> &bucket = g_fonts.entries[hash];
+    for (size_t i = 0; i < bucket.size(); ++i)
+    {
+        if (memcmp(&bucket[i]->logfont, &key, sizeof(LOGFONT)) == 0)
+        {
+            bucket[i]->lastUse = ++g_fonts.clock;
+            ++g_fonts.stats.hits;
+            return bucket[i];
+        }
+    }
+
+    HFONT hfont = CreateFontIndirect(&key);
+    if (!hfont)
+    {
+        if (bucket.empty())
+            g_fonts.entries.erase(hash);
+        return NULL;
+    }
+
+    FontEntry *entry = new FontEntry();
+    entry->logfont = key;
+    entry->hfont = hfont;
+    entry->hash = hash;
+    entry->refs = 0;
+    entry->lastUse = ++g_fonts.clock;
+    bucket.push_back(entry);
+    ++g_fonts.count;
+    ++g_fonts.stats.created;
+
+    // 新字体先加引用，淘汰时不会删除它
+    ++entry->refs;
+    font_evict(g_fonts.capacity);
+    --entry->refs;
+    return entry;
+}
+
+// 选回 EasyX 的字体，之后设备上不再有缓存的字体
+static void font_forget(const void *img)
+{
+    std::unordered_map<const void *, FontSelection>::iterator it = g_fonts.selections.find(img);
+    if (it == g_fonts.selections.end())
+        return;
+
+    HDC hdc = GetImageHDC(reinterpret_cast<IMAGE *>(const_cast<void *>(img)));
+    // EasyX 已经选入了别的字体时不需要选回
+    if (hdc && GetCurrentObject(hdc, OBJ_FONT) == it->second.entry->hfont)
+        SelectObject(hdc, it->second.original);
+    --it->second.entry->refs;
+    g_fonts.selections.erase(it);
+}
+
+static void font_forget_all()
+{
+    while (!g_fonts.selections.empty())
+        font_forget(g_fonts.selections.begin()->first);
+}
+
+// 当前工作图像上选入的缓存字体，EasyX 重新选入自己的字体后返回 NULL
+static FontEntry *font_selected()
+{
+    std::unordered_map<const void *, FontSelection>::iterator it = g_fonts.selections.find(g_shadow.key);
+    if (it == g_fonts.selections.end())
+        return NULL;
+    HDC hdc = GetImageHDC(GetWorkingImage());
+    return hdc && GetCurrentObject(hdc, OBJ_FONT) == it->second.entry->hfont ? it->second.entry : NULL;
+}
+
+// 返回 1 表示切换了字体，0 表示已经是当前字体
+static int font_select(FontEntry *entry)
+{
+    HDC hdc = GetImageHDC(GetWorkingImage());
+    if (!hdc)
+        return 0;
+
+    HGDIOBJ current = GetCurrentObject(hdc, OBJ_FONT);
+    if (current == entry->hfont)
+    {
+        ++g_fonts.stats.skipped;
+        return 0;
+    }
+
+    dirty_textstyle(entry->logfont.lfEscapement);
+    HGDIOBJ previous = SelectObject(hdc, entry->hfont);
+    ++entry->refs;
+    ++g_fonts.stats.selects;
+
+    std::unordered_map<const void *, FontSelection>::iterator it = g_fonts.selections.find(g_shadow.key);
+    if (it == g_fonts.selections.end())
+    {
+        FontSelection selection = {entry, previous};
+        g_fonts.selections[g_shadow.key] = selection;
+        return 1;
+    }
+
+    // 上一个缓存字体已被 EasyX 的字体替换时，替换它的才是需要选回的字体
+    if (previous != it->second.entry->hfont)
+        it->second.original = previous;
+    --it->second.entry->refs;
+    it->second.entry = entry;
+    return 1;
+}
+
+// 调用 EasyX 的文本样式函数之前选回 EasyX 的字体
+static inline void font_release_current()
+{
+    if (!g_fonts.selections.empty())
+        font_forget(g_shadow.key);
+}
+
+void *easyx_font_acquire(const void *pLogFont)
+{
+    PROFILE_SCOPE(EASYX_PROF_TEXT);
+    LOGFONT lf;
+    if (pLogFont)
+        lf = *reinterpret_cast<const LOGFONT *>(pLogFont);
+    else
+        easyx_gettextstyle(&lf);
+
+    FontEntry *entry = font_lookup(&lf);
+    if (entry)
+        ++entry->refs;
+    return entry;
+}
+
+void easyx_font_release(void *font)
+{
+    FontEntry *entry = reinterpret_cast<FontEntry *>(font);
+    if (!entry)
+        return;
+    --entry->refs;
+    font_evict(g_fonts.capacity);
+}
+
+int easyx_font_select(void *font)
+{
+    PROFILE_SCOPE(EASYX_PROF_TEXT);
+    FontEntry *entry = reinterpret_cast<FontEntry *>(font);
+    if (!entry)
+        return 0;
+    entry->lastUse = ++g_fonts.clock;
+    return font_select(entry);
+}
+
+void easyx_font_getlogfont(void *font, void *pLogFont)
+{
+    FontEntry *entry = reinterpret_cast<FontEntry *>(font);
+    if (entry && pLogFont)
+        *reinterpret_cast<LOGFONT *>(pLogFont) = entry->logfont;
+}
+
+HFONT easyx_font_gethandle(void *font)
+{
+    FontEntry *entry = reinterpret_cast<FontEntry *>(font);
+    return entry ? entry->hfont : NULL;
+}
+
+void easyx_fontcache_setcapacity(int capacity)
+{
+    g_fonts.capacity = capacity > 0 ? static_cast<size_t>(capacity) : FONTCACHE_DEFAULT_CAPACITY;
+    font_evict(g_fonts.capacity);
+}
+
+void easyx_fontcache_clear()
+{
+    font_evict(0);
+}
+
+void easyx_fontcache_getstats(EasyXFontCacheStats *pStats)
+{
+    if (!pStats)
+        return;
+    *pStats = g_fonts.stats;
+    pStats->cached = static_cast<int>(g_fonts.count);
+    pStats->selected = static_cast<int>(g_fonts.selections.size());
+}
+
+// 无窗口渲染
+// 无窗口模式下由画布代替绘图窗口，EasyX 中表示绘图窗口的 NULL 都映射到画布
+static IMAGE *g_canvas = NULL;
+
+// 创建绘图窗口或画布的线程。状态缓存、字体缓存和工作图像只在这个线程中访问，
+// 尚未创建时任何线程都视为绘图线程
+static std::atomic<DWORD> g_graphicsThread(0);
+
+static bool on_graphics_thread()
+{
+    DWORD thread = g_graphicsThread.load(std::memory_order_relaxed);
+    return thread == 0 || thread == GetCurrentThreadId();
+}
+
+static void imagepool_drain_deferred();
+
+static IMAGE *device_image(const void *pImg)
+{
+    if (!pImg && g_canvas)
+        return g_canvas;
+    return reinterpret_cast<IMAGE *>(const_cast<void *>(pImg));
+}
+
 // 图形窗口相关函数
 HWND easyx_initgraph(int width, int height, int flag)
 {
-    return initgraph(width, height, flag);
+    if (g_canvas)
+        easyx_closegraph();
+
+    font_forget_all();
+    shadow_reset();
+    g_graphicsThread.store(GetCurrentThreadId(), std::memory_order_relaxed);
+    HWND hwnd = initgraph(width, height, flag);
+    g_shadow.window = GetWorkingImage();
+    g_shadow.key = g_shadow.window;
+
+    dirty_clear();
+    dirty_reset_transform();
+    g_dirty.batching = false;
+    g_dirty.width = width;
+    g_dirty.height = height;
+    return hwnd;
 }
 
 void easyx_closegraph()
 {
+    imagepool_drain_deferred();
+    font_forget_all();
+    shadow_reset();
+    g_shadow.window = NULL;
+    g_shadow.key = NULL;
+    dirty_clear();
+    g_dirty.batching = false;
+    g_dirty.width = g_dirty.height = 0;
+
+    if (g_canvas)
+    {
+        // 无窗口模式没有创建窗口，只释放画布
+        SetWorkingImage(NULL);
+        delete g_canvas;
+        g_canvas = NULL;
+        return;
+    }
     closegraph();
 }
 
+// 无窗口渲染相关函数
+void *easyx_initheadless(int width, int height)
+{
+    if (width <= 0 || height <= 0)
+        return NULL;
+    if (g_canvas || GetHWnd())
+        easyx_closegraph();
+
+    font_forget_all();
+    shadow_reset();
+    g_graphicsThread.store(GetCurrentThreadId(), std::memory_order_relaxed);
+    g_canvas = new IMAGE(width, height);
+    SetWorkingImage(g_canvas);
+    g_shadow.window = g_canvas;
+    g_shadow.key = g_canvas;
+
+    dirty_clear();
+    dirty_reset_transform();
+    g_dirty.batching = false;
+    g_dirty.width = width;
+    g_dirty.height = height;
+    return g_canvas;
+}
+
+void *easyx_getcanvas()
+{
+    return g_canvas;
+}
+
 // 图形环境相关函数
 void easyx_cleardevice()
 {
+    PROFILE_SCOPE(EASYX_PROF_PRIMITIVES);
+    dirty_all();
     cleardevice();
 }
 
 void easyx_setcliprgn(void *hrgn)
 {
+    PROFILE_SCOPE(EASYX_PROF_STATE);
     setcliprgn(reinterpret_cast<HRGN>(hrgn));
 }
 
 void easyx_clearcliprgn()
 {
+    PROFILE_SCOPE(EASYX_PROF_STATE);
     clearcliprgn();
 }
 
 // 坐标和比例相关函数
 void easyx_setorigin(int x, int y)
 {
+    PROFILE_SCOPE(EASYX_PROF_STATE);
+    if (dirty_window_current())
+    {
+        g_dirty.originX = x;
+        g_dirty.originY = y;
+    }
     setorigin(x, y);
 }
 
@@ -69,6 +974,12 @@ void easyx_getaspectratio(float *pxasp, float *pyasp)
 
 void easyx_setaspectratio(float xasp, float yasp)
 {
+    PROFILE_SCOPE(EASYX_PROF_STATE);
+    if (dirty_window_current())
+    {
+        g_dirty.xasp = xasp;
+        g_dirty.yasp = yasp;
+    }
     setaspectratio(xasp, yasp);
 }
 
@@ -80,6 +991,7 @@ int easyx_getrop2()
 
 void easyx_setrop2(int mode)
 {
+    PROFILE_SCOPE(EASYX_PROF_STATE);
     setrop2(mode);
 }
 
@@ -90,17 +1002,40 @@ int easyx_getpolyfillmode()
 
 void easyx_setpolyfillmode(int mode)
 {
+    PROFILE_SCOPE(EASYX_PROF_STATE);
     setpolyfillmode(mode);
 }
 
 void easyx_graphdefaults()
 {
+    PROFILE_SCOPE(EASYX_PROF_STATE);
+    shadow_invalidate(~0u);
+    if (dirty_window_current())
+        dirty_reset_transform();
     graphdefaults();
 }
 
 // 线条样式相关函数
 void easyx_setlinestyle(int style, int thickness, const uint32_t *puserstyle, uint32_t userstylecount)
 {
+    PROFILE_SCOPE(EASYX_PROF_STATE);
+    if (dirty_window_current())
+        g_dirty.thickness = thickness > 0 ? thickness : 1;
+
+    uint32_t count = puserstyle ? userstylecount : 0;
+    if (g_shadow.enabled)
+    {
+        ShadowState &state = shadow_current();
+        if ((state.valid & SHADOW_LINESTYLE) && state.linestyle.equals(style, thickness, puserstyle, count))
+        {
+            ++g_shadow.hits;
+            return;
+        }
+        state.linestyle.assign(style, thickness, puserstyle, count);
+        state.valid |= SHADOW_LINESTYLE;
+        ++g_shadow.misses;
+    }
+
     setlinestyle(style, thickness, reinterpret_cast<const DWORD *>(puserstyle), static_cast<DWORD>(userstylecount));
 }
 
@@ -145,6 +1080,13 @@ uint32_t easyx_getlinestyle_len()
 // 填充样式相关函数
 void easyx_setfillstyle(int style, long hatch, const void *ppattern)
 {
+    PROFILE_SCOPE(EASYX_PROF_STATE);
+    // 图案填充的内容可能在指针不变的情况下改变，不做缓存
+    if (ppattern)
+        shadow_invalidate(SHADOW_FILLSTYLE);
+    else if (shadow_skip(SHADOW_FILLSTYLE, &ShadowState::fillstyle, ShadowFillStyle{style, hatch}))
+        return;
+
     setfillstyle(style, hatch, reinterpret_cast<const IMAGE *>(ppattern));
 }
 
@@ -171,6 +1113,8 @@ void easyx_getfillstyle(int *pstyle, long *phatch, void **pppattern)
 
 void easyx_setfillstyle_pattern(const uint8_t *ppattern8x8)
 {
+    PROFILE_SCOPE(EASYX_PROF_STATE);
+    shadow_invalidate(SHADOW_FILLSTYLE);
     setfillstyle(ppattern8x8);
 }
 
@@ -182,6 +1126,9 @@ uint32_t easyx_getlinecolor()
 
 void easyx_setlinecolor(uint32_t color)
 {
+    PROFILE_SCOPE(EASYX_PROF_STATE);
+    if (shadow_skip(SHADOW_LINECOLOR, &ShadowState::linecolor, color))
+        return;
     setlinecolor(color);
 }
 
@@ -192,6 +1139,9 @@ uint32_t easyx_gettextcolor()
 
 void easyx_settextcolor(uint32_t color)
 {
+    PROFILE_SCOPE(EASYX_PROF_STATE);
+    if (shadow_skip(SHADOW_TEXTCOLOR, &ShadowState::textcolor, color))
+        return;
     settextcolor(color);
 }
 
@@ -202,6 +1152,9 @@ uint32_t easyx_getfillcolor()
 
 void easyx_setfillcolor(uint32_t color)
 {
+    PROFILE_SCOPE(EASYX_PROF_STATE);
+    if (shadow_skip(SHADOW_FILLCOLOR, &ShadowState::fillcolor, color))
+        return;
     setfillcolor(color);
 }
 
@@ -212,6 +1165,9 @@ uint32_t easyx_getbkcolor()
 
 void easyx_setbkcolor(uint32_t color)
 {
+    PROFILE_SCOPE(EASYX_PROF_STATE);
+    if (shadow_skip(SHADOW_BKCOLOR, &ShadowState::bkcolor, color))
+        return;
     setbkcolor(color);
 }
 
@@ -222,6 +1178,9 @@ int easyx_getbkmode()
 
 void easyx_setbkmode(int mode)
 {
+    PROFILE_SCOPE(EASYX_PROF_STATE);
+    if (shadow_skip(SHADOW_BKMODE, &ShadowState::bkmode, mode))
+        return;
     setbkmode(mode);
 }
 
@@ -254,245 +1213,742 @@ uint32_t easyx_hsv_to_rgb(float H, float S, float V)
 // 绘图相关函数
 uint32_t easyx_getpixel(int x, int y)
 {
+    PROFILE_SCOPE(EASYX_PROF_PRIMITIVES);
     return getpixel(x, y);
 }
 
 void easyx_putpixel(int x, int y, uint32_t color)
 {
+    PROFILE_SCOPE(EASYX_PROF_PRIMITIVES);
+    dirty_logical(x, y, x, y, 1);
     putpixel(x, y, color);
 }
 
 void easyx_line(int x1, int y1, int x2, int y2)
 {
+    PROFILE_SCOPE(EASYX_PROF_PRIMITIVES);
+    dirty_logical(x1, y1, x2, y2, dirty_line_pad());
     line(x1, y1, x2, y2);
 }
 
 void easyx_rectangle(int left, int top, int right, int bottom)
 {
+    PROFILE_SCOPE(EASYX_PROF_PRIMITIVES);
+    dirty_logical(left, top, right, bottom, dirty_line_pad());
     rectangle(left, top, right, bottom);
 }
 
 void easyx_fillrectangle(int left, int top, int right, int bottom)
 {
+    PROFILE_SCOPE(EASYX_PROF_PRIMITIVES);
+    dirty_logical(left, top, right, bottom, dirty_line_pad());
     fillrectangle(left, top, right, bottom);
 }
 
 void easyx_solidrectangle(int left, int top, int right, int bottom)
 {
+    PROFILE_SCOPE(EASYX_PROF_PRIMITIVES);
+    dirty_logical(left, top, right, bottom, 1);
     solidrectangle(left, top, right, bottom);
 }
 
 void easyx_clearrectangle(int left, int top, int right, int bottom)
 {
+    PROFILE_SCOPE(EASYX_PROF_PRIMITIVES);
+    dirty_logical(left, top, right, bottom, 1);
     clearrectangle(left, top, right, bottom);
 }
 
 void easyx_circle(int x, int y, int radius)
 {
+    PROFILE_SCOPE(EASYX_PROF_PRIMITIVES);
+    dirty_logical(x - radius, y - radius, x + radius, y + radius, dirty_line_pad());
     circle(x, y, radius);
 }
 
 void easyx_fillcircle(int x, int y, int radius)
 {
+    PROFILE_SCOPE(EASYX_PROF_PRIMITIVES);
+    dirty_logical(x - radius, y - radius, x + radius, y + radius, dirty_line_pad());
     fillcircle(x, y, radius);
 }
 
 void easyx_solidcircle(int x, int y, int radius)
 {
+    PROFILE_SCOPE(EASYX_PROF_PRIMITIVES);
+    dirty_logical(x - radius, y - radius, x + radius, y + radius, 1);
     solidcircle(x, y, radius);
 }
 
 void easyx_clearcircle(int x, int y, int radius)
 {
+    PROFILE_SCOPE(EASYX_PROF_PRIMITIVES);
+    dirty_logical(x - radius, y - radius, x + radius, y + radius, 1);
     clearcircle(x, y, radius);
 }
 
 void easyx_ellipse(int left, int top, int right, int bottom)
 {
+    PROFILE_SCOPE(EASYX_PROF_PRIMITIVES);
+    dirty_logical(left, top, right, bottom, dirty_line_pad());
     ellipse(left, top, right, bottom);
 }
 
 void easyx_fillellipse(int left, int top, int right, int bottom)
 {
+    PROFILE_SCOPE(EASYX_PROF_PRIMITIVES);
+    dirty_logical(left, top, right, bottom, dirty_line_pad());
     fillellipse(left, top, right, bottom);
 }
 
 void easyx_solidellipse(int left, int top, int right, int bottom)
 {
+    PROFILE_SCOPE(EASYX_PROF_PRIMITIVES);
+    dirty_logical(left, top, right, bottom, 1);
     solidellipse(left, top, right, bottom);
 }
 
 void easyx_clearellipse(int left, int top, int right, int bottom)
 {
+    PROFILE_SCOPE(EASYX_PROF_PRIMITIVES);
+    dirty_logical(left, top, right, bottom, 1);
     clearellipse(left, top, right, bottom);
 }
 
 void easyx_roundrect(int left, int top, int right, int bottom, int ellipsewidth, int ellipseheight)
 {
+    PROFILE_SCOPE(EASYX_PROF_PRIMITIVES);
+    dirty_logical(left, top, right, bottom, dirty_line_pad());
     roundrect(left, top, right, bottom, ellipsewidth, ellipseheight);
 }
 
 void easyx_fillroundrect(int left, int top, int right, int bottom, int ellipsewidth, int ellipseheight)
 {
+    PROFILE_SCOPE(EASYX_PROF_PRIMITIVES);
+    dirty_logical(left, top, right, bottom, dirty_line_pad());
     fillroundrect(left, top, right, bottom, ellipsewidth, ellipseheight);
 }
 
 void easyx_solidroundrect(int left, int top, int right, int bottom, int ellipsewidth, int ellipseheight)
 {
+    PROFILE_SCOPE(EASYX_PROF_PRIMITIVES);
+    dirty_logical(left, top, right, bottom, 1);
     solidroundrect(left, top, right, bottom, ellipsewidth, ellipseheight);
 }
 
 void easyx_clearroundrect(int left, int top, int right, int bottom, int ellipsewidth, int ellipseheight)
 {
+    PROFILE_SCOPE(EASYX_PROF_PRIMITIVES);
+    dirty_logical(left, top, right, bottom, 1);
     clearroundrect(left, top, right, bottom, ellipsewidth, ellipseheight);
 }
 
 void easyx_arc(int left, int top, int right, int bottom, double stangle, double endangle)
 {
+    PROFILE_SCOPE(EASYX_PROF_PRIMITIVES);
+    dirty_logical(left, top, right, bottom, dirty_line_pad());
     arc(left, top, right, bottom, stangle, endangle);
 }
 
 void easyx_pie(int left, int top, int right, int bottom, double stangle, double endangle)
 {
+    PROFILE_SCOPE(EASYX_PROF_PRIMITIVES);
+    dirty_logical(left, top, right, bottom, dirty_line_pad());
     pie(left, top, right, bottom, stangle, endangle);
 }
 
 void easyx_fillpie(int left, int top, int right, int bottom, double stangle, double endangle)
 {
+    PROFILE_SCOPE(EASYX_PROF_PRIMITIVES);
+    dirty_logical(left, top, right, bottom, dirty_line_pad());
     fillpie(left, top, right, bottom, stangle, endangle);
 }
 
 void easyx_solidpie(int left, int top, int right, int bottom, double stangle, double endangle)
 {
+    PROFILE_SCOPE(EASYX_PROF_PRIMITIVES);
+    dirty_logical(left, top, right, bottom, 1);
     solidpie(left, top, right, bottom, stangle, endangle);
 }
 
 void easyx_clearpie(int left, int top, int right, int bottom, double stangle, double endangle)
 {
+    PROFILE_SCOPE(EASYX_PROF_PRIMITIVES);
+    dirty_logical(left, top, right, bottom, 1);
     clearpie(left, top, right, bottom, stangle, endangle);
 }
 
 void easyx_polyline(const void *points, int num)
 {
+    PROFILE_SCOPE(EASYX_PROF_PRIMITIVES);
+    dirty_points(reinterpret_cast<const POINT *>(points), num, dirty_line_pad());
     polyline(reinterpret_cast<const POINT *>(points), num);
 }
 
 void easyx_polygon(const void *points, int num)
 {
+    PROFILE_SCOPE(EASYX_PROF_PRIMITIVES);
+    dirty_points(reinterpret_cast<const POINT *>(points), num, dirty_line_pad());
     polygon(reinterpret_cast<const POINT *>(points), num);
 }
 
 void easyx_fillpolygon(const void *points, int num)
 {
+    PROFILE_SCOPE(EASYX_PROF_PRIMITIVES);
+    dirty_points(reinterpret_cast<const POINT *>(points), num, dirty_line_pad());
     fillpolygon(reinterpret_cast<const POINT *>(points), num);
 }
 
 void easyx_solidpolygon(const void *points, int num)
 {
+    PROFILE_SCOPE(EASYX_PROF_PRIMITIVES);
+    dirty_points(reinterpret_cast<const POINT *>(points), num, 1);
     solidpolygon(reinterpret_cast<const POINT *>(points), num);
 }
 
 void easyx_clearpolygon(const void *points, int num)
 {
+    PROFILE_SCOPE(EASYX_PROF_PRIMITIVES);
+    dirty_points(reinterpret_cast<const POINT *>(points), num, 1);
     clearpolygon(reinterpret_cast<const POINT *>(points), num);
 }
 
 void easyx_polybezier(const void *points, int num)
 {
+    PROFILE_SCOPE(EASYX_PROF_PRIMITIVES);
+    dirty_points(reinterpret_cast<const POINT *>(points), num, dirty_line_pad());
     polybezier(reinterpret_cast<const POINT *>(points), num);
 }
 
+// 顶点转换暂存区，稳态下不产生堆分配
+struct PointScratch
+{
+    std::vector<POINT> points;
+};
+
+static thread_local PointScratch t_point_scratch;
+
+// 将调用者的顶点缓冲区转换为 POINT 数组，返回的指针在下一次调用前有效，格式无效时返回 NULL
+static const POINT *points_convert(const void *xs, const void *ys, size_t stride, int coordType, int num)
+{
+    if (!xs || !ys || num <= 0)
+        return NULL;
+    if (stride == 0)
+        stride = sizeof(int32_t) * 2;
+
+    const unsigned char *px = static_cast<const unsigned char *>(xs);
+    const unsigned char *py = static_cast<const unsigned char *>(ys);
+    bool packed = py == px + sizeof(int32_t) && stride == sizeof(POINT);
+
+    if (coordType == EASYX_COORD_INT32 && packed)
+        return static_cast<const POINT *>(xs);
+    if (coordType != EASYX_COORD_INT32 && coordType != EASYX_COORD_FLOAT)
+        return NULL;
+
+    std::vector<POINT> &out = t_point_scratch.points;
+    if (out.size() < static_cast<size_t>(num))
+        out.resize(num);
+
+    int i = 0;
+    if (coordType == EASYX_COORD_INT32)
+    {
+        for (; i < num; ++i, px += stride, py += stride)
+        {
+            int32_t x, y;
+            memcpy(&x, px, sizeof(x));
+            memcpy(&y, py, sizeof(y));
+            out[i].x = x;
+            out[i].y = y;
+        }
+        return out.data();
+    }
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+    // 交错存放的 float 一次转换两个顶点，舍入方式与下面的 lrintf 相同（就近取偶）
+    if (packed)
+    {
+        const float *in = static_cast<const float *>(xs);
+        for (; i + 2 <= num; i += 2)
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(&out[i]), _mm_cvtps_epi32(_mm_loadu_ps(in + i * 2)));
+        px += i * stride;
+        py += i * stride;
+    }
+#endif
+    for (; i < num; ++i, px += stride, py += stride)
+    {
+        float x, y;
+        memcpy(&x, px, sizeof(x));
+        memcpy(&y, py, sizeof(y));
+        out[i].x = lrintf(x);
+        out[i].y = lrintf(y);
+    }
+    return out.data();
+}
+
+void easyx_polyline_strided(const void *xs, const void *ys, size_t stride, int coordType, int num)
+{
+    PROFILE_SCOPE(EASYX_PROF_PRIMITIVES);
+    const POINT *points = points_convert(xs, ys, stride, coordType, num);
+    if (!points)
+        return;
+    dirty_points(points, num, dirty_line_pad());
+    polyline(points, num);
+}
+
+void easyx_polygon_strided(const void *xs, const void *ys, size_t stride, int coordType, int num)
+{
+    PROFILE_SCOPE(EASYX_PROF_PRIMITIVES);
+    const POINT *points = points_convert(xs, ys, stride, coordType, num);
+    if (!points)
+        return;
+    dirty_points(points, num, dirty_line_pad());
+    polygon(points, num);
+}
+
+void easyx_fillpolygon_strided(const void *xs, const void *ys, size_t stride, int coordType, int num)
+{
+    PROFILE_SCOPE(EASYX_PROF_PRIMITIVES);
+    const POINT *points = points_convert(xs, ys, stride, coordType, num);
+    if (!points)
+        return;
+    dirty_points(points, num, dirty_line_pad());
+    fillpolygon(points, num);
+}
+
+void easyx_solidpolygon_strided(const void *xs, const void *ys, size_t stride, int coordType, int num)
+{
+    PROFILE_SCOPE(EASYX_PROF_PRIMITIVES);
+    const POINT *points = points_convert(xs, ys, stride, coordType, num);
+    if (!points)
+        return;
+    dirty_points(points, num, 1);
+    solidpolygon(points, num);
+}
+
+void easyx_polylines(const void *xs, const void *ys, size_t stride, int coordType, const int32_t *offsets, int count)
+{
+    PROFILE_SCOPE(EASYX_PROF_PRIMITIVES);
+    if (!offsets || count <= 0 || offsets[0] < 0)
+        return;
+
+    // 顶点数不合法（递减）的折线跳过，只转换用到的顶点 [offsets[0], total)
+    int base = offsets[0];
+    int total = offsets[count];
+    if (total <= base)
+        return;
+    if (stride == 0)
+        stride = sizeof(int32_t) * 2;
+    size_t skip = static_cast<size_t>(base) * stride;
+    const POINT *points = points_convert(xs ? static_cast<const unsigned char *>(xs) + skip : NULL,
+                                         ys ? static_cast<const unsigned char *>(ys) + skip : NULL, stride, coordType, total - base);
+    if (!points)
+        return;
+
+    // points[0] 对应第 base 个顶点
+    dirty_points(points, total - base, dirty_line_pad());
+    for (int i = 0; i < count; ++i)
+    {
+        int first = offsets[i], last = offsets[i + 1];
+        if (first >= base && last <= total && last - first >= 2)
+            polyline(points + (first - base), last - first);
+    }
+}
+
 void easyx_floodfill(int x, int y, uint32_t color, int filltype)
 {
+    PROFILE_SCOPE(EASYX_PROF_PRIMITIVES);
+    // 填充范围无法预知
+    dirty_all();
     floodfill(x, y, color, filltype);
 }
 
 // 文本相关函数
 void easyx_outtextxy(int x, int y, const char *str)
 {
-    std::basic_string<TCHAR> tstr = ansi_to_tstring(str);
-    outtextxy(x, y, tstr.c_str());
+    PROFILE_SCOPE(EASYX_PROF_TEXT);
+    const TCHAR *tstr = text_lookup(str);
+    dirty_text(x, y, tstr);
+    outtextxy(x, y, tstr);
+}
+
+void easyx_outtextxy_n(int x, int y, const char *str, size_t len)
+{
+    PROFILE_SCOPE(EASYX_PROF_TEXT);
+    const TCHAR *tstr = text_lookup(str, len);
+    dirty_text(x, y, tstr);
+    outtextxy(x, y, tstr);
 }
 
 void easyx_outtextxy_char(int x, int y, char c)
 {
-    outtextxy(x, y, static_cast<TCHAR>(c));
+    PROFILE_SCOPE(EASYX_PROF_TEXT);
+    TCHAR tstr[2] = {static_cast<TCHAR>(c), 0};
+    dirty_text(x, y, tstr);
+    outtextxy(x, y, tstr[0]);
 }
 
 int easyx_textwidth(const char *str)
 {
-    std::basic_string<TCHAR> tstr = ansi_to_tstring(str);
-    return textwidth(tstr.c_str());
+    PROFILE_SCOPE(EASYX_PROF_TEXT);
+    return textwidth(text_lookup(str));
+}
+
+int easyx_textwidth_n(const char *str, size_t len)
+{
+    PROFILE_SCOPE(EASYX_PROF_TEXT);
+    return textwidth(text_lookup(str, len));
 }
 
 int easyx_textwidth_char(char c)
 {
+    PROFILE_SCOPE(EASYX_PROF_TEXT);
     return textwidth(static_cast<TCHAR>(c));
 }
 
 int easyx_textheight(const char *str)
 {
-    std::basic_string<TCHAR> tstr = ansi_to_tstring(str);
-    return textheight(tstr.c_str());
+    PROFILE_SCOPE(EASYX_PROF_TEXT);
+    return textheight(text_lookup(str));
+}
+
+int easyx_textheight_n(const char *str, size_t len)
+{
+    PROFILE_SCOPE(EASYX_PROF_TEXT);
+    return textheight(text_lookup(str, len));
 }
 
 int easyx_textheight_char(char c)
 {
+    PROFILE_SCOPE(EASYX_PROF_TEXT);
     return textheight(static_cast<TCHAR>(c));
 }
 
 int easyx_drawtext(const char *str, void *pRect, unsigned int uFormat)
 {
-    std::basic_string<TCHAR> tstr = ansi_to_tstring(str);
-    return drawtext(tstr.c_str(), reinterpret_cast<RECT *>(pRect), uFormat);
+    return easyx_drawtext_n(str, str ? strlen(str) : 0, pRect, uFormat);
+}
+
+int easyx_drawtext_n(const char *str, size_t len, void *pRect, unsigned int uFormat)
+{
+    PROFILE_SCOPE(EASYX_PROF_TEXT);
+    // DT_MODIFYSTRING 可能改写字符串，不能使用缓存中的结果
+    const TCHAR *tstr = text_lookup(str, len, (uFormat & DT_MODIFYSTRING) == 0);
+    dirty_drawtext(reinterpret_cast<const RECT *>(pRect), uFormat);
+    return drawtext(tstr, reinterpret_cast<RECT *>(pRect), uFormat);
 }
 
 int easyx_drawtext_char(char c, void *pRect, unsigned int uFormat)
 {
+    PROFILE_SCOPE(EASYX_PROF_TEXT);
+    dirty_drawtext(reinterpret_cast<const RECT *>(pRect), uFormat);
     return drawtext(static_cast<TCHAR>(c), reinterpret_cast<RECT *>(pRect), uFormat);
 }
 
 void easyx_settextstyle(int nHeight, int nWidth, const char *lpszFace)
 {
-    std::basic_string<TCHAR> tstr = ansi_to_tstring(lpszFace);
-    settextstyle(nHeight, nWidth, tstr.c_str());
+    PROFILE_SCOPE(EASYX_PROF_TEXT);
+    font_release_current();
+    settextstyle(nHeight, nWidth, text_lookup(lpszFace));
 }
 
 void easyx_settextstyle_full(int nHeight, int nWidth, const char *lpszFace, int nEscapement, int nOrientation, int nWeight, int bItalic, int bUnderline, int bStrikeOut)
 {
-    std::basic_string<TCHAR> tstr = ansi_to_tstring(lpszFace);
-    settextstyle(nHeight, nWidth, tstr.c_str(), nEscapement, nOrientation, nWeight, bItalic != 0, bUnderline != 0, bStrikeOut != 0);
+    PROFILE_SCOPE(EASYX_PROF_TEXT);
+    font_release_current();
+    dirty_textstyle(nEscapement);
+    settextstyle(nHeight, nWidth, text_lookup(lpszFace), nEscapement, nOrientation, nWeight, bItalic != 0, bUnderline != 0, bStrikeOut != 0);
+}
+
+// 所有字段都已指定，按 LOGFONT 从字体缓存中取得
+static void font_build(LOGFONT *lf, int nHeight, int nWidth, const char *lpszFace, int nEscapement, int nOrientation, int nWeight, int bItalic, int bUnderline, int bStrikeOut, unsigned char fbCharSet, unsigned char fbOutPrecision, unsigned char fbClipPrecision, unsigned char fbQuality, unsigned char fbPitchAndFamily)
+{
+    memset(lf, 0, sizeof(LOGFONT));
+    lf->lfHeight = nHeight;
+    lf->lfWidth = nWidth;
+    lf->lfEscapement = nEscapement;
+    lf->lfOrientation = nOrientation;
+    lf->lfWeight = nWeight;
+    lf->lfItalic = bItalic != 0;
+    lf->lfUnderline = bUnderline != 0;
+    lf->lfStrikeOut = bStrikeOut != 0;
+    lf->lfCharSet = fbCharSet;
+    lf->lfOutPrecision = fbOutPrecision;
+    lf->lfClipPrecision = fbClipPrecision;
+    lf->lfQuality = fbQuality;
+    lf->lfPitchAndFamily = fbPitchAndFamily;
+
+    const TCHAR *face = text_lookup(lpszFace);
+    for (size_t i = 0; face && i < LF_FACESIZE - 1 && face[i]; ++i)
+        lf->lfFaceName[i] = face[i];
 }
 
 void easyx_settextstyle_full_ex(int nHeight, int nWidth, const char *lpszFace, int nEscapement, int nOrientation, int nWeight, int bItalic, int bUnderline, int bStrikeOut, unsigned char fbCharSet, unsigned char fbOutPrecision, unsigned char fbClipPrecision, unsigned char fbQuality, unsigned char fbPitchAndFamily)
 {
-    std::basic_string<TCHAR> tstr = ansi_to_tstring(lpszFace);
-    settextstyle(nHeight, nWidth, tstr.c_str(), nEscapement, nOrientation, nWeight, bItalic != 0, bUnderline != 0, bStrikeOut != 0, fbCharSet, fbOutPrecision, fbClipPrecision, fbQuality, fbPitchAndFamily);
+    PROFILE_SCOPE(EASYX_PROF_TEXT);
+    LOGFONT lf;
+    font_build(&lf, nHeight, nWidth, lpszFace, nEscapement, nOrientation, nWeight, bItalic, bUnderline, bStrikeOut, fbCharSet, fbOutPrecision, fbClipPrecision, fbQuality, fbPitchAndFamily);
+    FontEntry *entry = font_lookup(&lf);
+    if (entry)
+    {
+        font_select(entry);
+        return;
+    }
+
+    font_release_current();
+    dirty_textstyle(nEscapement);
+    settextstyle(nHeight, nWidth, text_lookup(lpszFace), nEscapement, nOrientation, nWeight, bItalic != 0, bUnderline != 0, bStrikeOut != 0, fbCharSet, fbOutPrecision, fbClipPrecision, fbQuality, fbPitchAndFamily);
 }
 
 void easyx_settextstyle_logfont(void *pLogFont)
 {
+    PROFILE_SCOPE(EASYX_PROF_TEXT);
+    FontEntry *entry = pLogFont ? font_lookup(reinterpret_cast<LOGFONT *>(pLogFont)) : NULL;
+    if (entry)
+    {
+        font_select(entry);
+        return;
+    }
+
+    font_release_current();
+    if (pLogFont)
+        dirty_textstyle(reinterpret_cast<LOGFONT *>(pLogFont)->lfEscapement);
     settextstyle(reinterpret_cast<LOGFONT *>(pLogFont));
 }
 
 void easyx_gettextstyle(void *pLogFont)
 {
-    gettextstyle(reinterpret_cast<LOGFONT *>(pLogFont));
+    // EasyX 记录的是选入缓存字体之前的样式
+    FontEntry *entry = font_selected();
+    if (entry && pLogFont)
+        *reinterpret_cast<LOGFONT *>(pLogFont) = entry->logfont;
+    else
+        gettextstyle(reinterpret_cast<LOGFONT *>(pLogFont));
+}
+
+// IMAGE::SetDefault 是受保护成员，通过派生类取得成员指针后使用，只用于图像池重置回收的图像
+struct ImageAccess : IMAGE
+{
+    static void reset(IMAGE *img)
+    {
+        void (IMAGE::*fn)() = &ImageAccess::SetDefault;
+        (img->*fn)();
+    }
+};
+
+static size_t image_bytes(IMAGE *img)
+{
+    return static_cast<size_t>(img->getwidth()) * img->getheight() * sizeof(DWORD);
+}
+
+// 图像池默认的内存预算：64 MB
+#define IMAGEPOOL_DEFAULT_BUDGET (64u << 20)
+
+// 空闲的图像按宽高分桶，同一尺寸后放回的先取出。
+// Image 可能在调度器和工作线程上创建和释放，图像池的所有字段都由 mutex 保护。
+// 放回前需要清除状态缓存并检查工作图像，这些只能在绘图线程中进行，
+// 其他线程放回的图像先记入 deferred，由绘图线程下一次获取、放回图像或关闭图形环境时回收
+struct PooledImage
+{
+    IMAGE *image;
+    uint64_t tick; // 放回时的序号，超出预算时先淘汰最早放回的
+    size_t bytes;
+};
+
+struct ImagePool
+{
+    std::unordered_map<uint64_t, std::vector<PooledImage>> buckets;
+    size_t budget;
+    size_t bytes;
+    uint64_t tick;
+    int idle;
+    EasyXImagePoolStats stats;
+    std::vector<IMAGE *> deferred;
+    std::mutex mutex;
+};
+
+static ImagePool g_imagePool = {std::unordered_map<uint64_t, std::vector<PooledImage>>(), IMAGEPOOL_DEFAULT_BUDGET, 0, 0, 0, {}, std::vector<IMAGE *>()};
+
+static inline uint64_t imagepool_key(int width, int height)
+{
+    return (static_cast<uint64_t>(static_cast<uint32_t>(width)) << 32) | static_cast<uint32_t>(height);
+}
+
+// 淘汰最早放回的空闲图像，直到占用不超过 budget，调用时持有 g_imagePool.mutex
+static void imagepool_evict(size_t budget)
+{
+    while (g_imagePool.bytes > budget && g_imagePool.idle > 0)
+    {
+        std::unordered_map<uint64_t, std::vector<PooledImage>>::iterator oldest = g_imagePool.buckets.end();
+        for (std::unordered_map<uint64_t, std::vector<PooledImage>>::iterator it = g_imagePool.buckets.begin(); it != g_imagePool.buckets.end(); ++it)
+        {
+            if (!it->second.empty() && (oldest == g_imagePool.buckets.end() || it->second.front().tick < oldest->second.front().tick))
+                oldest = it;
+        }
+        if (oldest == g_imagePool.buckets.end())
+            break;
+
+        PooledImage entry = oldest->second.front();
+        oldest->second.erase(oldest->second.begin());
+        if (oldest->second.empty())
+            g_imagePool.buckets.erase(oldest);
+        g_imagePool.bytes -= entry.bytes;
+        --g_imagePool.idle;
+        ++g_imagePool.stats.evictions;
+        delete entry.image;
+    }
 }
 
 // 图像相关函数
 void *easyx_create_image(int width, int height)
 {
+    PROFILE_SCOPE(EASYX_PROF_IMAGES);
     return new IMAGE(width, height);
 }
 
 void easyx_destroy_image(void *img)
 {
+    PROFILE_SCOPE(EASYX_PROF_IMAGES);
+    shadow_forget(img);
     delete reinterpret_cast<IMAGE *>(img);
 }
 
+void *easyx_image_acquire(int width, int height)
+{
+    PROFILE_SCOPE(EASYX_PROF_IMAGES);
+    if (on_graphics_thread())
+        imagepool_drain_deferred();
+
+    PooledImage entry;
+    {
+        std::lock_guard<std::mutex> lock(g_imagePool.mutex);
+        std::unordered_map<uint64_t, std::vector<PooledImage>>::iterator it = g_imagePool.buckets.find(imagepool_key(width, height));
+        if (it == g_imagePool.buckets.end())
+        {
+            ++g_imagePool.stats.misses;
+            entry.image = NULL;
+        }
+        else
+        {
+            entry = it->second.back();
+            it->second.pop_back();
+            if (it->second.empty())
+                g_imagePool.buckets.erase(it);
+            g_imagePool.bytes -= entry.bytes;
+            --g_imagePool.idle;
+            ++g_imagePool.stats.hits;
+        }
+    }
+    if (!entry.image)
+        return new IMAGE(width, height);
+
+    // 与新创建的图像一致：绘图状态恢复默认，像素清零
+    ImageAccess::reset(entry.image);
+    DWORD *buffer = GetImageBuffer(entry.image);
+    if (buffer)
+        memset(buffer, 0, sizeof(DWORD) * static_cast<size_t>(width) * height);
+    return entry.image;
+}
+
+// 清除图像的缓存状态后放回池中或销毁，只在绘图线程中调用
+static void imagepool_put(IMAGE *image)
+{
+    // 画布由无窗口模式持有，在 easyx_closegraph 中释放
+    if (image == g_canvas)
+        return;
+    shadow_forget(image);
+
+    // 仍是工作图像的图像不回收，避免之后的绘制写入空闲图像
+    size_t bytes = image_bytes(image);
+    if (image == GetWorkingImage() || image->getwidth() <= 0 || image->getheight() <= 0)
+    {
+        delete image;
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(g_imagePool.mutex);
+    if (bytes > g_imagePool.budget)
+    {
+        delete image;
+        return;
+    }
+
+    PooledImage entry = {image, ++g_imagePool.tick, bytes};
+    g_imagePool.buckets[imagepool_key(image->getwidth(), image->getheight())].push_back(entry);
+    g_imagePool.bytes += bytes;
+    ++g_imagePool.idle;
+    ++g_imagePool.stats.released;
+    imagepool_evict(g_imagePool.budget);
+}
+
+// 回收其他线程放回的图像，只在绘图线程中调用
+static void imagepool_drain_deferred()
+{
+    std::vector<IMAGE *> deferred;
+    {
+        std::lock_guard<std::mutex> lock(g_imagePool.mutex);
+        if (g_imagePool.deferred.empty())
+            return;
+        deferred.swap(g_imagePool.deferred);
+    }
+    for (size_t i = 0; i < deferred.size(); ++i)
+        imagepool_put(deferred[i]);
+}
+
+void easyx_image_release(void *img)
+{
+    PROFILE_SCOPE(EASYX_PROF_IMAGES);
+    IMAGE *image = reinterpret_cast<IMAGE *>(img);
+    if (!image)
+        return;
+
+    if (!on_graphics_thread())
+    {
+        std::lock_guard<std::mutex> lock(g_imagePool.mutex);
+        g_imagePool.deferred.push_back(image);
+        return;
+    }
+
+    imagepool_drain_deferred();
+    imagepool_put(image);
+}
+
+void easyx_imagepool_setbudget(size_t bytes)
+{
+    std::lock_guard<std::mutex> lock(g_imagePool.mutex);
+    g_imagePool.budget = bytes;
+    imagepool_evict(bytes);
+}
+
+size_t easyx_imagepool_getbudget()
+{
+    std::lock_guard<std::mutex> lock(g_imagePool.mutex);
+    return g_imagePool.budget;
+}
+
+void easyx_imagepool_clear()
+{
+    if (on_graphics_thread())
+        imagepool_drain_deferred();
+
+    std::lock_guard<std::mutex> lock(g_imagePool.mutex);
+    imagepool_evict(0);
+}
+
+void easyx_imagepool_getstats(EasyXImagePoolStats *pStats)
+{
+    if (!pStats)
+        return;
+
+    std::lock_guard<std::mutex> lock(g_imagePool.mutex);
+    *pStats = g_imagePool.stats;
+    pStats->bytes = g_imagePool.bytes;
+    pStats->idle = g_imagePool.idle;
+}
+
 void easyx_copy_image(void *pDstImg, const void *pSrcImg)
 {
+    PROFILE_SCOPE(EASYX_PROF_IMAGES);
+    shadow_forget(pDstImg);
     *reinterpret_cast<IMAGE *>(pDstImg) = *reinterpret_cast<const IMAGE *>(pSrcImg);
 }
 
@@ -508,44 +1964,64 @@ int easyx_image_getheight(void *img)
 
 void easyx_image_resize(void *img, int width, int height)
 {
+    PROFILE_SCOPE(EASYX_PROF_IMAGES);
+    shadow_forget(img);
     reinterpret_cast<IMAGE *>(img)->Resize(width, height);
 }
 
 int easyx_loadimage_file(void *pDstImg, const char *pImgFile, int nWidth, int nHeight, int bResize)
 {
+    PROFILE_SCOPE(EASYX_PROF_IMAGES);
+    shadow_forget(pDstImg);
+    // 目标为 NULL 时直接加载到绘图窗口
+    if (!pDstImg)
+        dirty_all();
     std::basic_string<TCHAR> tstr = ansi_to_tstring(pImgFile);
-    return loadimage(reinterpret_cast<IMAGE *>(pDstImg), tstr.c_str(), nWidth, nHeight, bResize != 0);
+    return loadimage(device_image(pDstImg), tstr.c_str(), nWidth, nHeight, bResize != 0);
 }
 
 void easyx_saveimage(const char *pImgFile, const void *pImg)
 {
+    PROFILE_SCOPE(EASYX_PROF_IMAGES);
     std::basic_string<TCHAR> tstr = ansi_to_tstring(pImgFile);
-    saveimage(tstr.c_str(), reinterpret_cast<const IMAGE *>(pImg));
+    saveimage(tstr.c_str(), device_image(pImg));
 }
 
 void easyx_getimage(void *pDstImg, int srcX, int srcY, int srcWidth, int srcHeight)
 {
+    PROFILE_SCOPE(EASYX_PROF_IMAGES);
+    shadow_forget(pDstImg);
     getimage(reinterpret_cast<IMAGE *>(pDstImg), srcX, srcY, srcWidth, srcHeight);
 }
 
 void easyx_putimage(int dstX, int dstY, const void *pSrcImg, uint32_t dwRop)
 {
+    PROFILE_SCOPE(EASYX_PROF_IMAGES);
+    if (pSrcImg)
+    {
+        const IMAGE *src = reinterpret_cast<const IMAGE *>(pSrcImg);
+        dirty_logical(dstX, dstY, dstX + src->getwidth() - 1, dstY + src->getheight() - 1, 1);
+    }
     putimage(dstX, dstY, reinterpret_cast<const IMAGE *>(pSrcImg), dwRop);
 }
 
 void easyx_putimage_part(int dstX, int dstY, int dstWidth, int dstHeight, const void *pSrcImg, int srcX, int srcY, uint32_t dwRop)
 {
+    PROFILE_SCOPE(EASYX_PROF_IMAGES);
+    dirty_logical(dstX, dstY, dstX + dstWidth - 1, dstY + dstHeight - 1, 1);
     putimage(dstX, dstY, dstWidth, dstHeight, reinterpret_cast<const IMAGE *>(pSrcImg), srcX, srcY, dwRop);
 }
 
 void easyx_rotateimage(void *dstimg, const void *srcimg, double radian, uint32_t bkcolor, int autosize, int highquality)
 {
+    PROFILE_SCOPE(EASYX_PROF_IMAGES);
+    shadow_forget(dstimg);
     rotateimage(reinterpret_cast<IMAGE *>(dstimg), reinterpret_cast<const IMAGE *>(srcimg), radian, bkcolor, autosize != 0, highquality != 0);
 }
 
 uint32_t *easyx_getimagebuffer(const void *pImg)
 {
-    return reinterpret_cast<uint32_t *>(GetImageBuffer(reinterpret_cast<const IMAGE *>(pImg)));
+    return reinterpret_cast<uint32_t *>(GetImageBuffer(device_image(pImg)));
 }
 
 void *easyx_getworkingimage()
@@ -555,24 +2031,66 @@ void *easyx_getworkingimage()
 
 void easyx_setworkingimage(void *pImg)
 {
-    SetWorkingImage(reinterpret_cast<IMAGE *>(pImg));
+    PROFILE_SCOPE(EASYX_PROF_IMAGES);
+    SetWorkingImage(device_image(pImg));
+
+    // 以 EasyX 实际使用的设备指针作为键，保证绘图窗口只对应一个缓存项
+    g_shadow.key = GetWorkingImage();
+    g_shadow.current = NULL;
 }
 
 int easyx_loadimage_resource(void *pDstImg, const char *pResType, const char *pResName, int nWidth, int nHeight, int bResize)
 {
+    PROFILE_SCOPE(EASYX_PROF_IMAGES);
+    shadow_forget(pDstImg);
+    if (!pDstImg)
+        dirty_all();
     std::basic_string<TCHAR> tresType = ansi_to_tstring(pResType);
     std::basic_string<TCHAR> tresName = ansi_to_tstring(pResName);
-    return loadimage(reinterpret_cast<IMAGE *>(pDstImg), tresType.c_str(), tresName.c_str(), nWidth, nHeight, bResize != 0);
+    return loadimage(device_image(pDstImg), tresType.c_str(), tresName.c_str(), nWidth, nHeight, bResize != 0);
 }
 
 void easyx_resize_device(void *pImg, int width, int height)
 {
-    Resize(reinterpret_cast<IMAGE *>(pImg), width, height);
+    PROFILE_SCOPE(EASYX_PROF_IMAGES);
+    shadow_forget(pImg);
+    if (!pImg || pImg == g_shadow.window)
+    {
+        g_dirty.width = width;
+        g_dirty.height = height;
+        dirty_all();
+    }
+    Resize(device_image(pImg), width, height);
 }
 
 void *easyx_getimagehdc(const void *pImg)
 {
-    return GetImageHDC(reinterpret_cast<const IMAGE *>(pImg));
+    return GetImageHDC(device_image(pImg));
+}
+
+void easyx_getdevicesize(const void *pImg, int *pWidth, int *pHeight)
+{
+    const IMAGE *image = reinterpret_cast<const IMAGE *>(pImg ? pImg : g_shadow.window);
+    int width = 0, height = 0;
+    if (image)
+    {
+        width = image->getwidth();
+        height = image->getheight();
+    }
+    else if (GetHWnd())
+    {
+        // EasyX 没有给出窗口的 IMAGE 时，临时切换到窗口读取它的大小
+        IMAGE *working = GetWorkingImage();
+        SetWorkingImage(NULL);
+        width = getwidth();
+        height = getheight();
+        SetWorkingImage(working);
+    }
+
+    if (pWidth)
+        *pWidth = width;
+    if (pHeight)
+        *pHeight = height;
 }
 
 // 其他函数
@@ -588,27 +2106,87 @@ int easyx_getheight()
 
 void easyx_beginbatchdraw()
 {
-    BeginBatchDraw();
+    PROFILE_SCOPE(EASYX_PROF_FLUSH);
+    dirty_clear();
+    g_dirty.batching = true;
+    // 帧调度从批处理开始时计时
+    easyx_frame_reset();
+    // 无窗口模式直接绘制在画布上，批量绘图的开始、刷新和结束都不需要调用 EasyX
+    if (!g_canvas)
+        BeginBatchDraw();
 }
 
 void easyx_flushbatchdraw()
 {
-    FlushBatchDraw();
+    PROFILE_SCOPE(EASYX_PROF_FLUSH);
+    dirty_clear();
+    if (!g_canvas)
+        FlushBatchDraw();
+}
+
+int easyx_flushbatchdraw_dirty()
+{
+    PROFILE_SCOPE(EASYX_PROF_FLUSH);
+    easyx_dirty_enable(1);
+    int flushed = g_dirty.count;
+
+    if (g_canvas)
+    {
+        dirty_clear();
+        return 0;
+    }
+
+    if (g_dirty.all)
+    {
+        FlushBatchDraw();
+        flushed = 1;
+    }
+    else if (g_dirty.count > 0)
+    {
+        long long total = 0;
+        for (int i = 0; i < g_dirty.count; ++i)
+            total += dirty_area(g_dirty.rects[i]);
+
+        // 脏区域超过窗口一半时，一次整体刷新比多次局部刷新更快
+        if (total * 2 >= static_cast<long long>(g_dirty.width) * g_dirty.height)
+        {
+            FlushBatchDraw();
+            flushed = 1;
+        }
+        else
+        {
+            for (int i = 0; i < g_dirty.count; ++i)
+                FlushBatchDraw(g_dirty.rects[i].left, g_dirty.rects[i].top, g_dirty.rects[i].right, g_dirty.rects[i].bottom);
+        }
+    }
+
+    dirty_clear();
+    return flushed;
 }
 
 void easyx_flushbatchdraw_rect(int left, int top, int right, int bottom)
 {
-    FlushBatchDraw(left, top, right, bottom);
+    PROFILE_SCOPE(EASYX_PROF_FLUSH);
+    if (!g_canvas)
+        FlushBatchDraw(left, top, right, bottom);
 }
 
 void easyx_endbatchdraw()
 {
-    EndBatchDraw();
+    PROFILE_SCOPE(EASYX_PROF_FLUSH);
+    dirty_clear();
+    g_dirty.batching = false;
+    if (!g_canvas)
+        EndBatchDraw();
 }
 
 void easyx_endbatchdraw_rect(int left, int top, int right, int bottom)
 {
-    EndBatchDraw(left, top, right, bottom);
+    PROFILE_SCOPE(EASYX_PROF_FLUSH);
+    dirty_clear();
+    g_dirty.batching = false;
+    if (!g_canvas)
+        EndBatchDraw(left, top, right, bottom);
 }
 
 void easyx_delay(int ms)
@@ -637,55 +2215,281 @@ HWND easyx_gethwnd()
     return GetHWnd();
 }
 
+// 命令缓冲相关函数
+
+// 回放单条命令，参数个数不符时返回 EASYX_CMD_ERR_ARGS
+static int replay_command(uint32_t op, uint32_t argc, const int32_t *a)
+{
+#define EXPECT_ARGS(n) \
+    if (argc != (n))   \
+    return EASYX_CMD_ERR_ARGS
+
+    switch (op)
+    {
+    case EASYX_CMD_SETLINECOLOR:
+        EXPECT_ARGS(1);
+        easyx_setlinecolor(static_cast<uint32_t>(a[0]));
+        break;
+    case EASYX_CMD_SETFILLCOLOR:
+        EXPECT_ARGS(1);
+        easyx_setfillcolor(static_cast<uint32_t>(a[0]));
+        break;
+    case EASYX_CMD_SETTEXTCOLOR:
+        EXPECT_ARGS(1);
+        easyx_settextcolor(static_cast<uint32_t>(a[0]));
+        break;
+    case EASYX_CMD_SETBKCOLOR:
+        EXPECT_ARGS(1);
+        easyx_setbkcolor(static_cast<uint32_t>(a[0]));
+        break;
+    case EASYX_CMD_SETBKMODE:
+        EXPECT_ARGS(1);
+        easyx_setbkmode(a[0]);
+        break;
+    case EASYX_CMD_SETROP2:
+        EXPECT_ARGS(1);
+        easyx_setrop2(a[0]);
+        break;
+    case EASYX_CMD_SETLINESTYLE:
+        // 参数：style, thickness，之后为可选的用户自定义样式数组
+        if (argc < 2)
+            return EASYX_CMD_ERR_ARGS;
+        easyx_setlinestyle(a[0], a[1], argc > 2 ? reinterpret_cast<const uint32_t *>(a + 2) : NULL, argc - 2);
+        break;
+    case EASYX_CMD_SETFILLSTYLE:
+        EXPECT_ARGS(2);
+        easyx_setfillstyle(a[0], a[1], NULL);
+        break;
+    case EASYX_CMD_SETTEXTSTYLE:
+    {
+        // 参数：height, width, 字节数，之后为按 4 字节补齐的 UTF-8 字体名
+        if (argc < 3 || a[2] < 0 || argc != 3 + (static_cast<uint32_t>(a[2]) + 3) / 4)
+            return EASYX_CMD_ERR_ARGS;
+
+        std::string face(reinterpret_cast<const char *>(a + 3), static_cast<size_t>(a[2]));
+        easyx_settextstyle(a[0], a[1], face.c_str());
+        break;
+    }
+
+    case EASYX_CMD_CLEARDEVICE:
+        EXPECT_ARGS(0);
+        easyx_cleardevice();
+        break;
+    case EASYX_CMD_PUTPIXEL:
+        EXPECT_ARGS(3);
+        easyx_putpixel(a[0], a[1], static_cast<uint32_t>(a[2]));
+        break;
+    case EASYX_CMD_LINE:
+        EXPECT_ARGS(4);
+        easyx_line(a[0], a[1], a[2], a[3]);
+        break;
+    case EASYX_CMD_RECTANGLE:
+        EXPECT_ARGS(4);
+        easyx_rectangle(a[0], a[1], a[2], a[3]);
+        break;
+    case EASYX_CMD_FILLRECTANGLE:
+        EXPECT_ARGS(4);
+        easyx_fillrectangle(a[0], a[1], a[2], a[3]);
+        break;
+    case EASYX_CMD_SOLIDRECTANGLE:
+        EXPECT_ARGS(4);
+        easyx_solidrectangle(a[0], a[1], a[2], a[3]);
+        break;
+    case EASYX_CMD_CLEARRECTANGLE:
+        EXPECT_ARGS(4);
+        easyx_clearrectangle(a[0], a[1], a[2], a[3]);
+        break;
+    case EASYX_CMD_CIRCLE:
+        EXPECT_ARGS(3);
+        easyx_circle(a[0], a[1], a[2]);
+        break;
+    case EASYX_CMD_FILLCIRCLE:
+        EXPECT_ARGS(3);
+        easyx_fillcircle(a[0], a[1], a[2]);
+        break;
+    case EASYX_CMD_SOLIDCIRCLE:
+        EXPECT_ARGS(3);
+        easyx_solidcircle(a[0], a[1], a[2]);
+        break;
+    case EASYX_CMD_CLEARCIRCLE:
+        EXPECT_ARGS(3);
+        easyx_clearcircle(a[0], a[1], a[2]);
+        break;
+    case EASYX_CMD_ELLIPSE:
+        EXPECT_ARGS(4);
+        easyx_ellipse(a[0], a[1], a[2], a[3]);
+        break;
+    case EASYX_CMD_FILLELLIPSE:
+        EXPECT_ARGS(4);
+        easyx_fillellipse(a[0], a[1], a[2], a[3]);
+        break;
+    case EASYX_CMD_SOLIDELLIPSE:
+        EXPECT_ARGS(4);
+        easyx_solidellipse(a[0], a[1], a[2], a[3]);
+        break;
+    case EASYX_CMD_CLEARELLIPSE:
+        EXPECT_ARGS(4);
+        easyx_clearellipse(a[0], a[1], a[2], a[3]);
+        break;
+    case EASYX_CMD_ROUNDRECT:
+        EXPECT_ARGS(6);
+        easyx_roundrect(a[0], a[1], a[2], a[3], a[4], a[5]);
+        break;
+    case EASYX_CMD_FILLROUNDRECT:
+        EXPECT_ARGS(6);
+        easyx_fillroundrect(a[0], a[1], a[2], a[3], a[4], a[5]);
+        break;
+    case EASYX_CMD_SOLIDROUNDRECT:
+        EXPECT_ARGS(6);
+        easyx_solidroundrect(a[0], a[1], a[2], a[3], a[4], a[5]);
+        break;
+    case EASYX_CMD_CLEARROUNDRECT:
+        EXPECT_ARGS(6);
+        easyx_clearroundrect(a[0], a[1], a[2], a[3], a[4], a[5]);
+        break;
+
+    case EASYX_CMD_POLYLINE:
+    case EASYX_CMD_POLYGON:
+    case EASYX_CMD_FILLPOLYGON:
+    case EASYX_CMD_SOLIDPOLYGON:
+    case EASYX_CMD_CLEARPOLYGON:
+    {
+        // 参数：点数 n，之后为 n 个 (x, y)，与 POINT 内存布局一致
+        if (argc < 1 || a[0] < 0 || argc != 1 + 2 * static_cast<uint32_t>(a[0]))
+            return EASYX_CMD_ERR_ARGS;
+
+        const void *points = a + 1;
+        int num = a[0];
+
+        if (op == EASYX_CMD_POLYLINE)
+            easyx_polyline(points, num);
+        else if (op == EASYX_CMD_POLYGON)
+            easyx_polygon(points, num);
+        else if (op == EASYX_CMD_FILLPOLYGON)
+            easyx_fillpolygon(points, num);
+        else if (op == EASYX_CMD_SOLIDPOLYGON)
+            easyx_solidpolygon(points, num);
+        else
+            easyx_clearpolygon(points, num);
+        break;
+    }
+    case EASYX_CMD_OUTTEXTXY:
+    {
+        // 参数：x, y, 字节数，之后为按 4 字节补齐的 UTF-8 文本
+        if (argc < 3 || a[2] < 0 || argc != 3 + (static_cast<uint32_t>(a[2]) + 3) / 4)
+            return EASYX_CMD_ERR_ARGS;
+
+        easyx_outtextxy_n(a[0], a[1], reinterpret_cast<const char *>(a + 3), static_cast<size_t>(a[2]));
+        break;
+    }
+
+    default:
+        return EASYX_CMD_ERR_OPCODE;
+    }
+
+#undef EXPECT_ARGS
+    return 0;
+}
+
+int easyx_submit_commands(const void *buf, size_t len)
+{
+    PROFILE_SCOPE(EASYX_PROF_PRIMITIVES);
+    if (!buf || len < 2 * sizeof(uint32_t) || len % sizeof(uint32_t) != 0)
+        return EASYX_CMD_ERR_HEADER;
+
+    const uint32_t *p = static_cast<const uint32_t *>(buf);
+    const uint32_t *end = p + len / sizeof(uint32_t);
+
+    if (p[0] != EASYX_CMD_MAGIC || p[1] != EASYX_CMD_VERSION)
+        return EASYX_CMD_ERR_HEADER;
+
+    p += 2;
+
+    // 出错时立即停止，之前的命令已经生效
+    int executed = 0;
+    while (p < end)
+    {
+        uint32_t op = *p & 0xFFFF;
+        uint32_t argc = *p >> 16;
+        ++p;
+
+        if (argc > static_cast<uint32_t>(end - p))
+            return EASYX_CMD_ERR_TRUNCATED;
+
+        int result = replay_command(op, argc, reinterpret_cast<const int32_t *>(p));
+        if (result != 0)
+            return result;
+
+        p += argc;
+        ++executed;
+    }
+
+    return executed;
+}
+
 // 旧版 graphics.h 相关函数实现
 
 // 旧版文本相关函数
 void easyx_setfont(int nHeight, int nWidth, const char *lpszFace)
 {
+    PROFILE_SCOPE(EASYX_PROF_TEXT);
+    font_release_current();
     std::basic_string<TCHAR> tstr = ansi_to_tstring(lpszFace);
     setfont(nHeight, nWidth, tstr.c_str());
 }
 
 void easyx_setfont_full(int nHeight, int nWidth, const char *lpszFace, int nEscapement, int nOrientation, int nWeight, int bItalic, int bUnderline, int bStrikeOut)
 {
+    PROFILE_SCOPE(EASYX_PROF_TEXT);
+    font_release_current();
+    dirty_textstyle(nEscapement);
     std::basic_string<TCHAR> tstr = ansi_to_tstring(lpszFace);
     setfont(nHeight, nWidth, tstr.c_str(), nEscapement, nOrientation, nWeight, bItalic != 0, bUnderline != 0, bStrikeOut != 0);
 }
 
+// setfont 与 settextstyle 相同，指定了全部字段的版本同样使用字体缓存
 void easyx_setfont_full_ex(int nHeight, int nWidth, const char *lpszFace, int nEscapement, int nOrientation, int nWeight, int bItalic, int bUnderline, int bStrikeOut, unsigned char fbCharSet, unsigned char fbOutPrecision, unsigned char fbClipPrecision, unsigned char fbQuality, unsigned char fbPitchAndFamily)
 {
-    std::basic_string<TCHAR> tstr = ansi_to_tstring(lpszFace);
-    setfont(nHeight, nWidth, tstr.c_str(), nEscapement, nOrientation, nWeight, bItalic != 0, bUnderline != 0, bStrikeOut != 0, fbCharSet, fbOutPrecision, fbClipPrecision, fbQuality, fbPitchAndFamily);
+    easyx_settextstyle_full_ex(nHeight, nWidth, lpszFace, nEscapement, nOrientation, nWeight, bItalic, bUnderline, bStrikeOut, fbCharSet, fbOutPrecision, fbClipPrecision, fbQuality, fbPitchAndFamily);
 }
 
 void easyx_setfont_logfont(void *pLogFont)
 {
-    setfont(reinterpret_cast<LOGFONT *>(pLogFont));
+    easyx_settextstyle_logfont(pLogFont);
 }
 
 void easyx_getfont(void *pLogFont)
 {
-    getfont(reinterpret_cast<LOGFONT *>(pLogFont));
+    easyx_gettextstyle(pLogFont);
 }
 
 // 旧版绘图相关函数
 void easyx_bar(int left, int top, int right, int bottom)
 {
+    PROFILE_SCOPE(EASYX_PROF_PRIMITIVES);
+    dirty_logical(left, top, right, bottom, 1);
     bar(left, top, right, bottom);
 }
 
 void easyx_bar3d(int left, int top, int right, int bottom, int depth, int topflag)
 {
+    PROFILE_SCOPE(EASYX_PROF_PRIMITIVES);
+    // 立体部分向右上方延伸 depth 像素
+    dirty_logical(left, top - depth, right + depth, bottom, dirty_line_pad());
     bar3d(left, top, right, bottom, depth, topflag != 0);
 }
 
 void easyx_drawpoly(int numpoints, const int *polypoints)
 {
+    PROFILE_SCOPE(EASYX_PROF_PRIMITIVES);
+    dirty_points(reinterpret_cast<const POINT *>(polypoints), numpoints, dirty_line_pad());
     drawpoly(numpoints, polypoints);
 }
 
 void easyx_fillpoly(int numpoints, const int *polypoints)
 {
+    PROFILE_SCOPE(EASYX_PROF_PRIMITIVES);
+    dirty_points(reinterpret_cast<const POINT *>(polypoints), numpoints, dirty_line_pad());
     fillpoly(numpoints, polypoints);
 }
 
@@ -708,12 +2512,16 @@ uint32_t easyx_getcolor()
 
 void easyx_setcolor(uint32_t color)
 {
+    PROFILE_SCOPE(EASYX_PROF_STATE);
+    // 旧版 setcolor 同时修改线条颜色和文本颜色
+    shadow_invalidate(SHADOW_LINECOLOR | SHADOW_TEXTCOLOR);
     setcolor(color);
 }
 
 // 旧版光栅操作函数
 void easyx_setwritemode(int mode)
 {
+    PROFILE_SCOPE(EASYX_PROF_STATE);
     setwritemode(mode);
 }
 
@@ -740,60 +2548,111 @@ void easyx_moverel(int dx, int dy)
 
 void easyx_lineto(int x, int y)
 {
+    PROFILE_SCOPE(EASYX_PROF_PRIMITIVES);
+    if (dirty_active())
+        dirty_logical(getx(), gety(), x, y, dirty_line_pad());
     lineto(x, y);
 }
 
 void easyx_linerel(int dx, int dy)
 {
+    PROFILE_SCOPE(EASYX_PROF_PRIMITIVES);
+    if (dirty_active())
+        dirty_logical(getx(), gety(), getx() + dx, gety() + dy, dirty_line_pad());
     linerel(dx, dy);
 }
 
 void easyx_outtext(const char *str)
 {
-    std::basic_string<TCHAR> tstr = ansi_to_tstring(str);
-    outtext(tstr.c_str());
+    PROFILE_SCOPE(EASYX_PROF_TEXT);
+    const TCHAR *tstr = text_lookup(str);
+    if (dirty_active())
+        dirty_text(getx(), gety(), tstr);
+    outtext(tstr);
 }
 
 void easyx_outtext_char(char c)
 {
-    outtext(static_cast<TCHAR>(c));
+    PROFILE_SCOPE(EASYX_PROF_TEXT);
+    TCHAR tstr[2] = {static_cast<TCHAR>(c), 0};
+    if (dirty_active())
+        dirty_text(getx(), gety(), tstr);
+    outtext(tstr[0]);
 }
 
 // 旧版鼠标相关函数
 int easyx_mousehit()
 {
+    PROFILE_SCOPE(EASYX_PROF_MESSAGES);
     return MouseHit() ? 1 : 0;
 }
 
 void easyx_getmousemsg(void *pMsg)
 {
+    PROFILE_SCOPE(EASYX_PROF_MESSAGES);
     MOUSEMSG msg = GetMouseMsg();
     memcpy(pMsg, &msg, sizeof(MOUSEMSG));
 }
 
 int easyx_peekmousemsg(void *pMsg, int bRemoveMsg)
 {
+    PROFILE_SCOPE(EASYX_PROF_MESSAGES);
     return PeekMouseMsg(reinterpret_cast<MOUSEMSG *>(pMsg), bRemoveMsg != 0) ? 1 : 0;
 }
 
 void easyx_flushmousemsgbuffer()
 {
+    PROFILE_SCOPE(EASYX_PROF_MESSAGES);
     FlushMouseMsgBuffer();
 }
 
 // 消息相关函数
 void easyx_getmessage(CExMessage *pMsg, unsigned char filter)
 {
+    PROFILE_SCOPE(EASYX_PROF_MESSAGES);
+    // 无窗口模式永远不会有消息，返回空消息而不是一直等待
+    if (g_canvas)
+    {
+        memset(pMsg, 0, sizeof(CExMessage));
+        return;
+    }
     getmessage(reinterpret_cast<ExMessage *>(pMsg), filter);
 }
 
 int easyx_peekmessage(CExMessage *pMsg, unsigned char filter, int removemsg)
 {
+    PROFILE_SCOPE(EASYX_PROF_MESSAGES);
+    if (g_canvas)
+        return 0;
     return peekmessage(reinterpret_cast<ExMessage *>(pMsg), filter, removemsg != 0);
 }
 
+int easyx_peekmessages(CExMessage *pMsgs, int capacity, unsigned char filter, int coalesceMouseMove)
+{
+    PROFILE_SCOPE(EASYX_PROF_MESSAGES);
+    if (!pMsgs || capacity <= 0 || g_canvas)
+        return 0;
+
+    int count = 0;
+    ExMessage msg;
+    while (count < capacity && peekmessage(&msg, filter, true))
+    {
+        // 连续的鼠标移动只保留最后一个位置
+        if (coalesceMouseMove && msg.message == WM_MOUSEMOVE && count > 0 && pMsgs[count - 1].message == WM_MOUSEMOVE)
+        {
+            *reinterpret_cast<ExMessage *>(&pMsgs[count - 1]) = msg;
+            continue;
+        }
+
+        *reinterpret_cast<ExMessage *>(&pMsgs[count++]) = msg;
+    }
+
+    return count;
+}
+
 void easyx_flushmessage(unsigned char filter)
 {
+    PROFILE_SCOPE(EASYX_PROF_MESSAGES);
     flushmessage(filter);
 }
 
@@ -79,15 +79,136 @@ typedef struct ExMessage ExMessage;
 #define EASYX_EMPTY_FILL 0
 #define EASYX_SOLID_FILL 1
 
+// 命令缓冲格式常量
+// 命令流以 [EASYX_CMD_MAGIC, EASYX_CMD_VERSION] 两个 32 位字开头，
+// 之后每条命令为一个头字 (opcode | 参数字数 << 16) 加若干 32 位参数
+#define EASYX_CMD_MAGIC 0x42435845
+#define EASYX_CMD_VERSION 1
+
+// 命令缓冲操作码：状态设置
+#define EASYX_CMD_SETLINECOLOR 1
+#define EASYX_CMD_SETFILLCOLOR 2
+#define EASYX_CMD_SETTEXTCOLOR 3
+#define EASYX_CMD_SETBKCOLOR 4
+#define EASYX_CMD_SETBKMODE 5
+#define EASYX_CMD_SETROP2 6
+#define EASYX_CMD_SETLINESTYLE 7
+#define EASYX_CMD_SETFILLSTYLE 8
+#define EASYX_CMD_SETTEXTSTYLE 9
+
+// 命令缓冲操作码：绘图
+#define EASYX_CMD_CLEARDEVICE 16
+#define EASYX_CMD_PUTPIXEL 17
+#define EASYX_CMD_LINE 18
+#define EASYX_CMD_RECTANGLE 19
+#define EASYX_CMD_FILLRECTANGLE 20
+#define EASYX_CMD_SOLIDRECTANGLE 21
+#define EASYX_CMD_CLEARRECTANGLE 22
+#define EASYX_CMD_CIRCLE 23
+#define EASYX_CMD_FILLCIRCLE 24
+#define EASYX_CMD_SOLIDCIRCLE 25
+#define EASYX_CMD_CLEARCIRCLE 26
+#define EASYX_CMD_ELLIPSE 27
+#define EASYX_CMD_FILLELLIPSE 28
+#define EASYX_CMD_SOLIDELLIPSE 29
+#define EASYX_CMD_CLEARELLIPSE 30
+#define EASYX_CMD_ROUNDRECT 31
+#define EASYX_CMD_FILLROUNDRECT 32
+#define EASYX_CMD_SOLIDROUNDRECT 33
+#define EASYX_CMD_CLEARROUNDRECT 34
+#define EASYX_CMD_POLYLINE 35
+#define EASYX_CMD_POLYGON 36
+#define EASYX_CMD_FILLPOLYGON 37
+#define EASYX_CMD_SOLIDPOLYGON 38
+#define EASYX_CMD_CLEARPOLYGON 39
+#define EASYX_CMD_OUTTEXTXY 40
+
+// 命令缓冲错误码
+#define EASYX_CMD_ERR_HEADER (-1)
+#define EASYX_CMD_ERR_TRUNCATED (-2)
+#define EASYX_CMD_ERR_OPCODE (-3)
+#define EASYX_CMD_ERR_ARGS (-4)
+
+// 性能分析的函数类别
+#define EASYX_PROF_PRIMITIVES 0
+#define EASYX_PROF_STATE 1
+#define EASYX_PROF_TEXT 2
+#define EASYX_PROF_IMAGES 3
+#define EASYX_PROF_FLUSH 4
+#define EASYX_PROF_MESSAGES 5
+#define EASYX_PROF_CATEGORIES 6
+
+// 脏矩形跟踪最多保留的矩形数量，超出后并入面积增长最小的矩形
+#define EASYX_DIRTY_MAX_RECTS 32
+
+// 软件光栅化内核级别
+#define EASYX_RASTER_SCALAR 0
+#define EASYX_RASTER_SSE2 1
+#define EASYX_RASTER_AVX2 2
+
+// 并行分块渲染时分块缓冲区的初始内容
+#define EASYX_TILES_KEEP 0  // 复制工作图像中对应区域的像素
+#define EASYX_TILES_CLEAR 1 // 用背景色填充
+
+// 图像变换标志
+#define EASYX_TRANSFORM_NEAREST 0x00  // 最近邻采样
+#define EASYX_TRANSFORM_BILINEAR 0x01 // 双线性采样
+#define EASYX_TRANSFORM_BLEND 0x02    // 按源图像的透明度通道和全局透明度混合，否则直接复制
+
+// 精灵实例标志
+#define EASYX_SPRITE_BLEND 0x01 // 按精灵的透明度通道混合，否则直接复制
+
+// 精灵图集错误码
+#define EASYX_ATLAS_ERR_LOAD -1    // 图像文件加载失败
+#define EASYX_ATLAS_ERR_FULL -2    // 图集剩余空间放不下
+#define EASYX_ATLAS_ERR_INVALID -3 // 参数无效
+
+// 异步加载图像的状态
+#define EASYX_LOAD_NONE 0    // 编号无效，或已经取走、取消
+#define EASYX_LOAD_PENDING 1 // 等待或正在解码
+#define EASYX_LOAD_DECODED 2 // 已解码，等待 easyx_loadimage_finalize 创建图像
+#define EASYX_LOAD_READY 3   // 图像已创建，可以取走
+#define EASYX_LOAD_FAILED 4  // 加载失败
+
+// 资源包错误码
+#define EASYX_PACK_ERR_IO -1       // 文件读写失败
+#define EASYX_PACK_ERR_NOTFOUND -2 // 名称或编号不存在
+#define EASYX_PACK_ERR_INVALID -3  // 参数无效
+
+// 顶点缓冲区的坐标类型
+#define EASYX_COORD_INT32 0 // int32_t
+#define EASYX_COORD_FLOAT 1 // float，就近取整，正好在中间时取偶数（与 lrintf 相同）
+
+// 批量读写像素时外部缓冲区的像素格式
+#define EASYX_PIXEL_ARGB 0 // 0xAARRGGBB，与图像缓冲区相同
+#define EASYX_PIXEL_ABGR 1 // 0xAABBGGRR，与 COLORREF 相同
+
 #ifdef __cplusplus
 extern "C"
 {
 #endif
 
+    // 绘图状态缓存相关函数
+    // 按当前工作图像缓存颜色、背景模式、线条样式和填充样式，跳过重复的状态设置
+    void easyx_statecache_setenabled(int enabled);
+    int easyx_statecache_getenabled();
+    void easyx_statecache_invalidate();
+    void easyx_statecache_getstats(uint64_t *phits, uint64_t *pmisses);
+    void easyx_statecache_resetstats();
+
     // 图形窗口相关函数
     HWND easyx_initgraph(int width, int height, int flag);
     void easyx_closegraph();
 
+    // 无窗口渲染相关函数
+    // easyx_initheadless 不创建窗口，创建 width x height 的画布并设为工作图像，已有的窗口或画布先被关闭。
+    // 之后表示绘图窗口的 NULL（工作图像、图像缓冲区、加载和保存图像、录制）都指画布，批量绘图不再刷新，
+    // 消息函数不返回消息，呈现线程无法启动。画布属于当前进程，用 easyx_closegraph 释放。
+    // 文本的抗锯齿方式取决于系统设置，需要逐像素一致时在 LOGFONT 中指定 lfQuality
+    void *easyx_initheadless(int width, int height);
+    // 不在无窗口模式时返回 NULL
+    void *easyx_getcanvas();
+
     // 图形环境相关函数
     void easyx_cleardevice();
     void easyx_setcliprgn(void *hrgn);
@@ -167,14 +288,55 @@ extern "C"
     void easyx_polybezier(const void *points, int num);
     void easyx_floodfill(int x, int y, uint32_t color, int filltype);
 
+    // 以下函数直接读取调用者的顶点缓冲区：第 i 个顶点的坐标位于 xs + i * stride 和 ys + i * stride（字节），
+    // 可以描述交错存放的结构体、元组和分开存放的 x/y 数组。stride 为 0 表示 sizeof(int32_t) * 2。
+    // 紧密排列的 int32_t 顶点直接使用，其余格式在线程局部的暂存区中转换。
+    // easyx_polylines 一次绘制多条折线，第 i 条由顶点 [offsets[i], offsets[i + 1]) 组成，offsets 有 count + 1 项
+    void easyx_polyline_strided(const void *xs, const void *ys, size_t stride, int coordType, int num);
+    void easyx_polygon_strided(const void *xs, const void *ys, size_t stride, int coordType, int num);
+    void easyx_fillpolygon_strided(const void *xs, const void *ys, size_t stride, int coordType, int num);
+    void easyx_solidpolygon_strided(const void *xs, const void *ys, size_t stride, int coordType, int num);
+    void easyx_polylines(const void *xs, const void *ys, size_t stride, int coordType, const int32_t *offsets, int count);
+
+    // 折线图相关函数
+    // 时间序列样本按绝对编号存放，easyx_plot_trim 丢弃最旧的样本而不改变其余样本的编号。
+    // 每个像素列的样本多于 4 个时按列抽稀为首、最小、最大、尾四个点，抽稀结果按列缓存，
+    // 平移视口和追加样本时只重新计算变化的列。easyx_plot_draw 返回绘制的顶点数
+    typedef struct EasyXPlotView
+    {
+        double first;           // 视口左边缘对应的样本编号，抽稀时向下对齐到列边界
+        double samplesPerPixel; // 每个像素列的样本数，<= 0 表示把全部样本缩放到视口宽度
+        float yMin;             // 视口底边对应的样本值
+        float yMax;             // 视口顶边对应的样本值
+        int32_t left;           // 视口左上角x坐标
+        int32_t top;            // 视口左上角y坐标
+        int32_t width;          // 视口宽度
+        int32_t height;         // 视口高度
+    } EasyXPlotView;
+
+    void *easyx_plot_create();
+    void easyx_plot_destroy(void *plot);
+    void easyx_plot_setdata(void *plot, const float *samples, size_t count);
+    void easyx_plot_append(void *plot, const float *samples, size_t count);
+    void easyx_plot_trim(void *plot, size_t keep);
+    void easyx_plot_clear(void *plot);
+    size_t easyx_plot_count(void *plot);
+    int64_t easyx_plot_firstindex(void *plot);
+    int easyx_plot_draw(void *plot, const EasyXPlotView *view);
+
     // 文本相关函数
+    // 带 _n 后缀的版本接受长度明确的 UTF-8 文本，无需以 0 结尾
     void easyx_outtextxy(int x, int y, const char *str);
+    void easyx_outtextxy_n(int x, int y, const char *str, size_t len);
     void easyx_outtextxy_char(int x, int y, char c);
     int easyx_textwidth(const char *str);
+    int easyx_textwidth_n(const char *str, size_t len);
     int easyx_textwidth_char(char c);
     int easyx_textheight(const char *str);
+    int easyx_textheight_n(const char *str, size_t len);
     int easyx_textheight_char(char c);
     int easyx_drawtext(const char *str, void *pRect, unsigned int uFormat);
+    int easyx_drawtext_n(const char *str, size_t len, void *pRect, unsigned int uFormat);
     int easyx_drawtext_char(char c, void *pRect, unsigned int uFormat);
     void easyx_settextstyle(int nHeight, int nWidth, const char *lpszFace);
     void easyx_settextstyle_full(int nHeight, int nWidth, const char *lpszFace, int nEscapement, int nOrientation, int nWeight, int bItalic, int bUnderline, int bStrikeOut);
@@ -182,6 +344,140 @@ extern "C"
     void easyx_settextstyle_logfont(void *pLogFont);
     void easyx_gettextstyle(void *pLogFont);
 
+    // 字体缓存相关函数
+    // 按完整的 LOGFONT 缓存 HFONT，easyx_font_select 把缓存的字体直接选入当前工作图像，不再重新创建字体。
+    // easyx_settextstyle_logfont 和 easyx_settextstyle_full_ex 自动使用缓存；其他文本样式函数仍由 EasyX 创建字体。
+    // 没有被引用的字体超出容量时删除最久没有使用的，pLogFont 为 NULL 时使用当前文本样式
+    typedef struct EasyXFontCacheStats
+    {
+        uint64_t hits;      // 在缓存中找到字体的次数
+        uint64_t created;   // 调用 CreateFontIndirect 的次数
+        uint64_t evictions; // 被删除的字体数
+        uint64_t selects;   // 选入字体的次数
+        uint64_t skipped;   // 已经是当前字体、跳过选入的次数
+        int cached;         // 缓存的字体数
+        int selected;       // 选入了缓存字体的设备数
+    } EasyXFontCacheStats;
+
+    void *easyx_font_acquire(const void *pLogFont);
+    void easyx_font_release(void *font);
+    int easyx_font_select(void *font);
+    void easyx_font_getlogfont(void *font, void *pLogFont);
+    HFONT easyx_font_gethandle(void *font);
+    void easyx_fontcache_setcapacity(int capacity);
+    void easyx_fontcache_clear();
+    void easyx_fontcache_getstats(EasyXFontCacheStats *pStats);
+
+    // 文本排版相关函数
+    // 按宽度自动换行的多行文本，每个段落（以换行符分隔）只用 GetTextExtentExPoint 测量一次，
+    // 改变宽度只重新换行，局部编辑只重新测量内容变化的段落，每行用一次 ExtTextOut 绘制。
+    // 文本偏移为 UTF-8 字节偏移，坐标以排版区域左上角为原点，pLogFont 为 NULL 时使用当前文本样式
+#define EASYX_TEXTLAYOUT_LEFT 0
+#define EASYX_TEXTLAYOUT_CENTER 1
+#define EASYX_TEXTLAYOUT_RIGHT 2
+#define EASYX_TEXTLAYOUT_ERR_RANGE -1
+
+    typedef struct EasyXTextLayoutStats
+    {
+        uint64_t measured;   // 调用 GetTextExtentExPoint 测量段落的次数
+        uint64_t wrapped;    // 段落重新换行的次数
+        uint64_t reused;     // 修改文本时保留测量结果的段落数
+        uint64_t drawnLines; // 绘制的行数（不含裁剪区外的行）
+    } EasyXTextLayoutStats;
+
+    void *easyx_textlayout_create(const char *str, size_t len, const void *pLogFont, int width);
+    void easyx_textlayout_destroy(void *layout);
+    void easyx_textlayout_settext(void *layout, const char *str, size_t len);
+    int easyx_textlayout_edit(void *layout, size_t start, size_t removeLen, const char *str, size_t len);
+    void easyx_textlayout_setwidth(void *layout, int width);
+    void easyx_textlayout_setfont(void *layout, const void *pLogFont);
+    void easyx_textlayout_setalign(void *layout, int align);
+    void easyx_textlayout_setlinespacing(void *layout, int spacing);
+    // pSize 为 [宽, 高]
+    void easyx_textlayout_getsize(void *layout, int *pSize);
+    int easyx_textlayout_linecount(void *layout);
+    // pLine 为 [起始偏移, 字节数, x, y, 宽度]，行号超出范围时返回 0
+    int easyx_textlayout_getline(void *layout, int index, int *pLine);
+    size_t easyx_textlayout_hittest(void *layout, int x, int y);
+    // pPos 为 [x, y, 行高]
+    void easyx_textlayout_caretpos(void *layout, size_t offset, int *pPos);
+    void easyx_textlayout_draw(void *layout, int x, int y);
+    void easyx_textlayout_getstats(void *layout, EasyXTextLayoutStats *pStats);
+
+    // 字形图集相关函数
+    // 将字体的字形一次性光栅化到 IMAGE 图集中，之后直接写入当前工作图像的像素缓冲区。
+    // 坐标为设备像素坐标，不受 setorigin 和裁剪区域影响
+    void *easyx_textatlas_create(const void *pLogFont);
+    void easyx_textatlas_destroy(void *atlas);
+    void easyx_textatlas_preload(void *atlas, const char *str, size_t len);
+    int easyx_textatlas_draw(void *atlas, int x, int y, const char *str, size_t len, uint32_t color);
+    int easyx_textatlas_textwidth(void *atlas, const char *str, size_t len);
+    int easyx_textatlas_textheight(void *atlas);
+
+    // 软件光栅化相关函数
+    // 直接写入当前工作图像的像素缓冲区，按 CPU 支持情况选择 SSE2/AVX2 内核。
+    // 坐标为设备像素坐标，矩形包含右下边界，不受 setorigin 和裁剪区域影响
+    int easyx_raster_getsupported();
+    int easyx_raster_getlevel();
+    int easyx_raster_setlevel(int level);
+    void easyx_raster_clear(uint32_t color);
+    void easyx_raster_hline(int x1, int x2, int y, uint32_t color);
+    void easyx_raster_rectangle(int left, int top, int right, int bottom, uint32_t color);
+    void easyx_raster_fillrect(int left, int top, int right, int bottom, uint32_t color);
+    void easyx_raster_fillrects(const int32_t *rects, size_t count, uint32_t color);
+    void easyx_raster_fillcircle(int x, int y, int radius, uint32_t color);
+    void easyx_raster_fillellipse(int left, int top, int right, int bottom, uint32_t color);
+    // 批量读写图像像素，pImg 为 NULL 时使用当前工作图像。stride 为外部缓冲区每行的像素数，
+    // 为 0 时等于 width。超出图像的部分跳过，返回实际复制的像素数
+    int easyx_read_pixels(const void *pImg, int left, int top, int width, int height, uint32_t *dst, size_t stride, int format);
+    int easyx_write_pixels(void *pImg, int left, int top, int width, int height, const uint32_t *src, size_t stride, int format);
+    // 比较两幅图像的红、绿、蓝通道，任一通道的差值超过 tolerance 的像素计为不同，透明度不参与比较。
+    // 返回 1 表示有不同的像素，0 表示一致。图像为 NULL 时使用当前工作图像；pDiffImg 不为 NULL 时调整为
+    // 同样大小并写入差异图：超出容差的像素为红色，容差内的差异为黄色，其余为变淡的灰度
+#define EASYX_COMPARE_ERR_SIZE -1
+#define EASYX_COMPARE_ERR_INVALID -2
+
+    typedef struct EasyXImageDiff
+    {
+        uint64_t pixels; // 超出容差的像素数
+        int maxDelta;    // 所有像素中通道差值的最大值
+        int left;        // 超出容差的像素的外接矩形，包含右下边界，没有时均为 -1
+        int top;
+        int right;
+        int bottom;
+    } EasyXImageDiff;
+
+    int easyx_image_compare(const void *pImgA, const void *pImgB, int tolerance, void *pDiffImg, EasyXImageDiff *pDiff);
+
+    // 并行分块渲染相关函数
+    // easyx_render_tiles 把当前工作图像划分为 tileWidth x tileHeight 的分块，调用线程和工作线程各自领取分块，
+    // 在私有缓冲区中调用 render 渲染后复制回工作图像，全部完成后返回分块数。render 可能在任意线程上并发调用，
+    // 只能使用 easyx_tile_* 函数或直接写入 pixels，不能调用其他 EasyX 函数。easyx_tile_* 使用设备坐标，自动裁剪到分块内
+    typedef struct EasyXTile
+    {
+        uint32_t *pixels; // 分块缓冲区，0xAARRGGBB
+        int32_t pitch;    // 相邻两行间隔的像素数
+        int32_t x;        // 分块左上角在工作图像中的x坐标
+        int32_t y;        // 分块左上角在工作图像中的y坐标
+        int32_t width;    // 分块宽度，右侧和底部的分块可能小于指定大小
+        int32_t height;   // 分块高度
+        int32_t index;    // 分块编号，按行排列
+        int32_t thread;   // 渲染线程编号，0 为调用线程，小于 easyx_render_getthreads()
+    } EasyXTile;
+
+    typedef void (*EasyXTileRenderFn)(void *user, EasyXTile *tile);
+
+    int easyx_render_tiles(int tileWidth, int tileHeight, int flags, uint32_t background, EasyXTileRenderFn render, void *user);
+    void easyx_render_setthreads(int threads);
+    int easyx_render_getthreads();
+    void easyx_tile_clear(EasyXTile *tile, uint32_t color);
+    void easyx_tile_hline(EasyXTile *tile, int x1, int x2, int y, uint32_t color);
+    void easyx_tile_rectangle(EasyXTile *tile, int left, int top, int right, int bottom, uint32_t color);
+    void easyx_tile_fillrect(EasyXTile *tile, int left, int top, int right, int bottom, uint32_t color);
+    void easyx_tile_fillcircle(EasyXTile *tile, int x, int y, int radius, uint32_t color);
+    void easyx_tile_fillellipse(EasyXTile *tile, int left, int top, int right, int bottom, uint32_t color);
+    void easyx_tile_blend(EasyXTile *tile, int dstX, int dstY, const uint32_t *src, int width, int height, size_t stride, uint8_t globalAlpha);
+
     // 图像相关函数
     void *easyx_create_image(int width, int height);
     void easyx_destroy_image(void *img);
@@ -195,13 +491,185 @@ extern "C"
     void easyx_getimage(void *pDstImg, int srcX, int srcY, int srcWidth, int srcHeight);
     void easyx_putimage(int dstX, int dstY, const void *pSrcImg, uint32_t dwRop);
     void easyx_putimage_part(int dstX, int dstY, int dstWidth, int dstHeight, const void *pSrcImg, int srcX, int srcY, uint32_t dwRop);
+    // 按源图像的透明度通道和全局透明度混合绘制，源像素为非预乘的 ARGB。
+    // 超出源图像、设备范围和裁剪区域外接矩形的部分不绘制
+    void easyx_putimage_alpha(int dstX, int dstY, const void *pSrcImg, int srcX, int srcY, int width, int height, uint8_t globalAlpha);
     void easyx_rotateimage(void *dstimg, const void *srcimg, double radian, uint32_t bkcolor, int autosize, int highquality);
     void easyx_resize_device(void *pImg, int width, int height);
     uint32_t *easyx_getimagebuffer(const void *pImg);
     void *easyx_getworkingimage();
     void easyx_setworkingimage(void *pImg);
+    // 图像（NULL 为绘图窗口或无窗口模式的画布）的大小，与 easyx_getimagebuffer 返回的缓冲区一致。
+    // 窗口图像的大小可能与客户区不同（窗口被调整大小、DPI 缩放）
+    void easyx_getdevicesize(const void *pImg, int *pWidth, int *pHeight);
     void *easyx_getimagehdc(const void *pImg);
 
+    // 图像变换相关函数
+    // 旋转、缩放和平移一次完成，逐行直接写入目标缓冲区，不分配中间图像。
+    // matrix 为 6 个元素的仿射矩阵：x' = m[0] * u + m[1] * v + m[2]，y' = m[3] * u + m[4] * v + m[5]，(u, v) 为源图像坐标。
+    // radian 为逆时针旋转的弧度，与 rotateimage 一致。easyx_putimage_* 使用逻辑坐标，自动裁剪到设备范围和裁剪区域外接矩形内；
+    // easyx_rotateimage_fast 把 pDstImg 调整为旋转后的外接矩形大小，未覆盖的像素为透明。
+    // easyx_rotcache_* 按 steps 个量化角度缓存预旋转的帧，第一次用到某个角度时渲染，之后直接复制或混合；
+    // 缓存引用源图像，源图像的像素变化后需要调用 easyx_rotcache_invalidate
+    void easyx_putimage_affine(const void *pSrcImg, const double *matrix, int flags, uint8_t globalAlpha);
+    void easyx_putimage_transform(double x, double y, const void *pSrcImg, double radian, double scaleX, double scaleY, double pivotX, double pivotY, int flags, uint8_t globalAlpha);
+    void easyx_transformimage(void *pDstImg, const void *pSrcImg, const double *matrix, int flags, uint8_t globalAlpha);
+    void easyx_scaleimage(void *pDstImg, const void *pSrcImg, int width, int height, int flags);
+    void easyx_rotateimage_fast(void *pDstImg, const void *pSrcImg, double radian, double scale, int flags);
+    void *easyx_rotcache_create(const void *pSrcImg, int steps, double scale, int flags);
+    void easyx_rotcache_destroy(void *cache);
+    void easyx_rotcache_invalidate(void *cache);
+    int easyx_rotcache_getcached(void *cache);
+    void easyx_rotcache_draw(void *cache, double x, double y, double radian, int flags, uint8_t globalAlpha);
+
+    // 图像池相关函数
+    // easyx_image_acquire 优先取出同样大小的空闲图像，绘图状态恢复默认、像素清零后返回，否则创建新图像。
+    // easyx_image_release 把图像放回池中代替销毁，空闲图像超出内存预算时先销毁最早放回的。
+    // 获取和放回的图像也可以用 easyx_destroy_image 销毁或由 easyx_create_image 创建
+    // 图像池带锁，可以在任意线程上获取和放回图像；
+    // 绘图线程之外放回的图像要等绘图线程下一次获取、放回图像或关闭图形环境时才回收
+    typedef struct EasyXImagePoolStats
+    {
+        uint64_t hits;           // 取出空闲图像的次数
+        uint64_t misses;         // 没有空闲图像、新建图像的次数
+        uint64_t released;       // 放回池中的次数
+        uint64_t evictions;      // 因超出预算被销毁的空闲图像数
+        uint64_t bytes;          // 空闲图像占用的字节数
+        int idle;                // 空闲图像数
+    } EasyXImagePoolStats;
+
+    void *easyx_image_acquire(int width, int height);
+    void easyx_image_release(void *img);
+    void easyx_imagepool_setbudget(size_t bytes);
+    size_t easyx_imagepool_getbudget();
+    void easyx_imagepool_clear();
+    void easyx_imagepool_getstats(EasyXImagePoolStats *pStats);
+
+    // 场景图层相关函数
+    // 图层保存一段命令流（easyx_submit_commands 的格式，坐标以图层左上角为原点），光栅化到缓存的图像中，
+    // easyx_scene_present 只重新合成位置、可见性、层级或内容变化的区域，返回复制或混合的图层块数。
+    // 图层坐标为工作图像的设备坐标，不受 setorigin 和裁剪区影响
+#define EASYX_LAYER_OPAQUE 0x00
+#define EASYX_LAYER_TRANSPARENT 0x01
+
+    typedef struct EasyXSceneStats
+    {
+        uint64_t rasterized; // 光栅化图层的次数
+        uint64_t blits;      // 复制或混合的图层块数
+        uint64_t regions;    // 合成的区域数
+        uint64_t presents;   // 呈现次数
+    } EasyXSceneStats;
+
+    void *easyx_scene_create();
+    void easyx_scene_destroy(void *scene);
+    int easyx_scene_addlayer(void *scene, int x, int y, int width, int height, int z, int flags);
+    void easyx_scene_removelayer(void *scene, int layer);
+    void easyx_scene_setcommands(void *scene, int layer, const void *buf, size_t len);
+    void easyx_scene_invalidate(void *scene, int layer);
+    void easyx_scene_setposition(void *scene, int layer, int x, int y);
+    void easyx_scene_setsize(void *scene, int layer, int width, int height);
+    void easyx_scene_setvisible(void *scene, int layer, int visible);
+    void easyx_scene_setz(void *scene, int layer, int z);
+    void easyx_scene_setalpha(void *scene, int layer, uint8_t alpha);
+    void easyx_scene_setfill(void *scene, int layer, uint32_t color);
+    void easyx_scene_setbackground(void *scene, uint32_t color);
+    void easyx_scene_damage(void *scene, int left, int top, int right, int bottom);
+    void easyx_scene_redraw(void *scene);
+    int easyx_scene_present(void *scene);
+    void easyx_scene_getstats(void *scene, EasyXSceneStats *pStats);
+
+    // 精灵图集相关函数
+    // 将多张图像装箱到一张图集图像中，easyx_atlas_draw_batch 一次调用绘制所有实例，
+    // 直接复制或混合像素缓冲区。坐标为逻辑坐标，自动裁剪到设备范围和裁剪区域外接矩形内
+    typedef struct EasyXSpriteInstance
+    {
+        int32_t sprite; // 精灵编号
+        int32_t x;      // 目标位置x坐标
+        int32_t y;      // 目标位置y坐标
+        uint8_t alpha;  // 全局透明度，仅在设置 EASYX_SPRITE_BLEND 时使用
+        uint8_t flags;  // EASYX_SPRITE_* 标志
+        uint16_t reserved;
+    } EasyXSpriteInstance;
+
+    void *easyx_atlas_create(int width, int height);
+    void easyx_atlas_destroy(void *atlas);
+    int easyx_atlas_add_image(void *atlas, const void *pSrcImg, int srcX, int srcY, int width, int height);
+    int easyx_atlas_add_file(void *atlas, const char *pImgFile, int nWidth, int nHeight, int bResize);
+    int easyx_atlas_count(void *atlas);
+    int easyx_atlas_getsprite(void *atlas, int sprite, int32_t *pRect);
+    void *easyx_atlas_getimage(void *atlas);
+    int easyx_atlas_draw_batch(void *atlas, const EasyXSpriteInstance *instances, int n);
+
+    // 瓦片地图相关函数
+    // 瓦片编号按行存放，按 chunkSize x chunkSize 个瓦片划分区块并缓存渲染结果，
+    // 修改瓦片只标记所在区块，绘制时重新渲染可见的脏区块后直接复制到工作图像。
+    // 编号 0 和未定义的编号使用背景色，坐标为逻辑坐标，自动裁剪
+    void *easyx_tilemap_create(int cols, int rows, int tileWidth, int tileHeight, int chunkSize);
+    void easyx_tilemap_destroy(void *tilemap);
+    void easyx_tilemap_definecolor(void *tilemap, uint16_t tile, uint32_t color);
+    void easyx_tilemap_definesprite(void *tilemap, uint16_t tile, void *atlas, int sprite);
+    void easyx_tilemap_setbackground(void *tilemap, uint32_t color);
+    void easyx_tilemap_settile(void *tilemap, int col, int row, uint16_t tile);
+    int easyx_tilemap_gettile(void *tilemap, int col, int row);
+    void easyx_tilemap_settiles(void *tilemap, int col, int row, int width, int height, const uint16_t *tiles, size_t stride);
+    void easyx_tilemap_fill(void *tilemap, int col, int row, int width, int height, uint16_t tile);
+    void easyx_tilemap_invalidate(void *tilemap);
+    int easyx_tilemap_draw(void *tilemap, int x, int y, int scrollX, int scrollY, int viewWidth, int viewHeight);
+
+    // 异步图像加载相关函数
+    // easyx_loadimage_async 将请求交给工作线程用 WIC 解码，绘图线程每帧调用 easyx_loadimage_finalize
+    // 在时间预算内把解码结果创建为 IMAGE。easyx_loadimage_take 取走结果后请求即被释放，
+    // 取得的图像由调用者用 easyx_destroy_image 释放。进度从上次 easyx_loadimage_resetprogress 开始统计
+    typedef struct EasyXLoadProgress
+    {
+        int requested; // 提交的请求数
+        int finished;  // 已完成（成功或失败）的请求数
+        int failed;    // 失败的请求数
+        int cancelled; // 完成前被取消的请求数
+    } EasyXLoadProgress;
+
+    int easyx_loadimage_async(const char *pImgFile, int nWidth, int nHeight);
+    int easyx_loadimage_status(int id);
+    void *easyx_loadimage_take(int id, int *pError);
+    int easyx_loadimage_cancel(int id);
+    int easyx_loadimage_finalize(double budgetMs);
+    void easyx_loadimage_progress(EasyXLoadProgress *pProgress);
+    void easyx_loadimage_resetprogress();
+
+    // 解码图像缓存相关函数
+    // easyx_imagecache_load 与 easyx_loadimage_file 参数相同，按文件内容（而不是路径）和加载参数查找，
+    // 命中时直接复制缓存的像素，跳过解码。超出内存预算时淘汰最久未使用的条目
+    typedef struct EasyXImageCacheStats
+    {
+        uint64_t hits;      // 命中次数
+        uint64_t misses;    // 未命中次数
+        uint64_t evictions; // 因超出预算被淘汰的条目数
+        uint64_t bytes;     // 缓存的像素占用的字节数
+        int entries;        // 缓存的条目数
+    } EasyXImageCacheStats;
+
+    int easyx_imagecache_load(void *pDstImg, const char *pImgFile, int nWidth, int nHeight, int bResize);
+    void easyx_imagecache_setbudget(size_t bytes);
+    size_t easyx_imagecache_getbudget();
+    void easyx_imagecache_clear();
+    void easyx_imagecache_getstats(EasyXImageCacheStats *pStats);
+
+    // 资源包相关函数
+    // 资源包保存预解码的像素（与 IMAGE 缓冲区格式相同，按 64 字节对齐），打开时内存映射整个文件，
+    // easyx_pack_load 调整目标图像大小后直接复制像素，不需要解码。资源包由 easyx_packwriter_* 生成
+    void *easyx_pack_open(const char *pPackFile);
+    void easyx_pack_close(void *pack);
+    int easyx_pack_count(void *pack);
+    int easyx_pack_find(void *pack, const char *pName);
+    const char *easyx_pack_getname(void *pack, int index);
+    int easyx_pack_getsize(void *pack, int index, int32_t *pSize);
+    int easyx_pack_load(void *pack, int index, void *pDstImg);
+
+    void *easyx_packwriter_create();
+    void easyx_packwriter_destroy(void *writer);
+    int easyx_packwriter_add(void *writer, const char *pName, const void *pImg);
+    int easyx_packwriter_save(void *writer, const char *pPackFile);
+
     // 其他函数
     int easyx_getwidth();
     int easyx_getheight();
@@ -210,10 +678,125 @@ extern "C"
     void easyx_flushbatchdraw_rect(int left, int top, int right, int bottom);
     void easyx_endbatchdraw();
     void easyx_endbatchdraw_rect(int left, int top, int right, int bottom);
+
+    // 帧调度相关函数
+    // easyx_frame_present 等待到本帧的提交时刻后刷新批处理绘图，可选等待 DWM 合成以对齐垂直同步。
+    // easyx_frame_getremaining 返回距本帧提交时刻的毫秒数，已错过时为 0，不限帧率时为 -1
+    typedef struct EasyXFrameStats
+    {
+        double cpuMs;          // 上一帧提交完成到本帧调用 present 的时间
+        double waitMs;         // 为对齐提交时刻而等待的时间
+        double presentMs;      // 刷新批处理绘图（及等待 DWM）的时间
+        double frameMs;        // 整帧时间
+        uint64_t frameIndex;   // 已提交的帧数
+        uint64_t missedFrames; // 调用 present 时已经错过提交时刻的帧数
+    } EasyXFrameStats;
+
+    void easyx_frame_settargetfps(double fps);
+    double easyx_frame_gettargetfps();
+    void easyx_frame_setvsync(int enabled);
+    int easyx_frame_getvsync();
+    void easyx_frame_reset();
+    int easyx_frame_present(int dirtyOnly);
+    void easyx_frame_getstats(EasyXFrameStats *pStats);
+    double easyx_frame_getremaining();
+
+    // 呈现线程相关函数
+    // easyx_presenter_begin 取出一个离屏缓冲区并设为工作图像，easyx_presenter_submit 恢复工作图像并把它交给
+    // 呈现线程 BitBlt 到窗口，绘图线程不必等待复制完成。低延迟模式只呈现最新完成的帧，来不及呈现的帧计为丢弃；
+    // 高吞吐模式按顺序呈现每一帧，缓冲区用尽时 begin 等待。缓冲区大小在 start 时按窗口客户区确定
+#define EASYX_PRESENT_LATENCY 0
+#define EASYX_PRESENT_THROUGHPUT 1
+
+#define EASYX_PRESENT_ERR_RUNNING -1
+#define EASYX_PRESENT_ERR_INVALID -2
+
+    typedef struct EasyXPresenterStats
+    {
+        uint64_t submitted; // 提交的帧数
+        uint64_t presented; // 复制到窗口的帧数
+        uint64_t dropped;   // 被更新的帧取代、没有呈现的帧数
+        uint64_t stalls;    // begin 因没有空闲缓冲区而等待的次数
+        double waitMs;      // begin 等待空闲缓冲区的总时间
+        double presentMs;   // 最近一帧的复制（及等待 DWM）时间
+        int buffers;        // 缓冲区数量
+        int queued;         // 等待呈现的帧数
+    } EasyXPresenterStats;
+
+    int easyx_presenter_start(int buffers, int mode);
+    void easyx_presenter_stop();
+    int easyx_presenter_running();
+    void *easyx_presenter_begin();
+    void easyx_presenter_submit();
+    void easyx_presenter_setmode(int mode);
+    int easyx_presenter_getmode();
+    void easyx_presenter_getstats(EasyXPresenterStats *pStats);
+
+    // 录制相关函数
+    // easyx_recorder_capture 把图像（NULL 为绘图窗口或无窗口模式的画布）的缓冲区复制到帧池中立即返回，编码线程写入文件；
+    // 帧池用尽时丢弃这一帧并返回 0。原始和差分格式写入单个文件：16 字节文件头之后每帧一个 32 字节的记录头，
+    // 差分帧的内容为若干段 [相同像素数][变化像素数][变化的像素]。PNG 序列的文件名中连续的 '#' 替换为帧序号
+#define EASYX_RECORD_RAW 0
+#define EASYX_RECORD_DELTA 1
+#define EASYX_RECORD_PNG 2
+#define EASYX_RECORD_KEYFRAME 0x01
+#define EASYX_RECORD_ERR_INVALID -1
+#define EASYX_RECORD_ERR_IO -2
+
+    typedef struct EasyXRecorderStats
+    {
+        uint64_t captured; // 复制到帧池的帧数
+        uint64_t written;  // 编码并写入的帧数
+        uint64_t dropped;  // 帧池用尽或写入失败而丢弃的帧数
+        uint64_t bytes;    // 写入的字节数
+        double encodeMs;   // 最近一帧的编码和写入时间
+        int queued;        // 等待编码的帧数
+        int pool;          // 帧池的大小
+        int error;         // 第一次写入失败的 HRESULT，之后不再写入
+    } EasyXRecorderStats;
+
+    void *easyx_recorder_create(const char *path, int format, int poolFrames);
+    int easyx_recorder_capture(void *recorder, const void *img);
+    // 等待排队的帧全部写入
+    void easyx_recorder_flush(void *recorder);
+    void easyx_recorder_destroy(void *recorder);
+    void easyx_recorder_getstats(void *recorder, EasyXRecorderStats *pStats);
+
+    // 性能分析相关函数
+    // 需要启用 easyx-sys 的 profiler 特性，未启用时 easyx_profiler_available 返回 0，快照全为 0。
+    // 时间为独占时间：包装函数内部调用的其他包装函数只计入各自的类别
+    typedef struct EasyXProfilerSnapshot
+    {
+        uint64_t calls[EASYX_PROF_CATEGORIES]; // 各类别的调用次数
+        double ms[EASYX_PROF_CATEGORIES];      // 各类别累计的时间
+        double elapsedMs;                      // 距离上次重置的时间
+    } EasyXProfilerSnapshot;
+
+    int easyx_profiler_available();
+    void easyx_profiler_reset();
+    void easyx_profiler_snapshot(EasyXProfilerSnapshot *pSnapshot, int reset);
+
+    // 脏矩形相关函数
+    // 批处理期间包装层记录绘制到窗口的图元范围，easyx_flushbatchdraw_dirty 只刷新这些区域，
+    // 返回刷新的矩形数量。直接修改窗口缓冲区时需要用 easyx_dirty_add 手动登记（设备坐标，包含右下边界），
+    // 经过 HDC 绘制的内容用 easyx_dirty_addlogical 登记（逻辑坐标，pad 为向外扩展的像素数）。
+    // 跟踪默认关闭，easyx_flushbatchdraw_dirty 第一次调用时开启并刷新整个窗口，easyx_dirty_enable(0) 关闭
+    int easyx_flushbatchdraw_dirty();
+    void easyx_dirty_enable(int enable);
+    int easyx_dirty_isenabled();
+    void easyx_dirty_add(int left, int top, int right, int bottom);
+    void easyx_dirty_addlogical(int left, int top, int right, int bottom, int pad);
+    void easyx_dirty_markall();
+    void easyx_dirty_setmergethreshold(float ratio);
+    int easyx_dirty_getrects(int32_t *rects, int capacity);
     void easyx_delay(int ms);
     const char *easyx_geteasyxver();
     HWND easyx_gethwnd();
 
+    // 命令缓冲相关函数
+    // 一次性回放 buf 中的命令流，返回执行的命令数，格式错误时返回 EASYX_CMD_ERR_*
+    int easyx_submit_commands(const void *buf, size_t len);
+
     // 旧版 graphics.h 相关函数
 
     // 旧版文本相关函数
@@ -299,10 +882,53 @@ extern "C"
     // 消息相关函数
     void easyx_getmessage(struct CExMessage *msg, unsigned char filter);
     int easyx_peekmessage(struct CExMessage *pMsg, unsigned char filter, int removemsg);
+    // 一次取出最多 capacity 个消息，返回取出的数量。coalesceMouseMove 非 0 时连续的鼠标移动消息只保留最后一个
+    int easyx_peekmessages(struct CExMessage *pMsgs, int capacity, unsigned char filter, int coalesceMouseMove);
     void easyx_flushmessage(unsigned char filter);
     void easyx_setcapture();
     void easyx_releasecapture();
 
+    // 等待消息相关函数
+    // easyx_waitmessage 休眠到消息队列中有符合 filter 的消息、超时或 easyx_wake 被调用，不占用 CPU。
+    // timeoutMs 小于 0 表示一直等待。easyx_wake 可以在任意线程中调用，唤醒正在等待或下一次等待的线程
+    // 无窗口模式下不会有消息，只在超时或被唤醒时返回
+#define EASYX_WAIT_TIMEOUT 0
+#define EASYX_WAIT_MESSAGE 1
+#define EASYX_WAIT_WAKE 2
+
+    int easyx_waitmessage(int timeoutMs, unsigned char filter);
+    void easyx_wake();
+
+    // 无锁队列相关函数
+    // 命令队列为多生产者单消费者：任意线程用 easyx_cmdring_post 提交命令流（easyx_submit_commands 的格式），
+    // 绘图线程用 easyx_cmdring_drain 按提交顺序回放，返回回放的命令流数。消息队列为单生产者单消费者：
+    // 绘图线程用 easyx_msgring_pump 把 EasyX 队列中的消息移入，另一个线程用 easyx_msgring_pop 取出。
+    // 队列满时提交失败而不是等待，容量向上取整到 2 的幂
+#define EASYX_RING_ERR_FULL -1
+#define EASYX_RING_ERR_TOOBIG -2
+#define EASYX_RING_ERR_INVALID -3
+
+    typedef struct EasyXRingStats
+    {
+        uint64_t pushed;   // 成功提交的命令流数或消息数
+        uint64_t popped;   // 已回放的命令流数或已取出的消息数
+        uint64_t rejected; // 因队列已满被拒绝的次数
+        size_t used;       // 占用的容量，命令队列为字节数，消息队列为消息数
+        size_t capacity;   // 总容量，单位同上
+    } EasyXRingStats;
+
+    void *easyx_cmdring_create(size_t bytes);
+    void easyx_cmdring_destroy(void *ring);
+    int easyx_cmdring_post(void *ring, const void *buf, size_t len);
+    int easyx_cmdring_drain(void *ring, int maxStreams);
+    void easyx_cmdring_getstats(void *ring, EasyXRingStats *pStats);
+    void *easyx_msgring_create(int capacity);
+    void easyx_msgring_destroy(void *ring);
+    int easyx_msgring_push(void *ring, const struct CExMessage *pMsg);
+    int easyx_msgring_pump(void *ring, unsigned char filter);
+    int easyx_msgring_pop(void *ring, struct CExMessage *pMsgs, int capacity);
+    void easyx_msgring_getstats(void *ring, EasyXRingStats *pStats);
+
     // 对话框相关函数
     int easyx_inputbox(char *pString, int nMaxCount, const char *pPrompt, const char *pTitle, const char *pDefault, int width, int height, int bOnlyOK);
 
@@ -45,7 +45,7 @@ struct Block {
 // 游戏状态结构体
 #[derive(Debug)]
 struct GameState {
-    grid: [[Option<Color>; GRID_WIDTH]; GRID_HEIGHT],
+    grid: [[Option<Tetromino>; GRID_WIDTH]; GRID_HEIGHT],
     current_block: Block,
     next_block: Tetromino,
     score: u32,
@@ -116,6 +116,11 @@ impl Tetromino {
         }
     }
 
+    // 瓦片地图中的瓦片编号，0 为空格子
+    fn tile(&self) -> TileId {
+        *self as TileId + 1
+    }
+
     // 随机生成方块
     fn random() -> Self {
         use rand::Rng;
@@ -147,7 +152,11 @@ impl Block {
     }
 
     // 旋转方块
-    fn rotate(&mut self, direction: Direction, grid: &[[Option<Color>; GRID_WIDTH]; GRID_HEIGHT]) {
+    fn rotate(
+        &mut self,
+        direction: Direction,
+        grid: &[[Option<Tetromino>; GRID_WIDTH]; GRID_HEIGHT],
+    ) {
         let prev_r = self.rotation;
         let prev_x = self.x;
 
@@ -183,7 +192,7 @@ impl Block {
     }
 
     // 检查碰撞
-    fn check_collision(&self, grid: &[[Option<Color>; GRID_WIDTH]; GRID_HEIGHT]) -> bool {
+    fn check_collision(&self, grid: &[[Option<Tetromino>; GRID_WIDTH]; GRID_HEIGHT]) -> bool {
         let shape = self.shape.shapes();
 
         // 遍历旋转后的形状的每个位置
@@ -219,7 +228,7 @@ impl Block {
     fn move_block(
         &mut self,
         direction: Direction,
-        grid: &[[Option<Color>; GRID_WIDTH]; GRID_HEIGHT],
+        grid: &[[Option<Tetromino>; GRID_WIDTH]; GRID_HEIGHT],
     ) -> bool {
         let old_x = self.x;
         let old_y = self.y;
@@ -298,7 +307,7 @@ impl GameState {
                     {
                         let grid_x_usize = grid_x as usize;
                         let grid_y_usize = grid_y as usize;
-                        self.grid[grid_y_usize][grid_x_usize] = Some(block.shape.color());
+                        self.grid[grid_y_usize][grid_x_usize] = Some(block.shape);
                     }
                 }
             }
@@ -351,12 +360,65 @@ impl GameState {
     }
 }
 
+// 为每种方块生成一张格子图像放入图集，左边和上边留 1 像素黑边作为格子间隔
+fn build_block_atlas() -> Result<(SpriteAtlas, Vec<SpriteId>), AtlasError> {
+    const ALL: [Tetromino; 7] = [
+        Tetromino::I,
+        Tetromino::O,
+        Tetromino::T,
+        Tetromino::L,
+        Tetromino::J,
+        Tetromino::S,
+        Tetromino::Z,
+    ];
+
+    let mut atlas = SpriteAtlas::new(256, 64);
+    let mut sprites = Vec::with_capacity(ALL.len());
+    let size = BLOCK_SIZE as i32;
+    let mut pixels = vec![0; BLOCK_SIZE * BLOCK_SIZE];
+
+    for shape in ALL {
+        let color = 0xFF000000 | shape.color().as_colorref();
+        for (i, pixel) in pixels.iter_mut().enumerate() {
+            let (x, y) = (i % BLOCK_SIZE, i / BLOCK_SIZE);
+            *pixel = if x > 0 && y > 0 { color } else { 0xFF000000 };
+        }
+
+        let mut image = Image::new(size, size);
+        image.write_pixels(0, 0, size, size, &pixels, 0, PixelFormat::Abgr);
+        sprites.push(atlas.add_image(&image)?);
+    }
+
+    Ok((atlas, sprites))
+}
+
 fn main() -> Result<(), Box<dyn std::error::Error>> {
     // 初始化游戏状态
     let mut game = GameState::new();
     let mut end_game = false;
 
     run(800, 600, move |app| {
+        // 已固定的方块放在瓦片地图中，只有发生变化的区块才会重新渲染
+        let (atlas, sprites) = build_block_atlas()?;
+        let mut board = TileMap::new(
+            GRID_WIDTH as i32,
+            GRID_HEIGHT as i32,
+            BLOCK_SIZE as i32,
+            BLOCK_SIZE as i32,
+        );
+        for (tile, &sprite) in sprites.iter().enumerate() {
+            board.define_sprite(tile as TileId + 1, &atlas, sprite);
+        }
+        let mut tiles = [0; GRID_WIDTH * GRID_HEIGHT];
+
+        // 当前方块绘制命令缓冲，每帧复用
+        let mut cmds = CommandBuffer::new();
+        // 键盘消息缓冲，每帧一次取出所有按键
+        let mut messages = MessageBuffer::new(32);
+
+        // 按 60 帧每秒的节奏提交画面
+        app.set_target_fps(60.0);
+
         // 开始批处理绘图（启用双缓冲）
         app.begin_batch_draw();
 
@@ -364,8 +426,8 @@ fn main() -> Result<(), Box<dyn std::error::Error>> {
             // 清除屏幕以防止拖影
             app.clear_device();
 
-            // 使用peek_message处理键盘输入
-            while let Some(msg) = app.peek_message(MessageFilter::KeyBoard, true) {
+            // 批量取出键盘消息处理输入
+            for msg in messages.drain(MessageFilter::KeyBoard) {
                 // 只处理按键按下事件，忽略释放事件
                 if msg.ty == ExMessageType::KeyDown
                     && let Message::KeyBoard { vkcode, .. } = msg.msg
@@ -407,25 +469,18 @@ fn main() -> Result<(), Box<dyn std::error::Error>> {
             app.set_textstyle(24, 0, "Arial");
             app.out_text(GAME_WIDTH as i32 + 10, 10, "俄罗斯方块");
 
+            // 同步已固定的方块到瓦片地图后绘制
+            for (dst, cell) in tiles.iter_mut().zip(game.grid.iter().flatten()) {
+                *dst = cell.map_or(0, |shape| shape.tile());
+            }
+            board.set_region(0, 0, GRID_WIDTH, &tiles, GRID_WIDTH);
+            board.draw(0, 0);
+
             // 绘制游戏边界
             app.rectangle(0, 0, GAME_WIDTH as i32, GAME_HEIGHT as i32);
 
-            // 绘制已固定的方块
-            for y in 0..GRID_HEIGHT {
-                for x in 0..GRID_WIDTH {
-                    if let Some(color) = game.grid[y][x] {
-                        app.set_fillcolor(&color);
-                        app.fill_rectangle(
-                            x as i32 * BLOCK_SIZE as i32 + 1,
-                            y as i32 * BLOCK_SIZE as i32 + 1,
-                            (x + 1) as i32 * BLOCK_SIZE as i32 - 1,
-                            (y + 1) as i32 * BLOCK_SIZE as i32 - 1,
-                        );
-                    }
-                }
-            }
-
-            // 绘制当前方块
+            // 绘制当前方块，录制到命令缓冲后一次性提交
+            cmds.clear();
             let shape = game.current_block.shape.shapes();
             for (y, row) in shape.iter().enumerate().take(4) {
                 for (x, &cell) in row.iter().enumerate().take(4) {
@@ -436,16 +491,17 @@ fn main() -> Result<(), Box<dyn std::error::Error>> {
                         let block_x = game.current_block.x + rot_x as i32;
                         let block_y = game.current_block.y + rot_y as i32;
 
-                        app.set_fillcolor(&game.current_block.shape.color());
-                        app.fill_rectangle(
-                            block_x * BLOCK_SIZE as i32 + 1,
-                            block_y * BLOCK_SIZE as i32 + 1,
-                            (block_x + 1) * BLOCK_SIZE as i32 - 1,
-                            (block_y + 1) * BLOCK_SIZE as i32 - 1,
-                        );
+                        cmds.set_fillcolor(&game.current_block.shape.color())
+                            .fill_rectangle(
+                                block_x * BLOCK_SIZE as i32 + 1,
+                                block_y * BLOCK_SIZE as i32 + 1,
+                                (block_x + 1) * BLOCK_SIZE as i32 - 1,
+                                (block_y + 1) * BLOCK_SIZE as i32 - 1,
+                            );
                     }
                 }
             }
+            app.submit_commands(&cmds)?;
 
             // 绘制下一个方块预览
             let next_shape = game.next_block.shapes();
@@ -498,8 +554,8 @@ fn main() -> Result<(), Box<dyn std::error::Error>> {
                 );
             }
 
-            // 将缓冲区内容一次性刷新到屏幕（双缓冲）
-            app.flush_batch_draw();
+            // 在本帧的提交时刻将缓冲区内容一次性刷新到屏幕（双缓冲）
+            app.present_frame();
         }
 
         // 结束批处理绘图